@@ -33,6 +33,9 @@ class TypeNode;
 class ArrayLiteralNode;
 class BorrowExprNode;
 class TryStatement;
+class ScopedStatement;
+class DeferStatement;
+class ClosureExpression;
 class IntegerLiteral;
 class FloatLiteral;
 class StringLiteral;
@@ -160,7 +163,10 @@ struct ImportSpecifier {
         TEMPLATE_DECLARATION, // New
 
         // --- Custom ---
-        TRY_STATEMENT // For TryStatement AST node
+        TRY_STATEMENT, // For TryStatement AST node
+        SCOPED_STATEMENT, // scoped { ... } region block
+        DEFER_STATEMENT,  // defer stmt, run when its block exits
+        CLOSURE_EXPRESSION // fn (params) { body } as a value
     };
 
     // Visitor Interface
@@ -200,6 +206,9 @@ struct ImportSpecifier {
 
         // --- Custom ---
         virtual void visit(TryStatement* node) = 0;
+        virtual void visit(ScopedStatement* node) = 0;
+        virtual void visit(DeferStatement* node) = 0;
+        virtual void visit(ClosureExpression* node) = 0;
 
         // Declarations
         virtual void visit(VariableDeclaration* node) = 0;
@@ -244,6 +253,11 @@ struct ImportSpecifier {
         Statement(SourceLocation loc) : Node(loc) {}
     };
 
+    // Code to inline where control leaves one or more scopes, in the order it
+    // runs: the bodies of DeferStatements and the finally blocks of enclosing
+    // trys. Not owned; set by DeferLowering.
+    using CleanupList = std::vector<Statement*>;
+
     // Base Declaration Node (Declarations are Statements)
     class Declaration : public Statement {
     public:
@@ -280,6 +294,29 @@ struct ImportSpecifier {
         void accept(Visitor& visitor) override;
     };
 
+    // A local of an async fn that is live across an await, spilled into the
+    // coroutine frame at `offset`
+    struct CoroutineSlot {
+        std::string name;
+        size_t offset;
+        size_t size;
+        size_t align;
+    };
+
+    // Frame layout of a lowered async fn (vre/coroutine.hpp); set by
+    // CoroutineLowering. Offsets are from the start of the frame, whose
+    // first bytes are the VreCoroutine header.
+    struct CoroutineLayout {
+        bool lowered = false;
+        size_t resultOffset = 0;
+        size_t resultSize = 0;
+        std::vector<CoroutineSlot> slots;
+        size_t awaitCount = 0;  // resume states besides the entry state
+        size_t awaitOffset = 0; // where awaited callee frames are built in place
+        size_t awaitSize = 0;
+        size_t frameSize = 0;
+    };
+
     class FunctionDeclaration : public Declaration {
     public:
         std::unique_ptr<Identifier> id;
@@ -287,6 +324,9 @@ struct ImportSpecifier {
         std::unique_ptr<class BlockStatement> body; // Forward declare BlockStatement if full def is later
         bool isAsync;
         TypeNodePtr returnTypeNode; // Optional
+        TypeNodePtr throwsTypeNode; // `throws E`, optional
+        CoroutineLayout coroutine;  // Only for async fns
+        bool canFail = false;       // Returns a VreResult (vre/result.hpp); set by ErrorLowering
 
         FunctionDeclaration(SourceLocation loc, std::unique_ptr<Identifier> id, std::vector<FunctionParameter> params, std::unique_ptr<BlockStatement> body, bool isAsync = false, TypeNodePtr returnTypeNode = nullptr);
         virtual ~FunctionDeclaration();
@@ -313,6 +353,7 @@ struct ImportSpecifier {
         std::unique_ptr<Identifier> name;
         std::vector<std::unique_ptr<GenericParamNode>> genericParams;
         std::vector<std::unique_ptr<FieldDeclaration>> fields;
+        uint32_t typeId = 0; // Index in the module's VreTypeTable; set by TypeTableGenerator, 0 if not laid out
 
         StructDeclaration(SourceLocation loc, std::unique_ptr<Identifier> name, std::vector<std::unique_ptr<GenericParamNode>> genericParams, std::vector<std::unique_ptr<FieldDeclaration>> fields);
         NodeType getType() const override;
@@ -325,6 +366,7 @@ struct ImportSpecifier {
         std::unique_ptr<Identifier> name;
         std::vector<std::unique_ptr<GenericParamNode>> genericParams;
         std::vector<DeclPtr> members; // Can be FieldDeclaration or FunctionDeclaration
+        uint32_t typeId = 0; // As StructDeclaration::typeId
 
         ClassDeclaration(SourceLocation loc, std::unique_ptr<Identifier> name, std::vector<std::unique_ptr<GenericParamNode>> genericParams, std::vector<DeclPtr> members);
         NodeType getType() const override;
@@ -516,6 +558,46 @@ struct ImportSpecifier {
         std::string toString() const override; 
     };
 
+    enum class CaptureMode {
+        BY_VALUE,    // copied into the environment when the closure is made
+        BY_REFERENCE // a their<T> borrow (or `borrow`/`view` binding): the environment holds the reference
+    };
+
+    struct ClosureCapture {
+        std::string name;
+        CaptureMode mode;
+        size_t offset; // from the start of the environment
+        size_t size;
+        size_t align;
+    };
+
+    // Environment layout of a closure (vre/closure.hpp); set by
+    // ClosureConversion. Captures are in order of first use in the body.
+    struct ClosureLayout {
+        bool converted = false;
+        std::vector<ClosureCapture> captures;
+        size_t envSize = 0;
+        size_t envAlign = 1;
+    };
+
+    // An anonymous function value: `fn (x: Int) -> Int { ... }`, or
+    // `fn (x: Int) => expr`, whose body the parser wraps in a block returning
+    // expr. Variables of enclosing functions it uses are captured into a flat
+    // environment allocated with the closure.
+    class ClosureExpression : public Expression {
+    public:
+        std::vector<FunctionParameter> params;
+        TypeNodePtr returnTypeNode; // Optional
+        std::unique_ptr<BlockStatement> body;
+        ClosureLayout layout;
+
+        ClosureExpression(SourceLocation loc, std::vector<FunctionParameter> params, TypeNodePtr returnTypeNode,
+                          std::unique_ptr<BlockStatement> body);
+        NodeType getType() const override { return NodeType::CLOSURE_EXPRESSION; }
+        std::string toString() const override;
+        void accept(Visitor& visitor) override;
+    };
+
     // Represents one key-value pair in an object literal
     struct ObjectProperty {
         SourceLocation loc; // Location of the property itself (key or key:value)
@@ -576,10 +658,27 @@ struct ImportSpecifier {
         void accept(Visitor& visitor) override;
     };
 
+    // Where control goes when a `throw` or a call to a failing function
+    // produces an error; set by ErrorLowering
+    enum class ErrorTarget {
+        NONE,    // cannot fail; no check is emitted
+        HANDLER, // branch to the catch clauses of the innermost enclosing try
+        RETURN   // return the error from the enclosing function
+    };
+
+    struct ErrorEdge {
+        ErrorTarget target = ErrorTarget::NONE;
+        uint32_t cleanups = 0; // finally blocks run on the way, innermost first
+        TryStatement* handler = nullptr; // HANDLER: the try whose catch clauses it branches to
+    };
+
     class CallExpression : public Expression {
     public:
         ExprPtr callee;
         std::vector<ExprPtr> arguments;
+        uint32_t awaitState = 0; // For `await`: the resume state after it, numbered from 1 (CoroutineLowering)
+        ErrorEdge errorEdge;     // For `_throw` and calls to failing functions
+        CleanupList errorCleanups; // Run when errorEdge is taken
 
         CallExpression(SourceLocation loc, ExprPtr callee, std::vector<ExprPtr> arguments);
         virtual ~CallExpression();
@@ -588,11 +687,20 @@ struct ImportSpecifier {
         void accept(Visitor& visitor) override;
     };
 
+    // How an indexing site `s[i]` is bounds-checked; set by BoundsCheckElimination
+    enum class BoundsCheck {
+        CHECKED,    // checked at every access
+        HOISTED,    // covered by one check before the enclosing loop (ForStatement::hoistedBoundsChecks)
+        ELIMINATED  // proven in bounds; no check needed
+    };
+
     class MemberExpression : public Expression {
     public:
         ExprPtr object;   // The object whose member is being accessed
         ExprPtr property; // The property being accessed (Identifier or Expression if computed)
         bool computed;    // True if property is accessed with [], false for .
+        uint32_t cacheSite; // Unique per parsed site; indexes the VRE inline cache table (vre/inline_cache.hpp)
+        BoundsCheck boundsCheck = BoundsCheck::CHECKED; // Only meaningful for computed access
 
         MemberExpression(SourceLocation loc, ExprPtr object, ExprPtr property, bool computed);
         virtual ~MemberExpression();
@@ -619,6 +727,7 @@ struct ImportSpecifier {
     class BlockStatement : public Statement {
     public:
         std::vector<StmtPtr> body;
+        CleanupList exitCleanups; // The block's own defers, run when it falls through its end
 
         BlockStatement(SourceLocation loc, std::vector<StmtPtr> body);
         virtual ~BlockStatement();
@@ -628,22 +737,58 @@ struct ImportSpecifier {
     };
 
     // TryStatement AST node (define after BlockStatement)
+    // catch (e: ErrorType) { ... }; both the name and the type are optional
+    struct CatchClause {
+        std::optional<std::string> ident;
+        std::optional<std::string> errorType; // catches every error if absent
+        std::unique_ptr<BlockStatement> block;
+    };
+
     class TryStatement : public Statement {
     public:
         std::unique_ptr<BlockStatement> tryBlock;
-        std::optional<std::string> catchIdent;
-        std::unique_ptr<BlockStatement> catchBlock;
+        std::vector<CatchClause> catches; // tried in order
         std::unique_ptr<BlockStatement> finallyBlock;
+        ErrorEdge unmatched; // taken when no clause's type matches; set by ErrorLowering
+        CleanupList unmatchedCleanups;
 
         TryStatement(const SourceLocation& loc, std::unique_ptr<BlockStatement> tryBlock,
-                     std::optional<std::string> catchIdent,
-                     std::unique_ptr<BlockStatement> catchBlock,
+                     std::vector<CatchClause> catches,
                      std::unique_ptr<BlockStatement> finallyBlock);
         NodeType getType() const override;
         std::string toString() const override;
         void accept(Visitor& visitor) override;
     };
 
+    // scoped { ... }: allocations made inside the block live in a runtime region
+    // that is freed as a whole when the block exits.
+    class ScopedStatement : public Statement {
+    public:
+        std::unique_ptr<BlockStatement> body;
+        // Variables declared in the block whose values escape it; filled in by
+        // EscapeAnalysis and used to promote those allocations out of the region.
+        std::vector<std::string> escapingNames;
+
+        ScopedStatement(SourceLocation loc, std::unique_ptr<BlockStatement> body);
+        NodeType getType() const override;
+        std::string toString() const override;
+        void accept(Visitor& visitor) override;
+    };
+
+    // defer stmt: runs `body` when control leaves the enclosing block, by
+    // falling off its end, return, break, continue or an error. Defers of one
+    // block run in reverse order. Lowered by DeferLowering to inline copies
+    // at each exit rather than a runtime stack of closures.
+    class DeferStatement : public Statement {
+    public:
+        StmtPtr body; // An ExpressionStatement or a BlockStatement
+
+        DeferStatement(SourceLocation loc, StmtPtr body);
+        NodeType getType() const override;
+        std::string toString() const override;
+        void accept(Visitor& visitor) override;
+    };
+
     class ExpressionStatement : public Statement {
     public:
         ExprPtr expression;
@@ -668,12 +813,21 @@ struct ImportSpecifier {
         void accept(Visitor& visitor) override;
     };
 
+    // A bounds check executed once before a loop instead of on every iteration:
+    // `bound <= len(slice)`, where `bound` is the exclusive end of the loop range.
+    struct HoistedBoundsCheck {
+        std::string slice;
+        Expression* bound; // owned by the loop's range expression
+    };
+
     class ForStatement : public Statement {
     public:
         NodePtr init;   // VariableDeclaration or ExpressionStatement or nullptr
         ExprPtr test;   // Expression or nullptr
         ExprPtr update; // Expression or nullptr
         StmtPtr body;
+        std::vector<HoistedBoundsCheck> hoistedBoundsChecks; // Filled by BoundsCheckElimination
+        bool isParallel = false; // `@parallel for`: iterations run as chunks on the executor (vre/parallel.hpp)
 
         ForStatement(SourceLocation loc, NodePtr init, ExprPtr test, ExprPtr update, StmtPtr body);
         virtual ~ForStatement();
@@ -697,6 +851,7 @@ struct ImportSpecifier {
     class ReturnStatement : public Statement {
     public:
         ExprPtr argument; // Optional, can be nullptr
+        CleanupList cleanups; // Run after the argument is evaluated
 
         ReturnStatement(SourceLocation loc, ExprPtr argument = nullptr);
         virtual ~ReturnStatement();
@@ -707,6 +862,8 @@ struct ImportSpecifier {
 
     class BreakStatement : public Statement {
     public:
+        CleanupList cleanups;
+
         BreakStatement(SourceLocation loc);
         virtual ~BreakStatement();
         NodeType getType() const override;
@@ -716,6 +873,8 @@ struct ImportSpecifier {
 
     class ContinueStatement : public Statement {
     public:
+        CleanupList cleanups;
+
         ContinueStatement(SourceLocation loc);
         virtual ~ContinueStatement();
         NodeType getType() const override;
@@ -0,0 +1,72 @@
+#ifndef VYN_AST_WALKER_HPP
+#define VYN_AST_WALKER_HPP
+
+#include "vyn/ast.hpp"
+
+namespace vyn {
+
+// Visitor with a default implementation for every node that simply visits the
+// node's children in source order. Analysis passes derive from it and
+// override only the nodes they care about, calling the base method to keep
+// descending.
+class AstWalker : public Visitor {
+public:
+    // Visits `node` if it is non-null
+    void walk(Node* node) {
+        if (node) node->accept(*this);
+    }
+
+    // Literals
+    void visit(Identifier* node) override;
+    void visit(IntegerLiteral* node) override;
+    void visit(FloatLiteral* node) override;
+    void visit(StringLiteral* node) override;
+    void visit(BooleanLiteral* node) override;
+    void visit(ObjectLiteral* node) override;
+    void visit(NilLiteral* node) override;
+
+    // Expressions
+    void visit(UnaryExpression* node) override;
+    void visit(BinaryExpression* node) override;
+    void visit(CallExpression* node) override;
+    void visit(MemberExpression* node) override;
+    void visit(AssignmentExpression* node) override;
+    void visit(ArrayLiteralNode* node) override;
+    void visit(BorrowExprNode* node) override;
+
+    // Statements
+    void visit(BlockStatement* node) override;
+    void visit(ExpressionStatement* node) override;
+    void visit(IfStatement* node) override;
+    void visit(ForStatement* node) override;
+    void visit(WhileStatement* node) override;
+    void visit(ReturnStatement* node) override;
+    void visit(BreakStatement* node) override;
+    void visit(ContinueStatement* node) override;
+    void visit(TryStatement* node) override;
+    void visit(ScopedStatement* node) override;
+    void visit(DeferStatement* node) override;
+    void visit(ClosureExpression* node) override;
+
+    // Declarations
+    void visit(VariableDeclaration* node) override;
+    void visit(FunctionDeclaration* node) override;
+    void visit(TypeAliasDeclaration* node) override;
+    void visit(ImportDeclaration* node) override;
+    void visit(StructDeclaration* node) override;
+    void visit(ClassDeclaration* node) override;
+    void visit(FieldDeclaration* node) override;
+    void visit(ImplDeclaration* node) override;
+    void visit(EnumDeclaration* node) override;
+    void visit(EnumVariantNode* node) override;
+    void visit(GenericParamNode* node) override;
+
+    // Other
+    void visit(TypeNode* node) override;
+    void visit(Module* node) override;
+    void visit(TemplateDeclarationNode* node) override;
+};
+
+} // namespace vyn
+
+#endif // VYN_AST_WALKER_HPP
@@ -0,0 +1,78 @@
+#ifndef VYN_BOUNDS_CHECK_HPP
+#define VYN_BOUNDS_CHECK_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+struct BoundsCheckReport {
+    size_t indexSites = 0;    // `s[i]` accesses seen (range subscripts excluded)
+    size_t eliminated = 0;    // sites proven in bounds
+    size_t hoisted = 0;       // sites covered by a check before their loop
+    size_t hoistedChecks = 0; // checks placed before loops
+
+    size_t remaining() const { return indexSites - eliminated - hoisted; }
+};
+
+// Removes or hoists the bounds checks of `s[i]` inside `for (i in lo..hi)`
+// loops.
+//
+// A site qualifies when `s` is a variable, `i` is the induction variable of
+// an enclosing loop, `lo` is a non-negative integer literal, and the loop body
+// neither assigns `s` or `i` nor calls a method on `s` that could shrink it.
+// Then:
+//   - if `hi` is the length of `s` (`s.len()`, `s.length` or `len(s)`), the
+//     access is always in bounds and its check is ELIMINATED;
+//   - if `hi` is a literal, a variable the body does not assign, or the
+//     length of such a variable, and the access runs on every iteration (it
+//     is not under an if, an inner loop, a closure or the right side of
+//     `&&`, and the body has no break, continue, return or throw), the check
+//     is HOISTED: one `hi <= len(s)` check before the loop covers every
+//     iteration, recorded in ForStatement::hoistedBoundsChecks. An access
+//     that only some iterations reach would make that check reject valid
+//     programs. The body must also make no calls but length queries: the
+//     hoisted check panics before the first iteration, so output the
+//     iterations before the bad access would have printed must not exist.
+// Everything else stays CHECKED.
+class BoundsCheckElimination : public AstWalker {
+public:
+    BoundsCheckReport run(Module* module);
+
+    using AstWalker::visit;
+    void visit(ForStatement* node) override;
+    void visit(MemberExpression* node) override;
+
+    // Code that runs on some iterations only
+    void visit(IfStatement* node) override;
+    void visit(WhileStatement* node) override;
+    void visit(TryStatement* node) override;
+    void visit(DeferStatement* node) override;
+    void visit(ClosureExpression* node) override;
+    void visit(BinaryExpression* node) override;
+
+private:
+    struct Loop {
+        ForStatement* node;
+        std::string induction;
+        Expression* upper;
+        std::unordered_set<std::string> mutated; // names assigned, redeclared or mutated in the body
+        size_t conditional;                      // conditional_ at the top of the body
+        bool exits;                              // the body can leave an iteration early
+        bool effects;                            // the body calls something that may print
+    };
+
+    std::vector<Loop> loops_;
+    size_t conditional_ = 0; // how deep the walk is inside conditionally run code
+    BoundsCheckReport report_;
+
+    const Loop* enclosing_loop(const std::string& induction) const;
+};
+
+} // namespace vyn
+
+#endif // VYN_BOUNDS_CHECK_HPP
@@ -0,0 +1,173 @@
+#ifndef VYN_BYTECODE_HPP
+#define VYN_BYTECODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vyn/ast.hpp"
+
+namespace vyn {
+
+// The interpreter tier of TieredEngine (vyn/tiered.hpp) runs functions as
+// register bytecode. Every local and temporary has a register in the
+// frame; an instruction names its registers directly.
+enum class SlotKind : uint8_t { VOID, INT, FLOAT, BOOL };
+
+// One register. Each holds the kind the compiler gave it; Bool is 0 or 1 in i.
+union Slot {
+    int64_t i;
+    double f;
+};
+
+enum class Op : uint8_t {
+    LOAD_CONST,     // a = constants[b]
+    MOVE,           // a = b
+    ADD, SUB, MUL, DIV, MOD, // a = b op c, Int (wrapping)
+    FADD, FSUB, FMUL, FDIV,  // a = b op c, Float
+    BIT_AND, BIT_OR, BIT_XOR, SHL, SHR,
+    EQ, NE, LT, LE,          // a = b op c on Int or Bool; > and >= swap b and c
+    FEQ, FNE, FLT, FLE,
+    NEG, FNEG, NOT,          // a = op b
+    INC,                     // a = a + 1
+    INT_TO_FLOAT, FLOAT_TO_INT,
+    JUMP,           // pc = a
+    JUMP_IF_FALSE,  // if !b: pc = a
+    JUMP_IF_TRUE,   // if b: pc = a
+    LOOP,           // pc = a, a loop's back edge; b is the loop's index
+    CALL,           // a = functions[b](c, c + 1, ...)
+    RETURN,         // return a
+    RETURN_VOID,
+    PRINT,          // prints prints[b]
+    GET_GLOBAL,     // a = globals[b]
+    SET_GLOBAL,     // globals[a] = b
+};
+
+struct Instruction {
+    Op op;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+};
+
+struct PrintItem {
+    SlotKind kind; // VOID: a string literal
+    uint32_t reg = 0;
+    std::string text;
+};
+
+struct PrintSpec {
+    std::vector<PrintItem> items;
+    bool newline;
+};
+
+// Where a frame keeps its variables at a loop's back edge, so on-stack
+// replacement can move it into native code there (CBackend::OsrEntry)
+struct BytecodeLoop {
+    Statement* node; // the WhileStatement or ForStatement
+    std::vector<std::pair<std::string, uint32_t>> variables; // in scope at the head
+    std::vector<std::pair<ForStatement*, uint32_t>> bounds;  // the ends of this and the enclosing for loops
+    bool shadowed = false; // a variable in scope hides another, which the native copy could not restore
+};
+
+struct BytecodeFunction {
+    std::string name;
+    FunctionDeclaration* decl = nullptr; // null for the top-level statements of REPL input
+    std::vector<SlotKind> params; // in registers 0..n-1
+    SlotKind result = SlotKind::VOID;
+    std::vector<Instruction> code;
+    std::vector<Slot> constants;
+    std::vector<PrintSpec> prints;
+    uint32_t registers = 0; // frame size
+    std::vector<BytecodeLoop> loops; // by the index in LOOP's b
+};
+
+struct BytecodeModule {
+    std::vector<BytecodeFunction> functions;
+    std::unordered_map<std::string, uint32_t> byName;
+    std::vector<SlotKind> globals; // top-level variables of REPL input
+    std::unordered_map<std::string, uint32_t> globalsByName;
+    std::optional<uint32_t> script; // the function every REPL input's statements replace
+};
+
+// What BytecodeCompiler::add compiled from one REPL input
+struct BytecodeInput {
+    std::vector<std::string> functions; // defined or redefined
+    uint32_t script;                    // the function running the input's top-level statements
+};
+
+// Compiles the top-level functions of a module to bytecode.
+//
+// The bytecode tier covers the scalar core of the language: functions whose
+// parameters, locals and results are Int, Float or Bool, with if, while,
+// `for (i in a..b)`, break, continue, return, calls and print/println.
+// Anything else is a std::runtime_error naming the construct and its
+// location. Run DeferLowering first if the module uses defer.
+class BytecodeCompiler {
+public:
+    BytecodeModule run(Module* module);
+
+    // Adds one input of a REPL session to `session`, compiling only what it
+    // defines. Functions are added; one with the name of an earlier function
+    // replaces its body in place, so earlier callers get the new body, and
+    // must keep its signature. The other top-level statements are compiled,
+    // in order, into a function without parameters, where `var` declares
+    // (or, with the same type, sets) a global that later input can use. If
+    // the last statement is an expression with a value, that function
+    // returns it. Each input's statements replace the last input's in one
+    // slot, `session.script`, so a session does not grow a function per
+    // input. On error `session` is unchanged.
+    BytecodeInput add(BytecodeModule& session, Module* input);
+
+    struct Operand {
+        uint32_t reg;
+        SlotKind kind;
+    };
+
+private:
+    struct Loop {
+        std::vector<size_t> breaks;
+        std::vector<size_t> continues;
+        ForStatement* node = nullptr; // a for loop, whose bound is in register `end`
+        uint32_t end = 0;
+    };
+
+    BytecodeModule* module_ = nullptr;
+    BytecodeFunction* fn_ = nullptr;
+    std::vector<std::unordered_map<std::string, Operand>> scopes_;
+    std::vector<Loop> loops_;
+    uint32_t next_ = 0; // first free register
+
+    BytecodeFunction signature(FunctionDeclaration* decl);
+    SlotKind resolve(TypeNode* node);
+    const Operand* lookup(const std::string& name) const;
+    uint32_t temp();
+    size_t emit(Op op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    void patch(size_t at, size_t target) { fn_->code[at].a = static_cast<uint32_t>(target); }
+    size_t here() const { return fn_->code.size(); }
+    uint32_t constant(Slot value);
+    uint32_t beginLoop(Statement* node);
+
+    void compileFunction(BytecodeFunction& fn);
+    void compileScript(BytecodeFunction& fn, const std::vector<Statement*>& statements);
+    void compileGlobal(VariableDeclaration* node);
+    void compileStatement(Statement* node);
+    void compileBlock(BlockStatement* node);
+    void compileBody(Statement* node);
+    void compileCleanups(const CleanupList& cleanups);
+    void compileFor(ForStatement* node);
+
+    Operand compileExpression(Expression* node, int64_t hint = -1);
+    void compileInto(Expression* node, uint32_t dest, SlotKind kind);
+    Operand convert(Operand value, SlotKind kind, Node* node, int64_t hint = -1);
+    Operand compileBinary(BinaryExpression* node, int64_t hint);
+    Operand compileCall(CallExpression* node, int64_t hint);
+};
+
+} // namespace vyn
+
+#endif // VYN_BYTECODE_HPP
@@ -0,0 +1,209 @@
+#ifndef VYN_C_BACKEND_HPP
+#define VYN_C_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vyn/ast.hpp"
+
+namespace vyn {
+
+struct CBackendReport {
+    size_t structs = 0;
+    size_t functions = 0;     // including methods
+    size_t droppedTypes = 0;  // structs that own memory and get a generated drop function
+    size_t boundsChecks = 0;  // indexing sites still checked (MemberExpression::boundsCheck)
+};
+
+// Lowers a typed module to one portable C11 translation unit, which
+// compile() hands to the system C compiler.
+//
+// The supported subset is the monomorphic core of the language: structs
+// and classes (fields and methods), impl blocks, functions, Int/UInt/
+// i32/u32/Float/f32/Bool, string literals, `my<T>`, `their<T>`/`ptr<T>`
+// and fixed arrays `[T; N]`. Parameters, fields and return values need
+// type annotations; locals are typed from their initializer. `throw` and
+// try/catch/finally are lowered as ErrorLowering describes. Anything else
+// (generics, our<T>, slices, closures, async) is a std::runtime_error
+// naming the construct and its location.
+//
+// Lowering:
+//   - a struct becomes a C struct with its fields in declaration order, a
+//     fixed array an inline C array;
+//   - my<T> is an owning `T*`. make_my(v) allocates, and every owner is
+//     dropped where it goes out of scope (end of block, return, break,
+//     continue, after the DeferLowering cleanups of that exit); structs
+//     that own memory get a generated drop function. Using an owner as a
+//     value (initializer, assignment, argument, return) moves it and
+//     leaves the source null; assigning to an owner drops the old value;
+//   - their<T>, ptr<T> and `borrow`/`view` are plain pointers; a struct
+//     argument is borrowed implicitly where a their<T> is expected;
+//   - methods take `self` as a pointer: obj.m(x) calls Type_m(&obj, x);
+//   - indexing keeps a bounds check unless the index is a constant in
+//     range or BoundsCheckElimination removed or hoisted it;
+//   - integer + - * and << wrap, / and % by zero panic, and shift counts
+//     are taken modulo the width, as in the bytecode tier: they go through
+//     unsigned C arithmetic and the prelude's vyn_div/vyn_mod/vyn_shl, so
+//     no signed overflow is left undefined;
+//   - a function that can fail (FunctionDeclaration::canFail) returns a
+//     C bool, true if it failed, and its value through a trailing
+//     `vyn_result` pointer. `throw Name` or `throw Name(code)` stores the
+//     error's type and Int code in the vyn_error_* globals. Each error
+//     edge runs its cleanup list, drops the owners it leaves, and jumps
+//     to its try's catch clauses or returns true. A catch clause tests the
+//     stored type, and `catch (e)` binds the code to e;
+//   - operands and arguments are evaluated left to right, as in the other
+//     tiers: a call with a result goes into a temporary before its
+//     statement, and operands left of it are read into temporaries first.
+//     A while test that needs such statements becomes `while (true)` with
+//     the test inside, an else-if test an else block, and the right side
+//     of && and || an if;
+//   - `fn main() -> Int` becomes the exit status of the C main, unless
+//     `entryPoint` is false (a library, as TieredEngine builds); an error
+//     that leaves main is a panic.
+// Run ErrorLowering first if the module throws, then DeferLowering if it
+// uses defer or finally.
+class CBackend {
+public:
+    // A second copy of a function that starts at the head of one of its
+    // loops, for on-stack replacement (TieredEngine):
+    // `static RESULT symbol(const int64_t* vyn_slots)` sets the variables
+    // in scope there from 8-byte slots, then runs the loop and the rest of
+    // the function. Only Int, Float and Bool variables can be set.
+    struct OsrEntry {
+        FunctionDeclaration* function;
+        Statement* loop; // a WhileStatement or ForStatement of function
+        std::string symbol;
+        std::vector<std::pair<std::string, uint32_t>> variables; // name, slot
+        std::vector<std::pair<ForStatement*, uint32_t>> bounds;  // the ends of this and enclosing for loops
+    };
+
+    std::string run(Module* module, bool entryPoint = true, const std::vector<OsrEntry>& osr = {});
+    const CBackendReport& report() const { return report_; }
+
+    // Compiles C source to an executable with `compiler -std=c11 -O2`, or a
+    // shared object for dlopen with `shared`. The source is written next to
+    // the output, as `executable`.c. The compiler is spawned with an
+    // argument vector, not through a shell, so `compiler` is one program
+    // and paths may hold any character. Throws std::runtime_error with the
+    // compiler's output if it fails.
+    static void compile(const std::string& source, const std::string& executable, const std::string& compiler = "cc",
+                        bool shared = false);
+
+    struct Type {
+        enum class Kind { VOID, NIL, INT, UINT, I32, U32, FLOAT, F32, BOOL, STRING, STRUCT, OWNED, BORROWED, ARRAY };
+        Kind kind = Kind::VOID;
+        std::string name;                    // STRUCT
+        std::shared_ptr<const Type> element; // OWNED, BORROWED: the pointee; ARRAY: the element
+        int64_t length = 0;                  // ARRAY
+    };
+
+    struct Value {
+        std::string code;
+        Type type;
+        bool lvalue = false;
+    };
+
+private:
+    struct Record {
+        std::string name;
+        Declaration* decl;
+        std::vector<FieldDeclaration*> fieldDecls;
+        std::vector<std::pair<std::string, Type>> fields;
+        bool owns = false; // needs a drop function
+    };
+
+    struct Function {
+        std::string cname;
+        FunctionDeclaration* decl;
+        std::string owner;   // the struct of a method
+        bool hasSelf = false;
+        std::vector<Type> params; // excluding self
+        Type result;
+    };
+
+    struct Scope {
+        bool loop;
+        std::unordered_map<std::string, Type> variables;
+        std::vector<std::pair<std::string, Type>> owners; // dropped in reverse at exit
+        std::unordered_map<std::string, std::string> errors; // catch variables: the C expression of their type
+    };
+    struct Handler {
+        std::string label;  // the catch clauses
+        size_t scopes;      // scopes_.size() outside the try block
+        bool used;          // some error edge branches to it
+    };
+
+    std::vector<Record> records_;
+    std::unordered_map<std::string, size_t> recordsByName_;
+    std::vector<Function> functions_;
+    std::unordered_map<std::string, size_t> functionsByName_;
+    std::unordered_map<std::string, size_t> methods_; // "Type.method"
+    std::vector<Scope> scopes_;
+    const Function* current_ = nullptr;
+    const OsrEntry* osr_ = nullptr; // the entry current_ is emitted for, if any
+    std::unordered_map<Statement*, std::string> ends_; // the C variable holding each for loop's bound
+    std::unordered_map<TryStatement*, Handler> handlers_; // trys whose try block is being emitted
+    std::unordered_map<std::string, uint32_t> errorTypes_; // error type name to the id stored in vyn_error_type
+    std::string out_;
+    int indent_ = 0;
+    size_t temps_ = 0;
+    CBackendReport report_;
+
+    void collect(Module* module);
+    void addFunction(FunctionDeclaration* decl, const std::string& owner);
+    std::vector<size_t> orderRecords();
+    Type resolve(TypeNode* node, const std::string& self);
+    bool owns(const Type& type) const;
+    const Function* method(const std::string& type, const std::string& name) const;
+
+    std::string ctype(const Type& type) const;
+    std::string declare(const Type& type, const std::string& name) const;
+    std::string signature(const Function& fn) const;
+
+    void line(const std::string& text);
+    void emitRecord(const Record& record);
+    void emitHelpers(const Record& record);
+    void emitFunction(const Function& fn, const OsrEntry* osr = nullptr);
+    void emitOsrRestore();
+    void emitStatement(Statement* node);
+    void emitBlock(BlockStatement* node, bool loop = false);
+    void emitAssignment(AssignmentExpression* node);
+    void emitDrop(const std::string& place, const Type& type, int depth = 0);
+    void emitCleanups(const CleanupList& cleanups);
+    void emitTry(TryStatement* node);
+    void emitThrow(CallExpression* node);
+    void emitErrorEdge(Node* node, const ErrorEdge& edge, const CleanupList& cleanups);
+    uint32_t errorType(const std::string& name);
+    void emitScopeExit(size_t scopes);
+    size_t scopesToLoop() const;
+    void declareVariable(const std::string& name, const Type& type);
+    const Type* lookup(const std::string& name) const;
+
+    // An operand or argument emitted before out_.size() was `end`
+    struct Operand {
+        std::string code;
+        Type type; // what a temporary holding it is declared as
+        Expression* node;
+        size_t end;
+    };
+    void sequence(std::vector<Operand>& operands);
+
+    Value emitExpression(Expression* node);
+    Value emitMove(Expression* node);
+    Value emitInitializer(Expression* node, const Type& type);
+    Value emitCall(CallExpression* node);
+    std::vector<std::string> emitArguments(CallExpression* node, const Function& fn, size_t first);
+    Value emitInvoke(CallExpression* node, const Function& fn, std::vector<std::string> args);
+    Value emitPrint(CallExpression* node, bool newline);
+    Value emitStructLiteral(CallExpression* node, const Record& record);
+};
+
+} // namespace vyn
+
+#endif // VYN_C_BACKEND_HPP
@@ -0,0 +1,67 @@
+#ifndef VYN_CLOSURE_CONVERSION_HPP
+#define VYN_CLOSURE_CONVERSION_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+struct ClosureReport {
+    size_t closures = 0;
+    size_t byValue = 0;
+    size_t byReference = 0;
+    size_t emptyClosures = 0; // capture nothing; need no allocation
+    size_t largestEnv = 0;    // bytes
+};
+
+// Computes the flat environment of every closure (vre/closure.hpp).
+//
+// A closure captures each variable of an enclosing function or closure that
+// its body uses, including uses in closures nested inside it, which then
+// capture from its environment. Functions, globals and names bound inside
+// the body are not captured. A variable declared their<T>, or bound to a
+// `borrow`/`view` expression, is captured by reference: the environment
+// holds the 8-byte reference. Anything else is copied in by value, sized
+// from its annotation or initializer like a coroutine slot (Int/Float 8
+// bytes, Bool 1, String a VreString, otherwise a VreValue); assignments in
+// the body change that copy. Slots are packed by decreasing alignment.
+// Results are recorded in ClosureExpression::layout.
+class ClosureConversion : public AstWalker {
+public:
+    ClosureReport run(Module* module);
+
+    using AstWalker::visit;
+    void visit(FunctionDeclaration* node) override;
+    void visit(ClosureExpression* node) override;
+    void visit(BlockStatement* node) override;
+    void visit(VariableDeclaration* node) override;
+    void visit(ForStatement* node) override;
+    void visit(TryStatement* node) override;
+
+    struct Variable {
+        TypeNode* type;
+        Expression* init;
+    };
+
+private:
+    // Innermost last. A function scope starts a new chain: names of outer
+    // functions are not visible to it.
+    struct Scope {
+        bool function;
+        std::unordered_map<std::string, Variable> variables;
+    };
+
+    std::vector<Scope> scopes_;
+    ClosureReport report_;
+
+    const Variable* lookup(const std::string& name) const;
+    void declareParams(const std::vector<FunctionParameter>& params);
+};
+
+} // namespace vyn
+
+#endif // VYN_CLOSURE_CONVERSION_HPP
@@ -0,0 +1,21 @@
+#ifndef VYN_CONTROL_FLOW_HPP
+#define VYN_CONTROL_FLOW_HPP
+
+#include <vector>
+
+#include "vyn/ast.hpp"
+
+namespace vyn {
+
+// Control never falls off the end of a block ending in one of these, so a
+// backend emits no exit cleanups after it
+inline bool ends_in_jump(const std::vector<StmtPtr>& body) {
+    if (body.empty()) return false;
+    NodeType type = body.back()->getType();
+    return type == NodeType::RETURN_STATEMENT || type == NodeType::BREAK_STATEMENT ||
+           type == NodeType::CONTINUE_STATEMENT;
+}
+
+} // namespace vyn
+
+#endif // VYN_CONTROL_FLOW_HPP
@@ -0,0 +1,61 @@
+#ifndef VYN_COROUTINE_LOWERING_HPP
+#define VYN_COROUTINE_LOWERING_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+struct CoroutineReport {
+    size_t asyncFunctions = 0;
+    size_t awaitPoints = 0;
+    size_t parameters = 0;      // always in the frame: the caller passes arguments there
+    size_t spilledLocals = 0;   // locals live across an await, given a frame slot
+    size_t unspilledLocals = 0; // locals that stay in resume()'s own stack frame
+    size_t boxedAwaits = 0;     // awaits whose callee frame is allocated separately
+};
+
+// Lowers every `async fn` to a stackless state machine over a VreCoroutine
+// frame (vre/coroutine.hpp).
+//
+// Each `await` becomes a resume state, numbered in source order and recorded
+// in CallExpression::awaitState. Parameters always get a frame slot, since
+// the caller stores the arguments there before the first poll. A local gets
+// one only if it is live across some await: defined before it and used after
+// it, where a variable defined outside a loop and used inside counts as used
+// at the end of the loop. Every other local lives in resume()'s ordinary
+// stack frame.
+// Slots are sized from the type annotation, or the initializer when there is
+// none (Int/Float 8 bytes, Bool 1, String a VreString, anything else a
+// VreValue), and packed by decreasing alignment.
+//
+// The frame ends in a single await area sized for the largest async fn it
+// awaits, so the callee frame is built in place and an await allocates
+// nothing. A callee that is recursive with the caller, or not an async fn of
+// this module, cannot be sized and is boxed: the area holds a pointer to a
+// separately allocated frame. Results are recorded in
+// FunctionDeclaration::coroutine.
+class CoroutineLowering : public AstWalker {
+public:
+    CoroutineReport run(Module* module);
+
+    using AstWalker::visit;
+    void visit(FunctionDeclaration* node) override;
+
+private:
+    std::unordered_map<std::string, FunctionDeclaration*> asyncFunctions_;
+    std::vector<FunctionDeclaration*> order_; // every async fn, in source order
+    std::unordered_set<FunctionDeclaration*> inProgress_;
+    CoroutineReport report_;
+
+    void lower(FunctionDeclaration* fn);
+};
+
+} // namespace vyn
+
+#endif // VYN_COROUTINE_LOWERING_HPP
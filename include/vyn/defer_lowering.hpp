@@ -0,0 +1,79 @@
+#ifndef VYN_DEFER_LOWERING_HPP
+#define VYN_DEFER_LOWERING_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+struct DeferReport {
+    size_t defers = 0;
+    size_t exits = 0;           // scope exits with cleanup code to inline
+    size_t inlinedCleanups = 0; // statements copied into those exits, in total
+};
+
+// Lowers `defer` to cleanup code placed at every exit of its block, so that
+// nothing is registered at run time.
+//
+// Which defers are pending at a given point is known statically: those of
+// the enclosing blocks that come before it. Every exit therefore gets a
+// CleanupList, the pending defers of each scope it leaves, innermost block
+// first and newest defer first:
+//   - falling off the end of a block runs that block's own defers
+//     (BlockStatement::exitCleanups);
+//   - return leaves every scope of the function, break and continue those
+//     inside the innermost loop (ReturnStatement::cleanups etc.);
+//   - an error edge (set by ErrorLowering, which must run first) leaves
+//     the scopes inside the try block that catches it, or all of them
+//     (CallExpression::errorCleanups, TryStatement::unmatchedCleanups).
+// A try with a finally block acts as a scope whose single defer is the
+// finally block, so cleanups and finally blocks interleave correctly.
+//
+// A deferred statement runs while its block is already exiting, so it may
+// not return, or throw, break or continue out of itself; run() throws
+// std::runtime_error for those.
+class DeferLowering : public AstWalker {
+public:
+    DeferReport run(Module* module);
+
+    using AstWalker::visit;
+    void visit(FunctionDeclaration* node) override;
+    void visit(BlockStatement* node) override;
+    void visit(DeferStatement* node) override;
+    void visit(TryStatement* node) override;
+    void visit(ForStatement* node) override;
+    void visit(WhileStatement* node) override;
+    void visit(ReturnStatement* node) override;
+    void visit(BreakStatement* node) override;
+    void visit(ContinueStatement* node) override;
+    void visit(CallExpression* node) override;
+
+private:
+    enum class ScopeKind {
+        FUNCTION,
+        BLOCK,
+        FINALLY, // the try block and catch clauses of a try with a finally block
+        HANDLER, // the try block of a try with catch clauses
+        LOOP,    // a loop body
+        DEFER    // a deferred statement
+    };
+    struct Scope {
+        ScopeKind kind;
+        CleanupList pending; // in registration order
+    };
+
+    std::vector<Scope> scopes_; // innermost last
+    DeferReport report_;
+
+    // Cleanups of the scopes inside the innermost `boundary`
+    CleanupList unwind_to(ScopeKind boundary) const;
+    CleanupList error_cleanups(const ErrorEdge& edge) const;
+    bool inside_defer(ScopeKind boundary) const; // a DEFER scope comes before `boundary`
+    void exit(CleanupList& slot, CleanupList cleanups);
+};
+
+} // namespace vyn
+
+#endif // VYN_DEFER_LOWERING_HPP
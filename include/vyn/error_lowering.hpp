@@ -0,0 +1,52 @@
+#ifndef VYN_ERROR_LOWERING_HPP
+#define VYN_ERROR_LOWERING_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+struct ErrorLoweringReport {
+    size_t failingFunctions = 0; // lowered to return a VreResult
+    size_t throwSites = 0;
+    size_t checkedCalls = 0;     // calls to failing functions, each followed by a branch on error
+    size_t uncheckedCalls = 0;   // calls that cannot fail: no check at all
+    size_t handledSites = 0;     // throws and checked calls caught in their own function
+    size_t cleanupEdges = 0;     // error edges that run at least one finally block
+};
+
+// Lowers `throw` and try/catch/finally to explicit error values instead of
+// unwinding (vre/result.hpp).
+//
+// A function can fail if it declares `throws E`, or if a `throw` or a call
+// to a function that can fail is not caught inside it by a catch-all clause;
+// this is computed to a fixed point over the module and recorded in
+// FunctionDeclaration::canFail. Such a function returns its value with a
+// failed flag: a VreResult in the runtime, a bool return in CBackend.
+//
+// Every `_throw` and every call to a failing function gets an ErrorEdge:
+// HANDLER if it sits in the try block of a try with catch clauses, else
+// RETURN, plus the number of finally blocks to run on the way there (those
+// of enclosing try/finally statements, and of a try whose catch clause the
+// site is in). A try whose clauses all name a type also gets an edge for
+// errors that match none of them. Calls to functions that cannot fail, and
+// to anything not declared in the module, get no check.
+class ErrorLowering : public AstWalker {
+public:
+    ErrorLoweringReport run(Module* module);
+
+    using AstWalker::visit;
+    void visit(FunctionDeclaration* node) override;
+
+private:
+    std::unordered_map<std::string, std::vector<FunctionDeclaration*>> functions_;
+    std::vector<FunctionDeclaration*> order_; // every fn, in source order
+};
+
+} // namespace vyn
+
+#endif // VYN_ERROR_LOWERING_HPP
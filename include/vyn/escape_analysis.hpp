@@ -0,0 +1,62 @@
+#ifndef VYN_ESCAPE_ANALYSIS_HPP
+#define VYN_ESCAPE_ANALYSIS_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+// A variable declared inside a `scoped` block whose value leaves the block.
+struct EscapeDiagnostic {
+    std::string name;      // the escaping variable
+    SourceLocation loc;    // where it escapes
+    std::string reason;    // "returned" or "stored into 'outer'"
+};
+
+// Finds values allocated in a `scoped` block region that outlive the block.
+//
+// Each variable is tagged with the number of scoped blocks enclosing its
+// declaration (its region depth, counted per function). A value escapes when
+// a variable is returned from inside a scoped block, or is assigned into a
+// variable, or a field of one, that has a shallower region depth. Values flow
+// through identifiers, array and object literals, and struct literals. Call
+// results are assumed to be fresh.
+//
+// Escaping names are recorded on the ScopedStatement that owns the variable
+// so that code generation can allocate them outside the region (promotion);
+// the runtime still checks stores with vre::check_region_store.
+class EscapeAnalysis : public AstWalker {
+public:
+    std::vector<EscapeDiagnostic> analyze(Module* module);
+
+    using AstWalker::visit;
+    void visit(FunctionDeclaration* node) override;
+    void visit(BlockStatement* node) override;
+    void visit(ScopedStatement* node) override;
+    void visit(VariableDeclaration* node) override;
+    void visit(ReturnStatement* node) override;
+    void visit(AssignmentExpression* node) override;
+    void visit(ForStatement* node) override;
+
+private:
+    struct Binding {
+        int regionDepth;
+        ScopedStatement* owner; // innermost scoped block at declaration, or nullptr
+    };
+
+    std::vector<std::unordered_map<std::string, Binding>> scopes_;
+    std::vector<ScopedStatement*> regions_; // enclosing scoped blocks in the current function
+    std::vector<EscapeDiagnostic> diagnostics_;
+
+    void declare(const std::string& name);
+    const Binding* lookup(const std::string& name) const;
+    void collect_flowing_names(Expression* expr, std::vector<std::string>& out) const;
+    void report(const std::string& name, const Binding& binding, SourceLocation loc, const std::string& reason);
+};
+
+} // namespace vyn
+
+#endif // VYN_ESCAPE_ANALYSIS_HPP
@@ -0,0 +1,189 @@
+#ifndef VYN_LLVM_IR_HPP
+#define VYN_LLVM_IR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vyn/ast.hpp"
+
+namespace vyn {
+
+struct LlvmIrReport {
+    size_t structs = 0;
+    size_t functions = 0;     // including methods
+    size_t allocas = 0;       // locals and temporaries, all in entry blocks
+    size_t switches = 0;      // if/else-if chains lowered to `switch`
+    size_t noaliasParams = 0; // their<T> parameters and selfs proven exclusive
+    size_t boundsChecks = 0;  // indexing sites still checked (MemberExpression::boundsCheck)
+};
+
+// Writes a typed module as textual LLVM IR (a `.ll` file), so the LLVM
+// optimizer and code generator can be used without linking LLVM.
+//
+// The supported subset is the C backend's minus ownership: structs and
+// classes, impl blocks, functions, Int/UInt/i32/u32/Float/f32/Bool, string
+// literals, `their<T>`/`ptr<T>` and fixed arrays `[T; N]`. my<T> needs the
+// drop lowering only CBackend has so far; it, and everything CBackend
+// rejects, is a std::runtime_error naming the construct and its location.
+//
+// Lowering:
+//   - Int/UInt are i64, i32/u32 i32, Float double, f32 float, Bool i1;
+//     a struct is a named `%struct.T`, a fixed array `[N x T]`, pointers
+//     and strings are opaque `ptr`;
+//   - every local and parameter lives in an alloca in the entry block and
+//     is only loaded and stored, the shape mem2reg promotes to SSA;
+//   - a their<T> parameter or `self` is `noalias` only when exclusivity is
+//     evident from the signature: it is the one parameter holding a
+//     pointer and its struct holds none. Callers may pass one value to
+//     two borrows, as in f(p, p). ptr<T> parameters never are;
+//   - structs are passed `byval` and returned through `sret`;
+//   - an if/else-if chain comparing one integer variable with distinct
+//     constants (what `match` on integers lowers to) becomes a `switch`;
+//   - indexing keeps a bounds check, a branch to a cold panic block,
+//     unless the index is a constant in range or BoundsCheckElimination
+//     removed or hoisted it;
+//   - integer arithmetic wraps, / and % by zero branch to a cold panic
+//     block, MIN / -1 is MIN and MIN % -1 is 0, and shift counts are taken
+//     modulo the width, as in the C backend and the bytecode tier;
+//   - functions are `internal` and `fn main() -> Int` is wrapped in a C
+//     `main`. No target triple is set; tools default to the host.
+// Run DeferLowering first if the module uses defer.
+class LlvmIrEmitter {
+public:
+    std::string run(Module* module);
+    const LlvmIrReport& report() const { return report_; }
+
+    // Checks IR with `opt -verify`. The IR is written to `path`. Throws
+    // std::runtime_error with the tool's output if it is rejected.
+    static void verify(const std::string& ir, const std::string& path, const std::string& opt = "opt");
+
+    // Builds an executable with `opt -O2`, `llc -O2` and `compiler` as the
+    // linker. The IR is written next to the executable, as `executable`.ll.
+    // The tools are spawned with argument vectors, not through a shell, so
+    // paths may hold any character.
+    static void compile(const std::string& ir, const std::string& executable, const std::string& compiler = "cc");
+
+    struct Type {
+        enum class Kind { VOID, NIL, INT, UINT, I32, U32, FLOAT, F32, BOOL, STRING, STRUCT, BORROWED, POINTER, ARRAY };
+        Kind kind = Kind::VOID;
+        std::string name;                    // STRUCT
+        std::shared_ptr<const Type> element; // BORROWED, POINTER: the pointee; ARRAY: the element
+        int64_t length = 0;                  // ARRAY
+    };
+
+    // STRUCT and ARRAY values are always addresses; `lvalue` says whether
+    // the address is a variable's rather than a temporary's. For scalars,
+    // `lvalue` means `code` is an address to load from, else an operand.
+    struct Value {
+        std::string code;
+        Type type;
+        bool lvalue = false;
+        bool literal = false; // an integer constant that can take any integer type
+    };
+
+private:
+    struct Record {
+        std::string name;
+        Declaration* decl;
+        std::vector<FieldDeclaration*> fieldDecls;
+        std::vector<std::pair<std::string, Type>> fields;
+    };
+
+    struct Function {
+        std::string symbol;
+        FunctionDeclaration* decl;
+        std::string owner;   // the struct of a method
+        bool hasSelf = false;
+        std::vector<Type> params; // excluding self
+        Type result;
+    };
+
+    struct Variable {
+        Type type;
+        std::string address;
+    };
+
+    struct Loop {
+        std::string next;  // where continue goes
+        std::string exit;  // where break goes
+    };
+
+    std::vector<Record> records_;
+    std::unordered_map<std::string, size_t> recordsByName_;
+    std::vector<Function> functions_;
+    std::unordered_map<std::string, size_t> functionsByName_;
+    std::unordered_map<std::string, size_t> methods_; // "Type.method"
+    std::unordered_map<std::string, std::string> strings_; // contents -> global
+    std::string globals_;
+    std::vector<std::unordered_map<std::string, Variable>> scopes_;
+    std::vector<Loop> loops_;
+    std::unordered_map<std::string, size_t> names_; // allocas per variable name
+    const Function* current_ = nullptr;
+    std::string allocas_;
+    std::string body_;
+    std::string block_;       // the label of the current block
+    bool terminated_ = false; // the current block has its terminator
+    bool boundsFail_ = false;   // the current function branches to bounds.fail
+    bool divisionFail_ = false; // the current function branches to division.fail
+    size_t temps_ = 0;
+    size_t labels_ = 0;
+    LlvmIrReport report_;
+
+    void collect(Module* module);
+    void addFunction(FunctionDeclaration* decl, const std::string& owner);
+    std::vector<size_t> orderRecords();
+    Type resolve(TypeNode* node, const std::string& self);
+    const Function* method(const std::string& type, const std::string& name) const;
+    const Record& record(const std::string& name) const { return records_[recordsByName_.at(name)]; }
+
+    std::string ltype(const Type& type) const;
+    std::string signature(const Function& fn) const;
+    bool holdsPointer(const Type& type) const;
+    int noaliasParam(const Function& fn) const;
+    std::string global(const std::string& text);
+
+    std::string temp();
+    std::string label(const std::string& kind);
+    std::string stackSlot(const Type& type, const std::string& name = "");
+    void open();
+    void instr(const std::string& text);
+    void terminate(const std::string& text);
+    void begin(const std::string& label);
+
+    void emitFunction(const Function& fn);
+    void emitStatement(Statement* node);
+    void emitBlock(BlockStatement* node);
+    void emitBody(Statement* node);
+    void emitCleanups(const CleanupList& cleanups);
+    void emitIf(IfStatement* node);
+    bool emitSwitch(IfStatement* node);
+    void emitFor(ForStatement* node);
+    void emitReturn(ReturnStatement* node);
+    void emitBoundsCheck(const std::string& index, int64_t length, bool inclusive);
+    std::string emitDivisor(const std::string& dividend, const std::string& divisor, const Type& type);
+    void declareVariable(const std::string& name, const Type& type, const std::string& address);
+    const Variable* lookup(const std::string& name) const;
+
+    Value emitExpression(Expression* node);
+    void emitInto(Expression* node, const std::string& address, const Type& type);
+    void store(const Value& value, const std::string& address, const Type& type, Node* node);
+    void copy(const std::string& to, const std::string& from, const Type& type);
+    std::string rvalue(const Value& value);
+    std::string convert(const Value& value, const Type& to, Node* node);
+    Value emitBinary(BinaryExpression* node);
+    Value emitLogical(BinaryExpression* node);
+    Value emitMember(MemberExpression* node);
+    Value emitCall(CallExpression* node, const std::string* into = nullptr);
+    Value emitInvoke(CallExpression* node, const Function& fn, std::vector<std::string> args, size_t first,
+                     const std::string* into);
+    Value emitPrint(CallExpression* node, bool newline);
+    Value emitArrayLiteral(ArrayLiteralNode* node);
+};
+
+} // namespace vyn
+
+#endif // VYN_LLVM_IR_HPP
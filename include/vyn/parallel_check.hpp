@@ -0,0 +1,54 @@
+#ifndef VYN_PARALLEL_CHECK_HPP
+#define VYN_PARALLEL_CHECK_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+// A `@parallel` loop or comprehension whose iterations cannot run
+// independently.
+struct ParallelDiagnostic {
+    SourceLocation loc;
+    std::string reason; // e.g. "assigns 'total', which is shared between iterations"
+};
+
+// Checks that `@parallel for (i in a..b)` loops and `@parallel [e for i in
+// a..b]` comprehensions can run their iterations in any order on different
+// threads (vre/parallel.hpp).
+//
+// The iterable must be a range. A loop body may declare and assign its own
+// locals and store into `s[i]` of an outer `s`, where `i` is the induction
+// variable, since no two iterations share that element; it may then read `s`
+// only at `s[i]` (and its length). It may not assign an outer variable or
+// field, store at any other index, call a mutating method on an outer
+// variable (anything other than len/length/get), call a function that is
+// not pure (see pure()), leave the loop with break or return, or await. A
+// comprehension's element expression may not assign, await or call impure
+// functions at all.
+//
+// Each rejected loop or comprehension gets a diagnostic and is turned back
+// into its sequential form, so later passes never see an unsafe @parallel.
+class ParallelLoopCheck : public AstWalker {
+public:
+    std::vector<ParallelDiagnostic> check(Module* module);
+
+    using AstWalker::visit;
+    void visit(ForStatement* node) override;
+    void visit(CallExpression* node) override;
+
+private:
+    std::vector<ParallelDiagnostic> diagnostics_;
+    std::unordered_map<std::string, FunctionDeclaration*> functions_; // the module's top-level functions
+    std::unordered_map<std::string, bool> pure_;
+
+    bool pure(const std::string& function);
+};
+
+} // namespace vyn
+
+#endif // VYN_PARALLEL_CHECK_HPP
@@ -85,14 +85,23 @@ namespace vyn { // Changed Vyn to vyn
         // Constructor now takes a reference to a BaseParser instance (e.g., from TypeParser or another parent parser)
         ExpressionParser(BaseParser& parent_parser);
         vyn::ExprPtr parse();
+        // Closure bodies are statements; the Parser wires these up once it
+        // has constructed the other sub-parsers
+        void attach(TypeParser& type_parser, StatementParser& stmt_parser) {
+            type_parser_ = &type_parser;
+            stmt_parser_ = &stmt_parser;
+        }
 
     private:
         // Reference to the parent parser's token stream and methods
         BaseParser& parent_parser_ref_;
+        TypeParser* type_parser_ = nullptr;
+        StatementParser* stmt_parser_ = nullptr;
 
         // Helper methods to delegate to parent_parser_ref_ for token operations
         // This avoids direct access to tokens_, pos_ etc. and uses the parent's state.
         const vyn::token::Token& peek() const { return parent_parser_ref_.peek(); }
+        const vyn::token::Token& peekNext() const { return parent_parser_ref_.peekNext(); }
         vyn::token::Token consume() { return parent_parser_ref_.consume(); }
         vyn::token::Token expect(vyn::TokenType type) { return parent_parser_ref_.expect(type); }
         std::optional<vyn::token::Token> match(vyn::TokenType type) { return parent_parser_ref_.match(type); }
@@ -124,6 +133,7 @@ namespace vyn { // Changed Vyn to vyn
         vyn::ExprPtr parse_postfix_expr();
         vyn::ExprPtr parse_primary_expr();
         vyn::ExprPtr parse_atom(); 
+        vyn::ExprPtr parse_closure();
     };
 
     class TypeParser : public BaseParser {
@@ -157,6 +167,7 @@ namespace vyn { // Changed Vyn to vyn
         std::unique_ptr<vyn::WhileStatement> parse_while(); // Changed Vyn::AST::WhileStmtNode to vyn::WhileStatement
         std::unique_ptr<vyn::ForStatement> parse_for(); // Changed Vyn::AST::ForStmtNode to vyn::ForStatement
         std::unique_ptr<vyn::ReturnStatement> parse_return(); // Changed Vyn::AST::ReturnStmtNode to vyn::ReturnStatement
+        std::unique_ptr<vyn::ScopedStatement> parse_scoped();
         std::unique_ptr<vyn::BreakStatement> parse_break(); // Changed Vyn::AST::BreakStmtNode to vyn::BreakStatement
         std::unique_ptr<vyn::ContinueStatement> parse_continue(); // Changed Vyn::AST::ContinueStmtNode to vyn::ContinueStatement
         std::unique_ptr<vyn::VariableDeclaration> parse_var_decl(); // Changed Vyn::AST::VarDeclStmtNode to vyn::VariableDeclaration
@@ -0,0 +1,29 @@
+#ifndef VYN_PROCESS_HPP
+#define VYN_PROCESS_HPP
+
+#include <string>
+#include <vector>
+
+namespace vyn {
+
+struct ProgramRun {
+    int error = 0;       // errno if the program could not be started
+    bool exited = false; // it exited, with `status`, rather than being killed
+    int status = 0;
+    std::string output;  // its stdout and stderr, interleaved
+
+    bool succeeded() const { return error == 0 && exited && status == 0; }
+};
+
+// Runs args[0], looked up on PATH, with the argument vector `args` and
+// waits for it. It is spawned directly, not through a shell, so arguments
+// need no quoting. Its stdout and stderr go to `log_path`, which is read
+// back and removed.
+ProgramRun run_program(const std::vector<std::string>& args, const std::string& log_path);
+
+// The arguments joined by spaces, for messages
+std::string command_line(const std::vector<std::string>& args);
+
+} // namespace vyn
+
+#endif // VYN_PROCESS_HPP
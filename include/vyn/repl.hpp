@@ -0,0 +1,48 @@
+#ifndef VYN_REPL_HPP
+#define VYN_REPL_HPP
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vyn/ast.hpp"
+#include "vyn/tiered.hpp"
+
+namespace vyn {
+
+// An interactive session (`vyn_parser --repl`).
+//
+// Each input is lexed and parsed on its own, and only what it defines is
+// compiled (BytecodeCompiler::add) into the one session the inputs share:
+// functions, globals (top-level `var`) and the symbol table naming them
+// stay live, and earlier inputs are never run again. Redefining a function
+// replaces its body for every caller. Inputs run in the bytecode tier of a
+// TieredEngine, so the language is the tier's: Int, Float and Bool.
+class Repl {
+public:
+    // Evaluates one complete input. Returns the value of a trailing
+    // expression as print would show it, or "" if there is none. Lexing,
+    // parsing, compile and runtime errors are std::runtime_error; after a
+    // compile error the session is as before the input.
+    std::string eval(const std::string& input);
+
+    // Whether an input has all its brackets closed, outside string literals
+    // and comments. The loop reads more lines until it does.
+    static bool complete(const std::string& input);
+
+    // Reads inputs from `in` until the end or `:quit`, writing results and
+    // errors to `out`, with prompts if `prompt`.
+    void run(std::istream& in, std::ostream& out, bool prompt);
+
+    size_t inputs() const { return count_; }
+
+private:
+    TieredEngine engine_;
+    std::vector<std::unique_ptr<Module>> inputs_; // the bytecode points into them
+    size_t count_ = 0; // inputs read, for their names in errors
+};
+
+} // namespace vyn
+
+#endif // VYN_REPL_HPP
@@ -0,0 +1,132 @@
+#ifndef VYN_TIERED_HPP
+#define VYN_TIERED_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vyn/ast.hpp"
+#include "vyn/bytecode.hpp"
+#include "vyn/vre/value.hpp"
+
+namespace vyn {
+
+struct TierOptions {
+    uint64_t callThreshold = 1000;      // interpreted calls before a function is hot
+    uint64_t backEdgeThreshold = 10000; // interpreted loop iterations before it is hot
+    bool background = true;             // compile on a thread while the interpreter keeps running
+    std::string compiler = "cc";
+    size_t stackSlots = 1 << 20;        // registers of all interpreter frames together
+};
+
+struct TierReport {
+    size_t interpretedCalls = 0;
+    size_t nativeCalls = 0;   // entered from the interpreter or call(); calls inside native code are not seen
+    size_t backEdges = 0;     // loop iterations run by the interpreter
+    size_t osrEntries = 0;    // frames moved into native code at a loop's back edge
+    size_t tieredUp = 0;      // functions switched to native code
+    size_t compiles = 0;      // shared objects built
+    double compileMilliseconds = 0;
+    std::string compileError; // why there is no native tier, if there is none
+};
+
+enum class Tier { BYTECODE, NATIVE };
+
+// Runs a module in two tiers. Every function starts as bytecode (see
+// BytecodeCompiler) with a call counter and a loop back-edge counter; when
+// either crosses its threshold the module goes through CBackend into a
+// shared object, which is loaded with dlopen. From then on every call of a
+// hot function, including calls from frames already running in the
+// interpreter, goes to the native code: calls dispatch on the callee's tier
+// each time, so there is nothing to patch.
+//
+// A frame that is inside a loop when its function turns native moves at the
+// loop's next back edge (on-stack replacement): the object has a copy of the
+// function for each loop that starts at the loop's head, and takes the
+// frame's registers to set the variables in scope there. The rest of the
+// call runs natively. So a `main` that spends its time in one loop still
+// tiers up, through the back-edge counter. A loop where one variable
+// shadows another has no such entry and finishes in the interpreter.
+//
+// Both tiers compute the same results: CBackend gives integer arithmetic
+// the interpreter's wrapping, division and shift rules, and a division by
+// zero in native code comes back from its entry point and is thrown as the
+// same std::runtime_error the interpreter throws.
+//
+// The whole module is compiled once, so functions that become hot later
+// link against the same object without another compile. If the compiler
+// fails or is missing, everything keeps running as bytecode and
+// report().compileError says why.
+class TieredEngine {
+public:
+    explicit TieredEngine(TierOptions options = {});
+    ~TieredEngine();
+    TieredEngine(const TieredEngine&) = delete;
+    TieredEngine& operator=(const TieredEngine&) = delete;
+
+    // Compiles the module to bytecode; it must outlive the engine. Throws
+    // std::runtime_error for what the bytecode tier does not support. Run
+    // DeferLowering first if the module uses defer.
+    void load(Module* module);
+
+    // Calls a function with Int, Float or Bool arguments (an Int is accepted
+    // for a Float). A function without a result returns nil.
+    vre::VreValue call(const std::string& function, const std::vector<vre::VreValue>& args = {});
+
+    // Adds one input of a REPL session (BytecodeCompiler::add) and runs its
+    // top-level statements. Returns the value of a trailing expression, or
+    // nil. The input must outlive the engine. Functions added this way stay
+    // in the bytecode tier: a cc run per input would not be interactive.
+    vre::VreValue evaluate(Module* input);
+
+    Tier tier(const std::string& function) const;
+    const TierReport& report() const { return report_; }
+
+private:
+    using NativeEntry = const char* (*)(const void* args, void* result); // a panic's message, or null
+
+    enum class State : uint8_t { INTERPRETED, QUEUED, NATIVE, FAILED };
+
+    struct Function {
+        State state = State::INTERPRETED;
+        uint64_t calls = 0;
+        uint64_t backEdges = 0;
+        NativeEntry native = nullptr;
+        std::vector<NativeEntry> osr; // by loop index; null where there is no entry
+    };
+
+    TierOptions options_;
+    Module* module_ = nullptr;
+    BytecodeModule bytecode_;
+    std::vector<Function> functions_;
+    std::vector<Slot> stack_;
+    size_t top_ = 0;
+    std::vector<Slot> globals_;
+    bool session_ = false; // evaluate() was used
+    TierReport report_;
+
+    void* library_ = nullptr;
+    std::string libraryPath_;
+    std::thread compiler_;
+    bool compiling_ = false;
+    std::atomic<bool> ready_{false};
+    std::string buildError_;
+    double buildMilliseconds_ = 0;
+
+    Slot invoke(uint32_t index, const Slot* args);
+    Slot execute(uint32_t index, const Slot* args);
+    void print(const PrintSpec& spec, const Slot* registers) const;
+
+    void hot(uint32_t index);
+    std::string nativeSource();
+    void build(std::string source);
+    void poll();
+    void link();
+};
+
+} // namespace vyn
+
+#endif // VYN_TIERED_HPP
@@ -20,7 +20,7 @@ enum class TokenType {
     KEYWORD_NULL, KEYWORD_TRUE, KEYWORD_FALSE, KEYWORD_FN, KEYWORD_STRUCT,
     KEYWORD_ENUM, KEYWORD_TRAIT, KEYWORD_IMPL, KEYWORD_TYPE, KEYWORD_MODULE,
     KEYWORD_USE, KEYWORD_PUB, KEYWORD_MUT, KEYWORD_TRY, KEYWORD_CATCH,
-    KEYWORD_FINALLY, KEYWORD_DEFER, KEYWORD_MATCH, KEYWORD_SCOPED, KEYWORD_REF,
+    KEYWORD_FINALLY, KEYWORD_THROW, KEYWORD_DEFER, KEYWORD_MATCH, KEYWORD_SCOPED, KEYWORD_REF,
     KEYWORD_EXTERN, KEYWORD_AS, KEYWORD_IN, KEYWORD_CLASS, KEYWORD_TEMPLATE,
     KEYWORD_IMPORT, KEYWORD_SMUGGLE, KEYWORD_AWAIT, KEYWORD_ASYNC, KEYWORD_OPERATOR,
     KEYWORD_MY, KEYWORD_OUR, KEYWORD_THEIR, KEYWORD_PTR, // New ownership keywords
@@ -0,0 +1,67 @@
+#ifndef VYN_TYPE_TABLE_HPP
+#define VYN_TYPE_TABLE_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vyn/ast_walker.hpp"
+#include "vyn/vre/type_info.hpp"
+
+namespace vyn {
+
+// Builds the runtime type table of a module (vre/type_info.hpp) from its
+// struct and class declarations and its `impl Trait for Type` blocks.
+//
+// Every non-generic struct and class gets a type id, in source order after
+// the types it embeds, recorded in StructDeclaration::typeId and
+// ClassDeclaration::typeId. Fields are laid out from their annotations:
+// Int/Float 8 bytes, i32/u32/f32 4, Bool 1, String a VreString, our<T> a
+// reference the collector traces, my/their/ptr<T> an untraced pointer, a
+// struct of this module inline, and anything else (unannotated, optional,
+// generic, arrays) a VreValue. They are packed by decreasing alignment, so
+// the table's offsets are not in declaration order. A struct that contains
+// itself by value has no finite size and is a std::runtime_error.
+//
+// Each trait named by an impl gets a trait id, in order of first use. The
+// table records which types implement which traits; vtable slots stay null
+// until the code generator has emitted the method tables and fills them in.
+class TypeTableGenerator : public AstWalker {
+public:
+    vre::VreTypeTable run(Module* module);
+
+    using AstWalker::visit;
+    void visit(StructDeclaration* node) override;
+    void visit(ClassDeclaration* node) override;
+    void visit(ImplDeclaration* node) override;
+
+    struct FieldType {
+        vre::VreFieldKind kind;
+        uint32_t size;
+        uint32_t align;
+        vre::VreTypeId type = vre::VRE_DYNAMIC_TYPE; // For STRUCT
+    };
+
+private:
+    struct Record {
+        std::string name;
+        std::vector<FieldDeclaration*> fields;
+        uint32_t* typeId;
+        uint32_t size = 0; // Known once laid out
+        uint32_t align = 1;
+    };
+
+    std::vector<Record> records_; // in source order
+    std::unordered_map<std::string, size_t> byName_;
+    std::vector<ImplDeclaration*> impls_;
+    std::unordered_set<size_t> inProgress_;
+    vre::VreTypeTableBuilder builder_;
+
+    vre::VreTypeId layOut(size_t record);
+    FieldType fieldType(TypeNode* type);
+};
+
+} // namespace vyn
+
+#endif // VYN_TYPE_TABLE_HPP
@@ -0,0 +1,487 @@
+#ifndef VYN_VRE_CHANNEL_HPP
+#define VYN_VRE_CHANNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "vyn/vre/coroutine.hpp"
+#include "vyn/vre/futex.hpp"
+#include "vyn/vre/mutex.hpp"
+
+namespace vyn::vre {
+
+// Bounded lock-free MPMC queue (Dmitry Vyukov's array queue).
+//
+// Every cell carries a sequence number that says whose turn it is: a cell
+// at position p is free for the producer claiming p when its sequence is p,
+// and holds a value for the consumer claiming p when it is p + 1. A producer
+// or consumer claims a position with one CAS on its own counter and then
+// owns the cell outright, so producers and consumers never contend with each
+// other, only among themselves. The capacity is rounded up to a power of two
+// (at least 2).
+template<typename T>
+class VreBoundedQueue {
+public:
+    static constexpr bool bounded = true;
+
+    explicit VreBoundedQueue(size_t capacity) : mask_(round_up(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~VreBoundedQueue() {
+        while (try_pop()) {
+        }
+    }
+
+    VreBoundedQueue(const VreBoundedQueue&) = delete;
+    VreBoundedQueue& operator=(const VreBoundedQueue&) = delete;
+
+    // Moves from `value` only if there was room
+    bool try_push(T&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // the cell still holds the value from one lap ago
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<T> try_pop() {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return std::nullopt; // not written yet
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        T* slot = std::launder(reinterpret_cast<T*>(cell->storage));
+        std::optional<T> value(std::move(*slot));
+        slot->~T();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Estimates; may be stale by the time the caller looks
+    bool empty() const {
+        return dequeue_pos_.load(std::memory_order_seq_cst) >= enqueue_pos_.load(std::memory_order_seq_cst);
+    }
+    bool full() const {
+        size_t head = dequeue_pos_.load(std::memory_order_seq_cst);
+        return enqueue_pos_.load(std::memory_order_seq_cst) - head > mask_;
+    }
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static size_t round_up(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) rounded *= 2;
+        return rounded;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+// Unbounded lock-free MPMC queue of fixed-size blocks, after crossbeam's
+// SegQueue.
+//
+// Head and tail are indices that advance by one slot per operation, plus a
+// pointer to the block the index falls in; a producer claims a slot with one
+// CAS on the tail index. Each block has LAP - 1 slots: the index that would
+// address slot LAP - 1 marks "the next block is being installed", and
+// whoever claims the last real slot allocates and links it, so the queue
+// never blocks on an allocation made by another thread except across that
+// one-slot window. A block is freed by the last thread still touching it,
+// tracked through READ and DESTROY bits in each slot's state.
+template<typename T>
+class VreSegmentedQueue {
+public:
+    static constexpr bool bounded = false;
+
+    VreSegmentedQueue() = default;
+    ~VreSegmentedQueue() {
+        size_t head = head_.index.load(std::memory_order_relaxed) & ~HAS_NEXT;
+        size_t tail = tail_.index.load(std::memory_order_relaxed) & ~HAS_NEXT;
+        Block* block = head_.block.load(std::memory_order_relaxed);
+        for (; head != tail; head += 1 << SHIFT) {
+            size_t offset = (head >> SHIFT) % LAP;
+            if (offset < BLOCK_CAP) {
+                block->slots[offset].value()->~T();
+            } else {
+                Block* next = block->next.load(std::memory_order_relaxed);
+                delete block;
+                block = next;
+            }
+        }
+        delete block;
+    }
+
+    VreSegmentedQueue(const VreSegmentedQueue&) = delete;
+    VreSegmentedQueue& operator=(const VreSegmentedQueue&) = delete;
+
+    // Always succeeds; takes `bool` to match VreBoundedQueue
+    bool try_push(T&& value) {
+        size_t tail = tail_.index.load(std::memory_order_acquire);
+        Block* block = tail_.block.load(std::memory_order_acquire);
+        Block* next_block = nullptr;
+        for (;;) {
+            size_t offset = (tail >> SHIFT) % LAP;
+            if (offset == BLOCK_CAP) { // another producer is installing the next block
+                cpu_relax();
+                tail = tail_.index.load(std::memory_order_acquire);
+                block = tail_.block.load(std::memory_order_acquire);
+                continue;
+            }
+            // About to fill the block: allocate its successor before claiming the slot
+            if (offset + 1 == BLOCK_CAP && !next_block) next_block = new Block();
+
+            if (!block) { // the very first push
+                Block* first = new Block();
+                Block* expected = nullptr;
+                if (tail_.block.compare_exchange_strong(expected, first, std::memory_order_release)) {
+                    head_.block.store(first, std::memory_order_release);
+                    block = first;
+                } else {
+                    delete first;
+                    tail = tail_.index.load(std::memory_order_acquire);
+                    block = tail_.block.load(std::memory_order_acquire);
+                    continue;
+                }
+            }
+
+            size_t new_tail = tail + (1 << SHIFT);
+            if (tail_.index.compare_exchange_weak(tail, new_tail, std::memory_order_seq_cst,
+                                                  std::memory_order_acquire)) {
+                if (offset + 1 == BLOCK_CAP) { // claimed the last slot: link the next block
+                    tail_.block.store(next_block, std::memory_order_release);
+                    tail_.index.store(new_tail + (1 << SHIFT), std::memory_order_release);
+                    block->next.store(next_block, std::memory_order_release);
+                    next_block = nullptr;
+                }
+                Slot& slot = block->slots[offset];
+                new (slot.storage) T(std::move(value));
+                slot.state.fetch_or(WRITE, std::memory_order_release);
+                delete next_block;
+                return true;
+            }
+            block = tail_.block.load(std::memory_order_acquire);
+        }
+    }
+
+    std::optional<T> try_pop() {
+        size_t head = head_.index.load(std::memory_order_acquire);
+        Block* block = head_.block.load(std::memory_order_acquire);
+        for (;;) {
+            size_t offset = (head >> SHIFT) % LAP;
+            if (offset == BLOCK_CAP) { // the next block is being installed
+                cpu_relax();
+                head = head_.index.load(std::memory_order_acquire);
+                block = head_.block.load(std::memory_order_acquire);
+                continue;
+            }
+
+            size_t new_head = head + (1 << SHIFT);
+            if ((new_head & HAS_NEXT) == 0) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                size_t tail = tail_.index.load(std::memory_order_relaxed);
+                if (head >> SHIFT == tail >> SHIFT) return std::nullopt;
+                // Head and tail in different blocks: head's block has a successor
+                if ((head >> SHIFT) / LAP != (tail >> SHIFT) / LAP) new_head |= HAS_NEXT;
+            }
+            if (!block) { // the first push has claimed its slot but not published the block
+                cpu_relax();
+                head = head_.index.load(std::memory_order_acquire);
+                block = head_.block.load(std::memory_order_acquire);
+                continue;
+            }
+
+            if (head_.index.compare_exchange_weak(head, new_head, std::memory_order_seq_cst,
+                                                  std::memory_order_acquire)) {
+                if (offset + 1 == BLOCK_CAP) { // took the last slot: move on to the next block
+                    Block* next = block->wait_next();
+                    size_t next_index = (new_head & ~HAS_NEXT) + (1 << SHIFT);
+                    if (next->next.load(std::memory_order_relaxed)) next_index |= HAS_NEXT;
+                    head_.block.store(next, std::memory_order_release);
+                    head_.index.store(next_index, std::memory_order_release);
+                }
+                Slot& slot = block->slots[offset];
+                slot.wait_write();
+                std::optional<T> value(std::move(*slot.value()));
+                slot.value()->~T();
+                if (offset + 1 == BLOCK_CAP) {
+                    Block::destroy(block, 0);
+                } else if (slot.state.fetch_or(READ, std::memory_order_acq_rel) & DESTROY) {
+                    Block::destroy(block, offset + 1);
+                }
+                return value;
+            }
+            block = head_.block.load(std::memory_order_acquire);
+        }
+    }
+
+    // Estimates; may be stale by the time the caller looks
+    bool empty() const {
+        size_t head = head_.index.load(std::memory_order_seq_cst);
+        size_t tail = tail_.index.load(std::memory_order_seq_cst);
+        return head >> SHIFT == tail >> SHIFT;
+    }
+    bool full() const { return false; }
+
+private:
+    static constexpr size_t WRITE = 1;   // the value is in the slot
+    static constexpr size_t READ = 2;    // the value has been taken
+    static constexpr size_t DESTROY = 4; // the block is being freed; the reader of this slot finishes the job
+    static constexpr size_t LAP = 32;
+    static constexpr size_t BLOCK_CAP = LAP - 1;
+    static constexpr size_t SHIFT = 1;    // the low index bit is a flag
+    static constexpr size_t HAS_NEXT = 1; // in the head index: the head block has a successor
+
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::atomic<size_t> state{0};
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+        void wait_write() {
+            while ((state.load(std::memory_order_acquire) & WRITE) == 0) cpu_relax();
+        }
+    };
+
+    struct Block {
+        std::atomic<Block*> next{nullptr};
+        Slot slots[BLOCK_CAP];
+
+        Block* wait_next() {
+            for (;;) {
+                if (Block* block = next.load(std::memory_order_acquire)) return block;
+                cpu_relax();
+            }
+        }
+
+        // Frees the block unless a reader of a slot from `start` on is still
+        // using it, in which case that reader frees it when done. The reader
+        // of the last slot always starts here, with start == 0.
+        static void destroy(Block* block, size_t start) {
+            for (size_t i = start; i < BLOCK_CAP - 1; ++i) {
+                Slot& slot = block->slots[i];
+                if ((slot.state.load(std::memory_order_acquire) & READ) == 0 &&
+                    (slot.state.fetch_or(DESTROY, std::memory_order_acq_rel) & READ) == 0) {
+                    return;
+                }
+            }
+            delete block;
+        }
+    };
+
+    struct Position {
+        std::atomic<size_t> index{0};
+        std::atomic<Block*> block{nullptr};
+    };
+
+    alignas(64) Position head_;
+    alignas(64) Position tail_;
+};
+
+// Thrown by a send on a closed channel.
+class VreChannelClosedError : public std::runtime_error {
+public:
+    VreChannelClosedError() : std::runtime_error("Send on a closed channel") {}
+};
+
+// Where the receivers (or senders) of a channel wait: threads on a futex
+// eventcount and async tasks in a FIFO list of wakers. Waiters announce
+// themselves before re-checking the queue and notifiers fence between
+// publishing and looking for waiters, so a wakeup cannot be lost; with no
+// waiters, notify_one() is a fence and two loads.
+//
+// notify_one() claims one sleeping thread and turns it into a wake credit,
+// which the next thread to return from waiting consumes. Once every sleeper
+// has been claimed, further notifications skip the futex syscall: each
+// claimed thread is about to re-check the queue anyway.
+class VreChannelSignal {
+public:
+    void notify_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers(threads_.load(std::memory_order_relaxed)) == 0 && wakers_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        notify_slow(false);
+    }
+    void notify_all() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        notify_slow(true);
+    }
+
+    // Threads: prepare_wait(), re-check, then wait() or cancel_wait()
+    uint32_t prepare_wait();
+    void wait(uint32_t epoch);
+    void cancel_wait() { leave(); }
+
+    // Tasks: register_waker(), re-check, and if no longer needed try
+    // unregister_waker(). It fails if a notifier has already taken the waker,
+    // in which case the wake is on its way and the task must suspend.
+    void register_waker(VreWaker* waker);
+    bool unregister_waker(VreWaker* waker);
+
+private:
+    static constexpr uint64_t CREDIT = uint64_t(1) << 32;
+
+    // Low half: waiting threads no notifier has claimed yet; high half:
+    // claims not yet consumed by a returning thread
+    std::atomic<uint64_t> threads_{0};
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> wakers_{0};
+    Mutex<std::deque<VreWaker*>> waiting_;
+
+    static uint32_t sleepers(uint64_t threads) { return static_cast<uint32_t>(threads); }
+
+    void leave();
+    void notify_slow(bool all);
+};
+
+// Multi-producer multi-consumer channel over one of the queues above; use
+// BoundedChannel<T> or UnboundedChannel<T>.
+//
+// Each side can be used three ways: try_send/try_recv never wait, send/recv
+// block the calling thread, and poll_send/poll_recv follow the VreCoroutine
+// poll/waker protocol so a task on VreExecutor waits without blocking its
+// worker. close() wakes everyone: later sends throw VreChannelClosedError,
+// and receivers drain what is left before seeing the end of the stream.
+template<typename T, typename Queue>
+class VreChannel {
+public:
+    template<typename... Args>
+    explicit VreChannel(Args&&... args) : queue_(std::forward<Args>(args)...) {}
+
+    VreChannel(const VreChannel&) = delete;
+    VreChannel& operator=(const VreChannel&) = delete;
+
+    // False, leaving `value` alone, if the channel is full
+    bool try_send(T&& value) {
+        check_open();
+        if (!queue_.try_push(std::move(value))) return false;
+        receivers_.notify_one();
+        return true;
+    }
+    bool try_send(const T& value) {
+        T copy(value);
+        return try_send(std::move(copy));
+    }
+
+    void send(T value) {
+        while (!try_send(std::move(value))) {
+            uint32_t epoch = senders_.prepare_wait();
+            if (!queue_.full() || is_closed()) {
+                senders_.cancel_wait();
+            } else {
+                senders_.wait(epoch);
+            }
+        }
+    }
+
+    // READY once `value` has been moved into the channel
+    VrePoll poll_send(T& value, VreWaker& waker) {
+        for (;;) {
+            if (try_send(std::move(value))) return VrePoll::READY;
+            senders_.register_waker(&waker);
+            if (queue_.full() && !is_closed()) return VrePoll::PENDING;
+            if (!senders_.unregister_waker(&waker)) return VrePoll::PENDING;
+        }
+    }
+
+    // nullopt if nothing is queued right now
+    std::optional<T> try_recv() {
+        std::optional<T> value = queue_.try_pop();
+        if (value && Queue::bounded) senders_.notify_one();
+        return value;
+    }
+
+    // nullopt once the channel is closed and drained
+    std::optional<T> recv() {
+        for (;;) {
+            if (auto value = try_recv()) return value;
+            if (is_closed()) return try_recv();
+            uint32_t epoch = receivers_.prepare_wait();
+            if (!queue_.empty() || is_closed()) {
+                receivers_.cancel_wait();
+            } else {
+                receivers_.wait(epoch);
+            }
+        }
+    }
+
+    // READY with the next value in `out`, or with nullopt once the channel
+    // is closed and drained
+    VrePoll poll_recv(std::optional<T>& out, VreWaker& waker) {
+        for (;;) {
+            if ((out = try_recv())) return VrePoll::READY;
+            if (is_closed()) {
+                out = try_recv();
+                return VrePoll::READY;
+            }
+            receivers_.register_waker(&waker);
+            if (queue_.empty() && !is_closed()) return VrePoll::PENDING;
+            if (!receivers_.unregister_waker(&waker)) return VrePoll::PENDING;
+        }
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_seq_cst);
+        receivers_.notify_all();
+        senders_.notify_all();
+    }
+    bool is_closed() const { return closed_.load(std::memory_order_seq_cst); }
+
+    const Queue& queue() const { return queue_; }
+
+private:
+    Queue queue_;
+    std::atomic<bool> closed_{false};
+    VreChannelSignal receivers_; // waiting for a value
+    VreChannelSignal senders_;   // waiting for room; bounded channels only
+
+    void check_open() const {
+        if (closed_.load(std::memory_order_relaxed)) throw VreChannelClosedError();
+    }
+};
+
+template<typename T>
+using BoundedChannel = VreChannel<T, VreBoundedQueue<T>>;
+template<typename T>
+using UnboundedChannel = VreChannel<T, VreSegmentedQueue<T>>;
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_CHANNEL_HPP
@@ -0,0 +1,96 @@
+#ifndef VYN_VRE_CLOSURE_HPP
+#define VYN_VRE_CLOSURE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "vyn/vre/type_info.hpp"
+
+namespace vyn::vre {
+
+// Runtime representation of a Vyn function value: a code pointer followed,
+// in the same allocation, by the closure's captured environment. The
+// environment layout is fixed by the compiler (ClosureLayout in ast.hpp):
+// by-value captures are stored in it, their<T> borrows as a pointer.
+//
+// Code takes the environment as its first argument, so a call loads the code
+// pointer and makes one indirect call; nothing is type-erased beyond that.
+struct alignas(16) VreFunction {
+    static constexpr uint32_t STATIC = 1; // Lives in static storage; never freed
+
+    VreMethod code;              // R (*)(void* env, Args...)
+    void (*drop_env)(void* env); // nullptr if nothing in the environment needs destroying
+    uint32_t env_size;
+    uint32_t flags;
+
+    void* env() noexcept { return reinterpret_cast<unsigned char*>(this) + sizeof(VreFunction); }
+};
+static_assert(sizeof(VreFunction) == 32);
+
+// Owning handle to a VreFunction. Move-only, one pointer wide. Closures
+// that capture nothing share one static VreFunction per code pointer and
+// allocate nothing.
+class VreClosure {
+public:
+    // Environments may need at most this alignment
+    static constexpr size_t MAX_ENV_ALIGN = alignof(VreFunction);
+
+    VreClosure() noexcept = default;
+    VreClosure(VreClosure&& other) noexcept : fn_(std::exchange(other.fn_, nullptr)) {}
+    VreClosure& operator=(VreClosure&& other) noexcept {
+        if (this != &other) {
+            reset();
+            fn_ = std::exchange(other.fn_, nullptr);
+        }
+        return *this;
+    }
+    VreClosure(const VreClosure&) = delete;
+    VreClosure& operator=(const VreClosure&) = delete;
+    ~VreClosure() { reset(); }
+
+    // A closure over no variables
+    template<auto Code>
+    static VreClosure of() {
+        static VreFunction fn{reinterpret_cast<VreMethod>(Code), nullptr, 0, VreFunction::STATIC};
+        return VreClosure(&fn);
+    }
+    // A closure whose environment is `env`; Code reads it through its first
+    // argument as an Env*
+    template<typename Env, typename Code>
+    static VreClosure make(Code code, Env env) {
+        static_assert(alignof(Env) <= MAX_ENV_ALIGN, "closure environment is over-aligned");
+        void (*drop)(void*) = nullptr;
+        if constexpr (!std::is_trivially_destructible_v<Env>) {
+            drop = [](void* e) { static_cast<Env*>(e)->~Env(); };
+        }
+        VreClosure closure = allocate(reinterpret_cast<VreMethod>(code), sizeof(Env), drop);
+        new (closure.env()) Env(std::move(env));
+        return closure;
+    }
+    // An uninitialized environment of `env_size` bytes, for generated code
+    // to fill in capture by capture at the offsets of its ClosureLayout
+    static VreClosure allocate(VreMethod code, uint32_t env_size, void (*drop_env)(void*));
+
+    void reset() noexcept;
+
+    explicit operator bool() const noexcept { return fn_ != nullptr; }
+    VreFunction* function() const noexcept { return fn_; }
+    void* env() const noexcept { return fn_->env(); }
+
+    template<typename R, typename... Args>
+    R call(Args... args) const {
+        return reinterpret_cast<R (*)(void*, Args...)>(fn_->code)(fn_->env(), args...);
+    }
+
+private:
+    explicit VreClosure(VreFunction* fn) noexcept : fn_(fn) {}
+
+    VreFunction* fn_ = nullptr;
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_CLOSURE_HPP
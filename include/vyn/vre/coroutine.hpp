@@ -0,0 +1,72 @@
+#ifndef VYN_VRE_COROUTINE_HPP
+#define VYN_VRE_COROUTINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace vyn::vre {
+
+enum class VrePoll : uint8_t {
+    READY,   // finished
+    PENDING, // suspended; will be woken or resumed later
+};
+
+// Reschedules a suspended computation. wake() may be called from any thread,
+// at most once per suspension.
+class VreWaker {
+public:
+    virtual void wake() = 0;
+
+protected:
+    ~VreWaker() = default;
+};
+
+// Frame of a lowered `async fn` (see coroutine_lowering.hpp).
+//
+// The lowering sizes each async fn's frame exactly: this header, the locals
+// that are live across an await at fixed offsets, and one await area in which
+// the frame of the callee currently being awaited is built in place. A call
+// allocates its frame once; awaiting another async fn allocates nothing,
+// because only one await is in flight at a time and each callee reuses the
+// same area. The generated resume function switches on `state`.
+//
+// This is all an executor needs: poll() runs until the coroutine finishes
+// (READY) or blocks (PENDING). Before returning PENDING, the coroutine, or the
+// leaf future it awaits, arranges for waker.wake() to be called once polling
+// again can make progress. The coroutine does not know which executor, if
+// any, is polling it.
+struct VreCoroutine {
+    using ResumeFn = VrePoll (*)(VreCoroutine* self, VreWaker& waker);
+    static constexpr uint32_t DONE = UINT32_MAX;
+
+    ResumeFn resume;
+    uint32_t state;      // 0 on entry, k after the k-th await, DONE when finished
+    uint32_t frame_size; // CoroutineLayout::frameSize, header included
+
+    VrePoll poll(VreWaker& waker) {
+        if (state == DONE) return VrePoll::READY;
+        VrePoll result = resume(this, waker);
+        if (result == VrePoll::READY) state = DONE;
+        return result;
+    }
+
+    // The frame bytes at `offset`, as laid out by the lowering
+    template<typename T>
+    T* slot(size_t offset) {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(this) + offset);
+    }
+
+    // Starts the callee of an await inside this frame's await area
+    VreCoroutine* start_callee(size_t await_offset, ResumeFn callee, uint32_t callee_frame_size) {
+        return new (slot<char>(await_offset)) VreCoroutine{callee, 0, callee_frame_size};
+    }
+
+    // Allocates the zero-filled frame of a call from the slab pool
+    static VreCoroutine* create(ResumeFn resume, uint32_t frame_size);
+    static void destroy(VreCoroutine* frame);
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_COROUTINE_HPP
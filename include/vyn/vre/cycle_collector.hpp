@@ -0,0 +1,77 @@
+#ifndef VYN_VRE_CYCLE_COLLECTOR_HPP
+#define VYN_VRE_CYCLE_COLLECTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "vyn/vre/our.hpp"
+
+namespace vyn::vre {
+
+// Trial-deletion cycle collector for our<T> graphs (Bacon & Rajan, "Concurrent
+// Cycle Collection in Reference Counted Systems", synchronous variant).
+//
+// When the owner drops a reference to a traceable object and the count stays
+// above zero, the object may now be kept alive only by a cycle, so it is
+// buffered as a candidate root. The buffer holds a reference of its own.
+// A collection pause takes up to `max_roots_per_pause` roots and:
+//   1. marks the subgraph reachable from them gray, subtracting internal edges
+//   2. recolors black whatever still has an external reference, white the rest
+//   3. clears the references held by white objects and frees them
+//
+// Each thread collects its own buffer, at the make_our safepoint once the
+// buffer reaches `root_threshold`, or when collect_cycles() is called. Only
+// objects owned by the collecting thread and not referenced through another
+// thread's count take part; everything else counts as an external root. Other
+// threads must not mutate the participating objects during a pause.
+//
+// The collector is off by default: until it is enabled, releases buffer nothing.
+struct VreCycleCollectorConfig {
+    bool enabled = false;
+    size_t root_threshold = 4096;     // buffered roots that trigger a pause in make_our
+    size_t max_roots_per_pause = 512; // bounds the work done by one pause
+};
+
+struct VreCycleCollectorStats {
+    uint64_t pauses = 0;
+    uint64_t roots_scanned = 0;
+    uint64_t objects_traced = 0;
+    uint64_t objects_freed = 0; // members of garbage cycles
+    uint64_t total_pause_ns = 0;
+    uint64_t max_pause_ns = 0;
+
+    // Garbage cycle members freed per second of pause time
+    double throughput() const {
+        return total_pause_ns == 0 ? 0.0 : objects_freed * 1e9 / static_cast<double>(total_pause_ns);
+    }
+};
+
+void configure_cycle_collector(const VreCycleCollectorConfig& config);
+VreCycleCollectorConfig cycle_collector_config();
+
+// Totals over all threads since program start
+VreCycleCollectorStats cycle_collector_stats();
+
+// Runs one bounded pause over the calling thread's candidates. Returns the
+// number of objects freed.
+size_t collect_cycles_step();
+
+// Runs pauses until the calling thread's candidate buffer is empty.
+size_t collect_cycles();
+
+// Heap walk: calls `visit(VreRcHeader*)` for each our<T> reference held
+// directly by `object`. Does nothing for types without trace_children.
+template<typename T, typename F>
+void for_each_child(const our<T>& object, F&& visit) {
+    VreRcHeader* header = object.header();
+    if (!header || !header->ops->trace) return;
+    using Fn = std::remove_reference_t<F>;
+    header->ops->trace(
+        header, [](VreRcHeader* child, void* context) { (*static_cast<Fn*>(context))(child); },
+        const_cast<void*>(static_cast<const void*>(&visit)));
+}
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_CYCLE_COLLECTOR_HPP
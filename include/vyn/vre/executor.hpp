@@ -0,0 +1,260 @@
+#ifndef VYN_VRE_EXECUTOR_HPP
+#define VYN_VRE_EXECUTOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "vyn/vre/coroutine.hpp"
+#include "vyn/vre/memory.hpp"
+#include "vyn/vre/mutex.hpp"
+
+namespace vyn::vre {
+
+// Chase-Lev work-stealing deque (Lê et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", 2013).
+//
+// The owning worker pushes and pops at the bottom (LIFO, for locality);
+// other workers steal from the top (FIFO, taking the oldest and usually
+// largest pieces of work). Only a pop racing a steal for the last element
+// needs a CAS. The ring doubles when full; retired rings stay allocated
+// until the deque is destroyed because a thief may still be reading one.
+template<typename T>
+class VreChaseLevDeque {
+public:
+    explicit VreChaseLevDeque(size_t capacity = 256) : ring_(new Ring(round_up(capacity))) {}
+    ~VreChaseLevDeque() {
+        delete ring_.load(std::memory_order_relaxed);
+        for (Ring* ring : retired_) delete ring;
+    }
+
+    VreChaseLevDeque(const VreChaseLevDeque&) = delete;
+    VreChaseLevDeque& operator=(const VreChaseLevDeque&) = delete;
+
+    // Owner only
+    void push(T* item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(ring->mask)) {
+            ring = grow(ring, top, bottom);
+        }
+        ring->put(bottom, item);
+        bottom_.store(bottom + 1, std::memory_order_release); // publishes the item to thieves
+    }
+
+    // Owner only; nullptr when empty
+    T* pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = ring->get(bottom);
+        if (top == bottom) { // last element: race the thieves for it
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread; nullptr when empty or when another thief won the race
+    T* steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) return nullptr;
+        T* item = ring_.load(std::memory_order_acquire)->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // May be stale by the time the caller looks at it
+    size_t size_estimate() const {
+        int64_t size = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+private:
+    struct Ring {
+        explicit Ring(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T*>[capacity]) {}
+
+        T* get(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+        void put(int64_t index, T* item) { slots[index & mask].store(item, std::memory_order_relaxed); }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    static size_t round_up(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) rounded *= 2;
+        return rounded;
+    }
+
+    Ring* grow(Ring* old, int64_t top, int64_t bottom) {
+        Ring* ring = new Ring((old->mask + 1) * 2);
+        for (int64_t i = top; i < bottom; ++i) ring->put(i, old->get(i));
+        retired_.push_back(old);
+        ring_.store(ring, std::memory_order_release);
+        return ring;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Ring*> ring_;
+    std::vector<Ring*> retired_; // owner only
+};
+
+class VreTaskContext;
+class VreExecutor;
+
+// Activation record of an `async fn`, run as a stackless state machine.
+//
+// An async function lowers to a VreFrame subclass whose fields hold its
+// parameters and every local that lives across an await, and whose resume()
+// switches on `state_` to continue after the await that suspended it.
+// resume() returns READY when the function finishes (the executor then frees
+// the frame) and PENDING when it suspends or yields. To await, it registers
+// the awaited frames with VreTaskContext::await/await_all, stores the resume
+// point in `state_` and returns PENDING. The executor runs the frame again
+// once every awaited frame has finished. Awaited frames hand results back by
+// writing through pointers into the awaiting frame.
+//
+// Frames come from the runtime's slab pool and are owned by the executor
+// from the moment they are spawned or awaited.
+class VreFrame : public SlabAllocated<VreFrame> {
+public:
+    virtual ~VreFrame() = default;
+    virtual VrePoll resume(VreTaskContext& ctx) = 0;
+
+protected:
+    uint32_t state_ = 0; // resume point
+
+private:
+    friend class VreTaskContext;
+    friend class VreExecutor;
+
+    VreFrame* continuation_ = nullptr;       // frame awaiting this one
+    std::atomic<uint32_t> pending_{0};       // awaited frames not yet finished, plus one while running
+    std::atomic<uint32_t>* done_ = nullptr;  // signalled on completion of a block_on root
+};
+
+// What a running frame can do with the executor running it.
+class VreTaskContext {
+public:
+    // Starts `frame` without waiting for it
+    void spawn(VreFrame* frame);
+
+    // Suspends `self` until `child` / every frame in `children` finishes.
+    // resume() must return PENDING right after.
+    void await(VreFrame* self, VreFrame* child) { await_all(self, &child, 1); }
+    void await_all(VreFrame* self, std::initializer_list<VreFrame*> children) {
+        await_all(self, children.begin(), children.size());
+    }
+    void await_all(VreFrame* self, VreFrame* const* children, size_t count);
+
+    // Suspends `self` until VreExecutor::wake(self) is called, which may
+    // already happen before resume() returns PENDING
+    void suspend(VreFrame* self);
+
+    size_t worker_index() const { return index_; }
+
+private:
+    friend class VreExecutor;
+
+    VreTaskContext(VreExecutor& executor, size_t index) : executor_(executor), index_(index) {}
+
+    VreExecutor& executor_;
+    size_t index_;
+    bool awaited_ = false; // set by await during the current resume()
+};
+
+struct VreExecutorStats {
+    uint64_t resumes = 0;       // resume() calls
+    uint64_t frames_completed = 0;
+    uint64_t steals = 0;        // frames taken from another worker's deque
+    uint64_t injected = 0;      // frames taken from the global injector
+    uint64_t parks = 0;         // times a worker went to sleep
+};
+
+// Multi-threaded work-stealing executor for async frames.
+//
+// Every worker owns a Chase-Lev deque. Frames spawned or awaited by a running
+// frame go onto its worker's deque; frames spawned from outside go into a
+// global injector queue. An idle worker tries its own deque, the injector,
+// then steals from randomly chosen workers, and after a short spin parks on a
+// futex. Pushing work wakes one parked worker, if any.
+class VreExecutor {
+public:
+    // `workers` == 0 uses one worker per hardware thread
+    explicit VreExecutor(size_t workers = 0);
+    // Stops the workers. Frames still queued are destroyed without running;
+    // frames suspended at an await at that point are leaked.
+    ~VreExecutor();
+
+    VreExecutor(const VreExecutor&) = delete;
+    VreExecutor& operator=(const VreExecutor&) = delete;
+
+    // Starts `frame` on some worker without waiting for it
+    void spawn(VreFrame* frame);
+
+    // Runs `frame` to completion, including everything it awaits, and
+    // returns when it finishes. Must not be called from a worker.
+    void block_on(VreFrame* frame);
+
+    // Polls a lowered coroutine on the workers, re-polling whenever its
+    // waker fires. spawn() takes ownership of the coroutine and destroys it
+    // when it finishes; block_on() leaves it to the caller, who reads its
+    // result slot afterwards.
+    void spawn(VreCoroutine* coroutine);
+    void block_on(VreCoroutine* coroutine);
+
+    // Resumes a frame suspended with VreTaskContext::suspend
+    void wake(VreFrame* frame);
+
+    // True on this executor's own worker threads, where block_on is not allowed
+    bool on_worker() const;
+
+    size_t worker_count() const { return workers_.size(); }
+    VreExecutorStats stats() const;
+
+private:
+    friend class VreTaskContext;
+    struct Worker;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    Mutex<std::deque<VreFrame*>> injector_;
+    std::atomic<size_t> injector_size_{0};
+    std::atomic<uint32_t> epoch_{0};    // bumped to wake parked workers
+    std::atomic<uint32_t> sleepers_{0}; // workers parked or about to park
+    std::atomic<bool> stop_{false};
+
+    void run_worker(size_t index);
+    void run_frame(VreTaskContext& ctx, Worker& worker, VreFrame* frame);
+    void complete(Worker& worker, VreFrame* frame);
+    VreFrame* find_work(Worker& worker);
+    VreFrame* pop_injector();
+    void push_local(Worker& worker, VreFrame* frame);
+    void inject(VreFrame* frame);
+    bool has_visible_work() const;
+    void park(Worker& worker);
+    void notify();
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_EXECUTOR_HPP
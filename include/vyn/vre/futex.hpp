@@ -0,0 +1,37 @@
+#ifndef VYN_VRE_FUTEX_HPP
+#define VYN_VRE_FUTEX_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace vyn::vre {
+
+// Futex wrappers shared by the runtime's blocking primitives. On Linux they
+// map to FUTEX_WAIT_PRIVATE / FUTEX_WAKE_PRIVATE; elsewhere waiting degrades
+// to a short sleep and waking is a no-op, which is correct because every
+// caller re-checks its condition in a loop.
+
+// Sleeps while `*word == expected`, for at most `timeout` if given. May
+// return early or spuriously.
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, const std::chrono::nanoseconds* timeout = nullptr);
+
+// Wakes up to `count` threads sleeping on `word`. Only the address is used,
+// so waking a word whose owner has already returned is harmless.
+void futex_wake(std::atomic<uint32_t>* word, int count);
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_FUTEX_HPP
@@ -0,0 +1,566 @@
+#ifndef VYN_VRE_HASH_MAP_HPP
+#define VYN_VRE_HASH_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VYN_VRE_HASH_MAP_SSE2 1
+#endif
+
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/value.hpp"
+
+namespace vyn::vre {
+
+namespace hash_map_detail {
+
+// One control byte per slot. Full slots store the low 7 bits of their hash
+// (H2), so most probes reject non-matching slots without touching the keys.
+using ctrl_t = int8_t;
+constexpr ctrl_t kEmpty = -128;  // 0b10000000
+constexpr ctrl_t kDeleted = -2;  // 0b11111110
+constexpr ctrl_t kSentinel = -1; // 0b11111111, marks the end of the table
+
+inline bool is_full(ctrl_t c) { return c >= 0; }
+
+inline uint32_t trailing_zeros(uint64_t x) { return static_cast<uint32_t>(__builtin_ctzll(x)); }
+inline uint32_t leading_zeros(uint64_t x) { return static_cast<uint32_t>(__builtin_clzll(x)); }
+
+// Set of slot positions within a group. Each position is represented by one
+// bit every 2^Shift bits, counting from the least significant end.
+template<uint32_t Shift, uint32_t Width>
+class BitMask {
+public:
+    explicit BitMask(uint64_t bits) : bits_(bits) {}
+
+    explicit operator bool() const { return bits_ != 0; }
+    uint32_t lowest() const { return trailing_zeros(bits_) >> Shift; }
+    void clear_lowest() { bits_ &= bits_ - 1; }
+
+    // Positions free before the first / after the last member
+    uint32_t trailing_clear() const { return bits_ ? trailing_zeros(bits_) >> Shift : Width; }
+    uint32_t leading_clear() const {
+        return bits_ ? (leading_zeros(bits_) - (64 - (Width << Shift))) >> Shift : Width;
+    }
+
+private:
+    uint64_t bits_;
+};
+
+#ifdef VYN_VRE_HASH_MAP_SSE2
+
+// 16 control bytes compared at once with SSE2
+struct Group {
+    static constexpr size_t WIDTH = 16;
+    using Mask = BitMask<0, 16>;
+
+    explicit Group(const ctrl_t* pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+    Mask match(ctrl_t h2) const {
+        return Mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))));
+    }
+    Mask match_empty() const { return match(kEmpty); }
+    Mask match_empty_or_deleted() const {
+        return Mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl))));
+    }
+    uint32_t count_leading_empty_or_deleted() const {
+        uint32_t special = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(kSentinel), ctrl)));
+        return trailing_zeros(special + 1);
+    }
+
+    __m128i ctrl;
+};
+
+#else
+
+// 8 control bytes compared at once in a 64-bit word. match() may report a
+// false positive next to a true match; callers compare keys anyway.
+struct Group {
+    static constexpr size_t WIDTH = 8;
+    using Mask = BitMask<3, 8>;
+    static constexpr uint64_t kLsbs = 0x0101010101010101ull;
+    static constexpr uint64_t kMsbs = 0x8080808080808080ull;
+
+    explicit Group(const ctrl_t* pos) { std::memcpy(&ctrl, pos, sizeof(ctrl)); } // little-endian
+
+    Mask match(ctrl_t h2) const {
+        uint64_t x = ctrl ^ (kLsbs * static_cast<uint8_t>(h2));
+        return Mask((x - kLsbs) & ~x & kMsbs);
+    }
+    Mask match_empty() const { return Mask((ctrl & (~ctrl << 6)) & kMsbs); }
+    Mask match_empty_or_deleted() const { return Mask((ctrl & (~ctrl << 7)) & kMsbs); }
+    uint32_t count_leading_empty_or_deleted() const {
+        uint64_t special = (ctrl & (~ctrl << 7)) & kMsbs;
+        uint64_t other = ~special & kMsbs;
+        return other ? trailing_zeros(other) >> 3 : 8;
+    }
+
+    uint64_t ctrl;
+};
+
+#endif
+
+// Control bytes of a table with no slots: find() and begin() see the
+// sentinel straight away, so an empty map needs no allocation or null checks.
+alignas(16) inline const ctrl_t kEmptyGroup[Group::WIDTH] = {
+    kSentinel, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+#ifdef VYN_VRE_HASH_MAP_SSE2
+    kEmpty,    kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+#endif
+};
+
+// Spreads the caller's hash over 64 bits; H1 picks the first group, H2 is
+// the 7 bits kept in the control byte.
+inline uint64_t mix(size_t hash) {
+    uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+inline size_t h1(uint64_t hash) { return static_cast<size_t>(hash >> 7); }
+inline ctrl_t h2(uint64_t hash) { return static_cast<ctrl_t>(hash & 0x7F); }
+
+// Largest number of elements a table of `capacity` slots holds before it
+// grows: 7/8 of the slots, keeping at least one empty slot per probe window.
+inline size_t capacity_to_growth(size_t capacity) {
+    if (Group::WIDTH == 8 && capacity == 7) return 6;
+    return capacity - capacity / 8;
+}
+
+// Smallest valid capacity (2^k - 1) holding `growth` elements
+inline size_t growth_to_capacity(size_t growth) {
+    size_t needed = growth + (growth > 0 ? (growth - 1) / 7 : 0);
+    if (Group::WIDTH == 8 && growth == 7) needed = 8;
+    size_t capacity = 1;
+    while (capacity < needed) capacity = capacity * 2 + 1;
+    return capacity;
+}
+
+// Selects the lookup argument type: any Q for transparent hash/equality
+// functors, the key type otherwise.
+template<bool Transparent>
+struct KeyArg {
+    template<typename Q, typename K>
+    using type = K;
+};
+template<>
+struct KeyArg<true> {
+    template<typename Q, typename K>
+    using type = Q;
+};
+
+template<typename T, typename = void>
+struct IsTransparent : std::false_type {};
+template<typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+} // namespace hash_map_detail
+
+// Hash and equality used by HashMap by default. Specialized for VreValue and
+// VreString so that lookups can use a string_view (or an int64_t for
+// VreValue keys) without building a key first.
+template<typename K>
+struct VreHash : std::hash<K> {};
+template<typename K>
+struct VreKeyEq : std::equal_to<K> {};
+
+template<>
+struct VreHash<VreString> {
+    using is_transparent = void;
+    size_t operator()(const VreString& s) const noexcept { return s.hash(); }
+    size_t operator()(std::string_view s) const noexcept { return VreString::hash_of(s); }
+    size_t operator()(const char* s) const noexcept { return VreString::hash_of(s); }
+};
+template<>
+struct VreKeyEq<VreString> {
+    using is_transparent = void;
+    bool operator()(const VreString& a, const VreString& b) const noexcept { return a == b; }
+    bool operator()(const VreString& a, std::string_view b) const noexcept { return a.view() == b; }
+    bool operator()(const VreString& a, const char* b) const noexcept { return a.view() == b; }
+};
+
+// Strings hash by contents (using the cached VreString hash), objects and
+// arrays by identity. Values of different types never compare equal, so
+// Int 1 and Float 1.0 are distinct keys, and NaN keys are never found.
+template<>
+struct VreHash<VreValue> {
+    using is_transparent = void;
+    size_t operator()(const VreValue& v) const noexcept;
+    size_t operator()(int64_t i) const noexcept { return static_cast<size_t>(i); }
+    size_t operator()(std::string_view s) const noexcept { return VreString::hash_of(s); }
+    size_t operator()(const char* s) const noexcept { return VreString::hash_of(s); }
+    size_t operator()(const VreString& s) const noexcept { return s.hash(); }
+};
+template<>
+struct VreKeyEq<VreValue> {
+    using is_transparent = void;
+    bool operator()(const VreValue& a, const VreValue& b) const noexcept;
+    bool operator()(const VreValue& a, int64_t b) const noexcept {
+        return a.type == VreValueType::INTEGER && std::get<int64_t>(a.data) == b;
+    }
+    bool operator()(const VreValue& a, std::string_view b) const noexcept {
+        return a.type == VreValueType::STRING && std::get<VreString>(a.data).view() == b;
+    }
+    bool operator()(const VreValue& a, const char* b) const noexcept { return (*this)(a, std::string_view(b)); }
+    bool operator()(const VreValue& a, const VreString& b) const noexcept {
+        return a.type == VreValueType::STRING && std::get<VreString>(a.data) == b;
+    }
+};
+
+// Open-addressing hash map with SIMD-probed control bytes (a "Swiss table").
+//
+// Slots live in one flat array next to an array of control bytes. A lookup
+// hashes once, then scans a group of 16 control bytes (8 without SSE2) for
+// the key's 7-bit hash tag in a few instructions, comparing keys only for
+// tag matches; probing moves group by group and stops at the first group
+// with an empty slot. Erasing leaves a tombstone unless no probe could have
+// passed the slot. The table grows at 7/8 load.
+//
+// Elements move when the table grows, so insertions invalidate iterators and
+// references; erasing invalidates only the erased element. Iteration walks
+// the control bytes and never allocates.
+template<typename K, typename V, typename Hash = VreHash<K>, typename Eq = VreKeyEq<K>>
+class HashMap {
+    using ctrl_t = hash_map_detail::ctrl_t;
+    using Group = hash_map_detail::Group;
+    static constexpr bool kTransparent =
+        hash_map_detail::IsTransparent<Hash>::value && hash_map_detail::IsTransparent<Eq>::value;
+
+    template<typename Q>
+    using key_arg = typename hash_map_detail::KeyArg<kTransparent>::template type<Q, K>;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+
+    static_assert(alignof(value_type) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned HashMap elements");
+
+    template<bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename HashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type, value_type>&;
+        using pointer = std::conditional_t<Const, const value_type, value_type>*;
+
+        Iterator() = default;
+        operator Iterator<true>() const { return Iterator<true>(ctrl_, slot_); }
+
+        reference operator*() const { return *slot_; }
+        pointer operator->() const { return slot_; }
+        Iterator& operator++() {
+            ++ctrl_;
+            ++slot_;
+            skip_empty_or_deleted();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.ctrl_ == b.ctrl_; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.ctrl_ != b.ctrl_; }
+
+    private:
+        friend class HashMap;
+        friend class Iterator<!Const>;
+
+        Iterator(const ctrl_t* ctrl, pointer slot) : ctrl_(ctrl), slot_(slot) {}
+
+        void skip_empty_or_deleted() {
+            while (*ctrl_ < hash_map_detail::kSentinel) {
+                uint32_t shift = Group(ctrl_).count_leading_empty_or_deleted();
+                ctrl_ += shift;
+                slot_ += shift;
+            }
+        }
+
+        const ctrl_t* ctrl_ = nullptr;
+        pointer slot_ = nullptr;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    HashMap() = default;
+    explicit HashMap(size_t capacity) { reserve(capacity); }
+    HashMap(const HashMap& other) : hash_(other.hash_), eq_(other.eq_) {
+        reserve(other.size_);
+        for (const value_type& element : other) {
+            size_t index = find_first_non_full(hash_of(element.first));
+            new (&slots_[index]) value_type(element);
+            commit_insert(index, hash_of(element.first));
+        }
+    }
+    HashMap(HashMap&& other) noexcept
+        : ctrl_(other.ctrl_), slots_(other.slots_), size_(other.size_), capacity_(other.capacity_),
+          growth_left_(other.growth_left_), hash_(std::move(other.hash_)), eq_(std::move(other.eq_)) {
+        other.reset_to_empty();
+    }
+    HashMap& operator=(HashMap other) noexcept {
+        swap(other);
+        return *this;
+    }
+    ~HashMap() { destroy(); }
+
+    void swap(HashMap& other) noexcept {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(growth_left_, other.growth_left_);
+        std::swap(hash_, other.hash_);
+        std::swap(eq_, other.eq_);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // Number of slots; the map grows once size() reaches 7/8 of it
+    size_t capacity() const { return capacity_; }
+
+    iterator begin() {
+        iterator it(ctrl_, slots_);
+        it.skip_empty_or_deleted();
+        return it;
+    }
+    iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+    const_iterator begin() const { return const_cast<HashMap*>(this)->begin(); }
+    const_iterator end() const { return const_cast<HashMap*>(this)->end(); }
+
+    // Makes room for `count` elements without further rehashing
+    void reserve(size_t count) {
+        if (count > size_ + growth_left_) {
+            resize(hash_map_detail::growth_to_capacity(count));
+        }
+    }
+
+    // Destroys every element but keeps the slots
+    void clear() {
+        if (capacity_ == 0) return;
+        destroy_elements();
+        reset_ctrl();
+        size_ = 0;
+        growth_left_ = hash_map_detail::capacity_to_growth(capacity_);
+    }
+
+    template<typename Q = K>
+    iterator find(const key_arg<Q>& key) {
+        uint64_t hash = hash_of(key);
+        size_t mask = capacity_;
+        size_t offset = hash_map_detail::h1(hash) & mask;
+        for (size_t step = 0;; ) {
+            Group group(ctrl_ + offset);
+            for (auto match = group.match(hash_map_detail::h2(hash)); match; match.clear_lowest()) {
+                size_t index = (offset + match.lowest()) & mask;
+                if (eq_(slots_[index].first, key)) return iterator(ctrl_ + index, slots_ + index);
+            }
+            if (group.match_empty()) return end();
+            step += Group::WIDTH;
+            offset = (offset + step) & mask;
+        }
+    }
+    template<typename Q = K>
+    const_iterator find(const key_arg<Q>& key) const {
+        return const_cast<HashMap*>(this)->find<Q>(key);
+    }
+    template<typename Q = K>
+    bool contains(const key_arg<Q>& key) const {
+        return find<Q>(key) != end();
+    }
+    template<typename Q = K>
+    size_t count(const key_arg<Q>& key) const {
+        return contains<Q>(key) ? 1 : 0;
+    }
+    template<typename Q = K>
+    V& at(const key_arg<Q>& key) {
+        iterator it = find<Q>(key);
+        if (it == end()) throw std::runtime_error("HashMap key not found");
+        return it->second;
+    }
+    template<typename Q = K>
+    const V& at(const key_arg<Q>& key) const {
+        return const_cast<HashMap*>(this)->at<Q>(key);
+    }
+
+    // Inserts `key` with a V built from `args` unless the key is present; the
+    // bool is true if an element was inserted
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+        return emplace_key(key, std::forward<Args>(args)...);
+    }
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        return emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+    std::pair<iterator, bool> insert(const value_type& element) { return try_emplace(element.first, element.second); }
+    std::pair<iterator, bool> insert(value_type&& element) {
+        return try_emplace(std::move(const_cast<K&>(element.first)), std::move(element.second));
+    }
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(K key, M&& value) {
+        auto result = try_emplace(std::move(key), std::forward<M>(value));
+        if (!result.second) result.first->second = std::forward<M>(value);
+        return result;
+    }
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+    void erase(iterator it) {
+        it.slot_->~value_type();
+        erase_ctrl(static_cast<size_t>(it.ctrl_ - ctrl_));
+    }
+    template<typename Q = K>
+    size_t erase(const key_arg<Q>& key) {
+        iterator it = find<Q>(key);
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+private:
+    ctrl_t* ctrl_ = const_cast<ctrl_t*>(hash_map_detail::kEmptyGroup);
+    value_type* slots_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0; // 0 or 2^k - 1, used as the probe mask
+    size_t growth_left_ = 0;
+    Hash hash_;
+    Eq eq_;
+
+    template<typename Q>
+    uint64_t hash_of(const Q& key) const {
+        return hash_map_detail::mix(hash_(key));
+    }
+
+    // Control bytes: capacity_ slots, the sentinel, then a copy of the first
+    // WIDTH - 1 bytes so that a group starting near the end wraps around.
+    static size_t ctrl_bytes(size_t capacity) {
+        size_t bytes = capacity + Group::WIDTH;
+        return (bytes + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+    }
+
+    void set_ctrl(size_t index, ctrl_t value) {
+        ctrl_[index] = value;
+        ctrl_[((index - (Group::WIDTH - 1)) & capacity_) + ((Group::WIDTH - 1) & capacity_)] = value;
+    }
+
+    void reset_ctrl() {
+        std::memset(ctrl_, static_cast<uint8_t>(hash_map_detail::kEmpty), capacity_ + Group::WIDTH);
+        ctrl_[capacity_] = hash_map_detail::kSentinel;
+    }
+
+    void reset_to_empty() {
+        ctrl_ = const_cast<ctrl_t*>(hash_map_detail::kEmptyGroup);
+        slots_ = nullptr;
+        size_ = capacity_ = growth_left_ = 0;
+    }
+
+    // First empty or deleted slot on the probe sequence of `hash`
+    size_t find_first_non_full(uint64_t hash) const {
+        size_t mask = capacity_;
+        size_t offset = hash_map_detail::h1(hash) & mask;
+        for (size_t step = 0;; ) {
+            auto free = Group(ctrl_ + offset).match_empty_or_deleted();
+            if (free) return (offset + free.lowest()) & mask;
+            step += Group::WIDTH;
+            offset = (offset + step) & mask;
+        }
+    }
+
+    void commit_insert(size_t index, uint64_t hash) {
+        growth_left_ -= ctrl_[index] == hash_map_detail::kEmpty;
+        set_ctrl(index, hash_map_detail::h2(hash));
+        ++size_;
+    }
+
+    template<typename KeyT, typename... Args>
+    std::pair<iterator, bool> emplace_key(KeyT&& key, Args&&... args) {
+        iterator it = find(key);
+        if (it != end()) return {it, false};
+        uint64_t hash = hash_of(key);
+        size_t index = find_first_non_full(hash);
+        if (growth_left_ == 0 && ctrl_[index] != hash_map_detail::kDeleted) {
+            grow();
+            index = find_first_non_full(hash);
+        }
+        new (&slots_[index]) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<KeyT>(key)),
+                                        std::forward_as_tuple(std::forward<Args>(args)...));
+        commit_insert(index, hash);
+        return {iterator(ctrl_ + index, slots_ + index), true};
+    }
+
+    // Tombstones count against growth_left_; when most of the used slots are
+    // tombstones, rehashing at the same capacity reclaims them instead.
+    void grow() {
+        if (capacity_ > Group::WIDTH && size_ * 32 <= capacity_ * 25) {
+            resize(capacity_);
+        } else {
+            resize(capacity_ == 0 ? 1 : capacity_ * 2 + 1);
+        }
+    }
+
+    void resize(size_t capacity) {
+        ctrl_t* old_ctrl = ctrl_;
+        value_type* old_slots = slots_;
+        size_t old_capacity = capacity_;
+
+        char* memory = static_cast<char*>(::operator new(ctrl_bytes(capacity) + capacity * sizeof(value_type)));
+        ctrl_ = reinterpret_cast<ctrl_t*>(memory);
+        slots_ = reinterpret_cast<value_type*>(memory + ctrl_bytes(capacity));
+        capacity_ = capacity;
+        reset_ctrl();
+        growth_left_ = hash_map_detail::capacity_to_growth(capacity) - size_;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (!hash_map_detail::is_full(old_ctrl[i])) continue;
+            value_type& element = old_slots[i];
+            uint64_t hash = hash_of(element.first);
+            size_t index = find_first_non_full(hash);
+            new (&slots_[index]) value_type(std::move(const_cast<K&>(element.first)), std::move(element.second));
+            element.~value_type();
+            set_ctrl(index, hash_map_detail::h2(hash));
+        }
+        if (old_capacity > 0) ::operator delete(old_ctrl);
+    }
+
+    // A slot becomes empty again, rather than a tombstone, if every probe
+    // window containing it still has an empty slot, so no lookup can have
+    // continued past it.
+    void erase_ctrl(size_t index) {
+        --size_;
+        size_t before = (index - Group::WIDTH) & capacity_;
+        auto empty_after = Group(ctrl_ + index).match_empty();
+        auto empty_before = Group(ctrl_ + before).match_empty();
+        bool was_never_full = empty_before && empty_after &&
+                              empty_after.trailing_clear() + empty_before.leading_clear() < Group::WIDTH;
+        set_ctrl(index, was_never_full ? hash_map_detail::kEmpty : hash_map_detail::kDeleted);
+        growth_left_ += was_never_full;
+    }
+
+    void destroy_elements() {
+        if (std::is_trivially_destructible<value_type>::value) return;
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (hash_map_detail::is_full(ctrl_[i])) slots_[i].~value_type();
+        }
+    }
+
+    void destroy() {
+        if (capacity_ == 0) return;
+        destroy_elements();
+        ::operator delete(ctrl_);
+        reset_to_empty();
+    }
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_HASH_MAP_HPP
@@ -0,0 +1,102 @@
+#ifndef VYN_VRE_INLINE_CACHE_HPP
+#define VYN_VRE_INLINE_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vyn/vre/runtime_types.hpp"
+#include "vyn/vre/shape.hpp"
+
+namespace vyn::vre {
+
+// Inline cache for one property access site (a MemberExpression).
+//
+// The site's property name is fixed, so an entry only has to remember which
+// slot that name occupies in a given shape. A hit costs one pointer compare
+// per entry before indexing fields_by_index directly. The cache starts
+// uninitialized, becomes monomorphic on the first miss, polymorphic with up to
+// MAX_ENTRIES shapes, and megamorphic after that, at which point it stops
+// learning and misses fall back to VreShape::slot_of.
+//
+// A cache belongs to one thread of execution; it is not synchronized.
+class VreInlineCache {
+public:
+    enum class State : uint8_t { UNINITIALIZED, MONOMORPHIC, POLYMORPHIC, MEGAMORPHIC };
+
+    static constexpr size_t MAX_ENTRIES = 4;
+
+    // Property `name` of `object`, or nullptr if it has none
+    VreValue* load(VreObject& object, const VreString& name) {
+        const VreShape* shape = object.shape;
+        if (shape == entries_[0].shape && shape) { // monomorphic hit
+            return &object.fields_by_index[entries_[0].slot];
+        }
+        for (size_t i = 1; i < count_; ++i) {
+            if (entries_[i].shape == shape) {
+                return &object.fields_by_index[entries_[i].slot];
+            }
+        }
+        return load_miss(object, name);
+    }
+
+    // Sets property `name` of `object`, adding it if missing. Adding is cached
+    // too: the entry remembers the shape the object transitions to.
+    void store(VreObject& object, const VreString& name, VreValue value) {
+        for (size_t i = 0; i < count_; ++i) {
+            const Entry& entry = entries_[i];
+            if (entry.shape != object.shape) continue;
+            if (entry.transition) {
+                object.shape = entry.transition;
+                object.fields_by_index.push_back(std::move(value));
+            } else {
+                object.fields_by_index[entry.slot] = std::move(value);
+            }
+            return;
+        }
+        store_miss(object, name, std::move(value));
+    }
+
+    State state() const;
+    size_t entry_count() const { return count_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        const VreShape* shape;
+        const VreShape* transition; // non-null for stores that add the property
+        uint32_t slot;
+    };
+
+    std::array<Entry, MAX_ENTRIES> entries_{};
+    uint8_t count_ = 0;
+    bool megamorphic_ = false;
+    uint64_t misses_ = 0;
+
+    VreValue* load_miss(VreObject& object, const VreString& name);
+    void store_miss(VreObject& object, const VreString& name, VreValue value);
+    void remember(const VreShape* shape, const VreShape* transition, uint32_t slot);
+};
+
+// The inline caches of one execution context, indexed by
+// MemberExpression::cacheSite.
+class VreInlineCacheTable {
+public:
+    // The returned reference is invalidated by a later call with a larger site.
+    VreInlineCache& at(uint32_t site) {
+        if (site >= caches_.size()) {
+            caches_.resize(site + 1);
+        }
+        return caches_[site];
+    }
+
+    size_t size() const { return caches_.size(); }
+
+private:
+    std::vector<VreInlineCache> caches_;
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_INLINE_CACHE_HPP
@@ -1,26 +1,50 @@
 #ifndef VYN_VRE_MEMORY_HPP
 #define VYN_VRE_MEMORY_HPP
 
-#include <memory> // For std::unique_ptr, std::shared_ptr
+#include <memory> // For std::unique_ptr
 #include <cstddef> // For size_t
+#include <cstdint>
+#include <utility>
 
 namespace vyn::vre {
 
 // Forward declaration
 struct VreValue;
 
-// Basic heap allocation (could be replaced by a custom allocator later)
+// Runtime heap allocation. Small requests are served from size-class slabs
+// with a per-thread cache (see src/vre/memory.cpp); larger ones fall through
+// to the global operator new. Deallocation is sized: callers pass the same
+// size they allocated with.
 void* allocate_raw(size_t size);
-void deallocate_raw(void* ptr);
+void deallocate_raw(void* ptr, size_t size);
+
+// Largest request served from the slab size classes
+constexpr size_t SLAB_MAX_SIZE = 1024;
+// Alignment guaranteed for slab allocations
+constexpr size_t SLAB_ALIGNMENT = 16;
+
+// Allocator statistics, summed over all threads (including exited ones).
+struct AllocatorStats {
+    uint64_t allocations = 0;       // allocate_raw calls
+    uint64_t deallocations = 0;     // deallocate_raw calls
+    uint64_t bytes_requested = 0;   // sum of requested sizes
+    uint64_t large_allocations = 0; // requests above SLAB_MAX_SIZE
+    uint64_t slabs_created = 0;     // fresh slabs carved from the system heap
+    uint64_t depot_refills = 0;     // batches a thread cache took from the depot
+    uint64_t depot_flushes = 0;     // batches a thread cache returned to the depot
+};
+
+AllocatorStats allocator_stats();
 
 // Vyn's my<T> for unique ownership of heap-allocated values.
 // T would typically be a VreValue or a specific runtime type like VreObject.
 template<typename T>
 using my = std::unique_ptr<T>; // Using std::unique_ptr as a starting point
 
-// Vyn's our<T> for shared ownership of heap-allocated values (e.g., via ARC).
+// Vyn's our<T> for shared ownership of heap-allocated values: an intrusive,
+// biased reference-counted pointer. Defined in our.hpp.
 template<typename T>
-using our = std::shared_ptr<T>; // Using std::shared_ptr as a starting point for shared ownership
+class our;
 
 // Vyn's their<T> for non-owning, borrowed references to values.
 // This represents a raw pointer, indicating a borrow that does not affect lifetime.
@@ -28,26 +52,36 @@ using our = std::shared_ptr<T>; // Using std::shared_ptr as a starting point for
 template<typename T>
 using their = T*; // Using raw pointer for non-owning borrows
 
-// --- Potential future additions ---
-// class Allocator {
-// public:
-//     virtual ~Allocator() = default;
-//     virtual void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) = 0;
-//     virtual void deallocate(void* ptr, size_t size) = 0;
-// };
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+    virtual void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) = 0;
+    virtual void deallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) = 0;
+};
 
-// class DefaultAllocator : public Allocator {
-// public:
-//     void* allocate(size_t size, size_t alignment) override;
-//     void deallocate(void* ptr, size_t size) override;
-// };
+// Routes through allocate_raw/deallocate_raw; over-aligned requests go to the
+// aligned global operator new.
+class DefaultAllocator : public Allocator {
+public:
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) override;
+    void deallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t)) override;
+
+    static DefaultAllocator& instance();
+};
+
+// Mixin that gives a runtime type class-level operator new/delete backed by
+// the slab allocator, so make_my/new on it avoids malloc.
+template<typename T>
+struct SlabAllocated {
+    static void* operator new(size_t size) { return allocate_raw(size); }
+    static void operator delete(void* ptr, size_t size) { deallocate_raw(ptr, size); }
+};
 
 // Functions for creating Boxed values
-// template<typename T, typename... Args>
-// my<T> make_my(Args&&... args) { // Renamed from make_box
-//     // Potentially use custom allocation here
-//     return std::make_unique<T>(std::forward<Args>(args)...);
-// }
+template<typename T, typename... Args>
+my<T> make_my(Args&&... args) { // Renamed from make_box
+    return my<T>(new T(std::forward<Args>(args)...)); // uses T::operator new when T is SlabAllocated
+}
 
 } // namespace vyn::vre
 
@@ -0,0 +1,175 @@
+#ifndef VYN_VRE_MUTEX_HPP
+#define VYN_VRE_MUTEX_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace vyn::vre {
+
+// FIFO queue lock with direct handoff ("baton passing").
+//
+// Uncontended lock and unlock are a single compare-and-swap each. A
+// contended locker first spins for an adaptively sized interval, and only
+// while nobody is queued, so spinning never overtakes a queued thread. It
+// then appends itself to the wait queue and sleeps on a futex word of its
+// own. unlock() hands the lock straight to the oldest waiter, without
+// releasing it, and wakes only that thread. Waiters are therefore served in
+// arrival order and a waking thread never has to race for the lock.
+class VreQueueLock {
+public:
+    VreQueueLock() = default;
+    VreQueueLock(const VreQueueLock&) = delete;
+    VreQueueLock& operator=(const VreQueueLock&) = delete;
+
+    void lock() {
+        if (!try_lock()) lock_slow(nullptr);
+    }
+    bool try_lock() {
+        uint32_t expected = 0;
+        return state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    // False if the lock could not be taken before `deadline`
+    bool try_lock_until(std::chrono::steady_clock::time_point deadline) {
+        return try_lock() || lock_slow(&deadline);
+    }
+    void unlock() {
+        uint32_t expected = LOCKED;
+        if (!state_.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed)) {
+            unlock_slow();
+        }
+    }
+
+    // Current adaptive spin budget, in pause iterations
+    uint32_t spin_limit() const { return spin_limit_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t QUEUED = 2; // the wait queue is non-empty
+
+    // Lives on the waiting thread's stack for as long as it is queued
+    struct Waiter {
+        std::atomic<uint32_t> granted{0}; // futex word; set to 1 when handed the lock
+        Waiter* prev = nullptr;
+        Waiter* next = nullptr;
+    };
+
+    std::atomic<uint32_t> state_{0};
+    std::atomic<uint32_t> spin_limit_{100};
+    std::atomic<bool> queue_lock_{false}; // guards head_ and tail_
+    Waiter* head_ = nullptr;
+    Waiter* tail_ = nullptr;
+
+    bool lock_slow(const std::chrono::steady_clock::time_point* deadline);
+    void unlock_slow();
+    bool spin();
+    void lock_queue();
+    void unlock_queue() { queue_lock_.store(false, std::memory_order_release); }
+    void unlink(Waiter* waiter);
+};
+
+// Thrown when locking a Mutex whose previous holder exited its critical
+// section by an exception; the protected value may be inconsistent. Call
+// Mutex::clear_poison() once the value has been repaired.
+class VrePoisonError : public std::runtime_error {
+public:
+    VrePoisonError() : std::runtime_error("Mutex is poisoned: a previous holder threw while holding the lock") {}
+};
+
+template<typename T>
+class Mutex;
+
+// Holds a Mutex<T> and gives access to its value; dropping the guard passes
+// the lock to the next waiter. A guard destroyed during stack unwinding
+// poisons the mutex.
+template<typename T>
+class LockGuard {
+public:
+    LockGuard(LockGuard&& other) noexcept
+        : mutex_(std::exchange(other.mutex_, nullptr)), exceptions_(other.exceptions_) {}
+    LockGuard& operator=(LockGuard&& other) noexcept {
+        if (this != &other) {
+            release();
+            mutex_ = std::exchange(other.mutex_, nullptr);
+            exceptions_ = other.exceptions_;
+        }
+        return *this;
+    }
+    LockGuard(const LockGuard&) = delete;
+    LockGuard& operator=(const LockGuard&) = delete;
+    ~LockGuard() { release(); }
+
+    T& operator*() const { return mutex_->value_; }
+    T* operator->() const { return &mutex_->value_; }
+
+private:
+    friend class Mutex<T>;
+
+    explicit LockGuard(Mutex<T>* mutex) : mutex_(mutex), exceptions_(std::uncaught_exceptions()) {}
+
+    void release() {
+        if (!mutex_) return;
+        if (std::uncaught_exceptions() > exceptions_) {
+            mutex_->poisoned_.store(true, std::memory_order_relaxed);
+        }
+        mutex_->lock_.unlock();
+        mutex_ = nullptr;
+    }
+
+    Mutex<T>* mutex_;
+    int exceptions_; // uncaught exceptions when the guard was created
+};
+
+// A value of type T reachable only through a LockGuard, as specified by
+// mem_RFC.md section 7. lock(), try_lock() and lock_timeout() throw
+// VrePoisonError instead of returning a guard while the mutex is poisoned.
+template<typename T>
+class Mutex {
+public:
+    template<typename... Args>
+    explicit Mutex(Args&&... args) : value_(std::forward<Args>(args)...) {}
+
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    LockGuard<T> lock() {
+        lock_.lock();
+        return checked_guard();
+    }
+    std::optional<LockGuard<T>> try_lock() {
+        if (!lock_.try_lock()) return std::nullopt;
+        return checked_guard();
+    }
+    std::optional<LockGuard<T>> lock_timeout(std::chrono::nanoseconds timeout) {
+        if (!lock_.try_lock_until(std::chrono::steady_clock::now() + timeout)) return std::nullopt;
+        return checked_guard();
+    }
+
+    bool is_poisoned() const { return poisoned_.load(std::memory_order_relaxed); }
+    void clear_poison() { poisoned_.store(false, std::memory_order_relaxed); }
+
+    const VreQueueLock& raw_lock() const { return lock_; }
+
+private:
+    friend class LockGuard<T>;
+
+    VreQueueLock lock_;
+    std::atomic<bool> poisoned_{false};
+    T value_;
+
+    LockGuard<T> checked_guard() {
+        if (poisoned_.load(std::memory_order_relaxed)) {
+            lock_.unlock();
+            throw VrePoisonError();
+        }
+        return LockGuard<T>(this);
+    }
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_MUTEX_HPP
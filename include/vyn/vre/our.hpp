@@ -0,0 +1,260 @@
+#ifndef VYN_VRE_OUR_HPP
+#define VYN_VRE_OUR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "vyn/vre/memory.hpp"
+
+namespace vyn::vre {
+
+// Biased reference counting.
+//
+// Every our<T> object carries a VreRcHeader in front of the value. The thread
+// that created the object owns it and counts its own retains and releases in
+// the non-atomic `biased` field. All other threads use the atomic `shared`
+// field, whose low two bits are flags:
+//
+//   MERGED  the biased count has been folded into `shared`; from now on every
+//           thread, including the owner, uses `shared` only
+//   QUEUED  `shared` went negative and the object sits in the owner's merge
+//           queue; only queue processing may free it
+//
+// When the owner's biased count drops to zero it merges implicitly. When a
+// non-owner release drives `shared` negative, the object is queued to its owner,
+// which merges explicitly the next time it processes its queue (make_our does
+// this, as does our_process_pending_merges). Queues of exited threads are
+// merged by the thread that enqueues.
+//
+// Reference counting alone cannot free cycles. Types that report their
+// children (see VreRcBlock) can be handed to the cycle collector in
+// cycle_collector.hpp, which is off by default.
+
+struct VreRcHeader;
+
+// Heap walk callback: called once per our<T> reference an object holds.
+using VreChildVisitor = void (*)(VreRcHeader* child, void* context);
+
+// Operations that depend on the concrete type of the value.
+struct VreRcOps {
+    void (*destroy)(VreRcHeader* header); // runs ~T and frees the block
+    // Both nullptr for types that cannot hold our<T> references.
+    void (*trace)(VreRcHeader* header, VreChildVisitor visit, void* context);
+    void (*clear)(VreRcHeader* header); // drops every reference trace reports
+};
+
+// Per-thread ownership record. Records are never freed, so headers can keep
+// pointing at the record of a thread that has exited.
+struct VreThreadRecord {
+    std::mutex mutex;
+    std::vector<VreRcHeader*> queue; // objects waiting for an explicit merge
+    std::atomic<bool> pending{false};
+    bool alive = true;
+    std::vector<VreRcHeader*> cycle_candidates; // owner only; see cycle_collector.hpp
+};
+
+struct VreRcHeader {
+    static constexpr uint64_t MERGED = 1;
+    static constexpr uint64_t QUEUED = 2;
+    static constexpr uint64_t ONE = 4; // one reference in `shared`
+
+    VreThreadRecord* owner;
+    const VreRcOps* ops;
+    uint32_t biased;   // touched only by the owner
+    bool merged;       // touched only by the owner (or by whoever merges for a dead owner)
+    uint8_t color;     // cycle collector state, owner only
+    bool buffered;     // in the owner's cycle candidate buffer
+    std::atomic<uint64_t> shared;
+
+    static int64_t count_of(uint64_t word) { return static_cast<int64_t>(word) >> 2; }
+};
+
+// The calling thread's record, or nullptr until it first creates an object
+inline thread_local VreThreadRecord* t_rc_record = nullptr;
+
+// Cycle collector settings read on the fast paths; see cycle_collector.hpp
+inline std::atomic<bool> rc_cycle_collection_enabled{false};
+inline std::atomic<size_t> rc_cycle_root_threshold{4096};
+
+VreThreadRecord* rc_register_thread();
+void rc_release_shared(VreRcHeader* header);
+void rc_owner_unbias(VreRcHeader* header);
+void rc_buffer_candidate(VreRcHeader* header);
+void rc_collect_cycles_at_threshold();
+
+// Merges the objects other threads have queued to the calling thread.
+void our_process_pending_merges();
+
+inline bool rc_is_biased_to_me(const VreRcHeader* header) {
+    VreThreadRecord* me = t_rc_record;
+    return me != nullptr && header->owner == me && !header->merged;
+}
+
+inline void rc_retain(VreRcHeader* header) {
+    if (rc_is_biased_to_me(header)) {
+        ++header->biased;
+    } else {
+        header->shared.fetch_add(VreRcHeader::ONE, std::memory_order_relaxed);
+    }
+}
+
+inline void rc_release(VreRcHeader* header) {
+    if (rc_is_biased_to_me(header)) {
+        if (--header->biased == 0) {
+            rc_owner_unbias(header);
+        } else if (header->ops->trace && !header->buffered &&
+                   rc_cycle_collection_enabled.load(std::memory_order_relaxed)) {
+            rc_buffer_candidate(header); // may now be only referenced by a cycle
+        }
+    } else {
+        rc_release_shared(header);
+    }
+}
+
+// A type takes part in cycle collection by providing
+//   void trace_children(VreChildVisitor visit, void* context) const;
+//   void clear_children();
+template<typename T, typename = void>
+struct VreRcTraceable : std::false_type {};
+template<typename T>
+struct VreRcTraceable<T, std::void_t<decltype(std::declval<const T&>().trace_children(VreChildVisitor{}, nullptr)),
+                                     decltype(std::declval<T&>().clear_children())>> : std::true_type {};
+
+template<typename T>
+struct VreRcBlock {
+    VreRcHeader header;
+    T value;
+
+    template<typename... Args>
+    explicit VreRcBlock(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    static void destroy(VreRcHeader* header) {
+        auto* block = reinterpret_cast<VreRcBlock*>(header);
+        block->~VreRcBlock();
+        deallocate_raw(block, sizeof(VreRcBlock));
+    }
+    static void trace(VreRcHeader* header, VreChildVisitor visit, void* context) {
+        reinterpret_cast<VreRcBlock*>(header)->value.trace_children(visit, context);
+    }
+    static void clear(VreRcHeader* header) {
+        reinterpret_cast<VreRcBlock*>(header)->value.clear_children();
+    }
+    static constexpr VreRcOps make_ops() {
+        if constexpr (VreRcTraceable<T>::value) {
+            return VreRcOps{&VreRcBlock::destroy, &VreRcBlock::trace, &VreRcBlock::clear};
+        } else {
+            return VreRcOps{&VreRcBlock::destroy, nullptr, nullptr};
+        }
+    }
+    static const VreRcOps ops;
+};
+
+template<typename T>
+const VreRcOps VreRcBlock<T>::ops = VreRcBlock<T>::make_ops();
+
+// Intrusive shared pointer with biased reference counting. Unlike
+// std::shared_ptr there is no separate control block and no aliasing or
+// base-class conversion: an our<T> always points at a T made by make_our<T>.
+//
+// Copying and destroying an our<T> goes through the type-erased header only,
+// so T may be incomplete wherever our<T> is merely passed around.
+template<typename T>
+class our {
+public:
+    our() noexcept : header_(nullptr) {}
+    our(std::nullptr_t) noexcept : header_(nullptr) {}
+
+    our(const our& other) noexcept : header_(other.header_) {
+        if (header_) rc_retain(header_);
+    }
+    our(our&& other) noexcept : header_(other.header_) { other.header_ = nullptr; }
+
+    our& operator=(const our& other) noexcept {
+        if (other.header_) rc_retain(other.header_);
+        reset();
+        header_ = other.header_;
+        return *this;
+    }
+    our& operator=(our&& other) noexcept {
+        if (this != &other) {
+            reset();
+            header_ = other.header_;
+            other.header_ = nullptr;
+        }
+        return *this;
+    }
+    ~our() { reset(); }
+
+    void reset() noexcept {
+        if (header_) {
+            VreRcHeader* header = header_;
+            header_ = nullptr;
+            rc_release(header);
+        }
+    }
+
+    T* get() const noexcept { return header_ ? &block()->value : nullptr; }
+    T& operator*() const noexcept { return block()->value; }
+    T* operator->() const noexcept { return &block()->value; }
+    explicit operator bool() const noexcept { return header_ != nullptr; }
+
+    VreRcHeader* header() const noexcept { return header_; }
+
+    // Number of references. Exact only when no other thread is using the object.
+    int64_t use_count() const noexcept {
+        if (!header_) return 0;
+        int64_t shared = VreRcHeader::count_of(header_->shared.load(std::memory_order_relaxed));
+        return header_->merged ? shared : shared + header_->biased;
+    }
+
+    friend bool operator==(const our& a, const our& b) noexcept { return a.header_ == b.header_; }
+    friend bool operator!=(const our& a, const our& b) noexcept { return a.header_ != b.header_; }
+
+    template<typename U, typename... Args>
+    friend our<U> make_our(Args&&... args);
+
+private:
+    VreRcHeader* header_;
+
+    VreRcBlock<T>* block() const noexcept { return reinterpret_cast<VreRcBlock<T>*>(header_); }
+};
+
+template<typename T, typename... Args>
+our<T> make_our(Args&&... args) {
+    static_assert(alignof(VreRcBlock<T>) <= SLAB_ALIGNMENT, "over-aligned types are not supported by our<T>");
+    VreThreadRecord* me = t_rc_record ? t_rc_record : rc_register_thread();
+    if (me->pending.load(std::memory_order_relaxed)) {
+        our_process_pending_merges();
+    }
+    if (me->cycle_candidates.size() >= rc_cycle_root_threshold.load(std::memory_order_relaxed)) {
+        rc_collect_cycles_at_threshold();
+    }
+    void* mem = allocate_raw(sizeof(VreRcBlock<T>));
+    VreRcBlock<T>* block;
+    try {
+        block = new (mem) VreRcBlock<T>(std::forward<Args>(args)...);
+    } catch (...) {
+        deallocate_raw(mem, sizeof(VreRcBlock<T>));
+        throw;
+    }
+    block->header.owner = me;
+    block->header.ops = &VreRcBlock<T>::ops;
+    block->header.biased = 1;
+    block->header.merged = false;
+    block->header.color = 0;
+    block->header.buffered = false;
+    new (&block->header.shared) std::atomic<uint64_t>(0);
+    our<T> result;
+    result.header_ = &block->header;
+    return result;
+}
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_OUR_HPP
@@ -0,0 +1,203 @@
+#ifndef VYN_VRE_PACKED_VALUE_HPP
+#define VYN_VRE_PACKED_VALUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "vyn/vre/value.hpp"
+
+namespace vyn::vre {
+
+static_assert(sizeof(void*) == 8, "VrePackedValue requires 64-bit pointers");
+
+// Kind of a heap cell referenced by a VrePackedValue.
+enum class VreHeapKind : uint32_t {
+    BOXED_INT,  // i64 that does not fit in the 48-bit inline payload
+    STRING,
+    OBJECT,     // our<VreObject> reference
+    ARRAY,      // our<VreArray> reference
+};
+
+// Common header of every heap cell a VrePackedValue can point to.
+// Cells are reference counted; the last release destroys the cell.
+struct VreHeapCell {
+    std::atomic<uint32_t> refcount;
+    VreHeapKind kind;
+
+    explicit VreHeapCell(VreHeapKind k) : refcount(1), kind(k) {}
+};
+
+struct VreBoxedInt : VreHeapCell {
+    int64_t value;
+    explicit VreBoxedInt(int64_t v) : VreHeapCell(VreHeapKind::BOXED_INT), value(v) {}
+};
+
+struct VreBoxedString : VreHeapCell {
+    VreString value;
+    explicit VreBoxedString(VreString v) : VreHeapCell(VreHeapKind::STRING), value(std::move(v)) {}
+};
+
+// The cell holds one our<T> reference; the object's own count is untouched
+// by copies of the packed value
+struct VreBoxedObject : VreHeapCell {
+    our<VreObject> value;
+    explicit VreBoxedObject(our<VreObject> v) : VreHeapCell(VreHeapKind::OBJECT), value(std::move(v)) {}
+};
+
+struct VreBoxedArray : VreHeapCell {
+    our<VreArray> value;
+    explicit VreBoxedArray(our<VreArray> v) : VreHeapCell(VreHeapKind::ARRAY), value(std::move(v)) {}
+};
+
+// 8-byte NaN-boxed alternative to VreValue.
+//
+// Doubles are stored as their IEEE-754 bits, with every NaN canonicalized to
+// the positive quiet NaN so that the negative quiet NaN space is free for tags.
+// The top 16 bits select the encoding:
+//
+//   < 0xFFF9        f64
+//   0xFFF9          nil / false / true (payload 0 / 2 / 3)
+//   0xFFFA          i48, sign-extended from the low 48 bits
+//   0xFFFB          pointer to a VreHeapCell (boxed i64, string, object or array)
+//
+// Integers outside the i48 range are boxed on the heap; is_integer() and
+// as_integer() hide the difference. Copies only touch a refcount when the
+// value refers to a heap cell.
+class VrePackedValue {
+public:
+    static constexpr uint64_t TAG_SHIFT = 48;
+    static constexpr uint64_t PAYLOAD_MASK = (uint64_t(1) << TAG_SHIFT) - 1;
+    static constexpr uint64_t TAG_SPECIAL = uint64_t(0xFFF9) << TAG_SHIFT;
+    static constexpr uint64_t TAG_INT = uint64_t(0xFFFA) << TAG_SHIFT;
+    static constexpr uint64_t TAG_HEAP = uint64_t(0xFFFB) << TAG_SHIFT;
+    static constexpr uint64_t CANONICAL_NAN = 0x7FF8000000000000ULL;
+
+    static constexpr uint64_t NIL_BITS = TAG_SPECIAL | 0;
+    static constexpr uint64_t FALSE_BITS = TAG_SPECIAL | 2;
+    static constexpr uint64_t TRUE_BITS = TAG_SPECIAL | 3;
+
+    static constexpr int64_t INT48_MIN = -(int64_t(1) << 47);
+    static constexpr int64_t INT48_MAX = (int64_t(1) << 47) - 1;
+
+    // Constructors mirror VreValue
+    VrePackedValue() noexcept : bits_(NIL_BITS) {}
+    explicit VrePackedValue(bool val) noexcept : bits_(val ? TRUE_BITS : FALSE_BITS) {}
+    explicit VrePackedValue(int64_t val) {
+        if (val >= INT48_MIN && val <= INT48_MAX) {
+            bits_ = TAG_INT | (static_cast<uint64_t>(val) & PAYLOAD_MASK);
+        } else {
+            bits_ = encode_cell(new VreBoxedInt(val));
+        }
+    }
+    explicit VrePackedValue(double val) noexcept {
+        if (val != val) {
+            bits_ = CANONICAL_NAN;
+        } else {
+            std::memcpy(&bits_, &val, sizeof(bits_));
+        }
+    }
+    explicit VrePackedValue(const char* s) : bits_(encode_cell(new VreBoxedString(VreString(s)))) {}
+    explicit VrePackedValue(const std::string& s) : bits_(encode_cell(new VreBoxedString(VreString(s)))) {}
+    explicit VrePackedValue(VreString s) : bits_(encode_cell(new VreBoxedString(std::move(s)))) {}
+    explicit VrePackedValue(our<VreObject> o) : bits_(encode_cell(new VreBoxedObject(std::move(o)))) {}
+    explicit VrePackedValue(our<VreArray> a) : bits_(encode_cell(new VreBoxedArray(std::move(a)))) {}
+
+    VrePackedValue(const VrePackedValue& other) noexcept : bits_(other.bits_) { retain(); }
+    VrePackedValue(VrePackedValue&& other) noexcept : bits_(other.bits_) { other.bits_ = NIL_BITS; }
+    VrePackedValue& operator=(const VrePackedValue& other) noexcept {
+        if (this != &other) {
+            other.retain();
+            release();
+            bits_ = other.bits_;
+        }
+        return *this;
+    }
+    VrePackedValue& operator=(VrePackedValue&& other) noexcept {
+        if (this != &other) {
+            release();
+            bits_ = other.bits_;
+            other.bits_ = NIL_BITS;
+        }
+        return *this;
+    }
+    ~VrePackedValue() { release(); }
+
+    // Conversion to and from the variant-based representation
+    static VrePackedValue from_value(const VreValue& value);
+    VreValue to_value() const;
+
+    VreValueType type() const noexcept;
+
+    bool is_nil() const noexcept { return bits_ == NIL_BITS; }
+    bool is_boolean() const noexcept { return bits_ == TRUE_BITS || bits_ == FALSE_BITS; }
+    bool is_float() const noexcept { return tag() < 0xFFF9; }
+    bool is_integer() const noexcept {
+        return (bits_ & ~PAYLOAD_MASK) == TAG_INT || (is_heap() && cell()->kind == VreHeapKind::BOXED_INT);
+    }
+    bool is_string() const noexcept { return is_heap() && cell()->kind == VreHeapKind::STRING; }
+    bool is_object() const noexcept { return is_heap() && cell()->kind == VreHeapKind::OBJECT; }
+    bool is_array() const noexcept { return is_heap() && cell()->kind == VreHeapKind::ARRAY; }
+    // True if the value refers to a heap cell (boxed integer, string, object or array)
+    bool is_heap() const noexcept { return (bits_ & ~PAYLOAD_MASK) == TAG_HEAP; }
+
+    bool as_boolean() const {
+        if (!is_boolean()) throw std::runtime_error("VrePackedValue is not a boolean");
+        return bits_ == TRUE_BITS;
+    }
+    int64_t as_integer() const {
+        if ((bits_ & ~PAYLOAD_MASK) == TAG_INT) {
+            return static_cast<int64_t>(bits_ << 16) >> 16;
+        }
+        if (!is_integer()) throw std::runtime_error("VrePackedValue is not an integer");
+        return static_cast<const VreBoxedInt*>(cell())->value;
+    }
+    double as_float() const {
+        if (!is_float()) throw std::runtime_error("VrePackedValue is not a float");
+        double d;
+        std::memcpy(&d, &bits_, sizeof(d));
+        return d;
+    }
+    const VreString& as_string() const {
+        if (!is_string()) throw std::runtime_error("VrePackedValue is not a string");
+        return static_cast<const VreBoxedString*>(cell())->value;
+    }
+    const our<VreObject>& as_object() const {
+        if (!is_object()) throw std::runtime_error("VrePackedValue is not an object");
+        return static_cast<const VreBoxedObject*>(cell())->value;
+    }
+    const our<VreArray>& as_array() const {
+        if (!is_array()) throw std::runtime_error("VrePackedValue is not an array");
+        return static_cast<const VreBoxedArray*>(cell())->value;
+    }
+
+    uint64_t raw_bits() const noexcept { return bits_; }
+
+private:
+    uint64_t bits_;
+
+    uint16_t tag() const noexcept { return static_cast<uint16_t>(bits_ >> TAG_SHIFT); }
+    VreHeapCell* cell() const noexcept { return reinterpret_cast<VreHeapCell*>(bits_ & PAYLOAD_MASK); }
+
+    static uint64_t encode_cell(VreHeapCell* c) noexcept {
+        return TAG_HEAP | (reinterpret_cast<uint64_t>(c) & PAYLOAD_MASK);
+    }
+
+    void retain() const noexcept {
+        if (is_heap()) cell()->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void release() noexcept {
+        if (is_heap() && cell()->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy_cell(cell());
+        }
+    }
+    static void destroy_cell(VreHeapCell* c) noexcept;
+};
+
+static_assert(sizeof(VrePackedValue) == 8, "VrePackedValue must stay 8 bytes");
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_PACKED_VALUE_HPP
@@ -0,0 +1,127 @@
+#ifndef VYN_VRE_PARALLEL_HPP
+#define VYN_VRE_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <type_traits>
+
+#include "vyn/vre/executor.hpp"
+#include "vyn/vre/runtime_types.hpp"
+#include "vyn/vre/value.hpp"
+
+namespace vyn::vre {
+
+namespace parallel_detail {
+
+template<typename Body>
+struct Job {
+    const Body& body;
+    int64_t grain;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error; // the first exception thrown by the body
+
+    Job(const Body& body, int64_t grain) : body(body), grain(grain) {}
+};
+
+// Runs [begin, end) of a job: ranges larger than the grain split in two
+// halves awaited as children, so the first steal of a range takes half of
+// it and stolen work stays coarse.
+template<typename Body>
+class RangeFrame final : public VreFrame {
+public:
+    RangeFrame(Job<Body>& job, int64_t begin, int64_t end) : job_(job), begin_(begin), end_(end) {}
+
+    VrePoll resume(VreTaskContext& ctx) override {
+        if (state_ == 1 || job_.failed.load(std::memory_order_relaxed)) return VrePoll::READY;
+        if (end_ - begin_ > job_.grain) {
+            int64_t mid = begin_ + (end_ - begin_) / 2;
+            state_ = 1;
+            ctx.await_all(this, {new RangeFrame(job_, begin_, mid), new RangeFrame(job_, mid, end_)});
+            return VrePoll::PENDING;
+        }
+        try {
+            job_.body(begin_, end_);
+        } catch (...) {
+            if (!job_.failed.exchange(true)) job_.error = std::current_exception();
+        }
+        return VrePoll::READY;
+    }
+
+private:
+    Job<Body>& job_;
+    int64_t begin_;
+    int64_t end_;
+};
+
+} // namespace parallel_detail
+
+// Chunk size giving each worker about eight chunks to balance with
+inline int64_t parallel_grain(const VreExecutor& executor, int64_t count) {
+    return std::max<int64_t>(1, count / static_cast<int64_t>(executor.worker_count() * 8));
+}
+
+// Calls body(lo, hi) over disjoint chunks covering [begin, end) on the
+// executor's workers and returns when all have run. `grain` bounds the chunk
+// length; 0 picks parallel_grain(). If the body throws, chunks not yet
+// started are skipped and the first exception is rethrown here. Called from
+// one of the executor's own workers (a nested parallel loop), the whole
+// range runs inline as one chunk.
+template<typename Body>
+void parallel_for_chunks(VreExecutor& executor, int64_t begin, int64_t end, const Body& body, int64_t grain = 0) {
+    if (end <= begin) return;
+    if (executor.on_worker()) {
+        body(begin, end);
+        return;
+    }
+    parallel_detail::Job<Body> job(body, grain > 0 ? grain : parallel_grain(executor, end - begin));
+    executor.block_on(new parallel_detail::RangeFrame<Body>(job, begin, end));
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+// `@parallel for (i in begin..end) { body(i) }`
+template<typename Body>
+void parallel_for(VreExecutor& executor, int64_t begin, int64_t end, const Body& body, int64_t grain = 0) {
+    parallel_for_chunks(
+        executor, begin, end,
+        [&body](int64_t lo, int64_t hi) {
+            for (int64_t i = lo; i < hi; ++i) body(i);
+        },
+        grain);
+}
+
+// `@parallel [fn(i) for i in begin..end]`: the array is allocated at its
+// final size up front and every chunk writes its own elements in place.
+// T is the element type the compiler inferred: int64_t and double fill
+// unboxed INT and FLOAT arrays; anything else is collected as VreValue into
+// a GENERIC array.
+template<typename T, typename Fn>
+VreArray parallel_collect(VreExecutor& executor, int64_t begin, int64_t end, const Fn& fn, int64_t grain = 0) {
+    static_assert(std::is_same_v<T, int64_t> || std::is_same_v<T, double> || std::is_same_v<T, VreValue>,
+                  "parallel_collect produces Int, Float or boxed arrays");
+    size_t count = end > begin ? static_cast<size_t>(end - begin) : 0;
+    VreArray out;
+    T* data;
+    if constexpr (std::is_same_v<T, int64_t>) {
+        out = VreArray::filled(count, VreArrayKind::INT);
+        data = out.int_data();
+    } else if constexpr (std::is_same_v<T, double>) {
+        out = VreArray::filled(count, VreArrayKind::FLOAT);
+        data = out.float_data();
+    } else {
+        out = VreArray::filled(count, VreArrayKind::GENERIC);
+        data = out.generic_data();
+    }
+    parallel_for_chunks(
+        executor, begin, end,
+        [&](int64_t lo, int64_t hi) {
+            for (int64_t i = lo; i < hi; ++i) data[i - begin] = fn(i);
+        },
+        grain);
+    return out;
+}
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_PARALLEL_HPP
@@ -0,0 +1,123 @@
+#ifndef VYN_VRE_REGION_HPP
+#define VYN_VRE_REGION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "vyn/vre/memory.hpp"
+
+namespace vyn::vre {
+
+// Bump-pointer arena backing a `scoped { ... }` block.
+//
+// Allocation appends to the current chunk; nothing is freed individually.
+// Destroying (or resetting) the region runs the registered finalizers of
+// non-trivially-destructible objects and releases every chunk at once.
+class VreRegion {
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 32 * 1024;
+
+    explicit VreRegion(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    ~VreRegion();
+
+    VreRegion(const VreRegion&) = delete;
+    VreRegion& operator=(const VreRegion&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        uintptr_t aligned = (cursor_ + (alignment - 1)) & ~(uintptr_t(alignment) - 1);
+        if (aligned + size > limit_) {
+            return allocate_slow(size, alignment);
+        }
+        cursor_ = aligned + size;
+        bytes_allocated_ += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Constructs a T in the region. Its destructor, if any, runs when the
+    // region is released.
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* mem = allocate(sizeof(T), alignof(T));
+        T* obj = new (mem) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            finalizers_.push_back({[](void* p) { static_cast<T*>(p)->~T(); }, obj});
+        }
+        return obj;
+    }
+
+    // True if `ptr` points into memory owned by this region
+    bool contains(const void* ptr) const;
+
+    // Runs finalizers and frees all chunks except the current one, which is rewound
+    void reset();
+
+    size_t bytes_allocated() const { return bytes_allocated_; }
+    size_t chunk_count() const { return chunks_.size(); }
+
+private:
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    size_t chunk_size_;
+    uintptr_t cursor_ = 0;
+    uintptr_t limit_ = 0;
+    size_t bytes_allocated_ = 0;
+    std::vector<Chunk> chunks_;
+    std::vector<Finalizer> finalizers_;
+
+    void* allocate_slow(size_t size, size_t alignment);
+    void run_finalizers();
+};
+
+// RAII guard for a `scoped` block: creates a region and makes it the thread's
+// current region until the guard is destroyed. Scopes nest.
+class RegionScope {
+public:
+    RegionScope();
+    ~RegionScope();
+
+    RegionScope(const RegionScope&) = delete;
+    RegionScope& operator=(const RegionScope&) = delete;
+
+    VreRegion& region() { return region_; }
+
+private:
+    VreRegion region_;
+};
+
+// Innermost active region on this thread, or nullptr outside any scoped block
+VreRegion* current_region();
+
+// Nesting depth of the region that owns `ptr`: 0 for memory outside every
+// active region, 1 for the outermost scoped block, and so on.
+size_t region_depth_of(const void* ptr);
+
+// Allocates from the current region if there is one, otherwise from the heap.
+// Memory obtained outside a region must be released with deallocate_raw.
+void* scoped_allocate(size_t size);
+
+// Checked escape: throws std::runtime_error if storing `value` into `holder`
+// would let a region pointer outlive its region (the value lives in a deeper
+// region than the holder).
+void check_region_store(const void* holder, const void* value);
+
+// Promotion: copies a region-allocated object to the heap so it can outlive
+// the scoped block.
+template<typename T>
+my<T> promote(const T& object) {
+    return make_my<T>(object);
+}
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_REGION_HPP
@@ -0,0 +1,111 @@
+#ifndef VYN_VRE_RESULT_HPP
+#define VYN_VRE_RESULT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "vyn/vre/value.hpp"
+
+namespace vyn::vre {
+
+// Id of the error type called `name`, the same for every call with that
+// name; the empty name is 0, for errors thrown without a type. Thread-safe.
+uint32_t vre_error_type(std::string_view name);
+// Name registered for `type`
+std::string vre_error_type_name(uint32_t type);
+
+// An error in flight: the value of a `throw`, received by a `catch`.
+// `catch (e: NetworkError)` matches errors whose type is
+// vre_error_type("NetworkError"); an untyped catch matches all of them.
+struct VreError {
+    uint32_t type = 0;
+    VreValue payload;
+
+    bool is(uint32_t other) const { return type == other; }
+};
+
+// Thrown when C++ code asks a failed VreResult for its value: the boundary
+// where an error nothing caught becomes a C++ exception
+class VreUncaughtError : public std::runtime_error {
+public:
+    explicit VreUncaughtError(const VreError& error)
+        : std::runtime_error("Uncaught error" +
+                             (error.type ? " of type " + vre_error_type_name(error.type) : std::string())),
+          type(error.type) {}
+
+    uint32_t type;
+};
+
+// The error being propagated on this thread. A `throw` stores it here and
+// each frame on the way to the handler only passes a failed flag; the
+// handler takes it out. There is one slot per thread, so the error must be
+// taken before the next throw or before the task suspends.
+VreError& vre_current_error();
+// Stores `error` in vre_current_error(); kept out of line, off the fast path
+void vre_raise(VreError&& error);
+
+// Tag for a failed VreResult whose error is already in vre_current_error():
+// how a frame passes on the error of a call it made
+struct VreFailed {};
+inline constexpr VreFailed vre_failed{};
+
+// What a function that can fail returns once ErrorLowering has lowered its
+// `throw`s (FunctionDeclaration::canFail): its value and a failed flag, so
+// for scalar T it comes back in registers. Callers test is_err() after the
+// call and branch to their handler, or return vre_failed in turn. An error
+// costs a compare and a return per frame instead of an unwinder search,
+// and a call that succeeds costs one untaken branch.
+template<typename T>
+class [[nodiscard]] VreResult {
+public:
+    static_assert(std::is_default_constructible_v<T>, "a failed VreResult holds a default value");
+
+    VreResult(T value) : value_(std::move(value)) {}
+    VreResult(VreError error) : failed_(true) { vre_raise(std::move(error)); }
+    VreResult(VreFailed) : failed_(true) {}
+
+    bool is_ok() const { return !failed_; }
+    bool is_err() const { return failed_; }
+
+    // Throws VreUncaughtError, taking the error, if this failed
+    T& value() {
+        if (failed_) throw VreUncaughtError(take_error());
+        return value_;
+    }
+    // Only valid if is_err()
+    VreError& error() const { return vre_current_error(); }
+    VreError take_error() const { return std::move(vre_current_error()); }
+
+private:
+    T value_{};
+    bool failed_ = false;
+};
+
+template<>
+class [[nodiscard]] VreResult<void> {
+public:
+    VreResult() = default;
+    VreResult(VreError error) : failed_(true) { vre_raise(std::move(error)); }
+    VreResult(VreFailed) : failed_(true) {}
+
+    bool is_ok() const { return !failed_; }
+    bool is_err() const { return failed_; }
+
+    void value() const {
+        if (failed_) throw VreUncaughtError(take_error());
+    }
+    VreError& error() const { return vre_current_error(); }
+    VreError take_error() const { return std::move(vre_current_error()); }
+
+private:
+    bool failed_ = false;
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_RESULT_HPP
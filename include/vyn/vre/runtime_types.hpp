@@ -8,82 +8,234 @@
 
 #include "vyn/vre/value.hpp" // VreValue is fundamental
 #include "vyn/vre/memory.hpp" // For my<T>, etc.
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/shape.hpp"
+#include "vyn/vre/type_info.hpp"
+#include "vyn/vre/trait_object.hpp"
+#include "vyn/vre/closure.hpp"
+#include <stdexcept>
+#include <string_view>
 
 namespace vyn::vre {
 
 // Forward declarations
 struct VreObject;
 struct VreArray;
-struct VreString; // If more complex than std::string in VreValue
 struct VreSlice;
-struct VreTraitObject;
-struct VreFunction; // Or VreClosure
+class VreTraitObject; // trait_object.hpp
+struct VreFunction; // closure.hpp
 
 // Represents a Vyn struct/class instance at runtime
-struct VreObject {
+struct VreObject : SlabAllocated<VreObject> {
     // Option 1: Fields identified by name (more dynamic, REPL-friendly)
     // std::unordered_map<std::string, VreValue> fields;
 
     // Option 2: Fields as a vector (more performant if names are resolved to indices by compiler)
     std::vector<VreValue> fields_by_index;
     
-    // TypeId type_id; // Link to static type information (defined in type_info.hpp perhaps)
+    // Index into the compilation unit's VreTypeTable (type_info.hpp);
+    // VRE_DYNAMIC_TYPE for shaped objects
+    VreTypeId type_id = VRE_DYNAMIC_TYPE;
+
+    // Hidden class for dynamically shaped objects (REPL, object literals);
+    // nullptr for objects whose fields the compiler resolved to indices.
+    const VreShape* shape = nullptr;
 
     // Constructor, methods for field access, etc.
-    // VreObject(TypeId id, size_t field_count) : type_id(id), fields_by_index(field_count) {}
+    // VreObject(VreTypeId id, size_t field_count) : type_id(id), fields_by_index(field_count) {}
+
+    // Name-keyed access for dynamic code. Inline caches (inline_cache.hpp)
+    // skip the shape lookup once a site is warm.
+    VreValue* find_field(std::string_view name) {
+        int slot = shape ? shape->slot_of(name) : -1;
+        return slot < 0 ? nullptr : &fields_by_index[slot];
+    }
+    void set_field(const VreString& name, VreValue value) {
+        if (!shape) {
+            if (!fields_by_index.empty()) {
+                throw std::runtime_error("Cannot add named fields to an index-keyed VreObject");
+            }
+            shape = VreShape::empty();
+        }
+        if (VreValue* field = find_field(name.view())) {
+            *field = std::move(value);
+            return;
+        }
+        shape = shape->with_property(name);
+        fields_by_index.push_back(std::move(value));
+    }
+
+    // Heap walk for the cycle collector (see cycle_collector.hpp)
+    void trace_children(VreChildVisitor visit, void* context) const {
+        for (const VreValue& field : fields_by_index) {
+            if (VreRcHeader* child = field.heap_ref()) visit(child, context);
+        }
+    }
+    void clear_children() {
+        fields_by_index.clear();
+        shape = nullptr;
+    }
 };
 
-// Represents a Vyn dynamic array at runtime
-struct VreArray {
-    std::vector<VreValue> elements;
-    // Capacity, length are handled by std::vector
+// Element representation of a VreArray. An array starts EMPTY, takes the
+// kind of its first element, and moves to GENERIC on the first store of a
+// value of another type. It never transitions back.
+enum class VreArrayKind : uint8_t {
+    EMPTY,
+    INT,     // unboxed int64_t
+    FLOAT,   // unboxed double
+    BOOL,    // one bit per element
+    GENERIC, // boxed VreValue
 };
 
-// Represents a Vyn string at runtime (if std::string in VreValue is not sufficient)
-// struct VreString {
-//     // Could wrap std::string or be custom for specific encoding/small-string-optimization etc.
-//     std::string data;
-// };
-
-// Represents a Vyn slice (a view into an array or other contiguous memory)
-struct VreSlice {
-    VreValue* data_ptr; // Pointer to the first element
-    size_t length;
-
-    // Slices do not own their data
-    VreSlice(VreValue* ptr = nullptr, size_t len = 0) : data_ptr(ptr), length(len) {}
+// Represents a Vyn dynamic array at runtime.
+//
+// Homogeneous Int, Float and Bool arrays are stored unboxed in contiguous
+// storage aligned to STORAGE_ALIGNMENT, so numeric loops can run over
+// int_data()/float_data() directly and the compiler can vectorize them.
+struct VreArray : SlabAllocated<VreArray> {
+public:
+    static constexpr size_t STORAGE_ALIGNMENT = 64; // a cache line; enough for any SIMD load
+
+    VreArray() = default;
+    VreArray(const VreArray& other);
+    VreArray(VreArray&& other) noexcept;
+    VreArray& operator=(VreArray other) noexcept;
+    ~VreArray();
+
+    // `size` zero elements of an unboxed `kind`, or nils if `kind` is GENERIC
+    // or EMPTY, for filling in place through int_data(), float_data() or
+    // generic_data(). Distinct elements may be filled from different threads,
+    // except for BOOL, whose elements share words.
+    static VreArray filled(size_t size, VreArrayKind kind);
+
+    VreArrayKind kind() const { return kind_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Element access; throws std::runtime_error when out of bounds
+    VreValue get(size_t index) const;
+    VreValue get_unchecked(size_t index) const;
+    void set(size_t index, VreValue value);
+    void push(VreValue value);
+    void reserve(size_t capacity);
+
+    // Unboxed storage, or nullptr if the array is of another kind
+    int64_t* int_data() { return kind_ == VreArrayKind::INT ? static_cast<int64_t*>(storage_) : nullptr; }
+    double* float_data() { return kind_ == VreArrayKind::FLOAT ? static_cast<double*>(storage_) : nullptr; }
+    const int64_t* int_data() const { return kind_ == VreArrayKind::INT ? static_cast<int64_t*>(storage_) : nullptr; }
+    const double* float_data() const { return kind_ == VreArrayKind::FLOAT ? static_cast<double*>(storage_) : nullptr; }
+
+    // Boxed elements of a GENERIC array (empty for other kinds)
+    const std::vector<VreValue>& generic_elements() const { return elements_; }
+    VreValue* generic_data() { return kind_ == VreArrayKind::GENERIC ? elements_.data() : nullptr; }
+
+    // Bytes of element storage in use, excluding spare capacity
+    size_t storage_bytes() const;
+
+    // Number of live VreSlices over this array. A borrowed array cannot grow
+    // or change kind; attempts throw std::runtime_error.
+    uint32_t borrow_count() const { return borrows_; }
+    void borrow() { ++borrows_; }
+    void unborrow() { --borrows_; }
+
+    void trace_children(VreChildVisitor visit, void* context) const {
+        for (const VreValue& element : elements_) {
+            if (VreRcHeader* child = element.heap_ref()) visit(child, context);
+        }
+    }
+    void clear_children();
+
+private:
+    VreArrayKind kind_ = VreArrayKind::EMPTY;
+    size_t size_ = 0;
+    size_t capacity_ = 0;           // in elements (bits for BOOL)
+    void* storage_ = nullptr;       // INT, FLOAT and BOOL storage
+    std::vector<VreValue> elements_; // GENERIC storage
+    uint32_t borrows_ = 0;
+
+    static VreArrayKind kind_for(const VreValue& value);
+    size_t storage_capacity_bytes() const;
+    void grow(size_t min_capacity);
+    void store_unboxed(size_t index, const VreValue& value);
+    void make_generic();
+    void release_storage();
+    void check_not_borrowed(const char* operation) const;
 };
 
-// Represents a Vyn trait object for dynamic dispatch
-struct VreTraitObject {
-    my<void> instance_data; // Pointer to the actual object data (type-erased)
-    void* vtable_ptr;        // Pointer to the virtual table for this trait implementation
-
-    // The vtable would be a struct of function pointers
-    // Example:
-    // struct MyTraitVTable {
-    //     RetType (*method1)(void* self, Arg1Type, Arg2Type);
-    //     RetType (*method2)(void* self, Arg1Type);
-    // };
-};
+// Vyn strings at runtime are VreString (see string.hpp): inline storage for
+// short strings, a shared immutable buffer for long ones.
 
-// Represents a Vyn function or closure at runtime
-struct VreFunction {
-    // Could be a native function pointer, or a structure for closures
-    // For closures, it would need to store:
-    // 1. The function pointer
-    // 2. Captured environment (e.g, a my<VreObject> or similar)
-    
-    // Using std::function as a placeholder for complex callable
-    // std::function<VreValue(std::vector<VreValue>)> callable;
-    
-    // Or more low-level:
-    // using NativeFuncPtr = VreValue (*)(/* args context */);
-    // NativeFuncPtr ptr;
-    // my<VreObject> captured_env; // If it's a closure
+// Represents a Vyn slice: a bounds-checked view of elements
+// [offset, offset + length) of a VreArray of any kind.
+//
+// Slices do not own their data. While any slice borrows an array, the array
+// refuses to grow or change its element kind, so element storage seen
+// through a slice (including int_data()/float_data()) stays put. A slice must
+// not outlive its array. Subslicing (`s[a..b]`) is O(1) and never copies.
+struct VreSlice {
+public:
+    VreSlice() = default;
+    explicit VreSlice(VreArray& array) : VreSlice(array, 0, array.size()) {}
+    // Throws std::runtime_error unless begin <= end <= array.size()
+    VreSlice(VreArray& array, size_t begin, size_t end);
+
+    VreSlice(const VreSlice& other) : array_(other.array_), offset_(other.offset_), length_(other.length_) {
+        if (array_) array_->borrow();
+    }
+    VreSlice& operator=(const VreSlice& other) {
+        VreSlice copy(other);
+        std::swap(array_, copy.array_);
+        std::swap(offset_, copy.offset_);
+        std::swap(length_, copy.length_);
+        return *this;
+    }
+    ~VreSlice() {
+        if (array_) array_->unborrow();
+    }
+
+    size_t size() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    VreArray* array() const { return array_; }
+    size_t offset() const { return offset_; }
+
+    // Checked access; throws std::runtime_error when out of bounds
+    VreValue get(size_t index) const {
+        check_index(index);
+        return array_->get_unchecked(offset_ + index);
+    }
+    void set(size_t index, VreValue value) {
+        check_index(index);
+        array_->set(offset_ + index, std::move(value));
+    }
+
+    // For code whose bounds check was hoisted or proven redundant
+    VreValue get_unchecked(size_t index) const { return array_->get_unchecked(offset_ + index); }
+
+    // Unboxed view of the elements, or nullptr if the array is of another kind
+    const int64_t* int_data() const {
+        const int64_t* data = array_ ? static_cast<const VreArray*>(array_)->int_data() : nullptr;
+        return data ? data + offset_ : nullptr;
+    }
+    const double* float_data() const {
+        const double* data = array_ ? static_cast<const VreArray*>(array_)->float_data() : nullptr;
+        return data ? data + offset_ : nullptr;
+    }
+
+    // Elements [begin, end) of this slice, sharing its storage
+    VreSlice subslice(size_t begin, size_t end) const;
+
+private:
+    VreArray* array_ = nullptr;
+    size_t offset_ = 0;
+    size_t length_ = 0;
+
+    void check_index(size_t index) const {
+        if (index >= length_) throw_out_of_bounds(index);
+    }
+    [[noreturn]] void throw_out_of_bounds(size_t index) const;
 };
 
-
 } // namespace vyn::vre
 
 #endif // VYN_VRE_RUNTIME_TYPES_HPP
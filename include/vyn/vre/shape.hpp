@@ -0,0 +1,55 @@
+#ifndef VYN_VRE_SHAPE_HPP
+#define VYN_VRE_SHAPE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string_view>
+
+#include "vyn/vre/string.hpp"
+
+namespace vyn::vre {
+
+// Hidden class of a dynamically shaped VreObject.
+//
+// A shape records which property lives in which slot of fields_by_index.
+// Shapes form a transition tree rooted at VreShape::empty(): adding property
+// `p` to an object of shape S moves it to the child of S reached through `p`,
+// so objects that gain the same properties in the same order share a shape and
+// inline caches can key on the shape pointer alone. Shapes are immutable once
+// created and are never freed.
+class VreShape {
+public:
+    // The shape of an object with no properties
+    static const VreShape* empty();
+
+    // The shape reached by adding `name`, created on first use. Must not be
+    // called with a name the shape already has.
+    const VreShape* with_property(const VreString& name) const;
+
+    // Slot of `name`, or -1 if objects of this shape do not have it
+    int slot_of(std::string_view name) const;
+
+    const VreShape* parent() const { return parent_; }
+    // The property this shape added to its parent (empty for the root)
+    const VreString& last_property() const { return name_; }
+    size_t property_count() const { return property_count_; }
+
+    VreShape(const VreShape&) = delete;
+    VreShape& operator=(const VreShape&) = delete;
+
+private:
+    VreShape() = default;
+    VreShape(const VreShape* parent, VreString name);
+
+    const VreShape* parent_ = nullptr;
+    VreString name_;
+    size_t property_count_ = 0;
+    // Guarded by the global transition mutex
+    mutable std::map<VreString, std::unique_ptr<VreShape>> transitions_;
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_SHAPE_HPP
@@ -0,0 +1,113 @@
+#ifndef VYN_VRE_STRING_HPP
+#define VYN_VRE_STRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace vyn::vre {
+
+// Heap storage for strings that do not fit inline. The buffer is immutable
+// once created and shared between copies through its reference count.
+struct VreStringBuffer {
+    // Interned buffers are never freed; their refcount is not touched.
+    static constexpr uint32_t IMMORTAL = 0x80000000u;
+
+    std::atomic<uint32_t> refcount;
+    uint32_t size;
+    char data[1]; // size + 1 bytes, NUL terminated
+};
+
+// Immutable Vyn string.
+//
+// Strings of up to INLINE_CAPACITY bytes are stored inside the object itself;
+// longer strings live in a refcounted VreStringBuffer, so copying a VreString
+// never allocates. Length is stored alongside the data and the hash is
+// computed on first use and cached.
+class VreString {
+public:
+    static constexpr uint32_t INLINE_CAPACITY = 15;
+
+    VreString() noexcept : size_(0), hash_(0) { inline_[0] = '\0'; }
+    VreString(std::string_view s);
+    VreString(const char* s) : VreString(std::string_view(s)) {}
+    VreString(const std::string& s) : VreString(std::string_view(s)) {}
+
+    VreString(const VreString& other) noexcept;
+    VreString(VreString&& other) noexcept;
+    VreString& operator=(const VreString& other) noexcept;
+    VreString& operator=(VreString&& other) noexcept;
+    ~VreString() { release(); }
+
+    // Returns the canonical copy of `s`. Interned long strings share one
+    // immortal buffer, so repeated identifiers cost no further allocations
+    // and compare equal by pointer.
+    static VreString intern(std::string_view s);
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    bool is_inline() const noexcept { return size_ <= INLINE_CAPACITY; }
+    bool is_interned() const noexcept;
+
+    const char* data() const noexcept { return is_inline() ? inline_ : heap_->data; }
+    const char* c_str() const noexcept { return data(); }
+    std::string_view view() const noexcept { return std::string_view(data(), size_); }
+    std::string str() const { return std::string(data(), size_); }
+
+    // FNV-1a hash of the contents, cached after the first call.
+    uint32_t hash() const noexcept;
+    // The hash a VreString with contents `s` has, without constructing one
+    static uint32_t hash_of(std::string_view s) noexcept;
+
+    friend bool operator==(const VreString& a, const VreString& b) noexcept;
+    friend bool operator!=(const VreString& a, const VreString& b) noexcept { return !(a == b); }
+    friend bool operator<(const VreString& a, const VreString& b) noexcept { return a.view() < b.view(); }
+    friend bool operator==(const VreString& a, std::string_view b) noexcept { return a.view() == b; }
+    friend bool operator!=(const VreString& a, std::string_view b) noexcept { return a.view() != b; }
+    friend bool operator==(const VreString& a, const char* b) noexcept { return a.view() == b; }
+    friend bool operator!=(const VreString& a, const char* b) noexcept { return a.view() != b; }
+
+    // Concatenation allocates at most once, for the result.
+    friend VreString operator+(const VreString& a, const VreString& b);
+
+    // Number of heap buffers created by VreString since program start.
+    static uint64_t heap_allocations() noexcept;
+
+private:
+    union {
+        char inline_[INLINE_CAPACITY + 1];
+        VreStringBuffer* heap_;
+    };
+    uint32_t size_;
+    mutable uint32_t hash_; // 0 means not yet computed
+
+    struct UninitTag {};
+    VreString(UninitTag, size_t size);
+    char* mutable_data() noexcept { return is_inline() ? inline_ : heap_->data; }
+
+    void retain() const noexcept {
+        if (!is_inline() && !(heap_->refcount.load(std::memory_order_relaxed) & VreStringBuffer::IMMORTAL)) {
+            heap_->refcount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void release() noexcept {
+        if (!is_inline()) release_heap();
+    }
+    void release_heap() noexcept;
+};
+
+static_assert(sizeof(VreString) == 24, "VreString is expected to be 24 bytes");
+
+} // namespace vyn::vre
+
+namespace std {
+template<>
+struct hash<vyn::vre::VreString> {
+    size_t operator()(const vyn::vre::VreString& s) const noexcept { return s.hash(); }
+};
+} // namespace std
+
+#endif // VYN_VRE_STRING_HPP
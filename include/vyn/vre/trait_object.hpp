@@ -0,0 +1,137 @@
+#ifndef VYN_VRE_TRAIT_OBJECT_HPP
+#define VYN_VRE_TRAIT_OBJECT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "vyn/vre/type_info.hpp"
+
+namespace vyn::vre {
+
+// A Vyn trait object (`dyn Trait`): an owned value of any type implementing
+// the trait, plus that type's vtable for the trait (type_info.hpp).
+//
+// Values of up to INLINE_SIZE bytes with pointer alignment or less live in
+// the object itself, so boxing a small struct allocates nothing; larger ones
+// are allocated separately. The whole object is four words; the low bit of
+// the vtable pointer says whether the value is on the heap, so finding the
+// value never touches the vtable. Move-only: moving an inline value goes
+// through the vtable's relocate.
+class VreTraitObject {
+public:
+    static constexpr size_t INLINE_SIZE = 3 * sizeof(void*);
+
+    VreTraitObject() noexcept {}
+    VreTraitObject(VreTraitObject&& other) noexcept { take(other); }
+    VreTraitObject& operator=(VreTraitObject&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+    VreTraitObject(const VreTraitObject&) = delete;
+    VreTraitObject& operator=(const VreTraitObject&) = delete;
+    ~VreTraitObject() { reset(); }
+
+    // Constructs a T in place; `vtable` must be a vtable of T
+    template<typename T, typename... Args>
+    static VreTraitObject make(const VreVtableHeader* vtable, Args&&... args) {
+        VreTraitObject object;
+        new (object.allocate(vtable)) T(std::forward<Args>(args)...);
+        object.set_vtable(vtable);
+        return object;
+    }
+    // Takes the value at `from`, of the type `vtable` describes, leaving
+    // `from` destroyed. For generated code, which has no C++ type to name.
+    static VreTraitObject relocate_from(const VreVtableHeader* vtable, void* from);
+
+    void reset() noexcept;
+
+    explicit operator bool() const noexcept { return tagged_vtable_ != 0; }
+    const VreVtableHeader* vtable() const noexcept {
+        return reinterpret_cast<const VreVtableHeader*>(tagged_vtable_ & ~HEAP_BIT);
+    }
+    VreTypeId type() const noexcept { return tagged_vtable_ ? vtable()->type : VRE_DYNAMIC_TYPE; }
+    bool is_inline() const noexcept { return tagged_vtable_ && !(tagged_vtable_ & HEAP_BIT); }
+    void* data() noexcept { return tagged_vtable_ & HEAP_BIT ? storage_.heap : static_cast<void*>(storage_.bytes); }
+
+    // Calls method `slot` through the vtable; the method is
+    // R (*)(void* self, Args...)
+    template<typename R, typename... Args>
+    R call(size_t slot, Args... args) {
+        return reinterpret_cast<R (*)(void*, Args...)>(vtable()->method(slot))(data(), args...);
+    }
+
+private:
+    union Storage {
+        alignas(void*) unsigned char bytes[INLINE_SIZE];
+        void* heap;
+    };
+
+    static constexpr uintptr_t HEAP_BIT = 1;
+    static_assert(alignof(VreVtableHeader) > HEAP_BIT);
+
+    uintptr_t tagged_vtable_ = 0;
+    Storage storage_;
+
+    static bool fits_inline(const VreVtableHeader* vtable) noexcept {
+        return vtable->size <= INLINE_SIZE && vtable->align <= alignof(void*);
+    }
+    void set_vtable(const VreVtableHeader* vtable) noexcept {
+        tagged_vtable_ = reinterpret_cast<uintptr_t>(vtable) | (fits_inline(vtable) ? 0 : HEAP_BIT);
+    }
+    void* allocate(const VreVtableHeader* vtable);
+    void take(VreTraitObject& other) noexcept;
+};
+
+static_assert(sizeof(VreTraitObject) == 4 * sizeof(void*));
+
+// Calls method `slot` of `object` on the guarded fast path compilers emit for
+// a call site that only ever sees one implementation, or a trait with a sole
+// implementor (VreTypeTable::sole_implementor): one compare against the
+// expected vtable, then a direct call to Direct, which can be inlined. Any
+// other vtable takes the indirect call.
+template<auto Direct, typename... Args>
+auto vre_guarded_call(VreTraitObject& object, const VreVtableHeader* expected, size_t slot, Args... args) {
+    using R = decltype(Direct(static_cast<void*>(nullptr), args...));
+    if (object.vtable() == expected) return Direct(object.data(), args...);
+    return object.template call<R>(slot, args...);
+}
+
+// Profile of one dynamic call site: which vtables reach it. A site that
+// stays MONOMORPHIC is a candidate for vre_guarded_call when it is
+// recompiled; it turns POLYMORPHIC for good on the second vtable.
+//
+// A site belongs to one thread of execution; it is not synchronized.
+class VreDispatchSite {
+public:
+    enum class State : uint8_t { UNINITIALIZED, MONOMORPHIC, POLYMORPHIC };
+
+    template<typename R, typename... Args>
+    R call(VreTraitObject& object, size_t slot, Args... args) {
+        ++calls_;
+        if (object.vtable() != seen_) record_miss(object.vtable());
+        return object.call<R>(slot, args...);
+    }
+
+    State state() const;
+    // The one vtable seen, while MONOMORPHIC; otherwise nullptr
+    const VreVtableHeader* monomorphic_vtable() const { return polymorphic_ ? nullptr : seen_; }
+    uint64_t calls() const { return calls_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    const VreVtableHeader* seen_ = nullptr;
+    bool polymorphic_ = false;
+    uint64_t calls_ = 0;
+    uint64_t misses_ = 0;
+
+    void record_miss(const VreVtableHeader* vtable);
+};
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_TRAIT_OBJECT_HPP
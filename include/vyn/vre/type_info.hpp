@@ -0,0 +1,246 @@
+#ifndef VYN_VRE_TYPE_INFO_HPP
+#define VYN_VRE_TYPE_INFO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "vyn/vre/our.hpp"
+
+namespace vyn::vre {
+
+// Index of a type in its compilation unit's VreTypeTable. Id 0 is reserved
+// for VreObjects that have no static type (shaped objects, see shape.hpp).
+using VreTypeId = uint32_t;
+using VreTraitId = uint32_t;
+constexpr VreTypeId VRE_DYNAMIC_TYPE = 0;
+
+// How a field is stored, which decides how it is traced and dropped
+enum class VreFieldKind : uint8_t {
+    INT,    // int64_t or a narrower integer (size says which)
+    FLOAT,  // double or float
+    BOOL,
+    STRING, // VreString
+    VALUE,  // VreValue, which may hold an our<T> reference
+    REF,    // our<T>: a VreRcHeader*
+    STRUCT, // another type stored inline; VreFieldInfo::type says which
+    RAW,    // untraced pointer or bytes (my<T>, ptr<T>, their<T>)
+};
+
+struct VreFieldInfo {
+    const char* name;
+    uint32_t offset;
+    uint32_t size;
+    VreFieldKind kind;
+    VreTypeId type = VRE_DYNAMIC_TYPE; // For STRUCT fields
+};
+
+// A traced slot: the offset of a REF or VALUE field, with fields of inline
+// structs flattened in, so the collector walks one array per type
+struct VrePointerSlot {
+    uint32_t offset;
+    VreFieldKind kind; // REF or VALUE
+};
+
+// Static description of one type. Records are 40 bytes and stored back to
+// back; fields and pointer slots live in two shared arrays of the table,
+// addressed by [first, first + count).
+struct VreTypeInfo {
+    const char* name;
+    uint32_t size;
+    uint32_t align;
+    uint32_t first_field;
+    uint32_t field_count;
+    uint32_t first_pointer;
+    uint32_t pointer_count;
+    void (*drop)(void* object); // Destroys the fields in place; nullptr to drop by field kind
+};
+
+// Generic method pointer stored in a vtable; cast back to its real
+// signature, R (*)(void* self, Args...), at the call
+using VreMethod = void (*)();
+
+// Standard header of every trait vtable, followed directly by its
+// method_count VreMethod slots in trait declaration order. Everything a
+// trait object needs to own a value of unknown type is here, so the same
+// header serves all traits a type implements.
+struct VreVtableHeader {
+    void (*drop)(void* self);               // Destroys in place
+    void (*relocate)(void* to, void* from); // Move-constructs at `to`, then destroys `from`
+    uint32_t size;
+    uint32_t align;
+    VreTypeId type;
+    uint32_t method_count;
+
+    VreMethod method(size_t slot) const {
+        return reinterpret_cast<const VreMethod*>(reinterpret_cast<const unsigned char*>(this) + sizeof(*this))[slot];
+    }
+};
+
+template<size_t N>
+struct VreVtable {
+    VreVtableHeader header;
+    VreMethod methods[N];
+};
+static_assert(offsetof(VreVtable<1>, methods) == sizeof(VreVtableHeader));
+
+// The vtable of a C++ type T: `methods` are R (*)(void* self, Args...),
+// in slot order. Meant for static storage.
+template<typename T, typename... Methods>
+VreVtable<sizeof...(Methods)> vre_vtable_for(VreTypeId type, Methods... methods) {
+    static_assert(sizeof...(Methods) > 0, "a trait vtable needs at least one method");
+    return {{[](void* self) { static_cast<T*>(self)->~T(); },
+             [](void* to, void* from) {
+                 new (to) T(std::move(*static_cast<T*>(from)));
+                 static_cast<T*>(from)->~T();
+             },
+             sizeof(T), alignof(T), type, sizeof...(Methods)},
+            {reinterpret_cast<VreMethod>(methods)...}};
+}
+
+template<typename T>
+class VreRange {
+public:
+    VreRange(const T* begin, size_t size) : begin_(begin), size_(size) {}
+    const T* begin() const { return begin_; }
+    const T* end() const { return begin_ + size_; }
+    size_t size() const { return size_; }
+    const T& operator[](size_t i) const { return begin_[i]; }
+
+private:
+    const T* begin_;
+    size_t size_;
+};
+
+class VreTypeTableBuilder;
+
+// The read-only runtime type information of one compilation unit.
+//
+// A type is a dense index, so every query is an array access:
+//   - the exact-type test is a comparison of ids;
+//   - whether a type implements a trait is one bit of a types x traits
+//     matrix;
+//   - the vtable of a trait for a type is one slot of a types x traits
+//     array of pointers, which is also the checked cast to a trait object.
+// There is no inheritance between types, so these are all the dynamic type
+// tests the language needs. Built once by VreTypeTableBuilder (at load time,
+// from the compiler's TypeTableGenerator), then never written.
+class VreTypeTable {
+public:
+    VreTypeTable(VreTypeTable&&) = default;
+    VreTypeTable& operator=(VreTypeTable&&) = default;
+
+    size_t type_count() const { return types_.size(); }
+    size_t trait_count() const { return trait_names_.size(); }
+
+    const VreTypeInfo& type(VreTypeId id) const { return types_[id]; }
+    VreRange<VreFieldInfo> fields(VreTypeId id) const {
+        const VreTypeInfo& info = types_[id];
+        return {fields_.data() + info.first_field, info.field_count};
+    }
+    VreRange<VrePointerSlot> pointers(VreTypeId id) const {
+        const VreTypeInfo& info = types_[id];
+        return {pointers_.data() + info.first_pointer, info.pointer_count};
+    }
+    const std::string& trait_name(VreTraitId trait) const { return trait_names_[trait]; }
+
+    bool implements(VreTypeId type, VreTraitId trait) const {
+        size_t bit = static_cast<size_t>(type) * trait_stride_ + trait;
+        return (impls_[bit / 64] >> (bit % 64)) & 1;
+    }
+    // The vtable for `trait` of `type`, or nullptr if it does not implement it
+    // or its vtable has not been registered
+    const VreVtableHeader* vtable(VreTypeId type, VreTraitId trait) const {
+        return vtables_[static_cast<size_t>(type) * trait_stride_ + trait];
+    }
+    // The only type implementing `trait`, or VRE_DYNAMIC_TYPE if there are
+    // none or several. Calls through such a trait can be devirtualized behind
+    // a vtable guard (see vre_guarded_call in trait_object.hpp).
+    VreTypeId sole_implementor(VreTraitId trait) const { return sole_implementors_[trait]; }
+
+    // By name, for the REPL and diagnostics; linear. Return -1 if unknown.
+    int64_t find_type(std::string_view name) const;
+    int64_t find_trait(std::string_view name) const;
+    // The field called `name` of `type`, or nullptr
+    const VreFieldInfo* find_field(VreTypeId type, std::string_view name) const;
+
+    // Calls `visit` for each our<T> reference held by `object`, a value of
+    // `type`, through the type's pointer map (see cycle_collector.hpp)
+    void trace(const void* object, VreTypeId type, VreChildVisitor visit, void* context) const;
+    // Destroys `object` in place: the type's drop function, or else the
+    // destructors its field kinds call for. Does not free the storage.
+    void drop(void* object, VreTypeId type) const;
+
+private:
+    friend class VreTypeTableBuilder;
+    VreTypeTable() = default;
+
+    std::vector<VreTypeInfo> types_;
+    std::vector<VreFieldInfo> fields_;
+    std::vector<VrePointerSlot> pointers_;
+    std::vector<std::string> type_names_; // backs VreTypeInfo::name
+    std::vector<std::string> field_names_; // backs VreFieldInfo::name, in fields_ order
+    std::vector<std::string> trait_names_;
+    size_t trait_stride_ = 0;             // trait_count(), at least 1
+    std::vector<uint64_t> impls_;          // bit type * trait_stride_ + trait
+    std::vector<const VreVtableHeader*> vtables_; // slot type * trait_stride_ + trait
+    std::vector<VreTypeId> sole_implementors_;    // by trait
+};
+
+// Fills in a VreTypeTable. Types and traits get ids in the order they are
+// added, starting at 1 for types (0 is VRE_DYNAMIC_TYPE) and 0 for traits.
+// A builder makes one table; it is spent after build().
+class VreTypeTableBuilder {
+public:
+    struct Field {
+        std::string name;
+        uint32_t offset;
+        uint32_t size;
+        VreFieldKind kind;
+        VreTypeId type = VRE_DYNAMIC_TYPE; // For STRUCT fields, an id added earlier
+    };
+
+    VreTypeTableBuilder();
+
+    // Throws std::invalid_argument if a field does not fit in `size`, or a
+    // STRUCT field names a type not added yet
+    VreTypeId add_type(std::string name, uint32_t size, uint32_t align, std::vector<Field> fields,
+                       void (*drop)(void* object) = nullptr);
+    // A C++ type: size, alignment and drop come from T
+    template<typename T>
+    VreTypeId add_native(std::string name, std::vector<Field> fields) {
+        void (*drop)(void*) = nullptr;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            drop = [](void* object) { static_cast<T*>(object)->~T(); };
+        }
+        return add_type(std::move(name), sizeof(T), alignof(T), std::move(fields), drop);
+    }
+    VreTraitId add_trait(std::string name);
+    // Records that `type` implements `trait`; `vtable` may be set later by
+    // another call, once the code generator has emitted it
+    void implement(VreTypeId type, VreTraitId trait, const VreVtableHeader* vtable = nullptr);
+
+    VreTypeTable build();
+
+private:
+    struct Impl {
+        VreTypeId type;
+        VreTraitId trait;
+        const VreVtableHeader* vtable;
+    };
+
+    VreTypeTable table_;
+    std::vector<Impl> impls_;
+};
+
+// Layout of a REF field: an our<T> is exactly its header pointer
+static_assert(sizeof(our<int>) == sizeof(VreRcHeader*));
+
+} // namespace vyn::vre
+
+#endif // VYN_VRE_TYPE_INFO_HPP
@@ -7,24 +7,25 @@
 #include <memory> // For std::unique_ptr, std::shared_ptr if needed later
 #include <cstdint> // For fixed-width integers
 
-// Forward declarations if needed for complex types
-// namespace vyn::vre {
-// class VreObject; // Example
-// class VreArray;  // Example
-// }
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/our.hpp"
 
 namespace vyn::vre {
 
+// Defined in runtime_types.hpp; values hold them through our<T>
+struct VreObject;
+struct VreArray;
+
 // Enum to identify the type of value stored in VreValue
 enum class VreValueType {
     NIL,        // Represents null or uninitialized
     BOOLEAN,
     INTEGER,    // i64
     FLOAT,      // f64
-    STRING,     // Heap-allocated string
+    STRING,     // VreString (inline or refcounted heap buffer)
+    OBJECT,     // our<VreObject>, instance of a struct/class
+    ARRAY,      // our<VreArray>, dynamic array
     // --- Potentially more complex types later ---
-    // OBJECT,     // Instance of a struct/class
-    // ARRAY,      // Dynamic array/vector
     // FUNCTION,   // Function pointer or closure
     // NATIVE_POINTER, // Raw pointer for FFI or internal use
 };
@@ -57,9 +58,9 @@ struct VreValue {
         bool,           // For BOOLEAN
         int64_t,        // For INTEGER
         double,         // For FLOAT
-        std::string     // For STRING (heap-allocated)
-        // std::unique_ptr<VreObject>, // For OBJECT - if using unique_ptr
-        // std::unique_ptr<VreArray>   // For ARRAY - if using unique_ptr
+        VreString,      // For STRING
+        our<VreObject>, // For OBJECT
+        our<VreArray>   // For ARRAY
     > data;
 
     // Constructors
@@ -67,15 +68,28 @@ struct VreValue {
     explicit VreValue(bool val) : type(VreValueType::BOOLEAN), data(val) {}
     explicit VreValue(int64_t val) : type(VreValueType::INTEGER), data(val) {}
     explicit VreValue(double val) : type(VreValueType::FLOAT), data(val) {}
-    explicit VreValue(const char* s) : type(VreValueType::STRING), data(std::string(s)) {}
-    explicit VreValue(std::string s) : type(VreValueType::STRING), data(std::move(s)) {}
-
-    // Add constructors for VreObject, VreArray etc. as they are defined
+    explicit VreValue(const char* s) : type(VreValueType::STRING), data(VreString(s)) {}
+    explicit VreValue(const std::string& s) : type(VreValueType::STRING), data(VreString(s)) {}
+    explicit VreValue(VreString s) : type(VreValueType::STRING), data(std::move(s)) {}
+    explicit VreValue(our<VreObject> o) : type(VreValueType::OBJECT), data(std::move(o)) {}
+    explicit VreValue(our<VreArray> a) : type(VreValueType::ARRAY), data(std::move(a)) {}
 
     // Utility functions (examples)
     bool is_nil() const { return type == VreValueType::NIL; }
     bool is_boolean() const { return type == VreValueType::BOOLEAN; }
-    // ... more type checkers
+    bool is_integer() const { return type == VreValueType::INTEGER; }
+    bool is_float() const { return type == VreValueType::FLOAT; }
+    bool is_string() const { return type == VreValueType::STRING; }
+    bool is_object() const { return type == VreValueType::OBJECT; }
+    bool is_array() const { return type == VreValueType::ARRAY; }
+
+    // Refcount header of the referenced object or array, nullptr for other values
+    VreRcHeader* heap_ref() const {
+        if (type == VreValueType::OBJECT) return std::get<our<VreObject>>(data).header();
+        if (type == VreValueType::ARRAY) return std::get<our<VreArray>>(data).header();
+        return nullptr;
+    }
+    // See packed_value.hpp for the 8-byte NaN-boxed encoding with the same API
 
     // Accessors (with type checking)
     // Example:
@@ -84,10 +98,6 @@ struct VreValue {
     //     return std::get<bool>(data);
     // }
     // ... more accessors
-
-    // TODO: Consider how to handle memory for strings, objects, arrays.
-    // std::string for STRING implies heap allocation.
-    // VreObject and VreArray would also be heap-allocated, likely via smart pointers.
 };
 
 } // namespace vyn::vre
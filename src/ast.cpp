@@ -8,6 +8,7 @@
 #include <optional>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include "vyn/ast.hpp"
 #include "vyn/token.hpp"
@@ -23,13 +24,11 @@ ObjectLiteral::ObjectLiteral(SourceLocation loc, std::vector<ObjectProperty> pro
 
 // --- TryStatement Implementation ---
 TryStatement::TryStatement(const SourceLocation& loc, std::unique_ptr<BlockStatement> tryBlock,
-                 std::optional<std::string> catchIdent,
-                 std::unique_ptr<BlockStatement> catchBlock,
+                 std::vector<CatchClause> catches,
                  std::unique_ptr<BlockStatement> finallyBlock)
     : Statement(loc),
       tryBlock(std::move(tryBlock)),
-      catchIdent(std::move(catchIdent)),
-      catchBlock(std::move(catchBlock)),
+      catches(std::move(catches)),
       finallyBlock(std::move(finallyBlock)) {}
 
 NodeType TryStatement::getType() const { return NodeType::TRY_STATEMENT; }
@@ -37,10 +36,14 @@ NodeType TryStatement::getType() const { return NodeType::TRY_STATEMENT; }
 std::string TryStatement::toString() const {
     std::stringstream ss;
     ss << "try " << (tryBlock ? tryBlock->toString() : "<null>");
-    if (catchBlock) {
+    for (const CatchClause& clause : catches) {
         ss << " catch";
-        if (catchIdent) ss << "(" << *catchIdent << ")";
-        ss << " " << catchBlock->toString();
+        if (clause.ident) {
+            ss << "(" << *clause.ident;
+            if (clause.errorType) ss << ": " << *clause.errorType;
+            ss << ")";
+        }
+        ss << " " << (clause.block ? clause.block->toString() : "<null>");
     }
     if (finallyBlock) {
         ss << " finally " << finallyBlock->toString();
@@ -51,6 +54,52 @@ std::string TryStatement::toString() const {
 void TryStatement::accept(Visitor& visitor) {
     visitor.visit(this); // This is correct if Visitor has: virtual void visit(class TryStatement* node) = 0;
 }
+// --- ScopedStatement Implementation ---
+ScopedStatement::ScopedStatement(SourceLocation loc, std::unique_ptr<BlockStatement> body)
+    : Statement(loc), body(std::move(body)) {}
+
+NodeType ScopedStatement::getType() const { return NodeType::SCOPED_STATEMENT; }
+
+std::string ScopedStatement::toString() const {
+    return "scoped " + (body ? body->toString() : std::string("<null>"));
+}
+
+void ScopedStatement::accept(Visitor& visitor) {
+    visitor.visit(this);
+}
+// --- DeferStatement Implementation ---
+DeferStatement::DeferStatement(SourceLocation loc, StmtPtr body)
+    : Statement(loc), body(std::move(body)) {}
+
+NodeType DeferStatement::getType() const { return NodeType::DEFER_STATEMENT; }
+
+std::string DeferStatement::toString() const {
+    return "defer " + (body ? body->toString() : std::string("<null>"));
+}
+
+void DeferStatement::accept(Visitor& visitor) {
+    visitor.visit(this);
+}
+// --- ClosureExpression Implementation ---
+ClosureExpression::ClosureExpression(SourceLocation loc, std::vector<FunctionParameter> params,
+                                     TypeNodePtr returnTypeNode, std::unique_ptr<BlockStatement> body)
+    : Expression(loc), params(std::move(params)), returnTypeNode(std::move(returnTypeNode)), body(std::move(body)) {}
+
+std::string ClosureExpression::toString() const {
+    std::string result = "fn (";
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (i) result += ", ";
+        result += params[i].name ? params[i].name->name : std::string("<null>");
+        if (params[i].typeNode) result += ": " + params[i].typeNode->toString();
+    }
+    result += ")";
+    if (returnTypeNode) result += " -> " + returnTypeNode->toString();
+    return result + " " + (body ? body->toString() : std::string("<null>"));
+}
+
+void ClosureExpression::accept(Visitor& visitor) {
+    visitor.visit(this);
+}
 // --- ImportDeclaration methods ---
 ImportDeclaration::ImportDeclaration(
     SourceLocation loc,
@@ -158,8 +207,14 @@ TypeAliasDeclaration::~TypeAliasDeclaration() = default;
 CallExpression::CallExpression(SourceLocation loc, ExprPtr callee, std::vector<ExprPtr> arguments)
     : Expression(loc), callee(std::move(callee)), arguments(std::move(arguments)) {}
 
+static uint32_t next_member_cache_site() {
+    static std::atomic<uint32_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
 MemberExpression::MemberExpression(SourceLocation loc, ExprPtr object, ExprPtr property, bool computed)
-    : Expression(loc), object(std::move(object)), property(std::move(property)), computed(computed) {}
+    : Expression(loc), object(std::move(object)), property(std::move(property)), computed(computed),
+      cacheSite(next_member_cache_site()) {}
 
 UnaryExpression::UnaryExpression(SourceLocation loc, const vyn::token::Token& op, ExprPtr operand)
     : Expression(loc), op(op), operand(std::move(operand)) {}
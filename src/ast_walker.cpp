@@ -0,0 +1,140 @@
+#include "vyn/ast_walker.hpp"
+
+namespace vyn {
+
+// Literals
+void AstWalker::visit(Identifier*) {}
+void AstWalker::visit(IntegerLiteral*) {}
+void AstWalker::visit(FloatLiteral*) {}
+void AstWalker::visit(StringLiteral*) {}
+void AstWalker::visit(BooleanLiteral*) {}
+void AstWalker::visit(NilLiteral*) {}
+
+void AstWalker::visit(ObjectLiteral* node) {
+    for (auto& prop : node->properties) {
+        walk(prop.value.get());
+    }
+}
+
+// Expressions
+void AstWalker::visit(UnaryExpression* node) { walk(node->operand.get()); }
+
+void AstWalker::visit(BinaryExpression* node) {
+    walk(node->left.get());
+    walk(node->right.get());
+}
+
+void AstWalker::visit(CallExpression* node) {
+    walk(node->callee.get());
+    for (auto& arg : node->arguments) {
+        walk(arg.get());
+    }
+}
+
+void AstWalker::visit(MemberExpression* node) {
+    walk(node->object.get());
+    if (node->computed) {
+        walk(node->property.get()); // a plain .name is not an expression use
+    }
+}
+
+void AstWalker::visit(AssignmentExpression* node) {
+    walk(node->left.get());
+    walk(node->right.get());
+}
+
+void AstWalker::visit(ArrayLiteralNode* node) {
+    for (auto& elem : node->elements) {
+        walk(elem.get());
+    }
+}
+
+void AstWalker::visit(BorrowExprNode* node) { walk(node->expression.get()); }
+
+// Statements
+void AstWalker::visit(BlockStatement* node) {
+    for (auto& stmt : node->body) {
+        walk(stmt.get());
+    }
+}
+
+void AstWalker::visit(ExpressionStatement* node) { walk(node->expression.get()); }
+
+void AstWalker::visit(IfStatement* node) {
+    walk(node->test.get());
+    walk(node->consequent.get());
+    walk(node->alternate.get());
+}
+
+void AstWalker::visit(ForStatement* node) {
+    walk(node->init.get());
+    walk(node->test.get());
+    walk(node->update.get());
+    walk(node->body.get());
+}
+
+void AstWalker::visit(WhileStatement* node) {
+    walk(node->test.get());
+    walk(node->body.get());
+}
+
+void AstWalker::visit(ReturnStatement* node) { walk(node->argument.get()); }
+void AstWalker::visit(BreakStatement*) {}
+void AstWalker::visit(ContinueStatement*) {}
+
+void AstWalker::visit(TryStatement* node) {
+    walk(node->tryBlock.get());
+    for (CatchClause& clause : node->catches) walk(clause.block.get());
+    walk(node->finallyBlock.get());
+}
+
+void AstWalker::visit(ScopedStatement* node) { walk(node->body.get()); }
+
+void AstWalker::visit(DeferStatement* node) { walk(node->body.get()); }
+
+void AstWalker::visit(ClosureExpression* node) { walk(node->body.get()); }
+
+// Declarations
+void AstWalker::visit(VariableDeclaration* node) { walk(node->init.get()); }
+
+void AstWalker::visit(FunctionDeclaration* node) { walk(node->body.get()); }
+
+void AstWalker::visit(TypeAliasDeclaration*) {}
+void AstWalker::visit(ImportDeclaration*) {}
+
+void AstWalker::visit(StructDeclaration* node) {
+    for (auto& field : node->fields) {
+        walk(field.get());
+    }
+}
+
+void AstWalker::visit(ClassDeclaration* node) {
+    for (auto& member : node->members) {
+        walk(member.get());
+    }
+}
+
+void AstWalker::visit(FieldDeclaration* node) { walk(node->initializer.get()); }
+
+void AstWalker::visit(ImplDeclaration* node) {
+    for (auto& method : node->methods) {
+        walk(method.get());
+    }
+}
+
+void AstWalker::visit(EnumDeclaration*) {}
+void AstWalker::visit(EnumVariantNode*) {}
+void AstWalker::visit(GenericParamNode*) {}
+
+// Other
+void AstWalker::visit(TypeNode*) {}
+
+void AstWalker::visit(Module* node) {
+    for (auto& stmt : node->body) {
+        walk(stmt.get());
+    }
+}
+
+void AstWalker::visit(TemplateDeclarationNode* node) { walk(node->body.get()); }
+
+} // namespace vyn
@@ -0,0 +1,2086 @@
+// Runtime microbenchmarks. These are hidden from the default test run;
+// use `vyn_parser --bench` (or `--test "[benchmark]"`) to run them.
+#include "vyn/vyn.hpp"
+#include "vyn/bounds_check.hpp"
+#include "vyn/defer_lowering.hpp"
+#include "vyn/c_backend.hpp"
+#include "vyn/tiered.hpp"
+#include "vyn/repl.hpp"
+#include "vyn/vre/value.hpp"
+#include "vyn/vre/packed_value.hpp"
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/runtime_types.hpp"
+#include "vyn/vre/memory.hpp"
+#include "vyn/vre/region.hpp"
+#include "vyn/vre/our.hpp"
+#include "vyn/vre/cycle_collector.hpp"
+#include "vyn/vre/inline_cache.hpp"
+#include "vyn/vre/hash_map.hpp"
+#include "vyn/vre/mutex.hpp"
+#include "vyn/vre/executor.hpp"
+#include "vyn/vre/channel.hpp"
+#include "vyn/vre/parallel.hpp"
+#include "vyn/vre/result.hpp"
+#include "vyn/vre/type_info.hpp"
+#include "vyn/vre/trait_object.hpp"
+#include "vyn/vre/closure.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t kValueCount = 1 << 16;
+
+template<typename Value>
+std::vector<Value> make_mixed_values() {
+    std::vector<Value> values;
+    values.reserve(kValueCount);
+    for (size_t i = 0; i < kValueCount; ++i) {
+        switch (i % 4) {
+            case 0: values.emplace_back(static_cast<int64_t>(i)); break;
+            case 1: values.emplace_back(static_cast<double>(i) * 0.5); break;
+            case 2: values.emplace_back((i & 8) != 0); break;
+            default: values.emplace_back(); break;
+        }
+    }
+    return values;
+}
+
+// std::allocator that counts allocations, so std::string workloads can be
+// compared against VreString::heap_allocations().
+uint64_t g_counted_allocations = 0;
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(size_t n) {
+        ++g_counted_allocations;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+    template<typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using CountedString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+
+struct CountedStringHash {
+    size_t operator()(const CountedString& s) const {
+        return std::hash<std::string_view>()(std::string_view(s.data(), s.size()));
+    }
+};
+
+constexpr size_t kKeyCount = 1024;
+
+std::vector<std::string> make_keys() {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < kKeyCount; ++i) {
+        keys.push_back("request.header.field_" + std::to_string(i));
+    }
+    return keys;
+}
+
+} // namespace
+
+TEST_CASE("VreValue vs VrePackedValue", "[vre][.benchmark]") {
+    auto wide = make_mixed_values<vyn::vre::VreValue>();
+    auto packed = make_mixed_values<vyn::vre::VrePackedValue>();
+
+    INFO("VreValue array bytes: " << wide.size() * sizeof(vyn::vre::VreValue)
+         << ", VrePackedValue array bytes: " << packed.size() * sizeof(vyn::vre::VrePackedValue));
+    CHECK(packed.size() * sizeof(vyn::vre::VrePackedValue) * 2 <= wide.size() * sizeof(vyn::vre::VreValue));
+
+    BENCHMARK("copy array of VreValue") {
+        return std::vector<vyn::vre::VreValue>(wide);
+    };
+    BENCHMARK("copy array of VrePackedValue") {
+        return std::vector<vyn::vre::VrePackedValue>(packed);
+    };
+
+    BENCHMARK("sum integers in VreValue array") {
+        int64_t sum = 0;
+        for (const auto& v : wide) {
+            if (v.is_integer()) sum += std::get<int64_t>(v.data);
+        }
+        return sum;
+    };
+    BENCHMARK("sum integers in VrePackedValue array") {
+        int64_t sum = 0;
+        for (const auto& v : packed) {
+            if (v.is_integer()) sum += v.as_integer();
+        }
+        return sum;
+    };
+
+    vyn::vre::VreValue wide_str(std::string("a string that does not fit in SSO storage"));
+    vyn::vre::VrePackedValue packed_str(std::string("a string that does not fit in SSO storage"));
+    BENCHMARK("copy string VreValue") {
+        return vyn::vre::VreValue(wide_str);
+    };
+    BENCHMARK("copy string VrePackedValue") {
+        return vyn::vre::VrePackedValue(packed_str);
+    };
+}
+
+TEST_CASE("std::string vs VreString", "[vre][.benchmark]") {
+    auto raw_keys = make_keys();
+    std::vector<CountedString> std_keys(raw_keys.begin(), raw_keys.end());
+    std::vector<vyn::vre::VreString> vre_keys(raw_keys.begin(), raw_keys.end());
+
+    // Map keys: insert copies of existing keys, then look each one up
+    uint64_t std_before = g_counted_allocations;
+    {
+        std::unordered_map<CountedString, int, CountedStringHash> map;
+        for (const auto& k : std_keys) map.emplace(k, 1);
+    }
+    uint64_t vre_before = vyn::vre::VreString::heap_allocations();
+    {
+        std::unordered_map<vyn::vre::VreString, int> map;
+        for (const auto& k : vre_keys) map.emplace(k, 1);
+    }
+    INFO("map keys: std::string allocations " << g_counted_allocations - std_before
+         << ", VreString allocations " << vyn::vre::VreString::heap_allocations() - vre_before);
+    CHECK(vyn::vre::VreString::heap_allocations() - vre_before < g_counted_allocations - std_before);
+
+    BENCHMARK("map keys std::string") {
+        std::unordered_map<CountedString, int, CountedStringHash> map;
+        for (const auto& k : std_keys) map.emplace(k, 1);
+        int hits = 0;
+        for (const auto& k : std_keys) hits += map.count(k);
+        return hits;
+    };
+    BENCHMARK("map keys VreString") {
+        std::unordered_map<vyn::vre::VreString, int> map;
+        for (const auto& k : vre_keys) map.emplace(k, 1);
+        int hits = 0;
+        for (const auto& k : vre_keys) hits += map.count(k);
+        return hits;
+    };
+
+    // Concatenation loop building dotted names longer than the inline capacity
+    std::vector<CountedString> std_parts = {"request", "header", "content_type"};
+    std::vector<vyn::vre::VreString> vre_parts = {"request", "header", "content_type"};
+    auto std_concat = [&] {
+        size_t total = 0;
+        for (int i = 0; i < 1000; ++i) {
+            CountedString s = std_parts[0] + "." + std_parts[1] + "." + std_parts[2];
+            total += s.size();
+        }
+        return total;
+    };
+    auto vre_concat = [&] {
+        vyn::vre::VreString dot(".");
+        size_t total = 0;
+        for (int i = 0; i < 1000; ++i) {
+            vyn::vre::VreString s = vre_parts[0] + dot + vre_parts[1] + dot + vre_parts[2];
+            total += s.size();
+        }
+        return total;
+    };
+    std_before = g_counted_allocations;
+    std_concat();
+    vre_before = vyn::vre::VreString::heap_allocations();
+    vre_concat();
+    INFO("concat: std::string allocations " << g_counted_allocations - std_before
+         << ", VreString allocations " << vyn::vre::VreString::heap_allocations() - vre_before);
+    CHECK(vyn::vre::VreString::heap_allocations() - vre_before <= g_counted_allocations - std_before);
+
+    BENCHMARK("concat loop std::string") {
+        return std_concat();
+    };
+    BENCHMARK("concat loop VreString") {
+        return vre_concat();
+    };
+}
+
+namespace {
+
+// Same layout as VreObject, but allocated through the global heap.
+struct MallocObject {
+    std::vector<vyn::vre::VreValue> fields_by_index;
+};
+
+constexpr size_t kAllocCount = 10000;
+
+} // namespace
+
+TEST_CASE("Slab allocator vs malloc", "[vre][.benchmark]") {
+    std::vector<void*> ptrs(kAllocCount);
+
+    BENCHMARK("malloc/free 64 bytes, batch of 10000") {
+        for (auto& p : ptrs) p = std::malloc(64);
+        for (auto p : ptrs) std::free(p);
+        return ptrs.size();
+    };
+    BENCHMARK("allocate_raw/deallocate_raw 64 bytes, batch of 10000") {
+        for (auto& p : ptrs) p = vyn::vre::allocate_raw(64);
+        for (auto p : ptrs) vyn::vre::deallocate_raw(p, 64);
+        return ptrs.size();
+    };
+
+    BENCHMARK("malloc/free mixed sizes 16..512") {
+        for (size_t i = 0; i < ptrs.size(); ++i) ptrs[i] = std::malloc(16 + (i * 40) % 496);
+        for (auto p : ptrs) std::free(p);
+        return ptrs.size();
+    };
+    BENCHMARK("allocate_raw/deallocate_raw mixed sizes 16..512") {
+        for (size_t i = 0; i < ptrs.size(); ++i) ptrs[i] = vyn::vre::allocate_raw(16 + (i * 40) % 496);
+        for (size_t i = 0; i < ptrs.size(); ++i) vyn::vre::deallocate_raw(ptrs[i], 16 + (i * 40) % 496);
+        return ptrs.size();
+    };
+
+    std::vector<std::unique_ptr<MallocObject>> heap_objects(kAllocCount);
+    std::vector<vyn::vre::my<vyn::vre::VreObject>> slab_objects(kAllocCount);
+    BENCHMARK("new/delete plain object, batch of 10000") {
+        for (auto& o : heap_objects) o = std::make_unique<MallocObject>();
+        for (auto& o : heap_objects) o.reset();
+        return heap_objects.size();
+    };
+    BENCHMARK("make_my<VreObject>, batch of 10000") {
+        for (auto& o : slab_objects) o = vyn::vre::make_my<vyn::vre::VreObject>();
+        for (auto& o : slab_objects) o.reset();
+        return slab_objects.size();
+    };
+
+    // Producer allocates, consumer thread frees: exercises the depot path
+    BENCHMARK("cross-thread free malloc") {
+        for (auto& p : ptrs) p = std::malloc(64);
+        std::thread t([&] { for (auto p : ptrs) std::free(p); });
+        t.join();
+        return ptrs.size();
+    };
+    BENCHMARK("cross-thread free allocate_raw") {
+        for (auto& p : ptrs) p = vyn::vre::allocate_raw(64);
+        std::thread t([&] { for (auto p : ptrs) vyn::vre::deallocate_raw(p, 64); });
+        t.join();
+        return ptrs.size();
+    };
+}
+
+namespace {
+
+// A request handler that builds a linked list of temporaries and folds it.
+struct TempNode {
+    int64_t value;
+    TempNode* next;
+};
+
+constexpr int kTempsPerRequest = 1000;
+
+template<typename Alloc, typename Free>
+int64_t run_request(Alloc alloc, Free free_node) {
+    TempNode* head = nullptr;
+    for (int i = 0; i < kTempsPerRequest; ++i) {
+        auto* node = static_cast<TempNode*>(alloc(sizeof(TempNode)));
+        node->value = i;
+        node->next = head;
+        head = node;
+    }
+    int64_t sum = 0;
+    while (head) {
+        sum += head->value;
+        TempNode* next = head->next;
+        free_node(head);
+        head = next;
+    }
+    return sum;
+}
+
+} // namespace
+
+TEST_CASE("Per-object frees vs scoped region", "[vre][.benchmark]") {
+    BENCHMARK("request with malloc/free per temporary") {
+        return run_request([](size_t n) { return std::malloc(n); }, [](TempNode* p) { std::free(p); });
+    };
+    BENCHMARK("request with allocate_raw/deallocate_raw per temporary") {
+        return run_request([](size_t n) { return vyn::vre::allocate_raw(n); },
+                           [](TempNode* p) { vyn::vre::deallocate_raw(p, sizeof(TempNode)); });
+    };
+    BENCHMARK("request inside a scoped region") {
+        vyn::vre::RegionScope scope;
+        return run_request([](size_t n) { return vyn::vre::scoped_allocate(n); }, [](TempNode*) {});
+    };
+}
+
+namespace {
+
+constexpr int kRefCopies = 100000;
+
+// Each thread copies and drops its own handle to a shared object.
+template<typename Ptr>
+void copy_from_threads(const Ptr& shared, int thread_count) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([handle = shared]() {
+            for (int i = 0; i < kRefCopies / 4; ++i) {
+                Ptr local = handle;
+                (void)local;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+} // namespace
+
+TEST_CASE("our<T> vs std::shared_ptr", "[vre][.benchmark]") {
+    // libstdc++ skips atomics while the process has never started a thread,
+    // which would hide the cost shared_ptr pays in a real runtime.
+    std::thread([] {}).join();
+
+    auto sp = std::make_shared<int64_t>(42);
+    auto op = vyn::vre::make_our<int64_t>(42);
+
+    BENCHMARK("std::shared_ptr copy/drop on the creating thread") {
+        int64_t sum = 0;
+        for (int i = 0; i < kRefCopies; ++i) {
+            std::shared_ptr<int64_t> copy = sp;
+            sum += *copy;
+        }
+        return sum;
+    };
+    BENCHMARK("our<T> copy/drop on the creating thread") {
+        int64_t sum = 0;
+        for (int i = 0; i < kRefCopies; ++i) {
+            vyn::vre::our<int64_t> copy = op;
+            sum += *copy;
+        }
+        return sum;
+    };
+    BENCHMARK("std::shared_ptr copy/drop from 4 threads") {
+        copy_from_threads(sp, 4);
+        return sp.use_count();
+    };
+    BENCHMARK("our<T> copy/drop from 4 threads") {
+        copy_from_threads(op, 4);
+        vyn::vre::our_process_pending_merges();
+        return op.use_count();
+    };
+}
+
+namespace {
+
+constexpr int kCycleCount = 1000;
+
+// Builds `count` two-object rings and drops every outside reference to them.
+void make_garbage_rings(int count, bool cyclic) {
+    using namespace vyn::vre;
+    for (int i = 0; i < count; ++i) {
+        our<VreObject> a = make_our<VreObject>();
+        our<VreObject> b = make_our<VreObject>();
+        a->fields_by_index.push_back(VreValue(b));
+        if (cyclic) b->fields_by_index.push_back(VreValue(a));
+    }
+}
+
+} // namespace
+
+TEST_CASE("Cycle collector pauses", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    VreCycleCollectorConfig config;
+    config.enabled = true;
+    config.root_threshold = 256;
+    config.max_roots_per_pause = 128;
+    configure_cycle_collector(config);
+
+    VreCycleCollectorStats before = cycle_collector_stats();
+    make_garbage_rings(kCycleCount, true);
+    collect_cycles();
+    VreCycleCollectorStats stats = cycle_collector_stats();
+    VreCycleCollectorStats delta;
+    delta.pauses = stats.pauses - before.pauses;
+    delta.objects_freed = stats.objects_freed - before.objects_freed;
+    delta.total_pause_ns = stats.total_pause_ns - before.total_pause_ns;
+    INFO("pauses " << delta.pauses << ", max pause " << stats.max_pause_ns << " ns, freed " << delta.objects_freed
+         << " objects at " << delta.throughput() << " objects/s of pause");
+    CHECK(delta.objects_freed == 2 * kCycleCount);
+
+    BENCHMARK("acyclic pairs freed by reference counting") {
+        make_garbage_rings(kCycleCount, false);
+        return collect_cycles();
+    };
+    BENCHMARK("cyclic pairs freed by the cycle collector") {
+        make_garbage_rings(kCycleCount, true);
+        return collect_cycles();
+    };
+
+    configure_cycle_collector(VreCycleCollectorConfig());
+}
+
+namespace {
+
+constexpr int kFieldObjects = 64;
+constexpr int kFieldReads = 100000;
+
+} // namespace
+
+TEST_CASE("Indexed vs inline-cached vs map field access", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    const char* names[] = {"id", "name", "x", "y", "z", "w"};
+    std::vector<VreObject> objects(kFieldObjects);
+    std::vector<std::unordered_map<std::string, VreValue>> maps(kFieldObjects);
+    for (int i = 0; i < kFieldObjects; ++i) {
+        for (const char* name : names) {
+            objects[i].set_field(name, VreValue(int64_t(i)));
+            maps[i].emplace(name, VreValue(int64_t(i)));
+        }
+    }
+    const int z_slot = objects[0].shape->slot_of("z");
+    const VreString z = VreString::intern("z");
+
+    BENCHMARK("indexed field read") {
+        int64_t sum = 0;
+        for (int i = 0; i < kFieldReads; ++i) {
+            sum += std::get<int64_t>(objects[i % kFieldObjects].fields_by_index[z_slot].data);
+        }
+        return sum;
+    };
+    BENCHMARK("inline-cached field read") {
+        VreInlineCache cache;
+        int64_t sum = 0;
+        for (int i = 0; i < kFieldReads; ++i) {
+            sum += std::get<int64_t>(cache.load(objects[i % kFieldObjects], z)->data);
+        }
+        return sum;
+    };
+    BENCHMARK("shape lookup without a cache") {
+        int64_t sum = 0;
+        for (int i = 0; i < kFieldReads; ++i) {
+            sum += std::get<int64_t>(objects[i % kFieldObjects].find_field("z")->data);
+        }
+        return sum;
+    };
+    BENCHMARK("std::unordered_map field read") {
+        int64_t sum = 0;
+        for (int i = 0; i < kFieldReads; ++i) {
+            sum += std::get<int64_t>(maps[i % kFieldObjects].find("z")->second.data);
+        }
+        return sum;
+    };
+}
+
+namespace {
+
+constexpr int64_t kArrayLength = 100000;
+
+} // namespace
+
+TEST_CASE("Boxed vs unboxed Int arrays", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    std::vector<VreValue> boxed;
+    VreArray unboxed;
+    for (int64_t i = 0; i < kArrayLength; ++i) {
+        boxed.push_back(VreValue(i));
+        unboxed.push(VreValue(i));
+    }
+    INFO("boxed bytes: " << boxed.size() * sizeof(VreValue) << ", unboxed bytes: " << unboxed.storage_bytes());
+    CHECK(unboxed.storage_bytes() * 5 <= boxed.size() * sizeof(VreValue));
+
+    BENCHMARK("sum std::vector<VreValue>") {
+        int64_t sum = 0;
+        for (const VreValue& v : boxed) sum += std::get<int64_t>(v.data);
+        return sum;
+    };
+    BENCHMARK("sum VreArray int_data()") {
+        const int64_t* data = unboxed.int_data();
+        int64_t sum = 0;
+        for (size_t i = 0; i < unboxed.size(); ++i) sum += data[i];
+        return sum;
+    };
+    BENCHMARK("sum VreArray get()") {
+        int64_t sum = 0;
+        for (size_t i = 0; i < unboxed.size(); ++i) sum += std::get<int64_t>(unboxed.get(i).data);
+        return sum;
+    };
+}
+
+namespace {
+
+constexpr size_t kSliceLength = 100000;
+
+// A slice-heavy Vyn kernel: prefix sums, a windowed dot product and a copy
+const char* kSliceKernel = R"(fn kernel(a: [Int], b: [Int], out: [Int], n: Int) -> Int {
+    var acc = 0
+    for (i in 0..a.len()) {
+        acc = acc + a[i]
+        out[i] = acc
+    }
+    for (i in 0..n) {
+        acc = acc + a[i] * b[i]
+    }
+    for (i in 0..len(b)) {
+        out[i] = b[i]
+    }
+    var k = 0
+    while (k < n) {
+        acc = acc + a[k]
+        k = k + 1
+    }
+    return acc
+})";
+
+} // namespace
+
+TEST_CASE("Checked vs hoisted slice access", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    std::string source = kSliceKernel;
+    Lexer lexer(source, "slice_kernel.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "slice_kernel.vyn");
+    auto module = parser.parse_module();
+    vyn::BoundsCheckReport report = vyn::BoundsCheckElimination().run(module.get());
+    INFO("index sites " << report.indexSites << ", eliminated " << report.eliminated << ", hoisted "
+         << report.hoisted << " (" << report.hoistedChecks << " checks before loops), remaining "
+         << report.remaining());
+    CHECK(report.remaining() == 1); // only the while loop keeps its check
+
+    VreArray array;
+    for (size_t i = 0; i < kSliceLength; ++i) {
+        array.push(VreValue(int64_t(i)));
+    }
+    VreSlice slice(array);
+
+    BENCHMARK("checked get per element") {
+        int64_t sum = 0;
+        for (size_t i = 0; i < kSliceLength; ++i) sum += std::get<int64_t>(slice.get(i).data);
+        return sum;
+    };
+    BENCHMARK("hoisted check, unchecked get") {
+        if (kSliceLength > slice.size()) throw std::runtime_error("out of bounds");
+        int64_t sum = 0;
+        for (size_t i = 0; i < kSliceLength; ++i) sum += std::get<int64_t>(slice.get_unchecked(i).data);
+        return sum;
+    };
+    BENCHMARK("hoisted check, unboxed int_data()") {
+        if (kSliceLength > slice.size()) throw std::runtime_error("out of bounds");
+        const int64_t* data = slice.int_data();
+        int64_t sum = 0;
+        for (size_t i = 0; i < kSliceLength; ++i) sum += data[i];
+        return sum;
+    };
+}
+
+namespace {
+
+constexpr int64_t kMapKeys = 100000;
+
+// Keys spread over the whole int64 range, as hashed ids would be
+std::vector<int64_t> make_map_keys() {
+    std::vector<int64_t> keys;
+    keys.reserve(kMapKeys);
+    uint64_t state = 42;
+    for (int64_t i = 0; i < kMapKeys; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        keys.push_back(static_cast<int64_t>(state));
+    }
+    return keys;
+}
+
+// Insert and erase keys from a sliding window, so the table fills with
+// tombstones while its size stays constant
+template<typename Map>
+int64_t erase_heavy_mix(Map& map, const std::vector<int64_t>& keys) {
+    const size_t window = keys.size() / 4;
+    for (size_t i = 0; i < window; ++i) map[keys[i]] = int64_t(i);
+    int64_t found = 0;
+    for (size_t i = window; i < keys.size(); ++i) {
+        map.erase(keys[i - window]);
+        map[keys[i]] = int64_t(i);
+        found += map.count(keys[i - window / 2]) != 0;
+    }
+    return found;
+}
+
+} // namespace
+
+TEST_CASE("HashMap vs std::unordered_map", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    const std::vector<int64_t> keys = make_map_keys();
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < kMapKeys; ++i) names.push_back("field_name_" + std::to_string(i));
+
+    HashMap<int64_t, int64_t> swiss;
+    std::unordered_map<int64_t, int64_t> standard;
+    for (int64_t i = 0; i < kMapKeys; ++i) {
+        swiss[keys[i]] = i;
+        standard[keys[i]] = i;
+    }
+    HashMap<VreString, int64_t> swiss_names;
+    std::unordered_map<VreString, int64_t> standard_names;
+    for (int64_t i = 0; i < kMapKeys; ++i) {
+        swiss_names[VreString(names[i])] = i;
+        standard_names[VreString(names[i])] = i;
+    }
+    INFO("HashMap capacity " << swiss.capacity() << " for " << swiss.size() << " keys");
+    CHECK(swiss.size() == standard.size());
+
+    BENCHMARK("insert 100k Int keys, HashMap") {
+        HashMap<int64_t, int64_t> map;
+        for (int64_t i = 0; i < kMapKeys; ++i) map[keys[i]] = i;
+        return map.size();
+    };
+    BENCHMARK("insert 100k Int keys, std::unordered_map") {
+        std::unordered_map<int64_t, int64_t> map;
+        for (int64_t i = 0; i < kMapKeys; ++i) map[keys[i]] = i;
+        return map.size();
+    };
+    BENCHMARK("lookup 100k Int keys, HashMap") {
+        int64_t sum = 0;
+        for (int64_t key : keys) sum += swiss.find(key)->second;
+        return sum;
+    };
+    BENCHMARK("lookup 100k Int keys, std::unordered_map") {
+        int64_t sum = 0;
+        for (int64_t key : keys) sum += standard.find(key)->second;
+        return sum;
+    };
+    BENCHMARK("lookup 100k String keys by string_view, HashMap") {
+        int64_t sum = 0;
+        for (const std::string& name : names) sum += swiss_names.find(std::string_view(name))->second;
+        return sum;
+    };
+    BENCHMARK("lookup 100k String keys, std::unordered_map") {
+        int64_t sum = 0;
+        for (const std::string& name : names) sum += standard_names.find(VreString(name))->second;
+        return sum;
+    };
+    BENCHMARK("erase-heavy mix, HashMap") {
+        HashMap<int64_t, int64_t> map;
+        return erase_heavy_mix(map, keys);
+    };
+    BENCHMARK("erase-heavy mix, std::unordered_map") {
+        std::unordered_map<int64_t, int64_t> map;
+        return erase_heavy_mix(map, keys);
+    };
+}
+
+namespace {
+
+struct ContentionResult {
+    uint64_t ops = 0;
+    double ops_per_ms = 0;
+    int64_t p99_wait_ns = 0;
+    int64_t max_wait_ns = 0;
+    double fairness = 0; // fewest acquisitions of any thread / most of any thread
+};
+
+// `threads` threads increment a shared counter under `lock` for `window`,
+// timing every acquisition
+template<typename Lock>
+ContentionResult run_contention(Lock& lock, int threads, std::chrono::milliseconds window) {
+    using Clock = std::chrono::steady_clock;
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::atomic<int> ready{0};
+    std::vector<uint64_t> counts(threads);
+    std::vector<std::vector<int64_t>> waits(threads);
+    uint64_t counter = 0;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            waits[t].reserve(1 << 16);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto start = Clock::now();
+                lock.lock();
+                auto acquired = Clock::now();
+                ++counter;
+                lock.unlock();
+                ++counts[t];
+                waits[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(acquired - start).count());
+            }
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(window);
+    stop.store(true);
+    for (auto& worker : workers) worker.join();
+
+    ContentionResult result;
+    std::vector<int64_t> all;
+    for (auto& w : waits) all.insert(all.end(), w.begin(), w.end());
+    std::sort(all.begin(), all.end());
+    result.ops = counter;
+    result.ops_per_ms = double(counter) / window.count();
+    if (!all.empty()) {
+        result.p99_wait_ns = all[all.size() * 99 / 100];
+        result.max_wait_ns = all.back();
+    }
+    auto [fewest, most] = std::minmax_element(counts.begin(), counts.end());
+    result.fairness = *most ? double(*fewest) / double(*most) : 0;
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("Queue lock vs std::mutex under contention", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    using namespace std::chrono_literals;
+    std::ostringstream report;
+    bool every_thread_served = true;
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        VreQueueLock queue_lock;
+        std::mutex std_mutex;
+        ContentionResult fifo = run_contention(queue_lock, threads, 50ms);
+        ContentionResult os = run_contention(std_mutex, threads, 50ms);
+        report << threads << " threads: queue lock " << fifo.ops_per_ms << " ops/ms, p99 " << fifo.p99_wait_ns
+               << " ns, max " << fifo.max_wait_ns << " ns, fairness " << fifo.fairness << " | std::mutex "
+               << os.ops_per_ms << " ops/ms, p99 " << os.p99_wait_ns << " ns, max " << os.max_wait_ns
+               << " ns, fairness " << os.fairness << "\n";
+        every_thread_served = every_thread_served && fifo.fairness > 0;
+    }
+    INFO(report.str());
+    CHECK(every_thread_served);
+
+    VreQueueLock queue_lock;
+    std::mutex std_mutex;
+    BENCHMARK("uncontended lock/unlock x1000, queue lock") {
+        for (int i = 0; i < 1000; ++i) {
+            queue_lock.lock();
+            queue_lock.unlock();
+        }
+        return queue_lock.spin_limit();
+    };
+    BENCHMARK("uncontended lock/unlock x1000, std::mutex") {
+        for (int i = 0; i < 1000; ++i) {
+            std_mutex.lock();
+            std_mutex.unlock();
+        }
+        return 0;
+    };
+}
+
+namespace {
+
+using vyn::vre::VreFrame;
+using vyn::vre::VrePoll;
+using vyn::vre::VreTaskContext;
+
+// Binary fan-out/fan-in tree: each frame awaits two children and sums them
+struct TreeFrame : VreFrame {
+    int depth;
+    int64_t* out;
+    int64_t left = 0;
+    int64_t right = 0;
+
+    TreeFrame(int depth, int64_t* out) : depth(depth), out(out) {}
+
+    VrePoll resume(VreTaskContext& ctx) override {
+        if (state_ == 0) {
+            if (depth == 0) {
+                *out = 1;
+                return VrePoll::READY;
+            }
+            state_ = 1;
+            ctx.await_all(this, {new TreeFrame(depth - 1, &left), new TreeFrame(depth - 1, &right)});
+            return VrePoll::PENDING;
+        }
+        *out = left + right + 1;
+        return VrePoll::READY;
+    }
+};
+
+int64_t tree_sequential(int depth) {
+    return depth == 0 ? 1 : tree_sequential(depth - 1) + tree_sequential(depth - 1) + 1;
+}
+
+// One frame awaiting `width` leaves that each do a little arithmetic
+struct LeafFrame : VreFrame {
+    int64_t seed;
+    int64_t* out;
+
+    LeafFrame(int64_t seed, int64_t* out) : seed(seed), out(out) {}
+
+    VrePoll resume(VreTaskContext&) override {
+        int64_t x = seed;
+        for (int i = 0; i < 200; ++i) x = x * 6364136223846793005ll + 1442695040888963407ll;
+        *out = x & 0xFF;
+        return VrePoll::READY;
+    }
+};
+
+struct FanOutFrame : VreFrame {
+    std::vector<int64_t> results;
+    std::vector<VreFrame*> leaves;
+    int64_t* out;
+
+    FanOutFrame(size_t width, int64_t* out) : results(width), out(out) {}
+
+    VrePoll resume(VreTaskContext& ctx) override {
+        if (state_ == 0) {
+            for (size_t i = 0; i < results.size(); ++i) leaves.push_back(new LeafFrame(int64_t(i), &results[i]));
+            state_ = 1;
+            ctx.await_all(this, leaves.data(), leaves.size());
+            return VrePoll::PENDING;
+        }
+        int64_t sum = 0;
+        for (int64_t r : results) sum += r;
+        *out = sum;
+        return VrePoll::READY;
+    }
+};
+
+constexpr int kTreeDepth = 16;      // 131071 frames
+constexpr size_t kFanOutWidth = 10000;
+
+} // namespace
+
+TEST_CASE("Work-stealing executor on fan-out/fan-in graphs", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    size_t workers = std::max(2u, std::thread::hardware_concurrency());
+    VreExecutor single(1);
+    VreExecutor pool(workers);
+
+    int64_t nodes = 0;
+    pool.block_on(new TreeFrame(kTreeDepth, &nodes));
+    VreExecutorStats stats = pool.stats();
+    INFO(workers << " workers: " << stats.frames_completed << " frames, " << stats.steals << " steals, "
+         << stats.injected << " injected, " << stats.parks << " parks");
+    CHECK(nodes == tree_sequential(kTreeDepth));
+
+    BENCHMARK("binary tree of 131071 calls, sequential") {
+        return tree_sequential(kTreeDepth);
+    };
+    BENCHMARK("binary tree of 131071 frames, 1 worker") {
+        int64_t result = 0;
+        single.block_on(new TreeFrame(kTreeDepth, &result));
+        return result;
+    };
+    BENCHMARK("binary tree of 131071 frames, all workers") {
+        int64_t result = 0;
+        pool.block_on(new TreeFrame(kTreeDepth, &result));
+        return result;
+    };
+    BENCHMARK("fan-out to 10000 leaves, 1 worker") {
+        int64_t result = 0;
+        single.block_on(new FanOutFrame(kFanOutWidth, &result));
+        return result;
+    };
+    BENCHMARK("fan-out to 10000 leaves, all workers") {
+        int64_t result = 0;
+        pool.block_on(new FanOutFrame(kFanOutWidth, &result));
+        return result;
+    };
+}
+
+namespace {
+
+// Baseline channel: a deque behind std::mutex with two condition variables
+template<typename T>
+class LockedChannel {
+public:
+    explicit LockedChannel(size_t capacity) : capacity_(capacity) {}
+
+    void send(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&] { return queue_.size() < capacity_; });
+        queue_.push_back(std::move(value));
+        not_empty_.notify_one();
+    }
+    std::optional<T> recv() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return !queue_.empty() || closed_; });
+        if (queue_.empty()) return std::nullopt;
+        T value = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return value;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> queue_;
+    bool closed_ = false;
+};
+
+struct ChannelRun {
+    double msgs_per_ms = 0;
+    bool complete = false; // every message arrived exactly once
+};
+
+// `producers` threads send `total` messages between them to `consumers`
+// threads, which receive until the channel is closed
+template<typename Channel>
+ChannelRun run_channel(Channel& channel, int producers, int consumers, int64_t total) {
+    using Clock = std::chrono::steady_clock;
+    std::atomic<int64_t> sum{0};
+    std::atomic<int64_t> received{0};
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            int64_t local = 0, count = 0;
+            while (auto value = channel.recv()) {
+                local += *value;
+                ++count;
+            }
+            sum += local;
+            received += count;
+        });
+    }
+    std::vector<std::thread> senders;
+    for (int p = 0; p < producers; ++p) {
+        senders.emplace_back([&, p] {
+            for (int64_t i = p; i < total; i += producers) channel.send(i);
+        });
+    }
+    for (auto& sender : senders) sender.join();
+    channel.close();
+    for (auto& thread : threads) thread.join();
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    ChannelRun run;
+    run.msgs_per_ms = total / ms;
+    run.complete = received.load() == total && sum.load() == total * (total - 1) / 2;
+    return run;
+}
+
+} // namespace
+
+TEST_CASE("Channel throughput for SPSC, MPSC and MPMC", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    const int64_t total = 400000;
+    const size_t capacity = 1024;
+    struct Topology {
+        const char* name;
+        int producers;
+        int consumers;
+    };
+    std::ostringstream report;
+    bool complete = true;
+    for (Topology topology : {Topology{"SPSC", 1, 1}, Topology{"MPSC", 4, 1}, Topology{"MPMC", 4, 4}}) {
+        BoundedChannel<int64_t> bounded(capacity);
+        UnboundedChannel<int64_t> unbounded;
+        LockedChannel<int64_t> locked(capacity);
+        ChannelRun b = run_channel(bounded, topology.producers, topology.consumers, total);
+        ChannelRun u = run_channel(unbounded, topology.producers, topology.consumers, total);
+        ChannelRun l = run_channel(locked, topology.producers, topology.consumers, total);
+        report << topology.name << ": bounded " << b.msgs_per_ms << " msgs/ms, unbounded " << u.msgs_per_ms
+               << " msgs/ms, mutex+condvar " << l.msgs_per_ms << " msgs/ms\n";
+        complete = complete && b.complete && u.complete && l.complete;
+    }
+    INFO(report.str());
+    CHECK(complete);
+
+    // Single-threaded send/recv pairs: the cost of the channel itself
+    BoundedChannel<int64_t> bounded(capacity);
+    UnboundedChannel<int64_t> unbounded;
+    LockedChannel<int64_t> locked(capacity);
+    BENCHMARK("send+recv x1000, bounded") {
+        int64_t sum = 0;
+        for (int64_t i = 0; i < 1000; ++i) {
+            bounded.try_send(i);
+            sum += *bounded.try_recv();
+        }
+        return sum;
+    };
+    BENCHMARK("send+recv x1000, unbounded") {
+        int64_t sum = 0;
+        for (int64_t i = 0; i < 1000; ++i) {
+            unbounded.try_send(i);
+            sum += *unbounded.try_recv();
+        }
+        return sum;
+    };
+    BENCHMARK("send+recv x1000, mutex+condvar") {
+        int64_t sum = 0;
+        for (int64_t i = 0; i < 1000; ++i) {
+            locked.send(i);
+            sum += *locked.recv();
+        }
+        return sum;
+    };
+}
+
+namespace {
+
+// Per-element work for the compute-bound map: a few Newton steps for sqrt
+double newton_sqrt(int64_t i) {
+    double x = static_cast<double>(i) + 1.0;
+    double guess = x;
+    for (int step = 0; step < 24; ++step) guess = 0.5 * (guess + x / guess);
+    return guess;
+}
+
+// Best of three runs of `fn`, in milliseconds
+template<typename Fn>
+double best_ms(const Fn& fn) {
+    using Clock = std::chrono::steady_clock;
+    double best = 0;
+    for (int run = 0; run < 3; ++run) {
+        auto start = Clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+} // namespace
+
+TEST_CASE("parallel_for scaling on map workloads", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    const int64_t n = 2000000;
+    std::vector<size_t> counts = {1, 2, 4};
+    size_t cores = std::thread::hardware_concurrency();
+    for (size_t workers = 8; workers <= std::max<size_t>(8, cores); workers *= 2) counts.push_back(workers);
+
+    // Baselines: plain loops, no executor
+    std::vector<int64_t> source(n);
+    for (int64_t i = 0; i < n; ++i) source[i] = i;
+    double expected_sum = 0;
+    for (int64_t i = 0; i < n; ++i) expected_sum += newton_sqrt(i);
+    double sequential_squares = best_ms([&] {
+        VreArray out = VreArray::filled(n, VreArrayKind::INT);
+        int64_t* data = out.int_data();
+        for (int64_t i = 0; i < n; ++i) data[i] = source[i] * source[i];
+        return out;
+    });
+    double sequential_sqrt = best_ms([&] {
+        VreArray out = VreArray::filled(n, VreArrayKind::FLOAT);
+        double* data = out.float_data();
+        for (int64_t i = 0; i < n; ++i) data[i] = newton_sqrt(i);
+        return out;
+    });
+
+    std::ostringstream report;
+    report << cores << " hardware threads; " << n << " elements\n";
+    report << "sequential: squares " << sequential_squares << " ms, sqrt " << sequential_sqrt << " ms\n";
+    bool correct = true;
+    for (size_t workers : counts) {
+        VreExecutor executor(workers);
+        VreArray squares, roots;
+        double squares_ms = best_ms([&] {
+            squares = parallel_collect<int64_t>(executor, 0, n, [&](int64_t i) { return source[i] * source[i]; });
+        });
+        double sqrt_ms = best_ms([&] { roots = parallel_collect<double>(executor, 0, n, newton_sqrt); });
+        double sum = 0;
+        for (int64_t i = 0; i < n; ++i) sum += roots.float_data()[i];
+        correct = correct && squares.int_data()[n - 1] == (n - 1) * (n - 1) && sum == expected_sum;
+        report << workers << " workers: squares " << squares_ms << " ms (" << sequential_squares / squares_ms
+               << "x), sqrt " << sqrt_ms << " ms (" << sequential_sqrt / sqrt_ms << "x), "
+               << executor.stats().steals << " steals\n";
+    }
+    INFO(report.str());
+    CHECK(correct);
+
+    VreExecutor pool(std::max<size_t>(2, cores));
+    BENCHMARK("sqrt map over 100000, sequential") {
+        VreArray out = VreArray::filled(100000, VreArrayKind::FLOAT);
+        for (int64_t i = 0; i < 100000; ++i) out.float_data()[i] = newton_sqrt(i);
+        return out.float_data()[99999];
+    };
+    BENCHMARK("sqrt map over 100000, parallel_collect") {
+        VreArray out = parallel_collect<double>(pool, 0, 100000, newton_sqrt);
+        return out.float_data()[99999];
+    };
+}
+
+namespace {
+
+constexpr int kErrorDepth = 8; // frames between the throw and the catch
+
+// The C++ exception baseline: a payload-only exception, so the cost
+// measured is the unwinding and not building a message
+struct FieldError {
+    int64_t position;
+};
+
+// Hides a value from the optimizer, so neither chain below is folded into
+// a loop or a constant: each of its frames stays a real call, as separate
+// functions would be
+int64_t opaque(int64_t value) {
+    asm volatile("" : "+r"(value));
+    return value;
+}
+
+[[gnu::noinline]] int64_t parse_field_throwing(int64_t value, int depth) {
+    if (depth == 0) {
+        if (value < 0) throw FieldError{value};
+        return value;
+    }
+    return opaque(parse_field_throwing(value, depth - 1)) + 1;
+}
+
+// The same call chain as lowered by ErrorLowering: each frame checks the
+// callee's result and returns its error
+[[gnu::noinline]] vyn::vre::VreResult<int64_t> parse_field_lowered(int64_t value, int depth, uint32_t field_error) {
+    using namespace vyn::vre;
+    if (depth == 0) {
+        if (value < 0) return VreError{field_error, VreValue(value)};
+        return value;
+    }
+    VreResult<int64_t> inner = parse_field_lowered(value, depth - 1, field_error);
+    if (inner.is_err()) return vre_failed;
+    return opaque(inner.value()) + 1;
+}
+
+struct FieldTotals {
+    int64_t sum = 0;
+    int64_t errors = 0;
+    bool operator==(const FieldTotals& other) const { return sum == other.sum && errors == other.errors; }
+};
+
+FieldTotals parse_fields_throwing(const std::vector<int64_t>& fields) {
+    FieldTotals totals;
+    for (int64_t field : fields) {
+        try {
+            totals.sum += parse_field_throwing(field, static_cast<int>(opaque(kErrorDepth)));
+        } catch (const FieldError&) {
+            ++totals.errors;
+        }
+    }
+    return totals;
+}
+
+FieldTotals parse_fields_lowered(const std::vector<int64_t>& fields) {
+    uint32_t field_error = vyn::vre::vre_error_type("FieldError");
+    FieldTotals totals;
+    for (int64_t field : fields) {
+        vyn::vre::VreResult<int64_t> result =
+            parse_field_lowered(field, static_cast<int>(opaque(kErrorDepth)), field_error);
+        if (result.is_err()) {
+            ++totals.errors;
+        } else {
+            totals.sum += result.value();
+        }
+    }
+    return totals;
+}
+
+// `count` fields, every `period`-th one malformed (0: none)
+std::vector<int64_t> make_fields(size_t count, size_t period) {
+    std::vector<int64_t> fields(count);
+    for (size_t i = 0; i < count; ++i) {
+        fields[i] = period && i % period == 0 ? -static_cast<int64_t>(i) - 1 : static_cast<int64_t>(i);
+    }
+    return fields;
+}
+
+} // namespace
+
+TEST_CASE("Error propagation through VreResult vs C++ exceptions", "[vre][.benchmark]") {
+    using Clock = std::chrono::steady_clock;
+    const size_t count = 20000;
+    std::ostringstream report;
+    report << "ns per field, " << kErrorDepth << " frames deep\n";
+    bool agree = true;
+    for (size_t period : {0, 100, 2, 1}) {
+        std::vector<int64_t> fields = make_fields(count, period);
+        FieldTotals thrown, lowered;
+        auto start = Clock::now();
+        for (int rep = 0; rep < 5; ++rep) thrown = parse_fields_throwing(fields);
+        double exception_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (5 * count);
+        start = Clock::now();
+        for (int rep = 0; rep < 5; ++rep) lowered = parse_fields_lowered(fields);
+        double result_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (5 * count);
+        agree = agree && thrown == lowered;
+        report << (period ? 100.0 / period : 0.0) << "% errors: exceptions " << exception_ns << ", VreResult "
+               << result_ns << " (" << exception_ns / result_ns << "x)\n";
+    }
+    INFO(report.str());
+    CHECK(agree);
+
+    std::vector<int64_t> clean = make_fields(1000, 0);
+    std::vector<int64_t> half = make_fields(1000, 2);
+    BENCHMARK("1000 fields, no errors, exceptions") {
+        return parse_fields_throwing(clean).sum;
+    };
+    BENCHMARK("1000 fields, no errors, VreResult") {
+        return parse_fields_lowered(clean).sum;
+    };
+    BENCHMARK("1000 fields, half malformed, exceptions") {
+        return parse_fields_throwing(half).errors;
+    };
+    BENCHMARK("1000 fields, half malformed, VreResult") {
+        return parse_fields_lowered(half).errors;
+    };
+}
+
+namespace {
+
+// A defer-heavy Vyn function: three resources, two early returns. In the
+// C++ versions below, rejected(item) is item % 7 == 0 and skipped(item) is
+// item % 3 == 0.
+const char* kDeferKernel = R"(fn handle(r: Resources, item: Int) -> Int {
+    r.open(1)
+    defer r.close(1)
+    if (rejected(item)) {
+        return 0
+    }
+    r.open(2)
+    defer r.close(2)
+    if (skipped(item)) {
+        return 1
+    }
+    r.open(3)
+    defer r.close(3)
+    return item
+})";
+
+// Records opens and closes; the checksum depends on the order of closes
+struct Resources {
+    int64_t open = 0;
+    uint64_t checksum = 0;
+
+    void acquire(int id) {
+        ++open;
+        checksum = checksum * 31 + static_cast<uint64_t>(id);
+    }
+    void release(int id) {
+        --open;
+        checksum = checksum * 37 + static_cast<uint64_t>(id);
+    }
+};
+
+// kDeferKernel as written by hand
+[[gnu::noinline]] int64_t handle_by_hand(Resources& r, int64_t item) {
+    r.acquire(1);
+    if (item % 7 == 0) {
+        r.release(1);
+        return 0;
+    }
+    r.acquire(2);
+    if (item % 3 == 0) {
+        r.release(2);
+        r.release(1);
+        return 1;
+    }
+    r.acquire(3);
+    r.release(3);
+    r.release(2);
+    r.release(1);
+    return item;
+}
+
+// kDeferKernel as DeferLowering lowers it: each return runs its
+// ReturnStatement::cleanups inline, in order
+[[gnu::noinline]] int64_t handle_lowered(Resources& r, int64_t item) {
+    r.acquire(1);
+    if (item % 7 == 0) {
+        int64_t result = 0;
+        r.release(1);
+        return result;
+    }
+    r.acquire(2);
+    if (item % 3 == 0) {
+        int64_t result = 1;
+        r.release(2);
+        r.release(1);
+        return result;
+    }
+    r.acquire(3);
+    int64_t result = item;
+    r.release(3);
+    r.release(2);
+    r.release(1);
+    return result;
+}
+
+// kDeferKernel with defer pushing a closure onto a per-call stack that
+// every exit unwinds, the run-time scheme the lowering avoids
+[[gnu::noinline]] int64_t handle_with_closures(Resources& r, int64_t item) {
+    std::vector<std::function<void()>> deferred;
+    auto exit = [&](int64_t result) {
+        while (!deferred.empty()) {
+            deferred.back()();
+            deferred.pop_back();
+        }
+        return result;
+    };
+    r.acquire(1);
+    deferred.push_back([&r] { r.release(1); });
+    if (item % 7 == 0) return exit(0);
+    r.acquire(2);
+    deferred.push_back([&r] { r.release(2); });
+    if (item % 3 == 0) return exit(1);
+    r.acquire(3);
+    deferred.push_back([&r] { r.release(3); });
+    return exit(item);
+}
+
+template<typename Handle>
+Resources run_handles(Handle handle, int64_t count, int64_t& sum) {
+    Resources r;
+    for (int64_t item = 0; item < count; ++item) sum += handle(r, item);
+    return r;
+}
+
+} // namespace
+
+TEST_CASE("Lowered defer vs hand-written cleanup vs a closure stack", "[vre][.benchmark]") {
+    std::string source = kDeferKernel;
+    Lexer lexer(source, "defer_kernel.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "defer_kernel.vyn");
+    auto module = parser.parse_module();
+    vyn::DeferReport report = vyn::DeferLowering().run(module.get());
+    INFO(report.defers << " defers inlined at " << report.exits << " exits as " << report.inlinedCleanups
+         << " statements");
+    CHECK(report.inlinedCleanups == 9); // 1 + 2 + 3 at the returns, 3 at the end of the body
+
+    const int64_t count = 10000;
+    int64_t by_hand_sum = 0, lowered_sum = 0, closures_sum = 0;
+    Resources by_hand = run_handles(handle_by_hand, count, by_hand_sum);
+    Resources lowered = run_handles(handle_lowered, count, lowered_sum);
+    Resources closures = run_handles(handle_with_closures, count, closures_sum);
+    CHECK(by_hand.open == 0);
+    CHECK(lowered.checksum == by_hand.checksum);
+    CHECK(closures.checksum == by_hand.checksum);
+    CHECK(lowered_sum == by_hand_sum);
+
+    BENCHMARK("10000 calls, hand-written cleanup") {
+        int64_t sum = 0;
+        return run_handles(handle_by_hand, count, sum).checksum + sum;
+    };
+    BENCHMARK("10000 calls, lowered defer") {
+        int64_t sum = 0;
+        return run_handles(handle_lowered, count, sum).checksum + sum;
+    };
+    BENCHMARK("10000 calls, closure stack") {
+        int64_t sum = 0;
+        return run_handles(handle_with_closures, count, sum).checksum + sum;
+    };
+}
+
+namespace {
+
+// 16 classes implementing every subset of 4 traits, as C++ would model them:
+// each trait an interface, each class inheriting the interfaces it implements
+constexpr int kTraits = 4;
+constexpr int kTypes = 1 << kTraits;
+
+struct Instance {
+    virtual ~Instance() = default;
+    virtual int type_index() const = 0;
+};
+
+template<int Trait>
+struct TraitInterface {
+    virtual ~TraitInterface() = default;
+    virtual int64_t call() const { return Trait + 1; }
+};
+
+template<int Trait>
+struct NoTrait {};
+
+template<int Trait, int Mask>
+using TraitBase = std::conditional_t<(Mask >> Trait) & 1, TraitInterface<Trait>, NoTrait<Trait>>;
+
+template<int Mask>
+struct Implementor final : Instance, TraitBase<0, Mask>, TraitBase<1, Mask>, TraitBase<2, Mask>, TraitBase<3, Mask> {
+    int type_index() const override { return Mask; }
+};
+
+template<int... Masks>
+std::unique_ptr<Instance> make_implementor(int mask, std::integer_sequence<int, Masks...>) {
+    std::unique_ptr<Instance> result;
+    ((mask == Masks ? (result = std::make_unique<Implementor<Masks>>(), 0) : 0), ...);
+    return result;
+}
+
+// How many (object, trait) pairs have an implementation, asked four ways
+[[gnu::noinline]] int64_t count_by_dynamic_cast(const std::vector<std::unique_ptr<Instance>>& objects) {
+    int64_t found = 0;
+    for (const auto& object : objects) {
+        found += dynamic_cast<const TraitInterface<0>*>(object.get()) != nullptr;
+        found += dynamic_cast<const TraitInterface<1>*>(object.get()) != nullptr;
+        found += dynamic_cast<const TraitInterface<2>*>(object.get()) != nullptr;
+        found += dynamic_cast<const TraitInterface<3>*>(object.get()) != nullptr;
+    }
+    return found;
+}
+
+[[gnu::noinline]] int64_t count_by_map(const std::vector<vyn::vre::VreTypeId>& objects,
+                                       const std::unordered_map<uint64_t, const vyn::vre::VreVtableHeader*>& impls) {
+    int64_t found = 0;
+    for (vyn::vre::VreTypeId type : objects) {
+        for (uint64_t trait = 0; trait < kTraits; ++trait) {
+            auto it = impls.find(uint64_t{type} << 32 | trait);
+            found += it != impls.end() && it->second;
+        }
+    }
+    return found;
+}
+
+[[gnu::noinline]] int64_t count_by_table(const std::vector<vyn::vre::VreTypeId>& objects,
+                                         const vyn::vre::VreTypeTable& table) {
+    int64_t found = 0;
+    for (vyn::vre::VreTypeId type : objects) {
+        for (vyn::vre::VreTraitId trait = 0; trait < kTraits; ++trait) {
+            found += table.vtable(type, trait) != nullptr;
+        }
+    }
+    return found;
+}
+
+} // namespace
+
+TEST_CASE("Trait tests through the type table vs dynamic_cast vs a hash map", "[vre][.benchmark]") {
+    using namespace vyn::vre;
+    static const VreVtableHeader vtables[kTypes][kTraits] = {};
+    VreTypeTableBuilder builder;
+    std::vector<VreTypeId> ids;
+    for (int mask = 0; mask < kTypes; ++mask) ids.push_back(builder.add_type("T" + std::to_string(mask), 8, 8, {}));
+    for (int trait = 0; trait < kTraits; ++trait) builder.add_trait("Trait" + std::to_string(trait));
+    std::unordered_map<uint64_t, const VreVtableHeader*> impls;
+    for (int mask = 0; mask < kTypes; ++mask) {
+        for (int trait = 0; trait < kTraits; ++trait) {
+            if (!((mask >> trait) & 1)) continue;
+            builder.implement(ids[mask], trait, &vtables[mask][trait]);
+            impls.emplace(uint64_t{ids[mask]} << 32 | static_cast<uint64_t>(trait), &vtables[mask][trait]);
+        }
+    }
+    VreTypeTable table = builder.build();
+
+    const size_t count = 10000;
+    std::vector<std::unique_ptr<Instance>> instances;
+    std::vector<VreTypeId> typed;
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        int mask = static_cast<int>(seed >> 60);
+        instances.push_back(make_implementor(mask, std::make_integer_sequence<int, kTypes>()));
+        typed.push_back(ids[mask]);
+    }
+    int64_t expected = count_by_dynamic_cast(instances);
+    CHECK(count_by_map(typed, impls) == expected);
+    CHECK(count_by_table(typed, table) == expected);
+
+    BENCHMARK("10000 objects x 4 traits, dynamic_cast") {
+        return count_by_dynamic_cast(instances);
+    };
+    BENCHMARK("10000 objects x 4 traits, unordered_map") {
+        return count_by_map(typed, impls);
+    };
+    BENCHMARK("10000 objects x 4 traits, VreTypeTable") {
+        return count_by_table(typed, table);
+    };
+}
+
+namespace {
+
+// One trait, `area`, implemented by a square and a rectangle; the C++
+// reference is the same hierarchy with virtual functions
+struct Square {
+    int64_t side;
+};
+struct Rect {
+    int64_t width, height;
+};
+
+int64_t square_area(void* self) { return static_cast<Square*>(self)->side * static_cast<Square*>(self)->side; }
+int64_t rect_area(void* self) { return static_cast<Rect*>(self)->width * static_cast<Rect*>(self)->height; }
+
+const auto kSquareVtable = vyn::vre::vre_vtable_for<Square>(1, square_area);
+const auto kRectVtable = vyn::vre::vre_vtable_for<Rect>(2, rect_area);
+
+struct VirtualShape {
+    virtual ~VirtualShape() = default;
+    virtual int64_t area() const = 0;
+};
+struct VirtualSquare final : VirtualShape {
+    int64_t side;
+    explicit VirtualSquare(int64_t s) : side(s) {}
+    int64_t area() const override { return side * side; }
+};
+struct VirtualRect final : VirtualShape {
+    int64_t width, height;
+    VirtualRect(int64_t w, int64_t h) : width(w), height(h) {}
+    int64_t area() const override { return width * height; }
+};
+
+// Every `period`-th shape is a Rect; 0 for squares only
+std::vector<vyn::vre::VreTraitObject> make_trait_shapes(size_t count, size_t period) {
+    std::vector<vyn::vre::VreTraitObject> shapes;
+    for (size_t i = 0; i < count; ++i) {
+        auto n = static_cast<int64_t>(i % 100);
+        if (period && i % period == 0) {
+            shapes.push_back(vyn::vre::VreTraitObject::make<Rect>(&kRectVtable.header, Rect{n, 2}));
+        } else {
+            shapes.push_back(vyn::vre::VreTraitObject::make<Square>(&kSquareVtable.header, Square{n}));
+        }
+    }
+    return shapes;
+}
+
+std::vector<std::unique_ptr<VirtualShape>> make_virtual_shapes(size_t count, size_t period) {
+    std::vector<std::unique_ptr<VirtualShape>> shapes;
+    for (size_t i = 0; i < count; ++i) {
+        auto n = static_cast<int64_t>(i % 100);
+        if (period && i % period == 0) {
+            shapes.push_back(std::make_unique<VirtualRect>(n, 2));
+        } else {
+            shapes.push_back(std::make_unique<VirtualSquare>(n));
+        }
+    }
+    return shapes;
+}
+
+[[gnu::noinline]] int64_t sum_virtual(const std::vector<std::unique_ptr<VirtualShape>>& shapes) {
+    int64_t sum = 0;
+    for (const auto& shape : shapes) sum += shape->area();
+    return sum;
+}
+
+[[gnu::noinline]] int64_t sum_vtable(std::vector<vyn::vre::VreTraitObject>& shapes) {
+    int64_t sum = 0;
+    for (auto& shape : shapes) sum += shape.call<int64_t>(0);
+    return sum;
+}
+
+[[gnu::noinline]] int64_t sum_profiled(std::vector<vyn::vre::VreTraitObject>& shapes, vyn::vre::VreDispatchSite& site) {
+    int64_t sum = 0;
+    for (auto& shape : shapes) sum += site.call<int64_t>(shape, 0);
+    return sum;
+}
+
+[[gnu::noinline]] int64_t sum_guarded(std::vector<vyn::vre::VreTraitObject>& shapes) {
+    int64_t sum = 0;
+    for (auto& shape : shapes) sum += vyn::vre::vre_guarded_call<square_area>(shape, &kSquareVtable.header, 0);
+    return sum;
+}
+
+} // namespace
+
+TEST_CASE("Trait-object dispatch: vtable, profiled, guarded and C++ virtual", "[vre][.benchmark]") {
+    const size_t count = 10000;
+    auto mono = make_trait_shapes(count, 0);
+    auto mixed = make_trait_shapes(count, 2);
+    auto virtual_mono = make_virtual_shapes(count, 0);
+    auto virtual_mixed = make_virtual_shapes(count, 2);
+    vyn::vre::VreDispatchSite site;
+    int64_t expected = sum_virtual(virtual_mono);
+    CHECK(sum_vtable(mono) == expected);
+    CHECK(sum_profiled(mono, site) == expected);
+    CHECK(sum_guarded(mono) == expected);
+    CHECK(site.state() == vyn::vre::VreDispatchSite::State::MONOMORPHIC);
+    CHECK(sum_guarded(mixed) == sum_virtual(virtual_mixed));
+    CHECK(mono[0].is_inline());
+
+    BENCHMARK("10000 calls, one type, C++ virtual") {
+        return sum_virtual(virtual_mono);
+    };
+    BENCHMARK("10000 calls, one type, vtable") {
+        return sum_vtable(mono);
+    };
+    BENCHMARK("10000 calls, one type, profiled site") {
+        return sum_profiled(mono, site);
+    };
+    BENCHMARK("10000 calls, one type, guarded fast path") {
+        return sum_guarded(mono);
+    };
+    BENCHMARK("10000 calls, two types, C++ virtual") {
+        return sum_virtual(virtual_mixed);
+    };
+    BENCHMARK("10000 calls, two types, vtable") {
+        return sum_vtable(mixed);
+    };
+    BENCHMARK("10000 calls, two types, guarded fast path") {
+        return sum_guarded(mixed);
+    };
+    BENCHMARK("box 10000 small values, inline trait objects") {
+        return make_trait_shapes(count, 2).size();
+    };
+    BENCHMARK("box 10000 small values, std::make_unique") {
+        return make_virtual_shapes(count, 2).size();
+    };
+}
+
+namespace {
+
+// A closure over two Ints and a String, the shape ClosureConversion gives
+// `fn (x: Int) => x * scale + offset` plus a captured label
+struct ScaleEnv {
+    int64_t scale;
+    int64_t offset;
+    vyn::vre::VreString label;
+};
+
+[[gnu::noinline]] int64_t scale_direct(ScaleEnv* env, int64_t x) { return x * env->scale + env->offset; }
+[[gnu::noinline]] int64_t scale_code(void* env, int64_t x) { return scale_direct(static_cast<ScaleEnv*>(env), x); }
+
+[[gnu::noinline]] int64_t sum_direct(ScaleEnv& env, int64_t count) {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < count; ++i) sum += scale_direct(&env, i);
+    return sum;
+}
+
+[[gnu::noinline]] int64_t sum_closure(const vyn::vre::VreClosure& fn, int64_t count) {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < count; ++i) sum += fn.call<int64_t>(i);
+    return sum;
+}
+
+[[gnu::noinline]] int64_t sum_std_function(const std::function<int64_t(int64_t)>& fn, int64_t count) {
+    int64_t sum = 0;
+    for (int64_t i = 0; i < count; ++i) sum += fn(i);
+    return sum;
+}
+
+} // namespace
+
+TEST_CASE("Closure calls: direct vs VreClosure vs std::function", "[vre][.benchmark]") {
+    const int64_t count = 10000;
+    ScaleEnv env{3, 7, vyn::vre::VreString("scale")};
+    vyn::vre::VreClosure closure = vyn::vre::VreClosure::make(scale_code, ScaleEnv{3, 7, vyn::vre::VreString("scale")});
+    std::function<int64_t(int64_t)> function = [env](int64_t x) { return scale_direct(const_cast<ScaleEnv*>(&env), x); };
+    int64_t expected = sum_direct(env, count);
+    CHECK(sum_closure(closure, count) == expected);
+    CHECK(sum_std_function(function, count) == expected);
+
+    BENCHMARK("10000 calls, direct") {
+        return sum_direct(env, count);
+    };
+    BENCHMARK("10000 calls, VreClosure") {
+        return sum_closure(closure, count);
+    };
+    BENCHMARK("10000 calls, std::function") {
+        return sum_std_function(function, count);
+    };
+    BENCHMARK("make 1000 closures, VreClosure") {
+        int64_t total = 0;
+        for (int64_t i = 0; i < 1000; ++i) {
+            auto made = vyn::vre::VreClosure::make(scale_code, ScaleEnv{i, 1, vyn::vre::VreString("s")});
+            total += made.function()->env_size;
+        }
+        return total;
+    };
+    BENCHMARK("make 1000 closures, std::function") {
+        int64_t total = 0;
+        for (int64_t i = 0; i < 1000; ++i) {
+            ScaleEnv captured{i, 1, vyn::vre::VreString("s")};
+            std::function<int64_t(int64_t)> made = [captured](int64_t x) {
+                return scale_direct(const_cast<ScaleEnv*>(&captured), x);
+            };
+            total += static_cast<bool>(made);
+        }
+        return total;
+    };
+}
+
+namespace {
+
+constexpr const char* kNativeSieve = R"(fn sieve() -> Int {
+    var composite: [Bool; 200000]
+    var count = 0
+    for (i in 2..200000) {
+        if (!composite[i]) {
+            count = count + 1
+            var j = i * i
+            while (j < 200000) {
+                composite[j] = true
+                j = j + i
+            }
+        }
+    }
+    return count
+}
+
+fn main() -> Int {
+    var total = 0
+    for (round in 0..20) {
+        total = total + sieve()
+    }
+    println(total)
+    return 0
+})";
+
+// A B-tree of order 8 over Int keys: the monomorphic core of examples/btree.vyn
+constexpr const char* kNativeBTree = R"(class Node {
+    var keys: [Int; 7]
+    var children: [my<Node>; 8]
+    var count: Int
+    var leaf: Bool
+}
+
+class Tree {
+    var root: my<Node>
+    var size: Int
+
+    fn insert(self: their<Tree>, key: Int) {
+        if (self.root.count == 7) {
+            var top = new_node(false)
+            top.children[0] = self.root
+            self.root = top
+            split_child(borrow self.root, 0)
+        }
+        insert_non_full(borrow self.root, key)
+        self.size = self.size + 1
+    }
+
+    fn contains(self: their<Tree>, key: Int) -> Bool {
+        var node = borrow self.root
+        while (true) {
+            var i = 0
+            while (i < node.count && key > node.keys[i]) {
+                i = i + 1
+            }
+            if (i < node.count && key == node.keys[i]) {
+                return true
+            }
+            if (node.leaf) {
+                return false
+            }
+            node = borrow node.children[i]
+        }
+        return false
+    }
+}
+
+fn new_node(leaf: Bool) -> my<Node> {
+    return make_my(Node { count: 0, leaf: leaf })
+}
+
+fn split_child(parent: their<Node>, i: Int) {
+    var full = borrow parent.children[i]
+    var sibling = new_node(full.leaf)
+    for (j in 0..3) {
+        sibling.keys[j] = full.keys[j + 4]
+    }
+    if (!full.leaf) {
+        for (j in 0..4) {
+            sibling.children[j] = full.children[j + 4]
+        }
+    }
+    sibling.count = 3
+    full.count = 3
+    var j = parent.count
+    while (j > i) {
+        parent.children[j + 1] = parent.children[j]
+        parent.keys[j] = parent.keys[j - 1]
+        j = j - 1
+    }
+    parent.children[i + 1] = sibling
+    parent.keys[i] = full.keys[3]
+    parent.count = parent.count + 1
+}
+
+fn insert_non_full(node: their<Node>, key: Int) {
+    var i = node.count - 1
+    if (node.leaf) {
+        while (i >= 0 && node.keys[i] > key) {
+            node.keys[i + 1] = node.keys[i]
+            i = i - 1
+        }
+        node.keys[i + 1] = key
+        node.count = node.count + 1
+    } else {
+        while (i >= 0 && node.keys[i] > key) {
+            i = i - 1
+        }
+        i = i + 1
+        if (node.children[i].count == 7) {
+            split_child(node, i)
+            if (key > node.keys[i]) {
+                i = i + 1
+            }
+        }
+        insert_non_full(borrow node.children[i], key)
+    }
+}
+
+// A 31-bit linear congruential generator; key * 1103515245 fits in an Int
+fn next_key(key: Int) -> Int {
+    var next = key * 1103515245 + 12345
+    return next - next / 2147483648 * 2147483648
+}
+
+fn main() -> Int {
+    var tree = Tree { root: new_node(true), size: 0 }
+    var key = 1
+    for (k in 0..20000) {
+        key = next_key(key)
+        tree.insert(key)
+    }
+    var found = 0
+    key = 1
+    for (k in 0..40000) {
+        key = next_key(key)
+        if (tree.contains(key)) {
+            found = found + 1
+        }
+    }
+    println(found)
+    return 0
+})";
+
+int64_t native_sieve() {
+    static bool composite[200000];
+    std::fill(std::begin(composite), std::end(composite), false);
+    int64_t count = 0;
+    for (int64_t i = 2; i < 200000; ++i) {
+        if (!composite[i]) {
+            ++count;
+            for (int64_t j = i * i; j < 200000; j += i) composite[j] = true;
+        }
+    }
+    return count;
+}
+
+// The same B-tree written directly in C++
+struct NativeNode {
+    int64_t keys[7];
+    std::unique_ptr<NativeNode> children[8];
+    int64_t count = 0;
+    bool leaf;
+    explicit NativeNode(bool is_leaf) : leaf(is_leaf) {}
+};
+
+void native_split(NativeNode* parent, int64_t i) {
+    NativeNode* full = parent->children[i].get();
+    auto sibling = std::make_unique<NativeNode>(full->leaf);
+    for (int j = 0; j < 3; ++j) sibling->keys[j] = full->keys[j + 4];
+    if (!full->leaf) {
+        for (int j = 0; j < 4; ++j) sibling->children[j] = std::move(full->children[j + 4]);
+    }
+    sibling->count = full->count = 3;
+    for (int64_t j = parent->count; j > i; --j) {
+        parent->children[j + 1] = std::move(parent->children[j]);
+        parent->keys[j] = parent->keys[j - 1];
+    }
+    parent->children[i + 1] = std::move(sibling);
+    parent->keys[i] = full->keys[3];
+    ++parent->count;
+}
+
+void native_insert_non_full(NativeNode* node, int64_t key) {
+    int64_t i = node->count - 1;
+    if (node->leaf) {
+        for (; i >= 0 && node->keys[i] > key; --i) node->keys[i + 1] = node->keys[i];
+        node->keys[i + 1] = key;
+        ++node->count;
+        return;
+    }
+    while (i >= 0 && node->keys[i] > key) --i;
+    ++i;
+    if (node->children[i]->count == 7) {
+        native_split(node, i);
+        if (key > node->keys[i]) ++i;
+    }
+    native_insert_non_full(node->children[i].get(), key);
+}
+
+int64_t native_btree() {
+    auto root = std::make_unique<NativeNode>(true);
+    auto next_key = [](int64_t key) { return (key * 1103515245 + 12345) % 2147483648; };
+    int64_t key = 1;
+    for (int k = 0; k < 20000; ++k) {
+        key = next_key(key);
+        if (root->count == 7) {
+            auto top = std::make_unique<NativeNode>(false);
+            top->children[0] = std::move(root);
+            root = std::move(top);
+            native_split(root.get(), 0);
+        }
+        native_insert_non_full(root.get(), key);
+    }
+    int64_t found = 0;
+    key = 1;
+    for (int k = 0; k < 40000; ++k) {
+        key = next_key(key);
+        for (NativeNode* node = root.get();;) {
+            int64_t i = 0;
+            while (i < node->count && key > node->keys[i]) ++i;
+            if (i < node->count && key == node->keys[i]) {
+                ++found;
+                break;
+            }
+            if (node->leaf) break;
+            node = node->children[i].get();
+        }
+    }
+    return found;
+}
+
+// Compiles a Vyn program through the C backend; returns the executable's path
+std::string build_native(const std::string& source, const std::string& name) {
+    Lexer lexer(source, name + ".vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, name + ".vyn");
+    auto module = parser.parse_module();
+    vyn::BoundsCheckElimination().run(module.get());
+    vyn::DeferLowering().run(module.get());
+    std::string executable = (std::filesystem::temp_directory_path() / ("vyn_bench_" + name)).string();
+    vyn::CBackend::compile(vyn::CBackend().run(module.get()), executable);
+    return executable;
+}
+
+std::string run_native(const std::string& executable) {
+    std::string output = executable + ".out";
+    if (std::system(("'" + executable + "' > '" + output + "'").c_str()) != 0) return "failed";
+    std::ifstream file(output);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+TEST_CASE("Native code from the C backend vs hand-written C++", "[vre][.benchmark]") {
+    if (std::system("cc --version > /dev/null 2>&1") != 0) {
+        WARN("no C compiler; skipping");
+        return;
+    }
+    auto started = std::chrono::steady_clock::now();
+    std::string empty = build_native("fn main() -> Int {\n    return 0\n}", "empty");
+    std::string sieve = build_native(kNativeSieve, "sieve");
+    std::string btree = build_native(kNativeBTree, "btree");
+    auto compile_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    INFO("three programs lowered and compiled with cc -O2 in " << compile_ms.count() << " ms");
+
+    int64_t sieve_total = 0;
+    for (int round = 0; round < 20; ++round) sieve_total += native_sieve();
+    CHECK(run_native(sieve) == std::to_string(sieve_total) + "\n");
+    CHECK(run_native(btree) == std::to_string(native_btree()) + "\n");
+
+    // Each run of an executable includes starting the process; the empty
+    // program measures that part alone
+    BENCHMARK("process start, empty Vyn program") {
+        return std::system(("'" + empty + "'").c_str());
+    };
+    BENCHMARK("sieve x20, Vyn via C backend (process)") {
+        return std::system(("'" + sieve + "' > /dev/null").c_str());
+    };
+    BENCHMARK("sieve x20, C++ in process") {
+        int64_t total = 0;
+        for (int round = 0; round < 20; ++round) total += native_sieve();
+        return total;
+    };
+    BENCHMARK("B-tree 20k inserts + 40k lookups, Vyn via C backend (process)") {
+        return std::system(("'" + btree + "' > /dev/null").c_str());
+    };
+    BENCHMARK("B-tree 20k inserts + 40k lookups, C++ in process") {
+        return native_btree();
+    };
+
+    for (const std::string& executable : {empty, sieve, btree}) {
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+        std::filesystem::remove(executable + ".out");
+    }
+}
+
+namespace {
+
+// A function that spends its one call in a loop, as a main does
+constexpr const char* kLongLoop = R"(fn spin(limit: Int) -> Int {
+    var i = 0
+    var total = 0
+    while (i < limit) {
+        total = total + (i & 255) - total / 512
+        i = i + 1
+    }
+    return total
+})";
+
+} // namespace
+
+TEST_CASE("Tiered engine: long loops in the interpreter vs after on-stack replacement", "[vre][.benchmark]") {
+    if (std::system("cc --version > /dev/null 2>&1") != 0) {
+        WARN("no C compiler; skipping");
+        return;
+    }
+    Lexer lexer(kLongLoop, "long_loop.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "long_loop.vyn");
+    auto module = parser.parse_module();
+    using vyn::vre::VreValue;
+
+    vyn::TierOptions never;
+    never.callThreshold = std::numeric_limits<uint64_t>::max();
+    never.backEdgeThreshold = std::numeric_limits<uint64_t>::max();
+    vyn::TieredEngine interpreter(never);
+    interpreter.load(module.get());
+
+    // One call that never re-enters: only the back-edge counter and OSR can
+    // move it, while the compile runs on its thread
+    const int64_t iterations = 100000000;
+    auto started = std::chrono::steady_clock::now();
+    int64_t interpreted = std::get<int64_t>(interpreter.call("spin", {VreValue(iterations)}).data);
+    auto interpreted_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    vyn::TieredEngine tiered;
+    tiered.load(module.get());
+    started = std::chrono::steady_clock::now();
+    int64_t replaced = std::get<int64_t>(tiered.call("spin", {VreValue(iterations)}).data);
+    auto tiered_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    CHECK(replaced == interpreted);
+    CHECK(tiered.report().osrEntries == 1);
+    WARN("100M iterations in one call: " << interpreted_ms << " ms interpreted, " << tiered_ms
+         << " ms tiered (compile " << tiered.report().compileMilliseconds << " ms, "
+         << tiered.report().backEdges << " back edges before OSR)");
+
+    BENCHMARK("1M iterations, bytecode") {
+        return interpreter.call("spin", {VreValue(int64_t{1000000})});
+    };
+    BENCHMARK("1M iterations, native (entered from the engine)") {
+        return tiered.call("spin", {VreValue(int64_t{1000000})});
+    };
+}
+
+TEST_CASE("REPL: per-input latency in a large session", "[vre][.benchmark]") {
+    vyn::Repl repl;
+    // A session that has already defined a thousand functions and globals
+    for (int i = 0; i < 1000; ++i) {
+        std::string n = std::to_string(i);
+        repl.eval("var g" + n + " = " + n + "\nfn f" + n + "(x: Int) -> Int {\n    return x + g" + n + "\n}\n");
+    }
+    REQUIRE(repl.eval("f999(1) + f0(1)") == "1001");
+
+    int counter = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        std::string n = std::to_string(counter++);
+        repl.eval("fn step" + n + "(x: Int) -> Int {\n    return f" + n + "(x) * 2\n}\nstep" + n + "(g500)");
+    }
+    double per_input =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count() / 100;
+    CHECK(per_input < 5.0);
+    WARN("after 2000 definitions: " << per_input << " ms per input (a definition and a call)");
+
+    BENCHMARK("expression input") {
+        return repl.eval("f" + std::to_string(counter % 1000) + "(g1) + g2");
+    };
+    BENCHMARK("definition and call input") {
+        std::string n = std::to_string(counter++);
+        return repl.eval("fn more" + n + "(x: Int) -> Int {\n    return x + 1\n}\nmore" + n + "(g3)");
+    };
+}
@@ -0,0 +1,245 @@
+#include "vyn/bounds_check.hpp"
+
+#include <algorithm>
+
+namespace vyn {
+
+namespace {
+
+// Methods that cannot shrink a slice or array
+bool is_length_query(const std::string& name) {
+    return name == "len" || name == "length";
+}
+
+// Collects the names a loop body may change: assignment targets, redeclared
+// names, and receivers of method calls other than length queries.
+class MutationCollector : public AstWalker {
+public:
+    std::unordered_set<std::string> names;
+
+    using AstWalker::visit;
+
+    void visit(AssignmentExpression* node) override {
+        if (node->left && node->left->getType() == NodeType::IDENTIFIER) {
+            names.insert(static_cast<Identifier*>(node->left.get())->name);
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(VariableDeclaration* node) override {
+        if (node->id) names.insert(node->id->name);
+        AstWalker::visit(node);
+    }
+
+    void visit(CallExpression* node) override {
+        if (node->callee && node->callee->getType() == NodeType::MEMBER_EXPRESSION) {
+            auto* member = static_cast<MemberExpression*>(node->callee.get());
+            if (!member->computed && member->object && member->object->getType() == NodeType::IDENTIFIER &&
+                member->property && member->property->getType() == NodeType::IDENTIFIER &&
+                !is_length_query(static_cast<Identifier*>(member->property.get())->name)) {
+                names.insert(static_cast<Identifier*>(member->object.get())->name);
+            }
+        }
+        AstWalker::visit(node);
+    }
+};
+
+// Finds break, continue, return and throw (a call to `_throw`): anything
+// that ends an iteration before the rest of the body runs
+class EarlyExitFinder : public AstWalker {
+public:
+    bool found = false;
+
+    using AstWalker::visit;
+
+    void visit(BreakStatement*) override { found = true; }
+    void visit(ContinueStatement*) override { found = true; }
+    void visit(ReturnStatement*) override { found = true; }
+    void visit(ClosureExpression*) override {} // its returns leave the closure
+
+    void visit(CallExpression* node) override {
+        if (node->callee && node->callee->getType() == NodeType::IDENTIFIER &&
+            static_cast<Identifier*>(node->callee.get())->name == "_throw") {
+            found = true;
+        }
+        AstWalker::visit(node);
+    }
+};
+
+const std::string* identifier_name(Expression* expr) {
+    if (expr && expr->getType() == NodeType::IDENTIFIER) {
+        return &static_cast<Identifier*>(expr)->name;
+    }
+    return nullptr;
+}
+
+// The variable whose length `expr` is: `x` for `x.len()`, `x.length` or
+// `len(x)`; nullptr for anything else
+const std::string* length_receiver(Expression* expr) {
+    if (!expr) return nullptr;
+    if (expr->getType() == NodeType::CALL_EXPRESSION) {
+        auto* call = static_cast<CallExpression*>(expr);
+        if (call->callee && call->callee->getType() == NodeType::MEMBER_EXPRESSION && call->arguments.empty()) {
+            return length_receiver(call->callee.get());
+        }
+        const std::string* callee = identifier_name(call->callee.get());
+        if (callee && *callee == "len" && call->arguments.size() == 1) {
+            return identifier_name(call->arguments[0].get());
+        }
+        return nullptr;
+    }
+    if (expr->getType() == NodeType::MEMBER_EXPRESSION) {
+        auto* member = static_cast<MemberExpression*>(expr);
+        const std::string* property = identifier_name(member->property.get());
+        if (!member->computed && property && is_length_query(*property)) {
+            return identifier_name(member->object.get());
+        }
+    }
+    return nullptr;
+}
+
+// Finds calls other than length queries: print, or a function that may
+// print. A hoisted check that fails panics before any iteration runs, so
+// nothing an iteration before the failing access would have shown may
+// exist. Stores are not effects here, since a panic ends the program.
+class EffectFinder : public AstWalker {
+public:
+    bool found = false;
+
+    using AstWalker::visit;
+
+    void visit(ClosureExpression*) override {} // creating one runs nothing
+
+    void visit(CallExpression* node) override {
+        if (!length_receiver(node)) found = true;
+        AstWalker::visit(node);
+    }
+};
+
+} // namespace
+
+BoundsCheckReport BoundsCheckElimination::run(Module* module) {
+    loops_.clear();
+    conditional_ = 0;
+    report_ = BoundsCheckReport();
+    walk(module);
+    return report_;
+}
+
+const BoundsCheckElimination::Loop* BoundsCheckElimination::enclosing_loop(const std::string& induction) const {
+    for (auto it = loops_.rbegin(); it != loops_.rend(); ++it) {
+        if (it->induction == induction) return &*it;
+    }
+    return nullptr;
+}
+
+void BoundsCheckElimination::visit(ForStatement* node) {
+    const std::string* induction = node->init && node->init->getType() == NodeType::IDENTIFIER
+                                       ? &static_cast<Identifier*>(node->init.get())->name
+                                       : nullptr;
+    auto* range = node->test && node->test->getType() == NodeType::BINARY_EXPRESSION
+                      ? static_cast<BinaryExpression*>(node->test.get())
+                      : nullptr;
+    bool counted = induction && range && range->op.type == TokenType::DOTDOT && range->left &&
+                   range->left->getType() == NodeType::INTEGER_LITERAL &&
+                   static_cast<IntegerLiteral*>(range->left.get())->value >= 0;
+    if (!counted) {
+        AstWalker::visit(node);
+        return;
+    }
+
+    MutationCollector mutations;
+    mutations.walk(node->body.get());
+    EarlyExitFinder exits;
+    exits.walk(node->body.get());
+    EffectFinder effects;
+    effects.walk(node->body.get());
+    walk(node->test.get());
+    // The body may run zero times, so it is conditional for enclosing loops
+    ++conditional_;
+    loops_.push_back(Loop{node, *induction, range->right.get(), std::move(mutations.names), conditional_,
+                          exits.found, effects.found});
+    walk(node->body.get());
+    loops_.pop_back();
+    --conditional_;
+}
+
+void BoundsCheckElimination::visit(IfStatement* node) {
+    walk(node->test.get());
+    ++conditional_;
+    walk(node->consequent.get());
+    walk(node->alternate.get());
+    --conditional_;
+}
+
+void BoundsCheckElimination::visit(WhileStatement* node) {
+    ++conditional_;
+    AstWalker::visit(node);
+    --conditional_;
+}
+
+void BoundsCheckElimination::visit(TryStatement* node) {
+    ++conditional_;
+    AstWalker::visit(node);
+    --conditional_;
+}
+
+void BoundsCheckElimination::visit(DeferStatement* node) {
+    ++conditional_;
+    AstWalker::visit(node);
+    --conditional_;
+}
+
+void BoundsCheckElimination::visit(ClosureExpression* node) {
+    ++conditional_;
+    AstWalker::visit(node);
+    --conditional_;
+}
+
+void BoundsCheckElimination::visit(BinaryExpression* node) {
+    walk(node->left.get());
+    bool shortCircuit = node->op.type == TokenType::AND || node->op.type == TokenType::OR;
+    if (shortCircuit) ++conditional_;
+    walk(node->right.get());
+    if (shortCircuit) --conditional_;
+}
+
+void BoundsCheckElimination::visit(MemberExpression* node) {
+    AstWalker::visit(node);
+    if (!node->computed || !node->property) return;
+    if (node->property->getType() == NodeType::BINARY_EXPRESSION &&
+        static_cast<BinaryExpression*>(node->property.get())->op.type == TokenType::DOTDOT) {
+        return; // subslice; its range is checked once when the slice is made
+    }
+    ++report_.indexSites;
+
+    const std::string* slice = identifier_name(node->object.get());
+    const std::string* index = identifier_name(node->property.get());
+    const Loop* loop = index ? enclosing_loop(*index) : nullptr;
+    if (!slice || !loop || loop->mutated.count(*slice) || loop->mutated.count(loop->induction)) return;
+
+    const std::string* measured = length_receiver(loop->upper);
+    if (measured && *measured == *slice) {
+        node->boundsCheck = BoundsCheck::ELIMINATED;
+        ++report_.eliminated;
+        return;
+    }
+
+    // Literals, unassigned variables and lengths of unmutated variables
+    const std::string* bound = measured ? measured : identifier_name(loop->upper);
+    bool invariant = (loop->upper && loop->upper->getType() == NodeType::INTEGER_LITERAL) ||
+                     (bound && !loop->mutated.count(*bound));
+    if (!invariant || loop->exits || loop->effects || conditional_ != loop->conditional) return;
+
+    node->boundsCheck = BoundsCheck::HOISTED;
+    ++report_.hoisted;
+    auto& checks = loop->node->hoistedBoundsChecks;
+    bool already = std::any_of(checks.begin(), checks.end(),
+                               [&](const HoistedBoundsCheck& check) { return check.slice == *slice; });
+    if (!already) {
+        checks.push_back(HoistedBoundsCheck{*slice, loop->upper});
+        ++report_.hoistedChecks;
+    }
+}
+
+} // namespace vyn
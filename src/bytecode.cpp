@@ -0,0 +1,658 @@
+#include "vyn/bytecode.hpp"
+
+#include "vyn/control_flow.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace vyn {
+
+namespace {
+
+using Operand = BytecodeCompiler::Operand;
+
+std::string location_to_string(const SourceLocation& loc) {
+    return loc.filePath + ":" + std::to_string(loc.line) + ":" + std::to_string(loc.column);
+}
+
+[[noreturn]] void fail(Node* node, const std::string& message) {
+    throw std::runtime_error("bytecode: " + message + " at " + location_to_string(node->loc));
+}
+
+const char* kind_name(SlotKind kind) {
+    switch (kind) {
+        case SlotKind::VOID: return "nothing";
+        case SlotKind::INT: return "Int";
+        case SlotKind::FLOAT: return "Float";
+        case SlotKind::BOOL: return "Bool";
+    }
+    return "?";
+}
+
+Slot int_slot(int64_t value) {
+    Slot slot;
+    slot.i = value;
+    return slot;
+}
+
+Slot float_slot(double value) {
+    Slot slot;
+    slot.f = value;
+    return slot;
+}
+
+} // namespace
+
+BytecodeModule BytecodeCompiler::run(Module* module) {
+    BytecodeModule result;
+    module_ = &result;
+    for (auto& stmt : module->body) {
+        if (stmt->getType() != NodeType::FUNCTION_DECLARATION) {
+            fail(stmt.get(), "the bytecode tier runs functions only, not '" + stmt->toString() + "'");
+        }
+        BytecodeFunction fn = signature(static_cast<FunctionDeclaration*>(stmt.get()));
+        if (!result.byName.emplace(fn.name, static_cast<uint32_t>(result.functions.size())).second) {
+            fail(stmt.get(), "duplicate function " + fn.name);
+        }
+        result.functions.push_back(std::move(fn));
+    }
+    for (BytecodeFunction& fn : result.functions) compileFunction(fn);
+    module_ = nullptr;
+    return result;
+}
+
+BytecodeInput BytecodeCompiler::add(BytecodeModule& session, Module* input) {
+    module_ = &session;
+    size_t functions = session.functions.size();
+    size_t globals = session.globals.size();
+    std::vector<std::pair<uint32_t, BytecodeFunction>> replaced; // compiled aside, swapped in at the end
+    std::vector<Statement*> statements;
+    BytecodeInput result;
+    BytecodeFunction script;
+    script.name = "<input>";
+    try {
+        for (auto& stmt : input->body) {
+            if (stmt->getType() != NodeType::FUNCTION_DECLARATION) {
+                statements.push_back(stmt.get());
+                continue;
+            }
+            BytecodeFunction fn = signature(static_cast<FunctionDeclaration*>(stmt.get()));
+            auto found = session.byName.find(fn.name);
+            bool earlier = found != session.byName.end() && found->second < functions;
+            bool twice = std::any_of(replaced.begin(), replaced.end(), [&](const auto& entry) {
+                return entry.second.name == fn.name;
+            });
+            if ((found != session.byName.end() && !earlier) || twice) fail(stmt.get(), "duplicate function " + fn.name);
+            result.functions.push_back(fn.name);
+            if (!earlier) {
+                session.byName.emplace(fn.name, static_cast<uint32_t>(session.functions.size()));
+                session.functions.push_back(std::move(fn));
+                continue;
+            }
+            const BytecodeFunction& old = session.functions[found->second];
+            if (old.params != fn.params || old.result != fn.result) {
+                fail(stmt.get(), "cannot change the signature of " + fn.name + ", which earlier input may call");
+            }
+            replaced.emplace_back(found->second, std::move(fn));
+        }
+        // The statements first, so the input's functions can read the globals it declares
+        compileScript(script, statements);
+        for (size_t i = functions; i < session.functions.size(); ++i) compileFunction(session.functions[i]);
+        for (auto& entry : replaced) compileFunction(entry.second);
+    } catch (const std::runtime_error&) {
+        for (size_t i = functions; i < session.functions.size(); ++i) session.byName.erase(session.functions[i].name);
+        session.functions.resize(functions);
+        for (auto it = session.globalsByName.begin(); it != session.globalsByName.end();) {
+            it = it->second >= globals ? session.globalsByName.erase(it) : std::next(it);
+        }
+        session.globals.resize(globals);
+        module_ = nullptr;
+        throw;
+    }
+    for (auto& [index, fn] : replaced) session.functions[index] = std::move(fn);
+    if (!session.script) {
+        session.script = static_cast<uint32_t>(session.functions.size());
+        session.functions.emplace_back();
+    }
+    result.script = *session.script;
+    session.functions[result.script] = std::move(script);
+    module_ = nullptr;
+    return result;
+}
+
+BytecodeFunction BytecodeCompiler::signature(FunctionDeclaration* decl) {
+    if (decl->isAsync) fail(decl, "async functions are not supported");
+    if (decl->throwsTypeNode) fail(decl, "functions that throw are not supported");
+    if (!decl->body) fail(decl, "function " + decl->id->name + " has no body");
+    BytecodeFunction fn;
+    fn.name = decl->id->name;
+    fn.decl = decl;
+    for (const FunctionParameter& param : decl->params) {
+        if (!param.typeNode) fail(decl, "parameter " + param.name->name + " needs a type");
+        fn.params.push_back(resolve(param.typeNode.get()));
+    }
+    if (decl->returnTypeNode) fn.result = resolve(decl->returnTypeNode.get());
+    return fn;
+}
+
+SlotKind BytecodeCompiler::resolve(TypeNode* node) {
+    if (node->category == TypeNode::TypeCategory::IDENTIFIER && node->name && node->genericArguments.empty() &&
+        !node->isOptional) {
+        const std::string& name = node->name->name;
+        if (name == "Int" || name == "i64") return SlotKind::INT;
+        if (name == "Float" || name == "f64") return SlotKind::FLOAT;
+        if (name == "Bool") return SlotKind::BOOL;
+    }
+    fail(node, "type " + node->toString() + " is not supported; the bytecode tier runs Int, Float and Bool");
+}
+
+const Operand* BytecodeCompiler::lookup(const std::string& name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) return &it->second;
+    }
+    return nullptr;
+}
+
+uint32_t BytecodeCompiler::temp() {
+    uint32_t reg = next_++;
+    fn_->registers = std::max(fn_->registers, next_);
+    return reg;
+}
+
+size_t BytecodeCompiler::emit(Op op, uint32_t a, uint32_t b, uint32_t c) {
+    fn_->code.push_back(Instruction{op, a, b, c});
+    return fn_->code.size() - 1;
+}
+
+uint32_t BytecodeCompiler::constant(Slot value) {
+    fn_->constants.push_back(value);
+    return static_cast<uint32_t>(fn_->constants.size() - 1);
+}
+
+// Records the variables in scope at the head of the innermost loop in loops_
+uint32_t BytecodeCompiler::beginLoop(Statement* node) {
+    BytecodeLoop loop{node, {}, {}, false};
+    std::unordered_set<std::string> seen;
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        for (const auto& [name, var] : *scope) {
+            if (seen.insert(name).second) {
+                loop.variables.emplace_back(name, var.reg);
+            } else {
+                loop.shadowed = true;
+            }
+        }
+    }
+    for (const Loop& enclosing : loops_) {
+        if (enclosing.node) loop.bounds.emplace_back(enclosing.node, enclosing.end);
+    }
+    fn_->loops.push_back(std::move(loop));
+    return static_cast<uint32_t>(fn_->loops.size() - 1);
+}
+
+void BytecodeCompiler::compileFunction(BytecodeFunction& fn) {
+    fn_ = &fn;
+    scopes_.assign(1, {});
+    loops_.clear();
+    next_ = 0;
+    for (size_t i = 0; i < fn.params.size(); ++i) {
+        scopes_.back()[fn.decl->params[i].name->name] = Operand{temp(), fn.params[i]};
+    }
+    BlockStatement* body = fn.decl->body.get();
+    for (auto& stmt : body->body) compileStatement(stmt.get());
+    if (!ends_in_jump(body->body)) compileCleanups(body->exitCleanups);
+    emit(Op::RETURN_VOID); // falling off the end: a function with a result returns 0, 0.0 or false
+    scopes_.clear();
+    fn_ = nullptr;
+}
+
+// The top-level statements of REPL input. A trailing expression's value is
+// the result; an assignment's is not shown.
+void BytecodeCompiler::compileScript(BytecodeFunction& fn, const std::vector<Statement*>& statements) {
+    fn_ = &fn;
+    scopes_.assign(1, {});
+    loops_.clear();
+    next_ = 0;
+    for (size_t i = 0; i < statements.size(); ++i) {
+        Statement* stmt = statements[i];
+        switch (stmt->getType()) {
+            case NodeType::VARIABLE_DECLARATION:
+                compileGlobal(static_cast<VariableDeclaration*>(stmt));
+                continue;
+            case NodeType::RETURN_STATEMENT:
+                fail(stmt, "return outside a function");
+            case NodeType::DEFER_STATEMENT:
+                fail(stmt, "defer outside a function");
+            case NodeType::EXPRESSION_STATEMENT: {
+                Expression* expr = static_cast<ExpressionStatement*>(stmt)->expression.get();
+                if (i + 1 < statements.size() || expr->getType() == NodeType::ASSIGNMENT_EXPRESSION) break;
+                Operand value = compileExpression(expr);
+                if (value.kind != SlotKind::VOID) {
+                    fn.result = value.kind;
+                    emit(Op::RETURN, value.reg);
+                }
+                continue;
+            }
+            default:
+                break;
+        }
+        compileStatement(stmt);
+    }
+    if (fn.code.empty() || fn.code.back().op != Op::RETURN) emit(Op::RETURN_VOID);
+    scopes_.clear();
+    fn_ = nullptr;
+}
+
+void BytecodeCompiler::compileGlobal(VariableDeclaration* node) {
+    const std::string& name = node->id->name;
+    uint32_t reg = temp();
+    SlotKind kind;
+    if (node->typeNode) {
+        kind = resolve(node->typeNode.get());
+        if (node->init) {
+            compileInto(node->init.get(), reg, kind);
+        } else {
+            emit(Op::LOAD_CONST, reg, constant(int_slot(0)));
+        }
+    } else {
+        if (!node->init) fail(node, name + " needs a type or an initializer");
+        Operand init = compileExpression(node->init.get(), reg);
+        if (init.kind == SlotKind::VOID) fail(node, name + " needs a value");
+        if (init.reg != reg) emit(Op::MOVE, reg, init.reg);
+        kind = init.kind;
+    }
+    auto found = module_->globalsByName.find(name);
+    if (found == module_->globalsByName.end()) {
+        found = module_->globalsByName.emplace(name, static_cast<uint32_t>(module_->globals.size())).first;
+        module_->globals.push_back(kind);
+    } else if (module_->globals[found->second] != kind) { // functions compiled earlier read it as that kind
+        fail(node, std::string("global ") + name + " has type " + kind_name(module_->globals[found->second]));
+    }
+    emit(Op::SET_GLOBAL, found->second, reg);
+    next_ = reg;
+}
+
+void BytecodeCompiler::compileBlock(BlockStatement* node) {
+    uint32_t saved = next_;
+    scopes_.emplace_back();
+    for (auto& stmt : node->body) compileStatement(stmt.get());
+    if (!ends_in_jump(node->body)) compileCleanups(node->exitCleanups);
+    scopes_.pop_back();
+    next_ = saved;
+}
+
+// The body of an if or else, which need not be a block
+void BytecodeCompiler::compileBody(Statement* node) {
+    if (node->getType() == NodeType::BLOCK_STATEMENT) {
+        compileBlock(static_cast<BlockStatement*>(node));
+        return;
+    }
+    uint32_t saved = next_;
+    scopes_.emplace_back();
+    compileStatement(node);
+    scopes_.pop_back();
+    next_ = saved;
+}
+
+void BytecodeCompiler::compileCleanups(const CleanupList& cleanups) {
+    for (Statement* cleanup : cleanups) compileBody(cleanup);
+}
+
+// Temporaries live until the end of their statement; a declaration keeps
+// the register of its variable until the end of the block
+void BytecodeCompiler::compileStatement(Statement* node) {
+    uint32_t mark = next_;
+    switch (node->getType()) {
+        case NodeType::VARIABLE_DECLARATION: {
+            auto* decl = static_cast<VariableDeclaration*>(node);
+            const std::string& name = decl->id->name;
+            uint32_t reg = temp();
+            SlotKind kind;
+            if (decl->typeNode) {
+                kind = resolve(decl->typeNode.get());
+                if (decl->init) {
+                    compileInto(decl->init.get(), reg, kind);
+                } else {
+                    emit(Op::LOAD_CONST, reg, constant(int_slot(0)));
+                }
+            } else {
+                if (!decl->init) fail(node, name + " needs a type or an initializer");
+                Operand init = compileExpression(decl->init.get(), reg);
+                if (init.kind == SlotKind::VOID) fail(node, name + " needs a value");
+                if (init.reg != reg) emit(Op::MOVE, reg, init.reg);
+                kind = init.kind;
+            }
+            scopes_.back()[name] = Operand{reg, kind};
+            mark = reg + 1;
+            break;
+        }
+        case NodeType::EXPRESSION_STATEMENT:
+            compileExpression(static_cast<ExpressionStatement*>(node)->expression.get());
+            break;
+        case NodeType::BLOCK_STATEMENT:
+            compileBlock(static_cast<BlockStatement*>(node));
+            break;
+        case NodeType::SCOPED_STATEMENT:
+            compileBlock(static_cast<ScopedStatement*>(node)->body.get());
+            break;
+        case NodeType::DEFER_STATEMENT: // inlined at each exit through the cleanup lists
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto* branch = static_cast<IfStatement*>(node);
+            Operand test = convert(compileExpression(branch->test.get()), SlotKind::BOOL, branch->test.get());
+            size_t skip = emit(Op::JUMP_IF_FALSE, 0, test.reg);
+            next_ = mark;
+            compileBody(branch->consequent.get());
+            if (branch->alternate) {
+                size_t done = emit(Op::JUMP);
+                patch(skip, here());
+                compileBody(branch->alternate.get());
+                patch(done, here());
+            } else {
+                patch(skip, here());
+            }
+            break;
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto* loop = static_cast<WhileStatement*>(node);
+            if (loop->body->getType() != NodeType::BLOCK_STATEMENT) fail(node, "loop bodies must be blocks");
+            size_t top = here();
+            Operand test = convert(compileExpression(loop->test.get()), SlotKind::BOOL, loop->test.get());
+            size_t exit = emit(Op::JUMP_IF_FALSE, 0, test.reg);
+            next_ = mark;
+            loops_.emplace_back();
+            uint32_t index = beginLoop(loop);
+            compileBlock(static_cast<BlockStatement*>(loop->body.get()));
+            size_t latch = emit(Op::LOOP, static_cast<uint32_t>(top), index);
+            for (size_t at : loops_.back().continues) patch(at, latch);
+            for (size_t at : loops_.back().breaks) patch(at, here());
+            patch(exit, here());
+            loops_.pop_back();
+            break;
+        }
+        case NodeType::FOR_STATEMENT:
+            compileFor(static_cast<ForStatement*>(node));
+            break;
+        case NodeType::RETURN_STATEMENT: {
+            auto* ret = static_cast<ReturnStatement*>(node);
+            if (!ret->argument) {
+                if (fn_->result != SlotKind::VOID) fail(node, "missing return value");
+                compileCleanups(ret->cleanups);
+                emit(Op::RETURN_VOID);
+                break;
+            }
+            if (fn_->result == SlotKind::VOID) fail(node, fn_->name + " returns nothing");
+            Operand value = convert(compileExpression(ret->argument.get()), fn_->result, node);
+            if (!ret->cleanups.empty() && value.reg < mark) { // a variable the cleanups may change
+                uint32_t copy = temp();
+                emit(Op::MOVE, copy, value.reg);
+                value.reg = copy;
+            }
+            compileCleanups(ret->cleanups);
+            emit(Op::RETURN, value.reg);
+            break;
+        }
+        case NodeType::BREAK_STATEMENT:
+        case NodeType::CONTINUE_STATEMENT: {
+            bool is_break = node->getType() == NodeType::BREAK_STATEMENT;
+            if (loops_.empty()) fail(node, std::string(is_break ? "break" : "continue") + " outside a loop");
+            compileCleanups(is_break ? static_cast<BreakStatement*>(node)->cleanups
+                                     : static_cast<ContinueStatement*>(node)->cleanups);
+            (is_break ? loops_.back().breaks : loops_.back().continues).push_back(emit(Op::JUMP));
+            break;
+        }
+        default:
+            fail(node, "'" + node->toString() + "' is not supported");
+    }
+    next_ = mark;
+}
+
+void BytecodeCompiler::compileFor(ForStatement* node) {
+    auto* induction = dynamic_cast<Identifier*>(node->init.get());
+    auto* range = dynamic_cast<BinaryExpression*>(node->test.get());
+    if (!induction || !range || range->op.type != TokenType::DOTDOT || !node->body ||
+        node->body->getType() != NodeType::BLOCK_STATEMENT) {
+        fail(node, "only `for (i in a..b) { ... }` loops are supported");
+    }
+    uint32_t saved = next_;
+    uint32_t i = temp();
+    uint32_t end = temp();
+    for (auto [side, reg] : {std::pair{range->left.get(), i}, std::pair{range->right.get(), end}}) {
+        Operand bound = compileExpression(side, reg);
+        if (bound.kind != SlotKind::INT) fail(node, "ranges must be over Int");
+        if (bound.reg != reg) emit(Op::MOVE, reg, bound.reg);
+    }
+    scopes_.emplace_back();
+    scopes_.back()[induction->name] = Operand{i, SlotKind::INT};
+    size_t top = here();
+    uint32_t more = temp();
+    emit(Op::LT, more, i, end);
+    size_t exit = emit(Op::JUMP_IF_FALSE, 0, more);
+    next_ = end + 1;
+    loops_.push_back(Loop{{}, {}, node, end});
+    uint32_t index = beginLoop(node);
+    compileBlock(static_cast<BlockStatement*>(node->body.get()));
+    size_t latch = emit(Op::INC, i);
+    emit(Op::LOOP, static_cast<uint32_t>(top), index);
+    for (size_t at : loops_.back().continues) patch(at, latch);
+    for (size_t at : loops_.back().breaks) patch(at, here());
+    patch(exit, here());
+    loops_.pop_back();
+    scopes_.pop_back();
+    next_ = saved;
+}
+
+// --- Expressions ---
+
+// Compiles an expression, into register `hint` when it computes a new
+// value. A variable is returned as its own register.
+Operand BytecodeCompiler::compileExpression(Expression* node, int64_t hint) {
+    auto target = [&]() { return hint >= 0 ? static_cast<uint32_t>(hint) : temp(); };
+    switch (node->getType()) {
+        case NodeType::IDENTIFIER: {
+            const std::string& name = static_cast<Identifier*>(node)->name;
+            if (const Operand* var = lookup(name)) return *var;
+            auto global = module_->globalsByName.find(name);
+            if (global != module_->globalsByName.end()) {
+                uint32_t reg = target();
+                emit(Op::GET_GLOBAL, reg, global->second);
+                return Operand{reg, module_->globals[global->second]};
+            }
+            if (module_->byName.count(name)) fail(node, "functions are not values");
+            fail(node, "unknown name " + name);
+        }
+        case NodeType::INTEGER_LITERAL: {
+            uint32_t reg = target();
+            emit(Op::LOAD_CONST, reg, constant(int_slot(static_cast<IntegerLiteral*>(node)->value)));
+            return Operand{reg, SlotKind::INT};
+        }
+        case NodeType::FLOAT_LITERAL: {
+            uint32_t reg = target();
+            emit(Op::LOAD_CONST, reg, constant(float_slot(static_cast<FloatLiteral*>(node)->value)));
+            return Operand{reg, SlotKind::FLOAT};
+        }
+        case NodeType::BOOLEAN_LITERAL: {
+            uint32_t reg = target();
+            emit(Op::LOAD_CONST, reg, constant(int_slot(static_cast<BooleanLiteral*>(node)->value ? 1 : 0)));
+            return Operand{reg, SlotKind::BOOL};
+        }
+        case NodeType::UNARY_EXPRESSION: {
+            auto* unary = static_cast<UnaryExpression*>(node);
+            Expression* inner = unary->operand.get();
+            if (unary->op.type == TokenType::MINUS && inner->getType() == NodeType::INTEGER_LITERAL) {
+                uint32_t reg = target();
+                emit(Op::LOAD_CONST, reg, constant(int_slot(-static_cast<IntegerLiteral*>(inner)->value)));
+                return Operand{reg, SlotKind::INT};
+            }
+            if (unary->op.type == TokenType::MINUS && inner->getType() == NodeType::FLOAT_LITERAL) {
+                uint32_t reg = target();
+                emit(Op::LOAD_CONST, reg, constant(float_slot(-static_cast<FloatLiteral*>(inner)->value)));
+                return Operand{reg, SlotKind::FLOAT};
+            }
+            Operand value = compileExpression(inner);
+            switch (unary->op.type) {
+                case TokenType::BANG: {
+                    value = convert(value, SlotKind::BOOL, node);
+                    uint32_t reg = target();
+                    emit(Op::NOT, reg, value.reg);
+                    return Operand{reg, SlotKind::BOOL};
+                }
+                case TokenType::MINUS: {
+                    if (value.kind != SlotKind::INT && value.kind != SlotKind::FLOAT) fail(node, "unary - needs a number");
+                    uint32_t reg = target();
+                    emit(value.kind == SlotKind::INT ? Op::NEG : Op::FNEG, reg, value.reg);
+                    return Operand{reg, value.kind};
+                }
+                case TokenType::PLUS:
+                    if (value.kind != SlotKind::INT && value.kind != SlotKind::FLOAT) fail(node, "unary + needs a number");
+                    return value;
+                default:
+                    fail(node, "unsupported operator " + unary->op.lexeme);
+            }
+        }
+        case NodeType::BINARY_EXPRESSION:
+            return compileBinary(static_cast<BinaryExpression*>(node), hint);
+        case NodeType::CALL_EXPRESSION:
+            return compileCall(static_cast<CallExpression*>(node), hint);
+        case NodeType::ASSIGNMENT_EXPRESSION: {
+            auto* assign = static_cast<AssignmentExpression*>(node);
+            auto* id = dynamic_cast<Identifier*>(assign->left.get());
+            const Operand* var = id ? lookup(id->name) : nullptr;
+            auto global = id && !var ? module_->globalsByName.find(id->name) : module_->globalsByName.end();
+            if (global != module_->globalsByName.end()) {
+                uint32_t reg = hint >= 0 ? static_cast<uint32_t>(hint) : temp();
+                compileInto(assign->right.get(), reg, module_->globals[global->second]);
+                emit(Op::SET_GLOBAL, global->second, reg);
+                return Operand{reg, module_->globals[global->second]};
+            }
+            if (!var) fail(node, "cannot assign to " + assign->left->toString());
+            Operand target_var = *var;
+            compileInto(assign->right.get(), target_var.reg, target_var.kind);
+            return target_var;
+        }
+        case NodeType::STRING_LITERAL:
+            fail(node, "strings can only be printed in the bytecode tier");
+        default:
+            fail(node, "'" + node->toString() + "' is not supported");
+    }
+}
+
+void BytecodeCompiler::compileInto(Expression* node, uint32_t dest, SlotKind kind) {
+    Operand value = convert(compileExpression(node, dest), kind, node, dest);
+    if (value.reg != dest) emit(Op::MOVE, dest, value.reg);
+}
+
+// Int widens to Float implicitly, as in the C backend; Float to Int truncates
+Operand BytecodeCompiler::convert(Operand value, SlotKind kind, Node* node, int64_t hint) {
+    if (value.kind == kind) return value;
+    if (value.kind == SlotKind::INT && kind == SlotKind::FLOAT) {
+        uint32_t reg = hint >= 0 ? static_cast<uint32_t>(hint) : temp();
+        emit(Op::INT_TO_FLOAT, reg, value.reg);
+        return Operand{reg, kind};
+    }
+    if (value.kind == SlotKind::FLOAT && kind == SlotKind::INT) {
+        uint32_t reg = hint >= 0 ? static_cast<uint32_t>(hint) : temp();
+        emit(Op::FLOAT_TO_INT, reg, value.reg);
+        return Operand{reg, kind};
+    }
+    fail(node, std::string("cannot use ") + kind_name(value.kind) + " as " + kind_name(kind));
+}
+
+Operand BytecodeCompiler::compileBinary(BinaryExpression* node, int64_t hint) {
+    TokenType op = node->op.type;
+    if (op == TokenType::AND || op == TokenType::OR) {
+        // A fresh register: the right side may read the hint's variable
+        uint32_t reg = temp();
+        compileInto(node->left.get(), reg, SlotKind::BOOL);
+        size_t skip = emit(op == TokenType::AND ? Op::JUMP_IF_FALSE : Op::JUMP_IF_TRUE, 0, reg);
+        compileInto(node->right.get(), reg, SlotKind::BOOL);
+        patch(skip, here());
+        return Operand{reg, SlotKind::BOOL};
+    }
+    Operand left = compileExpression(node->left.get());
+    Operand right = compileExpression(node->right.get());
+    SlotKind kind;
+    if (left.kind == SlotKind::FLOAT || right.kind == SlotKind::FLOAT) {
+        kind = SlotKind::FLOAT;
+    } else if (left.kind == right.kind && left.kind != SlotKind::VOID) {
+        kind = left.kind;
+    } else {
+        fail(node, std::string("operator ") + node->op.lexeme + " on " + kind_name(left.kind) + " and " +
+                       kind_name(right.kind));
+    }
+    left = convert(left, kind, node);
+    right = convert(right, kind, node);
+    bool is_float = kind == SlotKind::FLOAT;
+    uint32_t b = left.reg;
+    uint32_t c = right.reg;
+    Op code;
+    SlotKind result = kind;
+    switch (op) {
+        case TokenType::EQEQ: code = is_float ? Op::FEQ : Op::EQ; result = SlotKind::BOOL; break;
+        case TokenType::NOTEQ: code = is_float ? Op::FNE : Op::NE; result = SlotKind::BOOL; break;
+        case TokenType::LT: code = is_float ? Op::FLT : Op::LT; result = SlotKind::BOOL; break;
+        case TokenType::LTEQ: code = is_float ? Op::FLE : Op::LE; result = SlotKind::BOOL; break;
+        case TokenType::GT: code = is_float ? Op::FLT : Op::LT; std::swap(b, c); result = SlotKind::BOOL; break;
+        case TokenType::GTEQ: code = is_float ? Op::FLE : Op::LE; std::swap(b, c); result = SlotKind::BOOL; break;
+        case TokenType::PLUS: code = is_float ? Op::FADD : Op::ADD; break;
+        case TokenType::MINUS: code = is_float ? Op::FSUB : Op::SUB; break;
+        case TokenType::MULTIPLY: code = is_float ? Op::FMUL : Op::MUL; break;
+        case TokenType::DIVIDE: code = is_float ? Op::FDIV : Op::DIV; break;
+        case TokenType::MODULO: code = Op::MOD; break;
+        case TokenType::AMPERSAND: code = Op::BIT_AND; break;
+        case TokenType::PIPE: code = Op::BIT_OR; break;
+        case TokenType::CARET: code = Op::BIT_XOR; break;
+        case TokenType::LSHIFT: code = Op::SHL; break;
+        case TokenType::RSHIFT: code = Op::SHR; break;
+        default: fail(node, "operator " + node->op.lexeme + " is not supported");
+    }
+    bool bitwise = code == Op::BIT_AND || code == Op::BIT_OR || code == Op::BIT_XOR;
+    bool integer_only = code == Op::MOD || code == Op::SHL || code == Op::SHR || bitwise;
+    if ((is_float && integer_only) ||
+        (kind == SlotKind::BOOL && result != SlotKind::BOOL && !bitwise) ||
+        (kind == SlotKind::BOOL && (code == Op::LT || code == Op::LE))) {
+        fail(node, "operator " + node->op.lexeme + " is not supported on " + kind_name(kind));
+    }
+    uint32_t reg = hint >= 0 ? static_cast<uint32_t>(hint) : temp();
+    emit(code, reg, b, c);
+    return Operand{reg, result};
+}
+
+Operand BytecodeCompiler::compileCall(CallExpression* node, int64_t hint) {
+    auto* callee = dynamic_cast<Identifier*>(node->callee.get());
+    if (!callee) fail(node, "only functions can be called");
+    const std::string& name = callee->name;
+    if (name == "println" || name == "print") {
+        PrintSpec spec{{}, name == "println"};
+        for (auto& arg : node->arguments) {
+            if (arg->getType() == NodeType::STRING_LITERAL) {
+                spec.items.push_back(PrintItem{SlotKind::VOID, 0, static_cast<StringLiteral*>(arg.get())->value});
+                continue;
+            }
+            Operand value = compileExpression(arg.get());
+            if (value.kind == SlotKind::VOID) fail(arg.get(), "cannot print nothing");
+            spec.items.push_back(PrintItem{value.kind, value.reg, ""});
+        }
+        fn_->prints.push_back(std::move(spec));
+        emit(Op::PRINT, 0, static_cast<uint32_t>(fn_->prints.size() - 1));
+        return Operand{0, SlotKind::VOID};
+    }
+    auto found = module_->byName.find(name);
+    if (found == module_->byName.end()) fail(node, "unknown function " + name);
+    const BytecodeFunction& target = module_->functions[found->second];
+    if (node->arguments.size() != target.params.size()) {
+        fail(node, name + " takes " + std::to_string(target.params.size()) + " arguments");
+    }
+    // Arguments go in consecutive registers, which become the callee's parameters
+    uint32_t first = next_;
+    for (size_t i = 0; i < target.params.size(); ++i) temp();
+    for (size_t i = 0; i < target.params.size(); ++i) {
+        compileInto(node->arguments[i].get(), first + static_cast<uint32_t>(i), target.params[i]);
+    }
+    uint32_t reg = hint >= 0 ? static_cast<uint32_t>(hint) : temp(); // written even for no result
+    emit(Op::CALL, reg, found->second, first);
+    return Operand{reg, target.result};
+}
+
+} // namespace vyn
@@ -0,0 +1,1606 @@
+#include "vyn/c_backend.hpp"
+
+#include "vyn/control_flow.hpp"
+#include "vyn/process.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace vyn {
+
+namespace {
+
+using Type = CBackend::Type;
+using Kind = CBackend::Type::Kind;
+
+std::string location_to_string(const SourceLocation& loc) {
+    return loc.filePath + ":" + std::to_string(loc.line) + ":" + std::to_string(loc.column);
+}
+
+[[noreturn]] void fail(Node* node, const std::string& message) {
+    throw std::runtime_error("C backend: " + message + " at " + location_to_string(node->loc));
+}
+
+std::string describe(Node* node) {
+    switch (node->getType()) {
+        case NodeType::CLOSURE_EXPRESSION: return "closures";
+        case NodeType::OBJECT_LITERAL_NODE: return "object literals without a struct name";
+        case NodeType::TEMPLATE_DECLARATION: return "templates";
+        case NodeType::ENUM_DECLARATION: return "enums";
+        case NodeType::IMPORT_DECLARATION: return "imports";
+        case NodeType::TYPE_ALIAS_DECLARATION: return "type aliases";
+        case NodeType::VARIABLE_DECLARATION: return "global variables";
+        case NodeType::FUNCTION_DECLARATION: return "nested functions";
+        default: return "'" + node->toString() + "'";
+    }
+}
+
+Type make(Kind kind) {
+    Type type;
+    type.kind = kind;
+    return type;
+}
+
+Type wrap(Kind kind, const Type& element, int64_t length = 0) {
+    Type type;
+    type.kind = kind;
+    type.element = std::make_shared<const Type>(element);
+    type.length = length;
+    return type;
+}
+
+bool is_integer(const Type& type) {
+    return type.kind == Kind::INT || type.kind == Kind::UINT || type.kind == Kind::I32 || type.kind == Kind::U32;
+}
+
+bool is_float(const Type& type) { return type.kind == Kind::FLOAT || type.kind == Kind::F32; }
+
+bool is_pointer(const Type& type) { return type.kind == Kind::OWNED || type.kind == Kind::BORROWED; }
+
+// The struct reached through `.`: a struct value, or the pointee of an owner or borrow
+const std::string* struct_of(const Type& type) {
+    if (type.kind == Kind::STRUCT) return &type.name;
+    if (is_pointer(type) && type.element->kind == Kind::STRUCT) return &type.element->name;
+    return nullptr;
+}
+
+bool is_literal(Expression* node) {
+    switch (node->getType()) {
+        case NodeType::INTEGER_LITERAL:
+        case NodeType::FLOAT_LITERAL:
+        case NodeType::BOOLEAN_LITERAL:
+        case NodeType::STRING_LITERAL:
+        case NodeType::NIL_LITERAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int64_t constant(Expression* node) {
+    if (node->getType() == NodeType::INTEGER_LITERAL) return static_cast<IntegerLiteral*>(node)->value;
+    if (node->getType() == NodeType::BINARY_EXPRESSION) {
+        auto* binary = static_cast<BinaryExpression*>(node);
+        int64_t left = constant(binary->left.get());
+        int64_t right = constant(binary->right.get());
+        switch (binary->op.type) {
+            case TokenType::PLUS: return left + right;
+            case TokenType::MINUS: return left - right;
+            case TokenType::MULTIPLY: return left * right;
+            case TokenType::DIVIDE:
+                if (right != 0) return left / right;
+                break;
+            default:
+                break;
+        }
+    }
+    fail(node, "array lengths must be integer constants");
+}
+
+// Vyn names that are C keywords or taken by the generated code get a trailing underscore
+std::string cident(const std::string& name) {
+    static const std::unordered_set<std::string> reserved = {
+        "auto",    "break",    "case",   "char",   "const",  "continue", "default",  "do",     "double",
+        "else",    "enum",     "extern", "float",  "for",    "goto",     "if",       "inline", "int",
+        "long",    "register", "restrict", "return", "short", "signed",  "sizeof",   "static", "struct",
+        "switch",  "typedef",  "union",  "unsigned", "void", "volatile", "while",    "bool",   "true",
+        "false",   "NULL",     "main",   "errno",  "free",   "malloc",   "memset",   "printf", "abort"};
+    if (reserved.count(name) || name.rfind("vyn_", 0) == 0) return name + "_";
+    return name;
+}
+
+std::string quote(const std::string& text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '?': out += "\\?"; break; // no trigraphs
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            default:
+                if (c < 0x20 || c >= 0x7f) {
+                    char octal[8];
+                    std::snprintf(octal, sizeof(octal), "\\%03o", c);
+                    out += octal;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out + "\"";
+}
+
+std::string float_literal(double value) {
+    std::ostringstream text;
+    text << std::setprecision(17) << value;
+    std::string result = text.str();
+    if (result.find_first_of(".eEn") == std::string::npos) result += ".0";
+    return result;
+}
+
+std::string join(const std::vector<std::string>& parts) {
+    std::string out;
+    for (size_t i = 0; i < parts.size(); ++i) out += (i ? ", " : "") + parts[i];
+    return out;
+}
+
+const char* binary_operator(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS: return "+";
+        case TokenType::MINUS: return "-";
+        case TokenType::MULTIPLY: return "*";
+        case TokenType::DIVIDE: return "/";
+        case TokenType::MODULO: return "%";
+        case TokenType::EQEQ: return "==";
+        case TokenType::NOTEQ: return "!=";
+        case TokenType::LT: return "<";
+        case TokenType::GT: return ">";
+        case TokenType::LTEQ: return "<=";
+        case TokenType::GTEQ: return ">=";
+        case TokenType::AND: return "&&";
+        case TokenType::OR: return "||";
+        case TokenType::AMPERSAND: return "&";
+        case TokenType::PIPE: return "|";
+        case TokenType::CARET: return "^";
+        case TokenType::LSHIFT: return "<<";
+        case TokenType::RSHIFT: return ">>";
+        default: return nullptr;
+    }
+}
+
+// An integer operator of Vyn on C operands of `kind`, as the prelude
+// defines it, or "" for the comparisons and bitwise operators, which C
+// already gets right
+std::string integer_operation(TokenType op, Kind kind, const std::string& left, const std::string& right) {
+    bool wide = kind == Kind::INT || kind == Kind::UINT;
+    bool is_signed = kind == Kind::INT || kind == Kind::I32;
+    std::string type = kind == Kind::INT ? "int64_t" : kind == Kind::UINT ? "uint64_t" : kind == Kind::I32 ? "int32_t" : "uint32_t";
+    std::string bits = wide ? "uint64_t" : "uint32_t";
+    std::string mask = wide ? "63" : "31";
+    switch (op) {
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+        case TokenType::MULTIPLY:
+            return "(" + type + ")((" + bits + ")" + left + " " + binary_operator(op) + " (" + bits + ")" + right + ")";
+        case TokenType::DIVIDE:
+        case TokenType::MODULO: {
+            // The 32-bit cases divide in 64 bits, where MIN / -1 does not overflow
+            std::string helper = std::string(is_signed ? "vyn_" : "vyn_u") + (op == TokenType::DIVIDE ? "div" : "mod");
+            std::string call = helper + "(" + left + ", " + right + ")";
+            return kind == Kind::INT || kind == Kind::UINT ? call : "(" + type + ")" + call;
+        }
+        case TokenType::LSHIFT:
+            if (kind == Kind::INT) return "vyn_shl(" + left + ", " + right + ")";
+            return "(" + type + ")((" + bits + ")" + left + " << (" + right + " & " + mask + "))";
+        case TokenType::RSHIFT:
+            if (kind == Kind::INT) return "vyn_shr(" + left + ", " + right + ")";
+            return "(" + type + ")(" + left + " >> (" + right + " & " + mask + "))";
+        default:
+            return "";
+    }
+}
+
+const char* kPrelude = R"(/* Generated by the Vyn C backend. */
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Set by a library's entry points to return a panic to their caller instead
+   of aborting the process */
+static jmp_buf* vyn_trap;
+static const char* vyn_trap_message;
+
+static void vyn_panic(const char* message) {
+    if (vyn_trap) {
+        vyn_trap_message = message;
+        longjmp(*vyn_trap, 1);
+    }
+    fflush(stdout); /* keep what was printed before the panic */
+    fprintf(stderr, "vyn: %s\n", message);
+    abort();
+}
+
+static inline int64_t vyn_index(int64_t index, int64_t length) {
+    if ((uint64_t)index >= (uint64_t)length) vyn_panic("index out of bounds");
+    return index;
+}
+
+/* Vyn integer semantics, which C leaves undefined: + - * and << wrap, / and %
+   by zero panic, MIN / -1 wraps to MIN, and shift counts are taken modulo
+   the width. The 64-bit cases are these helpers, the 32-bit ones inline. */
+static inline int64_t vyn_div(int64_t a, int64_t b) {
+    if (b == 0) vyn_panic("division by zero");
+    return b == -1 ? (int64_t)(0 - (uint64_t)a) : a / b;
+}
+
+static inline int64_t vyn_mod(int64_t a, int64_t b) {
+    if (b == 0) vyn_panic("division by zero");
+    return b == -1 ? 0 : a % b;
+}
+
+static inline uint64_t vyn_udiv(uint64_t a, uint64_t b) {
+    if (b == 0) vyn_panic("division by zero");
+    return a / b;
+}
+
+static inline uint64_t vyn_umod(uint64_t a, uint64_t b) {
+    if (b == 0) vyn_panic("division by zero");
+    return a % b;
+}
+
+static inline int64_t vyn_shl(int64_t a, int64_t b) { return (int64_t)((uint64_t)a << (b & 63)); }
+
+static inline int64_t vyn_shr(int64_t a, int64_t b) { return a >> (b & 63); }
+
+static inline void* vyn_alloc(size_t size) {
+    void* memory = malloc(size);
+    if (!memory) vyn_panic("out of memory");
+    return memory;
+}
+
+/* The error in flight: set by a throw, read by the catch clause that takes it */
+static uint32_t vyn_error_type;
+static int64_t vyn_error_payload;
+)";
+
+} // namespace
+
+std::string CBackend::run(Module* module, bool entryPoint, const std::vector<OsrEntry>& osr) {
+    records_.clear();
+    recordsByName_.clear();
+    functions_.clear();
+    functionsByName_.clear();
+    methods_.clear();
+    scopes_.clear();
+    current_ = nullptr;
+    osr_ = nullptr;
+    ends_.clear();
+    handlers_.clear();
+    errorTypes_.clear();
+    out_.clear();
+    indent_ = 0;
+    temps_ = 0;
+    report_ = CBackendReport{};
+
+    collect(module);
+    std::vector<size_t> order = orderRecords();
+
+    out_ = kPrelude;
+    out_ += "\n";
+    for (const Record& record : records_) line("typedef struct " + record.name + " " + record.name + ";");
+    for (size_t index : order) emitRecord(records_[index]);
+    out_ += "\n";
+    for (const Record& record : records_) {
+        const std::string& name = record.name;
+        line("static " + name + "* vyn_new_" + name + "(" + name + " value);");
+        line("static void vyn_free_" + name + "(" + name + "* owner);");
+        line("static " + name + "* vyn_move_" + name + "(" + name + "** owner);");
+        if (record.owns) {
+            line("static void vyn_drop_" + name + "(" + name + "* self);");
+            line("static " + name + " vyn_take_" + name + "(" + name + "* from);");
+        }
+    }
+    for (const Function& fn : functions_) line(signature(fn) + ";");
+    for (const Record& record : records_) emitHelpers(record);
+    for (const Function& fn : functions_) emitFunction(fn);
+    for (const OsrEntry& entry : osr) {
+        auto fn = std::find_if(functions_.begin(), functions_.end(),
+                               [&](const Function& candidate) { return candidate.decl == entry.function; });
+        if (fn == functions_.end() || fn->hasSelf) fail(entry.loop, "no function for OSR entry " + entry.symbol);
+        emitFunction(*fn, &entry);
+    }
+
+    auto main = functionsByName_.find("main");
+    if (entryPoint && main != functionsByName_.end()) {
+        const Function& fn = functions_[main->second];
+        if (!fn.params.empty()) fail(fn.decl, "main takes no parameters");
+        out_ += "\n";
+        if (fn.result.kind != Kind::VOID && !is_integer(fn.result)) {
+            fail(fn.decl, "main must return an integer or nothing");
+        }
+        line("int main(void) {");
+        if (fn.decl->canFail) {
+            if (fn.result.kind == Kind::VOID) {
+                line("    if (vyn_main()) vyn_panic(\"uncaught error\");");
+                line("    return 0;");
+            } else {
+                line("    " + ctype(fn.result) + " status;");
+                line("    if (vyn_main(&status)) vyn_panic(\"uncaught error\");");
+                line("    return (int)status;");
+            }
+        } else if (fn.result.kind == Kind::VOID) {
+            line("    vyn_main();");
+            line("    return 0;");
+        } else {
+            line("    return (int)vyn_main();");
+        }
+        line("}");
+    }
+
+    report_.structs = records_.size();
+    report_.functions = functions_.size();
+    for (const Record& record : records_) report_.droppedTypes += record.owns;
+    return out_;
+}
+
+void CBackend::compile(const std::string& source, const std::string& executable, const std::string& compiler,
+                       bool shared) {
+    std::string c_path = executable + ".c";
+    std::string log_path = executable + ".log";
+    {
+        std::ofstream file(c_path);
+        file << source;
+        if (!file) throw std::runtime_error("C backend: cannot write " + c_path);
+    }
+    std::vector<std::string> args{compiler, "-std=c11", "-O2"};
+    if (shared) args.insert(args.end(), {"-shared", "-fPIC"});
+    args.insert(args.end(), {"-o", executable, c_path});
+    ProgramRun run = run_program(args, log_path);
+    if (run.error != 0) {
+        throw std::runtime_error("C backend: cannot run `" + command_line(args) + "`: " + std::strerror(run.error));
+    }
+    if (!run.succeeded()) throw std::runtime_error("C backend: `" + command_line(args) + "` failed:\n" + run.output);
+}
+
+// --- Declarations ---
+
+void CBackend::collect(Module* module) {
+    std::vector<std::pair<FunctionDeclaration*, std::string>> functions;
+    auto add_record = [&](Declaration* decl, Identifier* name, std::vector<FieldDeclaration*> fields) {
+        if (!recordsByName_.emplace(name->name, records_.size()).second) fail(decl, "duplicate type " + name->name);
+        records_.push_back(Record{name->name, decl, std::move(fields), {}, false});
+    };
+
+    for (auto& stmt : module->body) {
+        switch (stmt->getType()) {
+            case NodeType::STRUCT_DECLARATION: {
+                auto* node = static_cast<StructDeclaration*>(stmt.get());
+                if (!node->genericParams.empty()) fail(node, "generic struct " + node->name->name + " is not supported");
+                std::vector<FieldDeclaration*> fields;
+                for (auto& field : node->fields) fields.push_back(field.get());
+                add_record(node, node->name.get(), std::move(fields));
+                break;
+            }
+            case NodeType::CLASS_DECLARATION: {
+                auto* node = static_cast<ClassDeclaration*>(stmt.get());
+                if (!node->genericParams.empty()) fail(node, "generic class " + node->name->name + " is not supported");
+                std::vector<FieldDeclaration*> fields;
+                for (auto& member : node->members) {
+                    if (member->getType() == NodeType::FIELD_DECLARATION) {
+                        fields.push_back(static_cast<FieldDeclaration*>(member.get()));
+                    } else if (member->getType() == NodeType::FUNCTION_DECLARATION) {
+                        functions.emplace_back(static_cast<FunctionDeclaration*>(member.get()), node->name->name);
+                    } else {
+                        fail(member.get(), "unsupported class member");
+                    }
+                }
+                add_record(node, node->name.get(), std::move(fields));
+                break;
+            }
+            case NodeType::IMPL_DECLARATION: {
+                auto* node = static_cast<ImplDeclaration*>(stmt.get());
+                if (!node->genericParams.empty()) fail(node, "generic impls are not supported");
+                if (!node->selfType || node->selfType->category != TypeNode::TypeCategory::IDENTIFIER ||
+                    !node->selfType->name) {
+                    fail(node, "impl of a type that is not a struct");
+                }
+                for (auto& method : node->methods) functions.emplace_back(method.get(), node->selfType->name->name);
+                break;
+            }
+            case NodeType::FUNCTION_DECLARATION:
+                functions.emplace_back(static_cast<FunctionDeclaration*>(stmt.get()), "");
+                break;
+            default:
+                fail(stmt.get(), describe(stmt.get()) + " at the top level are not supported");
+        }
+    }
+
+    for (Record& record : records_) {
+        for (FieldDeclaration* field : record.fieldDecls) {
+            if (!field->typeNode) fail(field, "field " + field->name->name + " needs a type");
+            record.fields.emplace_back(field->name->name, resolve(field->typeNode.get(), record.name));
+        }
+    }
+    for (auto& [decl, owner] : functions) {
+        if (!owner.empty() && !recordsByName_.count(owner)) fail(decl, "impl of unknown type " + owner);
+        addFunction(decl, owner);
+    }
+}
+
+void CBackend::addFunction(FunctionDeclaration* decl, const std::string& owner) {
+    if (decl->isAsync) fail(decl, "async functions are not supported");
+    if (decl->throwsTypeNode && !decl->canFail) fail(decl, "run ErrorLowering before lowering functions that throw");
+    if (!decl->body) fail(decl, "function " + decl->id->name + " has no body");
+
+    Function fn;
+    fn.decl = decl;
+    fn.owner = owner;
+    const std::string& name = decl->id->name;
+    if (owner.empty()) {
+        fn.cname = name == "main" ? "vyn_main" : "vyn_" + name;
+    } else {
+        fn.cname = owner + "_" + name;
+    }
+    for (size_t i = 0; i < decl->params.size(); ++i) {
+        const FunctionParameter& param = decl->params[i];
+        if (i == 0 && !owner.empty() && param.name->name == "self") {
+            fn.hasSelf = true;
+            continue;
+        }
+        if (!param.typeNode) fail(decl, "parameter " + param.name->name + " needs a type");
+        Type type = resolve(param.typeNode.get(), owner);
+        if (type.kind == Kind::ARRAY) fail(decl, "arrays are passed inside a struct, not by value");
+        fn.params.push_back(std::move(type));
+    }
+    fn.result = decl->returnTypeNode ? resolve(decl->returnTypeNode.get(), owner) : make(Kind::VOID);
+    if (fn.result.kind == Kind::ARRAY) fail(decl, "arrays are returned inside a struct, not by value");
+
+    auto& table = owner.empty() ? functionsByName_ : methods_;
+    std::string key = owner.empty() ? name : owner + "." + name;
+    if (!table.emplace(key, functions_.size()).second) fail(decl, "duplicate function " + key);
+    functions_.push_back(std::move(fn));
+}
+
+Type CBackend::resolve(TypeNode* node, const std::string& self) {
+    switch (node->category) {
+        case TypeNode::TypeCategory::IDENTIFIER: {
+            if (!node->genericArguments.empty()) fail(node, "generic type " + node->toString() + " is not supported");
+            if (node->isOptional) fail(node, "optional types are not supported");
+            const std::string& name = node->name->name;
+            if (name == "Int" || name == "i64") return make(Kind::INT);
+            if (name == "UInt" || name == "u64") return make(Kind::UINT);
+            if (name == "i32") return make(Kind::I32);
+            if (name == "u32") return make(Kind::U32);
+            if (name == "Float" || name == "f64") return make(Kind::FLOAT);
+            if (name == "f32") return make(Kind::F32);
+            if (name == "Bool") return make(Kind::BOOL);
+            if (name == "String") return make(Kind::STRING);
+            Type type = make(Kind::STRUCT);
+            if (name == "Self" && !self.empty()) {
+                type.name = self;
+            } else if (recordsByName_.count(name)) {
+                type.name = name;
+            } else {
+                fail(node, "unknown type " + name);
+            }
+            return type;
+        }
+        case TypeNode::TypeCategory::OWNERSHIP_WRAPPED: {
+            Type pointee = resolve(node->wrappedType.get(), self);
+            if (pointee.kind != Kind::STRUCT) fail(node, node->toString() + " must point to a struct");
+            switch (node->ownership) {
+                case OwnershipKind::MY:
+                    return wrap(Kind::OWNED, pointee);
+                case OwnershipKind::THEIR:
+                case OwnershipKind::PTR:
+                    return wrap(Kind::BORROWED, pointee);
+                case OwnershipKind::OUR:
+                    fail(node, "our<T> needs the reference-counting runtime and is not supported");
+            }
+            break;
+        }
+        case TypeNode::TypeCategory::ARRAY:
+            if (!node->arraySizeExpression) fail(node, "slices are not supported; use a fixed array [T; N]");
+            return wrap(Kind::ARRAY, resolve(node->arrayElementType.get(), self),
+                        constant(node->arraySizeExpression.get()));
+        default:
+            break;
+    }
+    fail(node, "type " + node->toString() + " is not supported");
+}
+
+// Structs in an order where everything a struct embeds by value comes first
+std::vector<size_t> CBackend::orderRecords() {
+    std::vector<size_t> order;
+    std::vector<int> state(records_.size(), 0); // 0 new, 1 in progress, 2 done
+    std::function<void(size_t)> visit = [&](size_t index) {
+        if (state[index] == 2) return;
+        Record& record = records_[index];
+        if (state[index] == 1) {
+            fail(record.decl, "struct " + record.name + " contains itself by value; use my<" + record.name + ">");
+        }
+        state[index] = 1;
+        for (auto& [name, type] : record.fields) {
+            const Type* inner = &type;
+            while (inner->kind == Kind::ARRAY) inner = inner->element.get();
+            if (inner->kind == Kind::STRUCT) visit(recordsByName_.at(inner->name));
+        }
+        for (auto& [name, type] : record.fields) record.owns = record.owns || owns(type);
+        state[index] = 2;
+        order.push_back(index);
+    };
+    for (size_t i = 0; i < records_.size(); ++i) visit(i);
+    return order;
+}
+
+bool CBackend::owns(const Type& type) const {
+    switch (type.kind) {
+        case Kind::OWNED: return true;
+        case Kind::STRUCT: return records_[recordsByName_.at(type.name)].owns;
+        case Kind::ARRAY: return owns(*type.element);
+        default: return false;
+    }
+}
+
+const CBackend::Function* CBackend::method(const std::string& type, const std::string& name) const {
+    auto it = methods_.find(type + "." + name);
+    return it == methods_.end() ? nullptr : &functions_[it->second];
+}
+
+std::string CBackend::ctype(const Type& type) const {
+    switch (type.kind) {
+        case Kind::VOID: return "void";
+        case Kind::NIL: return "void*";
+        case Kind::INT: return "int64_t";
+        case Kind::UINT: return "uint64_t";
+        case Kind::I32: return "int32_t";
+        case Kind::U32: return "uint32_t";
+        case Kind::FLOAT: return "double";
+        case Kind::F32: return "float";
+        case Kind::BOOL: return "bool";
+        case Kind::STRING: return "const char*";
+        case Kind::STRUCT: return type.name;
+        case Kind::OWNED:
+        case Kind::BORROWED: return ctype(*type.element) + "*";
+        case Kind::ARRAY: break;
+    }
+    throw std::runtime_error("C backend: arrays have no C value type");
+}
+
+std::string CBackend::declare(const Type& type, const std::string& name) const {
+    if (type.kind == Kind::ARRAY) return declare(*type.element, name + "[" + std::to_string(type.length) + "]");
+    return ctype(type) + " " + name;
+}
+
+std::string CBackend::signature(const Function& fn) const {
+    std::vector<std::string> params;
+    size_t index = 0;
+    for (const FunctionParameter& param : fn.decl->params) {
+        if (fn.hasSelf && &param == &fn.decl->params.front()) {
+            params.push_back(fn.owner + "* self");
+        } else {
+            params.push_back(declare(fn.params[index++], cident(param.name->name)));
+        }
+    }
+    if (fn.decl->canFail) {
+        if (fn.result.kind != Kind::VOID) params.push_back(ctype(fn.result) + "* vyn_result");
+        return "static bool " + fn.cname + "(" + (params.empty() ? "void" : join(params)) + ")";
+    }
+    return "static " + ctype(fn.result) + " " + fn.cname + "(" + (params.empty() ? "void" : join(params)) + ")";
+}
+
+// --- Emission ---
+
+void CBackend::line(const std::string& text) {
+    out_.append(static_cast<size_t>(indent_) * 4, ' ');
+    out_ += text;
+    out_ += "\n";
+}
+
+void CBackend::emitRecord(const Record& record) {
+    out_ += "\n";
+    line("struct " + record.name + " {");
+    for (auto& [name, type] : record.fields) line("    " + declare(type, cident(name)) + ";");
+    if (record.fields.empty()) line("    char vyn_empty;"); // C structs need a member
+    line("};");
+}
+
+void CBackend::emitHelpers(const Record& record) {
+    const std::string& name = record.name;
+    out_ += "\n";
+    line("static " + name + "* vyn_new_" + name + "(" + name + " value) {");
+    line("    " + name + "* owner = (" + name + "*)vyn_alloc(sizeof(" + name + "));");
+    line("    *owner = value;");
+    line("    return owner;");
+    line("}");
+    line("");
+    line("static void vyn_free_" + name + "(" + name + "* owner) {");
+    line("    if (!owner) return;");
+    if (record.owns) line("    vyn_drop_" + name + "(owner);");
+    line("    free(owner);");
+    line("}");
+    line("");
+    line("static " + name + "* vyn_move_" + name + "(" + name + "** owner) {");
+    line("    " + name + "* value = *owner;");
+    line("    *owner = NULL;");
+    line("    return value;");
+    line("}");
+    if (!record.owns) return;
+    line("");
+    line("static void vyn_drop_" + name + "(" + name + "* self) {");
+    ++indent_;
+    for (auto field = record.fields.rbegin(); field != record.fields.rend(); ++field) {
+        if (owns(field->second)) emitDrop("self->" + cident(field->first), field->second);
+    }
+    --indent_;
+    line("}");
+    line("");
+    line("static " + name + " vyn_take_" + name + "(" + name + "* from) {");
+    line("    " + name + " value = *from;");
+    line("    memset(from, 0, sizeof(" + name + "));");
+    line("    return value;");
+    line("}");
+}
+
+void CBackend::emitDrop(const std::string& place, const Type& type, int depth) {
+    switch (type.kind) {
+        case Kind::OWNED:
+            line("vyn_free_" + type.element->name + "(" + place + ");");
+            break;
+        case Kind::STRUCT:
+            line("vyn_drop_" + type.name + "(&" + place + ");");
+            break;
+        case Kind::ARRAY: {
+            std::string i = "vyn_i" + std::to_string(depth);
+            line("for (int64_t " + i + " = " + std::to_string(type.length) + "; " + i + "-- > 0;) {");
+            ++indent_;
+            emitDrop(place + "[" + i + "]", *type.element, depth + 1);
+            --indent_;
+            line("}");
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void CBackend::emitFunction(const Function& fn, const OsrEntry* osr) {
+    current_ = &fn;
+    osr_ = osr;
+    scopes_.assign(1, Scope{false, {}, {}, {}});
+    out_ += "\n";
+    if (osr) {
+        if (fn.decl->canFail) fail(osr->loop, "OSR entry " + osr->symbol + " into a function that can fail");
+        // The parameters are plain locals, set with the others at the loop
+        line("static " + ctype(fn.result) + " " + osr->symbol + "(const int64_t* vyn_slots) {");
+        ++indent_;
+        for (size_t i = 0; i < fn.params.size(); ++i) {
+            line(declare(fn.params[i], cident(fn.decl->params[i].name->name)) + ";");
+        }
+        line("goto vyn_osr;");
+    } else {
+        line(signature(fn) + " {");
+        ++indent_;
+    }
+    size_t index = 0;
+    for (const FunctionParameter& param : fn.decl->params) {
+        if (fn.hasSelf && &param == &fn.decl->params.front()) {
+            scopes_.back().variables["self"] = wrap(Kind::BORROWED, [&] {
+                Type self = make(Kind::STRUCT);
+                self.name = fn.owner;
+                return self;
+            }());
+        } else {
+            declareVariable(param.name->name, fn.params[index++]);
+        }
+    }
+    for (auto& stmt : fn.decl->body->body) emitStatement(stmt.get());
+    if (!ends_in_jump(fn.decl->body->body)) {
+        emitCleanups(fn.decl->body->exitCleanups);
+        emitScopeExit(1);
+        // Falling off the end of a function with a result returns its zero
+        // value, as in the bytecode tier
+        if (fn.result.kind != Kind::VOID) {
+            std::string zero = fn.result.kind == Kind::STRUCT ? "(" + ctype(fn.result) + "){0}"
+                               : is_pointer(fn.result)          ? "NULL"
+                               : fn.result.kind == Kind::STRING ? "\"\""
+                                                                : "0";
+            line(fn.decl->canFail ? "*vyn_result = " + zero + ";" : "return " + zero + ";");
+        }
+        if (fn.decl->canFail) line("return false;");
+    }
+    --indent_;
+    line("}");
+    scopes_.clear();
+    current_ = nullptr;
+    osr_ = nullptr;
+}
+
+// Jumped to from the top of an OSR copy; C allows a goto into the scope of
+// variables whose declarations it skips
+void CBackend::emitOsrRestore() {
+    line("if (0) {");
+    line("vyn_osr:;");
+    ++indent_;
+    for (const auto& [name, slot] : osr_->variables) {
+        const Type* type = lookup(name);
+        std::string var = cident(name);
+        std::string from = "vyn_slots[" + std::to_string(slot) + "]";
+        switch (type ? type->kind : Kind::VOID) {
+            case Kind::INT: line(var + " = " + from + ";"); break;
+            case Kind::FLOAT: line("memcpy(&" + var + ", &" + from + ", sizeof(double));"); break;
+            case Kind::BOOL: line(var + " = " + from + " != 0;"); break;
+            default: fail(osr_->loop, "cannot set " + name + " at OSR entry " + osr_->symbol);
+        }
+    }
+    for (const auto& [loop, slot] : osr_->bounds) {
+        auto end = ends_.find(loop);
+        if (end == ends_.end()) fail(osr_->loop, "no loop bound at OSR entry " + osr_->symbol);
+        line(end->second + " = vyn_slots[" + std::to_string(slot) + "];");
+    }
+    --indent_;
+    line("}");
+}
+
+void CBackend::emitBlock(BlockStatement* node, bool loop) {
+    scopes_.push_back(Scope{loop, {}, {}, {}});
+    ++indent_;
+    for (auto& stmt : node->body) emitStatement(stmt.get());
+    if (!ends_in_jump(node->body)) {
+        emitCleanups(node->exitCleanups);
+        emitScopeExit(1);
+    }
+    --indent_;
+    scopes_.pop_back();
+}
+
+void CBackend::emitCleanups(const CleanupList& cleanups) {
+    for (Statement* cleanup : cleanups) {
+        if (cleanup->getType() == NodeType::BLOCK_STATEMENT) {
+            line("{");
+            emitBlock(static_cast<BlockStatement*>(cleanup));
+            line("}");
+        } else {
+            emitStatement(cleanup);
+        }
+    }
+}
+
+// Drops the owners of the innermost `scopes` scopes, newest first
+void CBackend::emitScopeExit(size_t scopes) {
+    for (size_t i = 0; i < scopes; ++i) {
+        const Scope& scope = scopes_[scopes_.size() - 1 - i];
+        for (auto owner = scope.owners.rbegin(); owner != scope.owners.rend(); ++owner) {
+            emitDrop(owner->first, owner->second);
+        }
+    }
+}
+
+// The catch clauses follow the try block in an `if (0)` that only the gotos
+// of its error edges enter; the finally block follows both
+void CBackend::emitTry(TryStatement* node) {
+    std::string label = "vyn_catch" + std::to_string(temps_++);
+    if (!node->catches.empty()) handlers_[node] = Handler{label, scopes_.size(), false};
+    line("{");
+    emitBlock(node->tryBlock.get());
+    line("}");
+    auto handler = handlers_.find(node);
+    if (handler != handlers_.end()) {
+        bool used = handler->second.used;
+        handlers_.erase(handler);
+        if (used) {
+            line("if (0) {");
+            line(label + ":;");
+            ++indent_;
+            bool catch_all = false;
+            for (size_t i = 0; i < node->catches.size() && !catch_all; ++i) {
+                CatchClause& clause = node->catches[i];
+                std::string type;
+                if (clause.errorType) {
+                    type = std::to_string(errorType(*clause.errorType));
+                    line(std::string(i ? "} else " : "") + "if (vyn_error_type == " + type + ") {");
+                } else {
+                    catch_all = true;
+                    line(i ? "} else {" : "{");
+                }
+                scopes_.push_back(Scope{false, {}, {}, {}});
+                if (clause.ident) {
+                    ++indent_;
+                    if (type.empty()) {
+                        type = "vyn_etype" + std::to_string(temps_++);
+                        line("uint32_t " + type + " = vyn_error_type;");
+                    }
+                    line("int64_t " + cident(*clause.ident) + " = vyn_error_payload;");
+                    --indent_;
+                    declareVariable(*clause.ident, make(Kind::INT));
+                    scopes_.back().errors[*clause.ident] = type;
+                }
+                emitBlock(clause.block.get());
+                scopes_.pop_back();
+            }
+            if (!catch_all) {
+                line("} else {");
+                ++indent_;
+                emitErrorEdge(node, node->unmatched, node->unmatchedCleanups);
+                --indent_;
+            }
+            line("}");
+            --indent_;
+            line("}");
+        }
+    }
+    if (node->finallyBlock) {
+        line("{");
+        emitBlock(node->finallyBlock.get());
+        line("}");
+    }
+}
+
+// `throw Name`, `throw Name(code)`, or `throw e` to pass on the error a
+// catch clause bound to e
+void CBackend::emitThrow(CallExpression* node) {
+    if (node->arguments.size() != 1) fail(node, "throw takes one error");
+    Expression* error = node->arguments[0].get();
+    std::string type;
+    std::string code = "0";
+    if (error->getType() == NodeType::IDENTIFIER) {
+        const std::string& name = static_cast<Identifier*>(error)->name;
+        for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+            if (!scope->variables.count(name)) continue;
+            auto caught = scope->errors.find(name);
+            if (caught != scope->errors.end()) {
+                type = caught->second;
+                code = cident(name);
+            }
+            break;
+        }
+        if (type.empty() && !lookup(name)) type = std::to_string(errorType(name));
+    } else if (error->getType() == NodeType::CALL_EXPRESSION) {
+        auto* call = static_cast<CallExpression*>(error);
+        auto* name = dynamic_cast<Identifier*>(call->callee.get());
+        if (name && !functionsByName_.count(name->name) && !recordsByName_.count(name->name) &&
+            call->arguments.size() <= 1) {
+            if (call->arguments.size() == 1) {
+                Value value = emitExpression(call->arguments[0].get());
+                if (!is_integer(value.type)) fail(call, "an error code must be an integer");
+                code = "(int64_t)" + value.code;
+            }
+            type = std::to_string(errorType(name->name));
+        }
+    }
+    if (type.empty()) fail(node, "throw needs an error: Name, Name(code) or a caught error");
+    line("vyn_error_type = " + type + ";");
+    line("vyn_error_payload = " + code + ";");
+    emitErrorEdge(node, node->errorEdge, node->errorCleanups);
+}
+
+// Leaves for the catch clauses of the edge's try, or returns the error
+void CBackend::emitErrorEdge(Node* node, const ErrorEdge& edge, const CleanupList& cleanups) {
+    switch (edge.target) {
+        case ErrorTarget::HANDLER: {
+            auto handler = handlers_.find(edge.handler);
+            if (handler == handlers_.end()) fail(node, "error edge to a try that is not being emitted");
+            handler->second.used = true;
+            std::string label = handler->second.label;
+            size_t scopes = scopes_.size() - handler->second.scopes;
+            emitCleanups(cleanups); // may emit trys of its own, and rehash handlers_
+            emitScopeExit(scopes);
+            line("goto " + label + ";");
+            return;
+        }
+        case ErrorTarget::RETURN:
+            if (!current_->decl->canFail) break;
+            emitCleanups(cleanups);
+            emitScopeExit(scopes_.size());
+            line("return true;");
+            return;
+        case ErrorTarget::NONE:
+            break;
+    }
+    fail(node, "an error with nowhere to go; run ErrorLowering first");
+}
+
+// Error types are numbered from 1 in order of first use; 0 is none
+uint32_t CBackend::errorType(const std::string& name) {
+    return errorTypes_.emplace(name, static_cast<uint32_t>(errorTypes_.size() + 1)).first->second;
+}
+
+size_t CBackend::scopesToLoop() const {
+    for (size_t i = scopes_.size(); i-- > 0;) {
+        if (scopes_[i].loop) return scopes_.size() - i;
+    }
+    return 0;
+}
+
+void CBackend::declareVariable(const std::string& name, const Type& type) {
+    scopes_.back().variables[name] = type;
+    if (owns(type)) scopes_.back().owners.emplace_back(cident(name), type);
+}
+
+const Type* CBackend::lookup(const std::string& name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        auto it = scope->variables.find(name);
+        if (it != scope->variables.end()) return &it->second;
+    }
+    return nullptr;
+}
+
+void CBackend::emitStatement(Statement* node) {
+    switch (node->getType()) {
+        case NodeType::VARIABLE_DECLARATION: {
+            auto* decl = static_cast<VariableDeclaration*>(node);
+            Type type;
+            Value init;
+            if (decl->typeNode) {
+                type = resolve(decl->typeNode.get(), current_->owner);
+                if (decl->init) init = emitInitializer(decl->init.get(), type);
+            } else if (decl->init) {
+                init = emitInitializer(decl->init.get(), Type{});
+                type = init.type;
+            } else {
+                fail(node, decl->id->name + " needs a type or an initializer");
+            }
+            if (type.kind == Kind::VOID || type.kind == Kind::NIL) fail(node, decl->id->name + " needs a type");
+            std::string value = init.code;
+            if (!decl->init) {
+                if (type.kind == Kind::ARRAY || type.kind == Kind::STRUCT) {
+                    value = "{0}";
+                } else if (is_pointer(type)) {
+                    value = "NULL";
+                } else if (type.kind == Kind::STRING) {
+                    value = "\"\"";
+                } else {
+                    value = "0";
+                }
+            }
+            line(declare(type, cident(decl->id->name)) + " = " + value + ";");
+            declareVariable(decl->id->name, type);
+            break;
+        }
+        case NodeType::EXPRESSION_STATEMENT: {
+            Expression* expr = static_cast<ExpressionStatement*>(node)->expression.get();
+            if (expr->getType() == NodeType::ASSIGNMENT_EXPRESSION) {
+                emitAssignment(static_cast<AssignmentExpression*>(expr));
+                break;
+            }
+            if (expr->getType() == NodeType::CALL_EXPRESSION) {
+                auto* call = static_cast<CallExpression*>(expr);
+                auto* callee = dynamic_cast<Identifier*>(call->callee.get());
+                if (callee && callee->name == "_throw") {
+                    emitThrow(call);
+                    break;
+                }
+            }
+            Value value = emitExpression(expr);
+            if (value.code.empty() || (!value.lvalue && !owns(value.type) && value.code.rfind("vyn_res", 0) == 0)) {
+                break; // a checked call, already emitted with its result unused
+            }
+            if (!value.lvalue && owns(value.type)) { // an owner nobody keeps
+                std::string temp = "vyn_tmp" + std::to_string(temps_++);
+                line(declare(value.type, temp) + " = " + value.code + ";");
+                emitDrop(temp, value.type);
+            } else {
+                line(value.code + ";");
+            }
+            break;
+        }
+        case NodeType::BLOCK_STATEMENT:
+            line("{");
+            emitBlock(static_cast<BlockStatement*>(node));
+            line("}");
+            break;
+        case NodeType::SCOPED_STATEMENT: // regions only matter to the VRE allocator
+            line("{");
+            emitBlock(static_cast<ScopedStatement*>(node)->body.get());
+            line("}");
+            break;
+        case NodeType::DEFER_STATEMENT: // inlined at each exit through the cleanup lists
+            break;
+        case NodeType::TRY_STATEMENT:
+            emitTry(static_cast<TryStatement*>(node));
+            break;
+        case NodeType::IF_STATEMENT: {
+            auto* branch = static_cast<IfStatement*>(node);
+            std::string prefix;
+            int nested = 0; // else blocks opened for else-if tests that hoisted statements
+            while (true) {
+                size_t mark = out_.size();
+                indent_ += !prefix.empty();
+                std::string test = emitExpression(branch->test.get()).code;
+                indent_ -= !prefix.empty();
+                if (!prefix.empty() && out_.size() > mark) {
+                    // They cannot go between } and else if; the rest of the chain nests in an else block
+                    out_.insert(mark, std::string(static_cast<size_t>(indent_) * 4, ' ') + "} else {\n");
+                    ++indent_;
+                    ++nested;
+                    prefix.clear();
+                }
+                line(prefix + "if (" + test + ") {");
+                Statement* consequent = branch->consequent.get();
+                if (consequent->getType() == NodeType::BLOCK_STATEMENT) {
+                    emitBlock(static_cast<BlockStatement*>(consequent));
+                } else {
+                    scopes_.push_back(Scope{false, {}, {}, {}});
+                    ++indent_;
+                    emitStatement(consequent);
+                    emitScopeExit(1);
+                    --indent_;
+                    scopes_.pop_back();
+                }
+                Statement* alternate = branch->alternate.get();
+                if (alternate && alternate->getType() == NodeType::IF_STATEMENT) {
+                    branch = static_cast<IfStatement*>(alternate);
+                    prefix = "} else ";
+                    continue;
+                }
+                if (alternate) {
+                    line("} else {");
+                    if (alternate->getType() == NodeType::BLOCK_STATEMENT) {
+                        emitBlock(static_cast<BlockStatement*>(alternate));
+                    } else {
+                        scopes_.push_back(Scope{false, {}, {}, {}});
+                        ++indent_;
+                        emitStatement(alternate);
+                        emitScopeExit(1);
+                        --indent_;
+                        scopes_.pop_back();
+                    }
+                }
+                line("}");
+                for (; nested > 0; --nested) {
+                    --indent_;
+                    line("}");
+                }
+                break;
+            }
+            break;
+        }
+        case NodeType::WHILE_STATEMENT: {
+            auto* loop = static_cast<WhileStatement*>(node);
+            if (loop->body->getType() != NodeType::BLOCK_STATEMENT) fail(node, "loop bodies must be blocks");
+            if (osr_ && osr_->loop == node) emitOsrRestore();
+            size_t mark = out_.size();
+            ++indent_;
+            std::string test = emitExpression(loop->test.get()).code;
+            --indent_;
+            if (out_.size() > mark) {
+                // The test hoisted statements, which run before each test, inside the loop
+                out_.insert(mark, std::string(static_cast<size_t>(indent_) * 4, ' ') + "while (true) {\n");
+                ++indent_;
+                line("if (!(" + test + ")) break;");
+                --indent_;
+            } else {
+                line("while (" + test + ") {");
+            }
+            emitBlock(static_cast<BlockStatement*>(loop->body.get()), true);
+            line("}");
+            break;
+        }
+        case NodeType::FOR_STATEMENT: {
+            auto* loop = static_cast<ForStatement*>(node);
+            auto* induction = dynamic_cast<Identifier*>(loop->init.get());
+            auto* range = dynamic_cast<BinaryExpression*>(loop->test.get());
+            if (!induction || !range || range->op.type != TokenType::DOTDOT || !loop->body ||
+                loop->body->getType() != NodeType::BLOCK_STATEMENT) {
+                fail(node, "only `for (i in a..b) { ... }` loops are supported");
+            }
+            Value low = emitExpression(range->left.get());
+            std::vector<Operand> operands{Operand{low.code, low.type, range->left.get(), out_.size()}};
+            Value high = emitExpression(range->right.get());
+            sequence(operands);
+            low.code = operands[0].code;
+            if (!is_integer(low.type) || !is_integer(high.type)) fail(node, "ranges must be over integers");
+            Type type = range->left->getType() == NodeType::INTEGER_LITERAL ? high.type : low.type;
+            if (!loop->hoistedBoundsChecks.empty()) {
+                // The bound is evaluated once, for the checks and the loop; a loop
+                // that runs no iterations indexes nothing
+                std::string bound = "vyn_bound" + std::to_string(temps_++);
+                line(ctype(type) + " " + bound + " = " + high.code + ";");
+                high.code = bound;
+                for (const HoistedBoundsCheck& check : loop->hoistedBoundsChecks) {
+                    const Type* array = lookup(check.slice);
+                    if (!array || array->kind != Kind::ARRAY) fail(node, "hoisted bounds check on " + check.slice);
+                    if (check.bound != range->right.get()) fail(node, "hoisted bounds check is not on the loop's bound");
+                    line("if (" + bound + " > " + low.code + " && (uint64_t)" + bound + " > " +
+                         std::to_string(array->length) + ") vyn_panic(\"index out of bounds\");");
+                }
+            }
+            std::string var = cident(induction->name);
+            std::string end = "vyn_end" + std::to_string(temps_++);
+            ends_[loop] = end;
+            if (osr_ && osr_->loop == node) {
+                // The OSR entry sets the induction variable and bound, so they are declared outside the for
+                line("{");
+                ++indent_;
+                line(ctype(type) + " " + var + " = " + low.code + ", " + end + " = " + high.code + ";");
+                scopes_.push_back(Scope{true, {{induction->name, type}}, {}, {}});
+                emitOsrRestore();
+                line("for (; " + var + " < " + end + "; ++" + var + ") {");
+            } else {
+                line("for (" + ctype(type) + " " + var + " = " + low.code + ", " + end + " = " + high.code + "; " +
+                     var + " < " + end + "; ++" + var + ") {");
+                scopes_.push_back(Scope{true, {{induction->name, type}}, {}, {}});
+            }
+            emitBlock(static_cast<BlockStatement*>(loop->body.get()));
+            scopes_.pop_back();
+            line("}");
+            if (osr_ && osr_->loop == node) {
+                --indent_;
+                line("}");
+            }
+            break;
+        }
+        case NodeType::RETURN_STATEMENT: {
+            auto* ret = static_cast<ReturnStatement*>(node);
+            bool drops = false;
+            for (const Scope& scope : scopes_) drops = drops || !scope.owners.empty();
+            if (!ret->argument) {
+                emitCleanups(ret->cleanups);
+                emitScopeExit(scopes_.size());
+                line(current_->decl->canFail ? "return false;" : "return;");
+                break;
+            }
+            Value value = emitMove(ret->argument.get());
+            if (current_->decl->canFail) {
+                line("*vyn_result = " + value.code + ";");
+                emitCleanups(ret->cleanups);
+                emitScopeExit(scopes_.size());
+                line("return false;");
+                break;
+            }
+            if (!drops && ret->cleanups.empty()) {
+                line("return " + value.code + ";");
+                break;
+            }
+            std::string temp = "vyn_ret" + std::to_string(temps_++);
+            line(declare(current_->result, temp) + " = " + value.code + ";");
+            emitCleanups(ret->cleanups);
+            emitScopeExit(scopes_.size());
+            line("return " + temp + ";");
+            break;
+        }
+        case NodeType::BREAK_STATEMENT:
+        case NodeType::CONTINUE_STATEMENT: {
+            bool is_break = node->getType() == NodeType::BREAK_STATEMENT;
+            size_t scopes = scopesToLoop();
+            if (!scopes) fail(node, std::string(is_break ? "break" : "continue") + " outside a loop");
+            emitCleanups(is_break ? static_cast<BreakStatement*>(node)->cleanups
+                                  : static_cast<ContinueStatement*>(node)->cleanups);
+            emitScopeExit(scopes);
+            line(is_break ? "break;" : "continue;");
+            break;
+        }
+        default:
+            fail(node, describe(node) + " is not supported");
+    }
+}
+
+void CBackend::emitAssignment(AssignmentExpression* node) {
+    Value left = emitExpression(node->left.get());
+    if (!left.lvalue) fail(node, "cannot assign to " + node->left->toString());
+    if (left.type.kind == Kind::ARRAY) fail(node, "arrays cannot be assigned; assign their elements");
+    Value right = emitMove(node->right.get());
+    if (!owns(left.type)) {
+        line(left.code + " = " + right.code + ";");
+        return;
+    }
+    // The old value is dropped after the new one is computed, which may read it
+    std::string temp = "vyn_tmp" + std::to_string(temps_++);
+    line(declare(left.type, temp) + " = " + right.code + ";");
+    emitDrop(left.code, left.type);
+    line(left.code + " = " + temp + ";");
+}
+
+// --- Expressions ---
+
+// C leaves the order of operands and arguments unspecified. Calls go into
+// temporaries before the statement, in order, but an operand left of a
+// call could still be read after it (a field the call sets through a
+// borrow), so each operand followed by hoisted statements is read into a
+// temporary where it was emitted. Literals, temporaries, arrays and moved
+// owners stay where they are
+void CBackend::sequence(std::vector<Operand>& operands) {
+    size_t size = out_.size();
+    for (size_t i = operands.size(); i-- > 0;) { // the last first, so the earlier offsets stay valid
+        Operand& operand = operands[i];
+        Kind kind = operand.type.kind;
+        if (operand.end == size || is_literal(operand.node) || operand.code.rfind("vyn_res", 0) == 0 ||
+            kind == Kind::VOID || kind == Kind::NIL || kind == Kind::ARRAY || owns(operand.type)) {
+            continue;
+        }
+        std::string temp = "vyn_tmp" + std::to_string(temps_++);
+        out_.insert(operand.end, std::string(static_cast<size_t>(indent_) * 4, ' ') +
+                                     declare(operand.type, temp) + " = " + operand.code + ";\n");
+        operand.code = temp;
+    }
+}
+
+CBackend::Value CBackend::emitMove(Expression* node) {
+    Value value = emitExpression(node);
+    if (!value.lvalue || !owns(value.type)) return value;
+    switch (value.type.kind) {
+        case Kind::OWNED:
+            value.code = "vyn_move_" + value.type.element->name + "(&" + value.code + ")";
+            break;
+        case Kind::STRUCT:
+            value.code = "vyn_take_" + value.type.name + "(&" + value.code + ")";
+            break;
+        default:
+            fail(node, "arrays of owners cannot be moved");
+    }
+    value.lvalue = false;
+    return value;
+}
+
+CBackend::Value CBackend::emitInitializer(Expression* node, const Type& type) {
+    if (node->getType() != NodeType::ARRAY_LITERAL_NODE) return emitMove(node);
+    auto* literal = static_cast<ArrayLiteralNode*>(node);
+    if (literal->elements.empty()) {
+        if (type.kind != Kind::ARRAY) fail(node, "an empty array literal needs a type");
+        return Value{"{0}", type, false};
+    }
+    Type element = type.kind == Kind::ARRAY ? *type.element : Type{};
+    std::vector<Operand> operands;
+    for (auto& item : literal->elements) {
+        Value value = emitInitializer(item.get(), element);
+        if (element.kind == Kind::VOID) element = value.type;
+        operands.push_back(Operand{value.code, value.type, item.get(), out_.size()});
+    }
+    sequence(operands);
+    std::vector<std::string> parts;
+    for (Operand& operand : operands) parts.push_back(operand.code);
+    if (type.kind == Kind::ARRAY && static_cast<int64_t>(parts.size()) > type.length) {
+        fail(node, "too many elements for " + declare(type, ""));
+    }
+    return Value{"{" + join(parts) + "}", type.kind == Kind::ARRAY ? type : wrap(Kind::ARRAY, element, parts.size()),
+                 false};
+}
+
+CBackend::Value CBackend::emitExpression(Expression* node) {
+    switch (node->getType()) {
+        case NodeType::IDENTIFIER: {
+            const std::string& name = static_cast<Identifier*>(node)->name;
+            if (const Type* type = lookup(name)) return Value{cident(name), *type, true};
+            if (functionsByName_.count(name)) fail(node, "functions are not values");
+            fail(node, "unknown name " + name);
+        }
+        case NodeType::INTEGER_LITERAL:
+            return Value{"INT64_C(" + std::to_string(static_cast<IntegerLiteral*>(node)->value) + ")", make(Kind::INT)};
+        case NodeType::FLOAT_LITERAL:
+            return Value{float_literal(static_cast<FloatLiteral*>(node)->value), make(Kind::FLOAT)};
+        case NodeType::BOOLEAN_LITERAL:
+            return Value{static_cast<BooleanLiteral*>(node)->value ? "true" : "false", make(Kind::BOOL)};
+        case NodeType::STRING_LITERAL:
+            return Value{quote(static_cast<StringLiteral*>(node)->value), make(Kind::STRING)};
+        case NodeType::NIL_LITERAL:
+            return Value{"NULL", make(Kind::NIL)};
+        case NodeType::UNARY_EXPRESSION: {
+            auto* unary = static_cast<UnaryExpression*>(node);
+            Value operand = emitExpression(unary->operand.get());
+            switch (unary->op.type) {
+                case TokenType::BANG:
+                    return Value{"(!" + operand.code + ")", make(Kind::BOOL)};
+                case TokenType::MINUS:
+                case TokenType::PLUS:
+                    if (!is_integer(operand.type) && !is_float(operand.type)) fail(node, "unary " + unary->op.lexeme + " needs a number");
+                    if (unary->op.type == TokenType::MINUS && is_integer(operand.type)) { // wraps, like 0 - x
+                        return Value{integer_operation(TokenType::MINUS, operand.type.kind, "0", operand.code),
+                                     operand.type};
+                    }
+                    return Value{"(" + unary->op.lexeme + operand.code + ")", operand.type};
+                default:
+                    fail(node, "unsupported operator " + unary->op.lexeme);
+            }
+        }
+        case NodeType::BINARY_EXPRESSION: {
+            auto* binary = static_cast<BinaryExpression*>(node);
+            const char* op = binary_operator(binary->op.type);
+            if (!op) fail(node, "operator " + binary->op.lexeme + " is not supported here");
+            Value left = emitExpression(binary->left.get());
+            bool short_circuit = binary->op.type == TokenType::AND || binary->op.type == TokenType::OR;
+            size_t mark = out_.size();
+            indent_ += short_circuit;
+            Value right = emitExpression(binary->right.get());
+            indent_ -= short_circuit;
+            for (const Value* side : {&left, &right}) {
+                Kind kind = side->type.kind;
+                if (kind == Kind::STRUCT || kind == Kind::ARRAY || kind == Kind::STRING || kind == Kind::VOID) {
+                    fail(node, "operator " + binary->op.lexeme + " needs numbers, booleans or pointers");
+                }
+            }
+            if (short_circuit && out_.size() > mark) {
+                // The right side hoisted statements, which run only where it is evaluated
+                std::string temp = "vyn_tmp" + std::to_string(temps_++);
+                std::string pad(static_cast<size_t>(indent_) * 4, ' ');
+                std::string test = binary->op.type == TokenType::AND ? temp : "!" + temp;
+                out_.insert(mark, pad + "bool " + temp + " = " + left.code + ";\n" + pad + "if (" + test + ") {\n");
+                ++indent_;
+                line(temp + " = " + right.code + ";");
+                --indent_;
+                line("}");
+                return Value{temp, make(Kind::BOOL)};
+            }
+            if (!short_circuit) {
+                std::vector<Operand> operands{Operand{left.code, left.type, binary->left.get(), mark}};
+                sequence(operands);
+                left.code = operands[0].code;
+            }
+            std::string code = "(" + left.code + " " + op + " " + right.code + ")";
+            switch (binary->op.type) {
+                case TokenType::EQEQ:
+                case TokenType::NOTEQ:
+                case TokenType::LT:
+                case TokenType::GT:
+                case TokenType::LTEQ:
+                case TokenType::GTEQ:
+                case TokenType::AND:
+                case TokenType::OR:
+                    return Value{code, make(Kind::BOOL)};
+                default:
+                    break;
+            }
+            if (binary->op.type == TokenType::MODULO && (is_float(left.type) || is_float(right.type))) {
+                fail(node, "% needs integers");
+            }
+            if (left.type.kind == Kind::FLOAT || right.type.kind == Kind::FLOAT) return Value{code, make(Kind::FLOAT)};
+            if (is_float(left.type) || is_float(right.type)) return Value{code, make(Kind::F32)};
+            // An Int literal takes the type of the other side
+            Type type = binary->left->getType() == NodeType::INTEGER_LITERAL ? right.type : left.type;
+            if (is_integer(left.type) && is_integer(right.type)) {
+                std::string defined = integer_operation(binary->op.type, type.kind, left.code, right.code);
+                if (!defined.empty()) code = defined;
+            }
+            return Value{code, type};
+        }
+        case NodeType::CALL_EXPRESSION:
+            return emitCall(static_cast<CallExpression*>(node));
+        case NodeType::MEMBER_EXPRESSION: {
+            auto* member = static_cast<MemberExpression*>(node);
+            if (member->computed) {
+                Value object = emitExpression(member->object.get());
+                if (object.type.kind != Kind::ARRAY) fail(node, "only fixed arrays can be indexed");
+                Value index = emitExpression(member->property.get());
+                if (!is_integer(index.type)) fail(node, "array indices must be integers");
+                std::string length = std::to_string(object.type.length);
+                bool constant_in_bounds = member->property->getType() == NodeType::INTEGER_LITERAL &&
+                                          static_cast<IntegerLiteral*>(member->property.get())->value >= 0 &&
+                                          static_cast<IntegerLiteral*>(member->property.get())->value <
+                                              object.type.length;
+                if (member->boundsCheck == BoundsCheck::CHECKED && !constant_in_bounds) {
+                    ++report_.boundsChecks;
+                    return Value{object.code + "[vyn_index(" + index.code + ", " + length + ")]", *object.type.element,
+                                 object.lvalue};
+                }
+                return Value{object.code + "[" + index.code + "]", *object.type.element, object.lvalue};
+            }
+            auto* field = dynamic_cast<Identifier*>(member->property.get());
+            if (!field) fail(node, "member names must be identifiers");
+            Value object = emitExpression(member->object.get());
+            if (object.type.kind == Kind::ARRAY && field->name == "length") {
+                return Value{std::to_string(object.type.length), make(Kind::INT)};
+            }
+            const std::string* type = struct_of(object.type);
+            if (!type) fail(node, "." + field->name + " on a value that is not a struct");
+            const Record& record = records_[recordsByName_.at(*type)];
+            for (auto& [name, fieldType] : record.fields) {
+                if (name == field->name) {
+                    std::string access = object.type.kind == Kind::STRUCT ? "." : "->";
+                    return Value{object.code + access + cident(name), fieldType, true};
+                }
+            }
+            fail(node, *type + " has no field " + field->name);
+        }
+        case NodeType::ASSIGNMENT_EXPRESSION: {
+            auto* assign = static_cast<AssignmentExpression*>(node);
+            Value left = emitExpression(assign->left.get());
+            if (!left.lvalue || left.type.kind == Kind::ARRAY) fail(node, "cannot assign to " + assign->left->toString());
+            if (owns(left.type)) fail(node, "assignments to owners must be statements");
+            Value right = emitExpression(assign->right.get());
+            return Value{"(" + left.code + " = " + right.code + ")", left.type};
+        }
+        case NodeType::BORROW_EXPRESSION_NODE: {
+            Value value = emitExpression(static_cast<BorrowExprNode*>(node)->expression.get());
+            if (value.type.kind == Kind::STRUCT) {
+                if (!value.lvalue) fail(node, "cannot borrow a temporary");
+                return Value{"(&" + value.code + ")", wrap(Kind::BORROWED, value.type)};
+            }
+            if (is_pointer(value.type)) return Value{value.code, wrap(Kind::BORROWED, *value.type.element)};
+            fail(node, "only structs can be borrowed");
+        }
+        case NodeType::ARRAY_LITERAL_NODE:
+            fail(node, "array literals can only initialize variables and fields");
+        default:
+            fail(node, describe(node) + " are not supported");
+    }
+}
+
+CBackend::Value CBackend::emitCall(CallExpression* node) {
+    Expression* callee = node->callee.get();
+    if (callee->getType() == NodeType::IDENTIFIER) {
+        const std::string& name = static_cast<Identifier*>(callee)->name;
+        if (name == "make_my") {
+            if (node->arguments.size() != 1) fail(node, "make_my takes one value");
+            Value value = emitMove(node->arguments[0].get());
+            if (value.type.kind != Kind::STRUCT) fail(node, "make_my needs a struct value");
+            return Value{"vyn_new_" + value.type.name + "(" + value.code + ")", wrap(Kind::OWNED, value.type)};
+        }
+        if (name == "println" || name == "print") return emitPrint(node, name == "println");
+        if (name == "_throw") fail(node, "throw must be a statement");
+        if (name == "len" && node->arguments.size() == 1) {
+            Value value = emitExpression(node->arguments[0].get());
+            if (value.type.kind == Kind::ARRAY) return Value{std::to_string(value.type.length), make(Kind::INT)};
+        }
+        auto record = recordsByName_.find(name);
+        if (record != recordsByName_.end() && node->arguments.size() == 1 &&
+            node->arguments[0]->getType() == NodeType::OBJECT_LITERAL_NODE) {
+            return emitStructLiteral(node, records_[record->second]);
+        }
+        auto fn = functionsByName_.find(name);
+        if (fn == functionsByName_.end()) fail(node, "unknown function " + name);
+        const Function& target = functions_[fn->second];
+        return emitInvoke(node, target, emitArguments(node, target, 0));
+    }
+
+    if (callee->getType() != NodeType::MEMBER_EXPRESSION || static_cast<MemberExpression*>(callee)->computed) {
+        fail(node, "only functions and methods can be called");
+    }
+    auto* member = static_cast<MemberExpression*>(callee);
+    auto* name = dynamic_cast<Identifier*>(member->property.get());
+    if (!name) fail(node, "method names must be identifiers");
+
+    auto self_pointer = [&](const Value& self) {
+        if (self.type.kind == Kind::STRUCT) {
+            if (!self.lvalue) fail(node, "cannot call a method on a temporary");
+            return "&" + self.code;
+        }
+        return self.code;
+    };
+
+    // Type::method(...) or Type.method(...)
+    if (auto* type = dynamic_cast<Identifier*>(member->object.get());
+        type && !lookup(type->name) && recordsByName_.count(type->name)) {
+        const Function* fn = method(type->name, name->name);
+        if (!fn) fail(node, type->name + " has no method " + name->name);
+        std::vector<std::string> args;
+        size_t first = 0;
+        if (fn->hasSelf) {
+            if (node->arguments.empty()) fail(node, type->name + "::" + name->name + " needs self");
+            args.push_back(self_pointer(emitExpression(node->arguments[0].get())));
+            first = 1;
+        }
+        for (std::string& arg : emitArguments(node, *fn, first)) args.push_back(std::move(arg));
+        return emitInvoke(node, *fn, std::move(args));
+    }
+
+    Value object = emitExpression(member->object.get());
+    if (object.type.kind == Kind::ARRAY && name->name == "len" && node->arguments.empty()) {
+        return Value{std::to_string(object.type.length), make(Kind::INT)};
+    }
+    const std::string* type = struct_of(object.type);
+    const Function* fn = type ? method(*type, name->name) : nullptr;
+    if (!fn) fail(node, "no method " + name->name + " on " + member->object->toString());
+    if (!fn->hasSelf) fail(node, *type + "::" + name->name + " has no self; call it on the type");
+    std::vector<std::string> args{self_pointer(object)};
+    for (std::string& arg : emitArguments(node, *fn, 0)) args.push_back(std::move(arg));
+    return emitInvoke(node, *fn, std::move(args));
+}
+
+// A call with a result goes before the statement, into a temporary, so
+// calls run left to right (see sequence()); one to a function that can
+// fail takes its error edge if it returns true
+CBackend::Value CBackend::emitInvoke(CallExpression* node, const Function& fn, std::vector<std::string> args) {
+    if (!fn.decl->canFail) {
+        std::string call = fn.cname + "(" + join(args) + ")";
+        if (fn.result.kind == Kind::VOID) return Value{call, fn.result};
+        std::string temp = "vyn_res" + std::to_string(temps_++);
+        line(declare(fn.result, temp) + " = " + call + ";");
+        return Value{temp, fn.result};
+    }
+    std::string temp;
+    if (fn.result.kind != Kind::VOID) {
+        temp = "vyn_res" + std::to_string(temps_++);
+        line(declare(fn.result, temp) + ";");
+        args.push_back("&" + temp);
+    }
+    line("if (" + fn.cname + "(" + join(args) + ")) {");
+    ++indent_;
+    emitErrorEdge(node, node->errorEdge, node->errorCleanups);
+    --indent_;
+    line("}");
+    return Value{temp, fn.result};
+}
+
+// Arguments move into by-value parameters; a struct is borrowed implicitly
+// for a their<T> parameter
+std::vector<std::string> CBackend::emitArguments(CallExpression* node, const Function& fn, size_t first) {
+    if (node->arguments.size() - first != fn.params.size()) {
+        fail(node, fn.decl->id->name + " takes " + std::to_string(fn.params.size()) + " arguments");
+    }
+    std::vector<Operand> operands;
+    for (size_t i = 0; i < fn.params.size(); ++i) {
+        Expression* arg = node->arguments[first + i].get();
+        std::string code;
+        if (fn.params[i].kind == Kind::BORROWED) {
+            Value value = emitExpression(arg);
+            if (value.type.kind == Kind::STRUCT) {
+                if (!value.lvalue) fail(arg, "cannot borrow a temporary");
+                code = "&" + value.code;
+            } else {
+                code = value.code;
+            }
+        } else {
+            code = emitMove(arg).code;
+        }
+        operands.push_back(Operand{code, fn.params[i], arg, out_.size()});
+    }
+    sequence(operands);
+    std::vector<std::string> args;
+    for (Operand& operand : operands) args.push_back(operand.code);
+    return args;
+}
+
+CBackend::Value CBackend::emitPrint(CallExpression* node, bool newline) {
+    std::vector<Operand> operands;
+    for (auto& arg : node->arguments) {
+        Value value = emitExpression(arg.get());
+        operands.push_back(Operand{value.code, value.type, arg.get(), out_.size()});
+    }
+    sequence(operands);
+    std::string format;
+    std::vector<std::string> args;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        Expression* arg = node->arguments[i].get();
+        Value value{operands[i].code, operands[i].type};
+        if (!format.empty()) format += " ";
+        switch (value.type.kind) {
+            case Kind::INT: format += "%lld"; args.push_back("(long long)" + value.code); break;
+            case Kind::UINT: format += "%llu"; args.push_back("(unsigned long long)" + value.code); break;
+            case Kind::I32: format += "%d"; args.push_back("(int)" + value.code); break;
+            case Kind::U32: format += "%u"; args.push_back("(unsigned)" + value.code); break;
+            case Kind::FLOAT:
+            case Kind::F32: format += "%g"; args.push_back("(double)" + value.code); break;
+            case Kind::BOOL: format += "%s"; args.push_back("(" + value.code + " ? \"true\" : \"false\")"); break;
+            case Kind::STRING: format += "%s"; args.push_back(value.code); break;
+            default: fail(arg, "cannot print " + arg->toString());
+        }
+    }
+    if (newline) format += "\\n";
+    args.insert(args.begin(), "\"" + format + "\"");
+    return Value{"printf(" + join(args) + ")", make(Kind::VOID)};
+}
+
+CBackend::Value CBackend::emitStructLiteral(CallExpression* node, const Record& record) {
+    auto* literal = static_cast<ObjectLiteral*>(node->arguments[0].get());
+    std::vector<Operand> operands;
+    for (ObjectProperty& property : literal->properties) {
+        const Type* type = nullptr;
+        for (auto& [name, fieldType] : record.fields) {
+            if (name == property.key->name) type = &fieldType;
+        }
+        if (!type) fail(node, record.name + " has no field " + property.key->name);
+        Value value = emitInitializer(property.value.get(), *type);
+        operands.push_back(Operand{value.code, *type, property.value.get(), out_.size()});
+    }
+    sequence(operands);
+    std::vector<std::string> fields;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        fields.push_back("." + cident(literal->properties[i].key->name) + " = " + operands[i].code);
+    }
+    Type type = make(Kind::STRUCT);
+    type.name = record.name;
+    return Value{"((" + record.name + "){" + (fields.empty() ? "0" : join(fields)) + "})", type};
+}
+
+} // namespace vyn
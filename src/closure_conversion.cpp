@@ -0,0 +1,240 @@
+#include "vyn/closure_conversion.hpp"
+#include "vyn/vre/closure.hpp"
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/value.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace vyn {
+
+namespace {
+
+struct SlotType {
+    size_t size;
+    size_t align;
+};
+
+constexpr SlotType kValueSlot{sizeof(vre::VreValue), alignof(vre::VreValue)};
+constexpr SlotType kReferenceSlot{sizeof(void*), alignof(void*)};
+
+size_t align_up(size_t offset, size_t align) { return (offset + align - 1) / align * align; }
+
+bool is_reference(const ClosureConversion::Variable& var) {
+    if (var.type && var.type->category == TypeNode::TypeCategory::OWNERSHIP_WRAPPED &&
+        var.type->ownership == OwnershipKind::THEIR) {
+        return true;
+    }
+    return !var.type && var.init && var.init->getType() == NodeType::BORROW_EXPRESSION_NODE;
+}
+
+SlotType slot_for(const ClosureConversion::Variable& var) {
+    if (TypeNode* type = var.type) {
+        if (type->category != TypeNode::TypeCategory::IDENTIFIER || !type->name || type->isOptional) return kValueSlot;
+        const std::string& name = type->name->name;
+        if (name == "Int" || name == "Float" || name == "i64" || name == "u64" || name == "f64") return {8, 8};
+        if (name == "i32" || name == "u32" || name == "f32") return {4, 4};
+        if (name == "Bool") return {1, 1};
+        if (name == "String") return {sizeof(vre::VreString), alignof(vre::VreString)};
+        return kValueSlot;
+    }
+    if (!var.init) return kValueSlot;
+    switch (var.init->getType()) {
+        case NodeType::INTEGER_LITERAL:
+        case NodeType::FLOAT_LITERAL:
+            return {8, 8};
+        case NodeType::BOOLEAN_LITERAL:
+            return {1, 1};
+        case NodeType::STRING_LITERAL:
+            return {sizeof(vre::VreString), alignof(vre::VreString)};
+        case NodeType::BINARY_EXPRESSION: // `for (i in a..b)`: the induction variable is an Int
+            if (static_cast<BinaryExpression*>(var.init)->op.type == TokenType::DOTDOT) return {8, 8};
+            return kValueSlot;
+        default:
+            return kValueSlot;
+    }
+}
+
+// Names a closure body uses without binding them, in order of first use.
+// Nested closures count: what they use, the enclosing closure must capture.
+class FreeNames : public AstWalker {
+public:
+    std::vector<std::string> names;
+
+    explicit FreeNames(const std::vector<FunctionParameter>& params) { bind(params); }
+
+    using AstWalker::visit;
+    void visit(Identifier* node) override {
+        for (const auto& frame : frames_) {
+            if (frame.count(node->name)) return;
+        }
+        if (seen_.insert(node->name).second) names.push_back(node->name);
+    }
+    void visit(VariableDeclaration* node) override {
+        walk(node->init.get());
+        if (node->id) frames_.back().insert(node->id->name);
+    }
+    void visit(BlockStatement* node) override {
+        frames_.emplace_back();
+        AstWalker::visit(node);
+        frames_.pop_back();
+    }
+    void visit(ForStatement* node) override {
+        walk(node->test.get());
+        frames_.emplace_back();
+        if (auto* induction = dynamic_cast<Identifier*>(node->init.get())) {
+            frames_.back().insert(induction->name);
+        } else {
+            walk(node->init.get());
+        }
+        walk(node->update.get());
+        walk(node->body.get());
+        frames_.pop_back();
+    }
+    void visit(TryStatement* node) override {
+        walk(node->tryBlock.get());
+        for (CatchClause& clause : node->catches) {
+            frames_.emplace_back();
+            if (clause.ident) frames_.back().insert(*clause.ident);
+            walk(clause.block.get());
+            frames_.pop_back();
+        }
+        walk(node->finallyBlock.get());
+    }
+    void visit(ClosureExpression* node) override {
+        bind(node->params);
+        walk(node->body.get());
+        frames_.pop_back();
+    }
+    void visit(FunctionDeclaration*) override {} // a nested fn captures nothing
+
+private:
+    std::vector<std::unordered_set<std::string>> frames_;
+    std::unordered_set<std::string> seen_;
+
+    void bind(const std::vector<FunctionParameter>& params) {
+        frames_.emplace_back();
+        for (const auto& param : params) {
+            if (param.name) frames_.back().insert(param.name->name);
+        }
+    }
+};
+
+} // namespace
+
+ClosureReport ClosureConversion::run(Module* module) {
+    scopes_.clear();
+    report_ = ClosureReport{};
+    walk(module);
+    return report_;
+}
+
+const ClosureConversion::Variable* ClosureConversion::lookup(const std::string& name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        auto it = scope->variables.find(name);
+        if (it != scope->variables.end()) return &it->second;
+        if (scope->function) break;
+    }
+    return nullptr;
+}
+
+void ClosureConversion::declareParams(const std::vector<FunctionParameter>& params) {
+    for (const auto& param : params) {
+        if (param.name) scopes_.back().variables[param.name->name] = Variable{param.typeNode.get(), nullptr};
+    }
+}
+
+void ClosureConversion::visit(FunctionDeclaration* node) {
+    scopes_.push_back(Scope{true, {}});
+    declareParams(node->params);
+    walk(node->body.get());
+    scopes_.pop_back();
+}
+
+void ClosureConversion::visit(ClosureExpression* node) {
+    FreeNames free(node->params);
+    free.walk(node->body.get());
+
+    struct Captured {
+        ClosureCapture capture;
+        size_t order;
+    };
+    std::vector<Captured> captured;
+    for (const std::string& name : free.names) {
+        const Variable* var = lookup(name);
+        if (!var) continue; // a function, global or builtin
+        bool reference = is_reference(*var);
+        SlotType slot = reference ? kReferenceSlot : slot_for(*var);
+        captured.push_back({ClosureCapture{name, reference ? CaptureMode::BY_REFERENCE : CaptureMode::BY_VALUE, 0,
+                                           slot.size, slot.align},
+                            captured.size()});
+        ++(reference ? report_.byReference : report_.byValue);
+    }
+
+    // Pack by decreasing alignment, then restore first-use order
+    std::stable_sort(captured.begin(), captured.end(),
+                     [](const Captured& a, const Captured& b) { return a.capture.align > b.capture.align; });
+    ClosureLayout layout;
+    size_t offset = 0;
+    for (Captured& c : captured) {
+        offset = align_up(offset, c.capture.align);
+        c.capture.offset = offset;
+        offset += c.capture.size;
+        layout.envAlign = std::max(layout.envAlign, c.capture.align);
+    }
+    layout.envSize = align_up(offset, layout.envAlign);
+    std::sort(captured.begin(), captured.end(), [](const Captured& a, const Captured& b) { return a.order < b.order; });
+    for (Captured& c : captured) layout.captures.push_back(std::move(c.capture));
+    layout.converted = true;
+
+    ++report_.closures;
+    if (layout.captures.empty()) ++report_.emptyClosures;
+    report_.largestEnv = std::max(report_.largestEnv, layout.envSize);
+    static_assert(alignof(vre::VreValue) <= vre::VreClosure::MAX_ENV_ALIGN);
+    node->layout = std::move(layout);
+
+    // The body sees its own parameters, then everything the closure does
+    scopes_.push_back(Scope{false, {}});
+    declareParams(node->params);
+    walk(node->body.get());
+    scopes_.pop_back();
+}
+
+void ClosureConversion::visit(BlockStatement* node) {
+    scopes_.push_back(Scope{false, {}});
+    AstWalker::visit(node);
+    scopes_.pop_back();
+}
+
+void ClosureConversion::visit(VariableDeclaration* node) {
+    AstWalker::visit(node);
+    if (node->id && !scopes_.empty()) {
+        scopes_.back().variables[node->id->name] = Variable{node->typeNode.get(), node->init.get()};
+    }
+}
+
+void ClosureConversion::visit(ForStatement* node) {
+    walk(node->test.get());
+    scopes_.push_back(Scope{false, {}});
+    if (auto* induction = dynamic_cast<Identifier*>(node->init.get())) {
+        scopes_.back().variables[induction->name] = Variable{nullptr, node->test.get()};
+    } else {
+        walk(node->init.get());
+    }
+    walk(node->update.get());
+    walk(node->body.get());
+    scopes_.pop_back();
+}
+
+void ClosureConversion::visit(TryStatement* node) {
+    walk(node->tryBlock.get());
+    for (CatchClause& clause : node->catches) {
+        scopes_.push_back(Scope{false, {}});
+        if (clause.ident) scopes_.back().variables[*clause.ident] = Variable{nullptr, nullptr};
+        walk(clause.block.get());
+        scopes_.pop_back();
+    }
+    walk(node->finallyBlock.get());
+}
+
+} // namespace vyn
@@ -0,0 +1,291 @@
+#include "vyn/coroutine_lowering.hpp"
+#include "vyn/vre/coroutine.hpp"
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/value.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace vyn {
+
+namespace {
+
+struct SlotType {
+    size_t size;
+    size_t align;
+};
+
+constexpr SlotType kValueSlot{sizeof(vre::VreValue), alignof(vre::VreValue)};
+constexpr size_t kFrameAlign =
+    std::max({alignof(vre::VreCoroutine), alignof(vre::VreValue), alignof(vre::VreString)});
+
+size_t align_up(size_t offset, size_t align) { return (offset + align - 1) / align * align; }
+
+SlotType slot_for_type(TypeNode* type) {
+    if (!type || type->category != TypeNode::TypeCategory::IDENTIFIER || !type->name) return kValueSlot;
+    const std::string& name = type->name->name;
+    if (name == "Int" || name == "Float" || name == "i64" || name == "u64" || name == "f64") return {8, 8};
+    if (name == "i32" || name == "u32" || name == "f32") return {4, 4};
+    if (name == "Bool") return {1, 1};
+    if (name == "String") return {sizeof(vre::VreString), alignof(vre::VreString)};
+    return kValueSlot;
+}
+
+bool is_await(CallExpression* call) {
+    return call->callee && call->callee->getType() == NodeType::IDENTIFIER &&
+           static_cast<Identifier*>(call->callee.get())->name == "_await";
+}
+
+// The `_await` call inside `call`, if `call` is an awaited call. The parser
+// binds `await f(x)` as `(await f)(x)`, so the await wraps only the callee.
+CallExpression* awaited_call(CallExpression* call) {
+    if (call->callee && call->callee->getType() == NodeType::CALL_EXPRESSION) {
+        auto* inner = static_cast<CallExpression*>(call->callee.get());
+        if (is_await(inner)) return inner;
+    }
+    return nullptr;
+}
+
+// Name of the function an await calls, or empty
+std::string awaited_callee(CallExpression* await) {
+    if (await->arguments.size() != 1 || !await->arguments[0]) return {};
+    Expression* target = await->arguments[0].get();
+    if (target->getType() == NodeType::CALL_EXPRESSION) { // `await (f(x))`
+        target = static_cast<CallExpression*>(target)->callee.get();
+    }
+    if (!target || target->getType() != NodeType::IDENTIFIER) return {};
+    return static_cast<Identifier*>(target)->name;
+}
+
+// Numbers the events of one function body in evaluation order and records,
+// for each variable, where it is first defined and last used, and where each
+// await suspends. Nested functions are lowered separately and skipped.
+class LivenessScan : public AstWalker {
+public:
+    struct Variable {
+        std::string name;
+        size_t firstDef;
+        size_t lastUse;
+        SlotType slot;
+        bool parameter;
+    };
+
+    std::vector<Variable> variables; // in order of first definition
+    std::vector<std::pair<CallExpression*, size_t>> awaits;
+
+    void parameter(const FunctionParameter& param) {
+        if (!param.name) return;
+        define(param.name->name, slot_for_type(param.typeNode.get()));
+        find(param.name->name)->parameter = true;
+    }
+
+    using AstWalker::visit;
+
+    void visit(Identifier* node) override {
+        if (Variable* var = find(node->name)) var->lastUse = ++position_;
+    }
+
+    void visit(VariableDeclaration* node) override {
+        walk(node->init.get());
+        if (!node->id) return;
+        define(node->id->name, node->typeNode ? slot_for_type(node->typeNode.get()) : infer(node->init.get()));
+    }
+
+    void visit(AssignmentExpression* node) override {
+        if (!node->left || node->left->getType() != NodeType::IDENTIFIER) {
+            AstWalker::visit(node);
+            return;
+        }
+        walk(node->right.get());
+        if (node->op.type != TokenType::EQ) walk(node->left.get()); // compound assignment reads it too
+        auto* target = static_cast<Identifier*>(node->left.get());
+        if (!find(target->name)) define(target->name, infer(node->right.get()));
+        ++position_;
+    }
+
+    // The arguments of an awaited call are evaluated before it suspends
+    void visit(CallExpression* node) override {
+        if (CallExpression* await = awaited_call(node)) {
+            for (auto& arg : node->arguments) walk(arg.get());
+            walk(await);
+            return;
+        }
+        AstWalker::visit(node);
+        if (is_await(node)) awaits.emplace_back(node, ++position_);
+    }
+
+    // The range is evaluated once, but its operands are kept alive for the
+    // whole loop as if it were re-evaluated, so that its end needs no hidden
+    // slot. The induction variable is read by every step.
+    void visit(ForStatement* node) override {
+        const std::string* induction = nullptr;
+        if (node->init && node->init->getType() == NodeType::IDENTIFIER) {
+            induction = &static_cast<Identifier*>(node->init.get())->name;
+            define(*induction, {8, 8});
+        } else {
+            walk(node->init.get());
+        }
+        size_t start = position_;
+        walk(node->test.get());
+        walk(node->body.get());
+        walk(node->update.get());
+        if (induction) find(*induction)->lastUse = ++position_;
+        extend_across_loop(start);
+    }
+
+    void visit(WhileStatement* node) override {
+        size_t start = position_;
+        walk(node->test.get());
+        walk(node->body.get());
+        extend_across_loop(start);
+    }
+
+    void visit(FunctionDeclaration*) override {}
+
+private:
+    size_t position_ = 0;
+
+    Variable* find(const std::string& name) {
+        for (auto& var : variables) {
+            if (var.name == name) return &var;
+        }
+        return nullptr;
+    }
+
+    void define(const std::string& name, SlotType slot) {
+        ++position_;
+        if (Variable* var = find(name)) { // shadowing and redeclaration share a slot
+            var->slot.size = std::max(var->slot.size, slot.size);
+            var->slot.align = std::max(var->slot.align, slot.align);
+            return;
+        }
+        variables.push_back(Variable{name, position_, position_, slot, false});
+    }
+
+    // A variable defined before a loop and used in it is read again by the
+    // next iteration, so it stays live until the loop ends
+    void extend_across_loop(size_t start) {
+        for (auto& var : variables) {
+            if (var.firstDef <= start && var.lastUse > start) var.lastUse = position_ + 1;
+        }
+    }
+
+    SlotType infer(Expression* expr) {
+        if (!expr) return kValueSlot;
+        switch (expr->getType()) {
+            case NodeType::INTEGER_LITERAL:
+            case NodeType::FLOAT_LITERAL:
+                return {8, 8};
+            case NodeType::BOOLEAN_LITERAL:
+                return {1, 1};
+            case NodeType::STRING_LITERAL:
+                return {sizeof(vre::VreString), alignof(vre::VreString)};
+            case NodeType::IDENTIFIER: {
+                Variable* var = find(static_cast<Identifier*>(expr)->name);
+                return var ? var->slot : kValueSlot;
+            }
+            case NodeType::BINARY_EXPRESSION: {
+                auto* binary = static_cast<BinaryExpression*>(expr);
+                switch (binary->op.type) {
+                    case TokenType::EQEQ:
+                    case TokenType::NOTEQ:
+                    case TokenType::LT:
+                    case TokenType::GT:
+                    case TokenType::LTEQ:
+                    case TokenType::GTEQ:
+                        return {1, 1};
+                    default:
+                        return infer(binary->left.get());
+                }
+            }
+            default:
+                return kValueSlot;
+        }
+    }
+};
+
+} // namespace
+
+CoroutineReport CoroutineLowering::run(Module* module) {
+    asyncFunctions_.clear();
+    order_.clear();
+    inProgress_.clear();
+    report_ = CoroutineReport();
+    walk(module);
+    for (FunctionDeclaration* fn : order_) {
+        lower(fn);
+    }
+    return report_;
+}
+
+void CoroutineLowering::visit(FunctionDeclaration* node) {
+    if (node->isAsync) {
+        order_.push_back(node);
+        if (node->id) asyncFunctions_.emplace(node->id->name, node);
+    }
+    AstWalker::visit(node);
+}
+
+void CoroutineLowering::lower(FunctionDeclaration* fn) {
+    if (fn->coroutine.lowered) return;
+    inProgress_.insert(fn);
+
+    LivenessScan scan;
+    for (const auto& param : fn->params) scan.parameter(param);
+    scan.walk(fn->body.get());
+
+    CoroutineLayout layout;
+    layout.lowered = true;
+    layout.awaitCount = scan.awaits.size();
+    for (size_t i = 0; i < scan.awaits.size(); ++i) {
+        scan.awaits[i].first->awaitState = static_cast<uint32_t>(i + 1);
+    }
+
+    std::vector<const LivenessScan::Variable*> spilled;
+    for (const auto& var : scan.variables) {
+        bool live = var.parameter || std::any_of(scan.awaits.begin(), scan.awaits.end(), [&](const auto& await) {
+            return var.firstDef < await.second && await.second < var.lastUse;
+        });
+        if (live) {
+            spilled.push_back(&var);
+            ++(var.parameter ? report_.parameters : report_.spilledLocals);
+        } else {
+            ++report_.unspilledLocals;
+        }
+    }
+    std::stable_sort(spilled.begin(), spilled.end(),
+                     [](const auto* a, const auto* b) { return a->slot.align > b->slot.align; });
+
+    size_t offset = sizeof(vre::VreCoroutine);
+    if (fn->returnTypeNode) {
+        SlotType result = slot_for_type(fn->returnTypeNode.get());
+        layout.resultOffset = align_up(offset, result.align);
+        layout.resultSize = result.size;
+        offset = layout.resultOffset + result.size;
+    }
+    for (const auto* var : spilled) {
+        offset = align_up(offset, var->slot.align);
+        layout.slots.push_back(CoroutineSlot{var->name, offset, var->slot.size, var->slot.align});
+        offset += var->slot.size;
+    }
+
+    for (const auto& await : scan.awaits) {
+        auto callee = asyncFunctions_.find(awaited_callee(await.first));
+        if (callee != asyncFunctions_.end() && !inProgress_.count(callee->second)) {
+            lower(callee->second);
+            layout.awaitSize = std::max(layout.awaitSize, callee->second->coroutine.frameSize);
+        } else {
+            layout.awaitSize = std::max(layout.awaitSize, sizeof(vre::VreCoroutine*));
+            ++report_.boxedAwaits;
+        }
+    }
+    layout.awaitOffset = align_up(offset, kFrameAlign);
+    layout.frameSize = align_up(layout.awaitOffset + layout.awaitSize, kFrameAlign);
+
+    ++report_.asyncFunctions;
+    report_.awaitPoints += layout.awaitCount;
+    fn->coroutine = std::move(layout);
+    inProgress_.erase(fn);
+}
+
+} // namespace vyn
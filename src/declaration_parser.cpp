@@ -364,7 +364,9 @@ std::unique_ptr<vyn::FunctionDeclaration> DeclarationParser::parse_function() {
         this->expect(vyn::TokenType::SEMICOLON);
     }
     // vyn::FunctionDeclaration constructor: loc, id, params, body, isAsync, returnTypeNode
-    return std::make_unique<vyn::FunctionDeclaration>(loc, std::move(name), std::move(params_structs), std::move(body), is_async, std::move(return_type_node));
+    auto fn = std::make_unique<vyn::FunctionDeclaration>(loc, std::move(name), std::move(params_structs), std::move(body), is_async, std::move(return_type_node));
+    fn->throwsTypeNode = std::move(throws_type);
+    return fn;
 }
 
 // StructDeclNode not in ast.hpp. Assuming a Declaration type for it.
@@ -581,8 +583,12 @@ std::unique_ptr<vyn::VariableDeclaration> DeclarationParser::parse_global_var_de
         // Depending on language rules. For now, let's not enforce it strictly here.
     }
 
-
-    this->expect(vyn::TokenType::SEMICOLON);
+    // Ends at ';' or at the end of the line, like a local declaration
+    // (peek() skips NEWLINE tokens, so compare lines)
+    if (!this->match(vyn::TokenType::SEMICOLON) && this->peek().type != vyn::TokenType::END_OF_FILE &&
+        this->peek().location.line == this->previous_token().location.line) {
+        this->expect(vyn::TokenType::SEMICOLON);
+    }
 
     // vyn::VariableDeclaration constructor: loc, id, isConst, typeNode, init
     return std::make_unique<vyn::VariableDeclaration>(loc, std::move(identifier), is_const_decl, std::move(type_node), std::move(initializer)); // Changed variable name
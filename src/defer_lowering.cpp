@@ -0,0 +1,151 @@
+#include "vyn/defer_lowering.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace vyn {
+
+namespace {
+
+std::string location_to_string(const SourceLocation& loc) {
+    return loc.filePath + ":" + std::to_string(loc.line) + ":" + std::to_string(loc.column);
+}
+
+bool is_throw(CallExpression* call) {
+    return call->callee && call->callee->getType() == NodeType::IDENTIFIER &&
+           static_cast<Identifier*>(call->callee.get())->name == "_throw";
+}
+
+} // namespace
+
+DeferReport DeferLowering::run(Module* module) {
+    report_ = DeferReport{};
+    scopes_.clear();
+    walk(module);
+    return report_;
+}
+
+CleanupList DeferLowering::unwind_to(ScopeKind boundary) const {
+    CleanupList cleanups;
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        if (scope->kind == boundary || scope->kind == ScopeKind::FUNCTION) break;
+        cleanups.insert(cleanups.end(), scope->pending.rbegin(), scope->pending.rend());
+    }
+    return cleanups;
+}
+
+CleanupList DeferLowering::error_cleanups(const ErrorEdge& edge) const {
+    switch (edge.target) {
+    case ErrorTarget::HANDLER: return unwind_to(ScopeKind::HANDLER);
+    case ErrorTarget::RETURN: return unwind_to(ScopeKind::FUNCTION);
+    case ErrorTarget::NONE: break;
+    }
+    return {};
+}
+
+bool DeferLowering::inside_defer(ScopeKind boundary) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        if (scope->kind == ScopeKind::DEFER) return true;
+        if (scope->kind == boundary || scope->kind == ScopeKind::FUNCTION) return false;
+    }
+    return false;
+}
+
+void DeferLowering::exit(CleanupList& slot, CleanupList cleanups) {
+    slot = std::move(cleanups);
+    if (slot.empty()) return;
+    ++report_.exits;
+    report_.inlinedCleanups += slot.size();
+}
+
+void DeferLowering::visit(FunctionDeclaration* node) {
+    // A nested function starts its own stack: its returns leave only its scopes
+    std::vector<Scope> outer;
+    outer.swap(scopes_);
+    scopes_.push_back({ScopeKind::FUNCTION, {}});
+    walk(node->body.get());
+    scopes_.swap(outer);
+}
+
+void DeferLowering::visit(BlockStatement* node) {
+    scopes_.push_back({ScopeKind::BLOCK, {}});
+    for (auto& stmt : node->body) walk(stmt.get());
+    const CleanupList& pending = scopes_.back().pending;
+    exit(node->exitCleanups, CleanupList(pending.rbegin(), pending.rend()));
+    scopes_.pop_back();
+}
+
+void DeferLowering::visit(DeferStatement* node) {
+    ++report_.defers;
+    scopes_.push_back({ScopeKind::DEFER, {}});
+    walk(node->body.get());
+    scopes_.pop_back();
+    // Pending from here on in the innermost block; a defer outside any
+    // block (at module level) has no exit to run at
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        if (scope->kind == ScopeKind::BLOCK) {
+            scope->pending.push_back(node->body.get());
+            break;
+        }
+    }
+}
+
+void DeferLowering::visit(TryStatement* node) {
+    if (node->finallyBlock) scopes_.push_back({ScopeKind::FINALLY, {node->finallyBlock.get()}});
+    if (!node->catches.empty()) scopes_.push_back({ScopeKind::HANDLER, {}});
+    walk(node->tryBlock.get());
+    if (!node->catches.empty()) scopes_.pop_back();
+    exit(node->unmatchedCleanups, error_cleanups(node->unmatched));
+    for (CatchClause& clause : node->catches) walk(clause.block.get());
+    if (node->finallyBlock) scopes_.pop_back();
+    walk(node->finallyBlock.get());
+}
+
+void DeferLowering::visit(ForStatement* node) {
+    walk(node->init.get());
+    walk(node->test.get());
+    walk(node->update.get());
+    scopes_.push_back({ScopeKind::LOOP, {}});
+    walk(node->body.get());
+    scopes_.pop_back();
+}
+
+void DeferLowering::visit(WhileStatement* node) {
+    walk(node->test.get());
+    scopes_.push_back({ScopeKind::LOOP, {}});
+    walk(node->body.get());
+    scopes_.pop_back();
+}
+
+void DeferLowering::visit(ReturnStatement* node) {
+    AstWalker::visit(node);
+    if (inside_defer(ScopeKind::FUNCTION)) {
+        throw std::runtime_error("'return' inside a deferred statement at " + location_to_string(node->loc));
+    }
+    exit(node->cleanups, unwind_to(ScopeKind::FUNCTION));
+}
+
+void DeferLowering::visit(BreakStatement* node) {
+    if (inside_defer(ScopeKind::LOOP)) {
+        throw std::runtime_error("'break' out of a deferred statement at " + location_to_string(node->loc));
+    }
+    exit(node->cleanups, unwind_to(ScopeKind::LOOP));
+}
+
+void DeferLowering::visit(ContinueStatement* node) {
+    if (inside_defer(ScopeKind::LOOP)) {
+        throw std::runtime_error("'continue' out of a deferred statement at " + location_to_string(node->loc));
+    }
+    exit(node->cleanups, unwind_to(ScopeKind::LOOP));
+}
+
+void DeferLowering::visit(CallExpression* node) {
+    AstWalker::visit(node);
+    ScopeKind boundary = node->errorEdge.target == ErrorTarget::HANDLER ? ScopeKind::HANDLER : ScopeKind::FUNCTION;
+    if (is_throw(node) && inside_defer(boundary)) {
+        throw std::runtime_error("'throw' inside a deferred statement at " + location_to_string(node->loc));
+    }
+    exit(node->errorCleanups, error_cleanups(node->errorEdge));
+}
+
+} // namespace vyn
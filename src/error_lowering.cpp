@@ -0,0 +1,176 @@
+#include "vyn/error_lowering.hpp"
+
+#include <unordered_set>
+
+namespace vyn {
+
+namespace {
+
+const std::string* identifier_name(Expression* expr) {
+    if (expr && expr->getType() == NodeType::IDENTIFIER) {
+        return &static_cast<Identifier*>(expr)->name;
+    }
+    return nullptr;
+}
+
+bool is_throw(CallExpression* call) {
+    const std::string* name = identifier_name(call->callee.get());
+    return name && *name == "_throw";
+}
+
+// Name of the function or method a call invokes, or nullptr. An awaited
+// call `await f(x)` parses as `(await f)(x)` and invokes `f`.
+const std::string* callee_name(CallExpression* call) {
+    Expression* callee = call->callee.get();
+    if (callee && callee->getType() == NodeType::CALL_EXPRESSION) {
+        auto* inner = static_cast<CallExpression*>(callee);
+        const std::string* intrinsic = identifier_name(inner->callee.get());
+        if (!intrinsic || *intrinsic != "_await" || inner->arguments.size() != 1) return nullptr;
+        callee = inner->arguments[0].get();
+    }
+    if (const std::string* name = identifier_name(callee)) {
+        return name->empty() || (*name)[0] == '_' ? nullptr : name;
+    }
+    if (callee && callee->getType() == NodeType::MEMBER_EXPRESSION) {
+        auto* member = static_cast<MemberExpression*>(callee);
+        if (!member->computed) return identifier_name(member->property.get());
+    }
+    return nullptr;
+}
+
+bool has_catch_all(const TryStatement* node) {
+    for (const CatchClause& clause : node->catches) {
+        if (!clause.errorType) return true;
+    }
+    return false;
+}
+
+// Assigns the error edges of one function body, given the functions known
+// to fail so far. Nested functions are scanned on their own.
+class EdgeScan : public AstWalker {
+public:
+    EdgeScan(const std::unordered_set<FunctionDeclaration*>& failing,
+             const std::unordered_map<std::string, std::vector<FunctionDeclaration*>>& functions,
+             ErrorLoweringReport& report)
+        : failing_(failing), functions_(functions), report_(report) {}
+
+    bool escapes = false; // some error leaves the function
+
+    using AstWalker::visit;
+
+    void visit(CallExpression* node) override {
+        AstWalker::visit(node);
+        if (is_throw(node)) {
+            ++report_.throwSites;
+            site(node->errorEdge);
+            return;
+        }
+        const std::string* name = callee_name(node);
+        if (!name || !can_fail(*name)) {
+            node->errorEdge = ErrorEdge{};
+            if (name) ++report_.uncheckedCalls;
+            return;
+        }
+        ++report_.checkedCalls;
+        site(node->errorEdge);
+    }
+
+    void visit(TryStatement* node) override {
+        enclosing_.push_back({node, Region::TRY});
+        walk(node->tryBlock.get());
+        bool reached = reached_.count(node) > 0;
+        enclosing_.back().region = Region::CATCH;
+        node->unmatched = ErrorEdge{};
+        if (reached && !has_catch_all(node)) node->unmatched = edge();
+        for (CatchClause& clause : node->catches) walk(clause.block.get());
+        enclosing_.back().region = Region::FINALLY;
+        walk(node->finallyBlock.get());
+        enclosing_.pop_back();
+    }
+
+    void visit(FunctionDeclaration*) override {}
+
+private:
+    enum class Region { TRY, CATCH, FINALLY };
+    struct Enclosing {
+        TryStatement* node;
+        Region region;
+    };
+
+    const std::unordered_set<FunctionDeclaration*>& failing_;
+    const std::unordered_map<std::string, std::vector<FunctionDeclaration*>>& functions_;
+    ErrorLoweringReport& report_;
+    std::vector<Enclosing> enclosing_; // innermost last
+    std::unordered_set<TryStatement*> reached_; // trys whose handler some site branches to
+
+    bool can_fail(const std::string& name) const {
+        auto it = functions_.find(name);
+        if (it == functions_.end()) return false;
+        for (FunctionDeclaration* fn : it->second) {
+            if (failing_.count(fn)) return true;
+        }
+        return false;
+    }
+
+    // Where an error raised at the current position goes
+    ErrorEdge edge() {
+        ErrorEdge result;
+        for (auto it = enclosing_.rbegin(); it != enclosing_.rend(); ++it) {
+            TryStatement* node = it->node;
+            if (it->region == Region::TRY && !node->catches.empty()) {
+                result.target = ErrorTarget::HANDLER;
+                result.handler = node;
+                reached_.insert(node);
+                return result;
+            }
+            // Leaving a try block without catches, or a catch clause, runs
+            // the finally block; leaving the finally block itself does not
+            if (it->region != Region::FINALLY && node->finallyBlock) ++result.cleanups;
+        }
+        result.target = ErrorTarget::RETURN;
+        escapes = true;
+        return result;
+    }
+
+    void site(ErrorEdge& slot) {
+        slot = edge();
+        if (slot.target == ErrorTarget::HANDLER) ++report_.handledSites;
+        if (slot.cleanups > 0) ++report_.cleanupEdges;
+    }
+};
+
+} // namespace
+
+ErrorLoweringReport ErrorLowering::run(Module* module) {
+    functions_.clear();
+    order_.clear();
+    walk(module);
+
+    std::unordered_set<FunctionDeclaration*> failing;
+    for (FunctionDeclaration* fn : order_) {
+        if (fn->throwsTypeNode) failing.insert(fn);
+    }
+    // Failing only grows, so this settles after at most one pass per function
+    ErrorLoweringReport report;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        report = ErrorLoweringReport{};
+        for (FunctionDeclaration* fn : order_) {
+            EdgeScan scan(failing, functions_, report);
+            scan.walk(fn->body.get());
+            if (scan.escapes && failing.insert(fn).second) changed = true;
+        }
+    }
+    for (FunctionDeclaration* fn : order_) fn->canFail = failing.count(fn) > 0;
+    report.failingFunctions = failing.size();
+    return report;
+}
+
+void ErrorLowering::visit(FunctionDeclaration* node) {
+    if (node->id) functions_[node->id->name].push_back(node);
+    order_.push_back(node);
+    AstWalker::visit(node);
+}
+
+} // namespace vyn
@@ -0,0 +1,152 @@
+#include "vyn/escape_analysis.hpp"
+
+#include <algorithm>
+
+namespace vyn {
+
+std::vector<EscapeDiagnostic> EscapeAnalysis::analyze(Module* module) {
+    scopes_.clear();
+    regions_.clear();
+    diagnostics_.clear();
+    scopes_.emplace_back();
+    walk(module);
+    scopes_.clear();
+    return std::move(diagnostics_);
+}
+
+void EscapeAnalysis::declare(const std::string& name) {
+    Binding binding{static_cast<int>(regions_.size()), regions_.empty() ? nullptr : regions_.back()};
+    scopes_.back()[name] = binding;
+}
+
+const EscapeAnalysis::Binding* EscapeAnalysis::lookup(const std::string& name) const {
+    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+        auto found = it->find(name);
+        if (found != it->end()) return &found->second;
+    }
+    return nullptr;
+}
+
+void EscapeAnalysis::collect_flowing_names(Expression* expr, std::vector<std::string>& out) const {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case NodeType::IDENTIFIER:
+            out.push_back(static_cast<Identifier*>(expr)->name);
+            break;
+        case NodeType::ARRAY_LITERAL_NODE:
+            for (auto& elem : static_cast<ArrayLiteralNode*>(expr)->elements) {
+                collect_flowing_names(elem.get(), out);
+            }
+            break;
+        case NodeType::OBJECT_LITERAL_NODE:
+            for (auto& prop : static_cast<ObjectLiteral*>(expr)->properties) {
+                collect_flowing_names(prop.value.get(), out);
+            }
+            break;
+        case NodeType::BORROW_EXPRESSION_NODE:
+            collect_flowing_names(static_cast<BorrowExprNode*>(expr)->expression.get(), out);
+            break;
+        case NodeType::CALL_EXPRESSION: {
+            // Struct literals parse as Name(ObjectLiteral); other calls yield fresh values
+            auto* call = static_cast<CallExpression*>(expr);
+            if (call->arguments.size() == 1 && call->arguments[0] &&
+                call->arguments[0]->getType() == NodeType::OBJECT_LITERAL_NODE) {
+                collect_flowing_names(call->arguments[0].get(), out);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void EscapeAnalysis::report(const std::string& name, const Binding& binding, SourceLocation loc, const std::string& reason) {
+    diagnostics_.push_back({name, loc, reason});
+    if (binding.owner) {
+        auto& names = binding.owner->escapingNames;
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            names.push_back(name);
+        }
+    }
+}
+
+void EscapeAnalysis::visit(FunctionDeclaration* node) {
+    // Region depth is counted per function; the body cannot see the caller's regions
+    std::vector<ScopedStatement*> saved_regions;
+    saved_regions.swap(regions_);
+    scopes_.emplace_back();
+    for (auto& param : node->params) {
+        if (param.name) declare(param.name->name);
+    }
+    walk(node->body.get());
+    scopes_.pop_back();
+    regions_.swap(saved_regions);
+}
+
+void EscapeAnalysis::visit(BlockStatement* node) {
+    scopes_.emplace_back();
+    AstWalker::visit(node);
+    scopes_.pop_back();
+}
+
+void EscapeAnalysis::visit(ScopedStatement* node) {
+    node->escapingNames.clear();
+    regions_.push_back(node);
+    AstWalker::visit(node);
+    regions_.pop_back();
+}
+
+void EscapeAnalysis::visit(VariableDeclaration* node) {
+    AstWalker::visit(node);
+    if (node->id) declare(node->id->name);
+}
+
+void EscapeAnalysis::visit(ReturnStatement* node) {
+    AstWalker::visit(node);
+    std::vector<std::string> names;
+    collect_flowing_names(node->argument.get(), names);
+    for (const auto& name : names) {
+        const Binding* binding = lookup(name);
+        if (binding && binding->regionDepth > 0) {
+            report(name, *binding, node->loc, "returned");
+        }
+    }
+}
+
+void EscapeAnalysis::visit(AssignmentExpression* node) {
+    AstWalker::visit(node);
+
+    // Find the variable that ultimately holds the stored value: x, x.f, x[i].g, ...
+    Expression* target = node->left.get();
+    while (target && target->getType() == NodeType::MEMBER_EXPRESSION) {
+        target = static_cast<MemberExpression*>(target)->object.get();
+    }
+    if (!target || target->getType() != NodeType::IDENTIFIER) return;
+    const std::string& target_name = static_cast<Identifier*>(target)->name;
+    const Binding* target_binding = lookup(target_name);
+    int target_depth = target_binding ? target_binding->regionDepth : 0;
+
+    std::vector<std::string> names;
+    collect_flowing_names(node->right.get(), names);
+    for (const auto& name : names) {
+        const Binding* binding = lookup(name);
+        if (binding && binding->regionDepth > target_depth) {
+            report(name, *binding, node->loc, "stored into '" + target_name + "'");
+        }
+    }
+}
+
+void EscapeAnalysis::visit(ForStatement* node) {
+    scopes_.emplace_back();
+    if (node->init && node->init->getType() == NodeType::IDENTIFIER) {
+        declare(static_cast<Identifier*>(node->init.get())->name);
+    } else {
+        walk(node->init.get());
+    }
+    walk(node->test.get());
+    walk(node->update.get());
+    walk(node->body.get());
+    scopes_.pop_back();
+}
+
+} // namespace vyn
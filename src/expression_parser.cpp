@@ -40,6 +40,11 @@ namespace vyn {
             return nullptr;
         }
 
+        // fn (params) { ... } is a closure, not a declaration
+        if (token.type == vyn::TokenType::KEYWORD_FN && peekNext().type == vyn::TokenType::LPAREN) {
+            return parse_closure();
+        }
+
         // Handle identifiers and keywords that can be part of expressions
         if (token.type == vyn::TokenType::IDENTIFIER ||
             token.type == vyn::TokenType::KEYWORD_CLASS || 
@@ -268,6 +273,48 @@ namespace vyn {
         throw error(token, "Unexpected token in atom: " + token.lexeme);
     }
 
+    // fn (x: Int, y) -> Int { body }  or  fn (x: Int) => expr
+    vyn::ExprPtr ExpressionParser::parse_closure() {
+        vyn::token::Token fn_token = expect(vyn::TokenType::KEYWORD_FN);
+        if (!type_parser_ || !stmt_parser_) {
+            throw error(fn_token, "Closures can only be parsed by a full Parser");
+        }
+        expect(vyn::TokenType::LPAREN);
+        std::vector<vyn::FunctionParameter> params;
+        if (!check(vyn::TokenType::RPAREN)) {
+            do {
+                vyn::token::Token name = expect(vyn::TokenType::IDENTIFIER);
+                vyn::TypeNodePtr type = nullptr;
+                if (match(vyn::TokenType::COLON)) {
+                    type = type_parser_->parse();
+                }
+                params.emplace_back(std::make_unique<vyn::Identifier>(name.location, name.lexeme), std::move(type));
+            } while (match(vyn::TokenType::COMMA));
+        }
+        expect(vyn::TokenType::RPAREN);
+
+        vyn::TypeNodePtr return_type = nullptr;
+        if (match(vyn::TokenType::ARROW)) {
+            return_type = type_parser_->parse();
+        }
+
+        std::unique_ptr<vyn::BlockStatement> body;
+        if (match(vyn::TokenType::FAT_ARROW)) {
+            vyn::SourceLocation body_loc = current_location();
+            vyn::ExprPtr value = parse_expression();
+            if (!value) {
+                throw error(previous_token(), "Expected expression after '=>' in closure");
+            }
+            std::vector<vyn::StmtPtr> statements;
+            statements.push_back(std::make_unique<vyn::ReturnStatement>(body_loc, std::move(value)));
+            body = std::make_unique<vyn::BlockStatement>(body_loc, std::move(statements));
+        } else {
+            body = stmt_parser_->parse_block();
+        }
+        return std::make_unique<vyn::ClosureExpression>(fn_token.location, std::move(params), std::move(return_type),
+                                                        std::move(body));
+    }
+
     vyn::ExprPtr ExpressionParser::parse_primary_expr() {
         skip_comments_and_newlines();
         vyn::SourceLocation loc = current_location();
@@ -277,6 +324,23 @@ namespace vyn {
                   << loc.filePath << ":" << loc.line << ":" << loc.column << std::endl;
         #endif
 
+        // @parallel [expr for x in a..b]
+        if (peek().type == vyn::TokenType::AT) {
+            consume();
+            vyn::token::Token attribute = expect(vyn::TokenType::IDENTIFIER);
+            if (attribute.lexeme != "parallel") {
+                throw error(attribute, "Unknown attribute '@" + attribute.lexeme + "'");
+            }
+            vyn::ExprPtr expr = parse_primary_expr();
+            auto* comprehension = dynamic_cast<vyn::CallExpression*>(expr.get());
+            auto* name = comprehension ? dynamic_cast<vyn::Identifier*>(comprehension->callee.get()) : nullptr;
+            if (!name || name->name != "_list_comprehension") {
+                throw error(attribute, "Expected a list comprehension after '@parallel'");
+            }
+            name->name = "_parallel_list_comprehension";
+            return expr;
+        }
+
         // Check for await expression
         if (peek().type == vyn::TokenType::KEYWORD_AWAIT) {
             vyn::SourceLocation await_loc = current_location(); // Store await location
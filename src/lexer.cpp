@@ -395,6 +395,7 @@ vyn::TokenType Lexer::get_keyword_type(const std::string& word) {
         {"try", vyn::TokenType::KEYWORD_TRY},
         {"catch", vyn::TokenType::KEYWORD_CATCH},
         {"finally", vyn::TokenType::KEYWORD_FINALLY},
+        {"throw", vyn::TokenType::KEYWORD_THROW},
         {"defer", vyn::TokenType::KEYWORD_DEFER},
         {"match", vyn::TokenType::KEYWORD_MATCH},
         {"scoped", vyn::TokenType::KEYWORD_SCOPED},
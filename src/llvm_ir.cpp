@@ -0,0 +1,1561 @@
+#include "vyn/llvm_ir.hpp"
+
+#include "vyn/control_flow.hpp"
+#include "vyn/process.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace vyn {
+
+namespace {
+
+using Type = LlvmIrEmitter::Type;
+using Kind = LlvmIrEmitter::Type::Kind;
+
+std::string location_to_string(const SourceLocation& loc) {
+    return loc.filePath + ":" + std::to_string(loc.line) + ":" + std::to_string(loc.column);
+}
+
+[[noreturn]] void fail(Node* node, const std::string& message) {
+    throw std::runtime_error("LLVM IR: " + message + " at " + location_to_string(node->loc));
+}
+
+std::string describe(Node* node) {
+    switch (node->getType()) {
+        case NodeType::CLOSURE_EXPRESSION: return "closures";
+        case NodeType::OBJECT_LITERAL_NODE: return "object literals without a struct name";
+        case NodeType::TRY_STATEMENT: return "try statements";
+        case NodeType::TEMPLATE_DECLARATION: return "templates";
+        case NodeType::ENUM_DECLARATION: return "enums";
+        case NodeType::IMPORT_DECLARATION: return "imports";
+        case NodeType::TYPE_ALIAS_DECLARATION: return "type aliases";
+        case NodeType::VARIABLE_DECLARATION: return "global variables";
+        case NodeType::FUNCTION_DECLARATION: return "nested functions";
+        default: return "'" + node->toString() + "'";
+    }
+}
+
+Type make(Kind kind) {
+    Type type;
+    type.kind = kind;
+    return type;
+}
+
+Type wrap(Kind kind, const Type& element, int64_t length = 0) {
+    Type type;
+    type.kind = kind;
+    type.element = std::make_shared<const Type>(element);
+    type.length = length;
+    return type;
+}
+
+bool is_integer(const Type& type) {
+    return type.kind == Kind::INT || type.kind == Kind::UINT || type.kind == Kind::I32 || type.kind == Kind::U32;
+}
+
+bool is_signed(const Type& type) { return type.kind == Kind::INT || type.kind == Kind::I32; }
+
+int bits(const Type& type) { return type.kind == Kind::I32 || type.kind == Kind::U32 ? 32 : 64; }
+
+bool is_float(const Type& type) { return type.kind == Kind::FLOAT || type.kind == Kind::F32; }
+
+bool is_pointer(const Type& type) { return type.kind == Kind::BORROWED || type.kind == Kind::POINTER; }
+
+bool is_aggregate(const Type& type) { return type.kind == Kind::STRUCT || type.kind == Kind::ARRAY; }
+
+// The struct reached through `.`: a struct value, or the pointee of a pointer
+const std::string* struct_of(const Type& type) {
+    if (type.kind == Kind::STRUCT) return &type.name;
+    if (is_pointer(type) && type.element->kind == Kind::STRUCT) return &type.element->name;
+    return nullptr;
+}
+
+std::string type_name(const Type& type) {
+    switch (type.kind) {
+        case Kind::VOID: return "nothing";
+        case Kind::NIL: return "nil";
+        case Kind::INT: return "Int";
+        case Kind::UINT: return "UInt";
+        case Kind::I32: return "i32";
+        case Kind::U32: return "u32";
+        case Kind::FLOAT: return "Float";
+        case Kind::F32: return "f32";
+        case Kind::BOOL: return "Bool";
+        case Kind::STRING: return "String";
+        case Kind::STRUCT: return type.name;
+        case Kind::BORROWED: return "their<" + type_name(*type.element) + ">";
+        case Kind::POINTER: return "ptr<" + type_name(*type.element) + ">";
+        case Kind::ARRAY: return "[" + type_name(*type.element) + "; " + std::to_string(type.length) + "]";
+    }
+    return "?";
+}
+
+int64_t constant(Expression* node) {
+    if (node->getType() == NodeType::INTEGER_LITERAL) return static_cast<IntegerLiteral*>(node)->value;
+    if (node->getType() == NodeType::BINARY_EXPRESSION) {
+        auto* binary = static_cast<BinaryExpression*>(node);
+        int64_t left = constant(binary->left.get());
+        int64_t right = constant(binary->right.get());
+        switch (binary->op.type) {
+            case TokenType::PLUS: return left + right;
+            case TokenType::MINUS: return left - right;
+            case TokenType::MULTIPLY: return left * right;
+            case TokenType::DIVIDE:
+                if (right != 0) return left / right;
+                break;
+            default:
+                break;
+        }
+    }
+    fail(node, "array lengths must be integer constants");
+}
+
+// An integer literal, possibly negated: a `case` of a switch
+bool case_value(Expression* node, int64_t& value) {
+    if (node->getType() == NodeType::INTEGER_LITERAL) {
+        value = static_cast<IntegerLiteral*>(node)->value;
+        return true;
+    }
+    if (node->getType() == NodeType::UNARY_EXPRESSION) {
+        auto* unary = static_cast<UnaryExpression*>(node);
+        if (unary->op.type == TokenType::MINUS && unary->operand->getType() == NodeType::INTEGER_LITERAL) {
+            value = -static_cast<IntegerLiteral*>(unary->operand.get())->value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 32-bit integers take constants in [INT32_MIN, UINT32_MAX], as bit patterns
+bool fits(int64_t value, const Type& type) {
+    return bits(type) == 64 || (value >= INT32_MIN && value <= static_cast<int64_t>(UINT32_MAX));
+}
+
+// Floating-point constants are written as the hex bits of a double, the only
+// form LLVM reads back exactly. An f32 constant must be a float widened.
+std::string float_literal(double value, bool single) {
+    if (single) value = static_cast<float>(value);
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char text[24];
+    std::snprintf(text, sizeof(text), "0x%016" PRIX64, bits);
+    return text;
+}
+
+std::string escape(const std::string& text) {
+    std::string out;
+    for (unsigned char c : text) {
+        if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\') {
+            char hex[4];
+            std::snprintf(hex, sizeof(hex), "\\%02X", c);
+            out += hex;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    return out;
+}
+
+// The size of a type, as a constant expression
+std::string size_of(const std::string& type) {
+    return "ptrtoint (ptr getelementptr (" + type + ", ptr null, i32 1) to i64)";
+}
+
+std::string join(const std::vector<std::string>& parts) {
+    std::string out;
+    for (size_t i = 0; i < parts.size(); ++i) out += (i ? ", " : "") + parts[i];
+    return out;
+}
+
+bool is_comparison(TokenType type) {
+    switch (type) {
+        case TokenType::EQEQ:
+        case TokenType::NOTEQ:
+        case TokenType::LT:
+        case TokenType::GT:
+        case TokenType::LTEQ:
+        case TokenType::GTEQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char* integer_compare(TokenType type, bool is_signed) {
+    switch (type) {
+        case TokenType::EQEQ: return "eq";
+        case TokenType::NOTEQ: return "ne";
+        case TokenType::LT: return is_signed ? "slt" : "ult";
+        case TokenType::GT: return is_signed ? "sgt" : "ugt";
+        case TokenType::LTEQ: return is_signed ? "sle" : "ule";
+        case TokenType::GTEQ: return is_signed ? "sge" : "uge";
+        default: return nullptr;
+    }
+}
+
+const char* float_compare(TokenType type) {
+    switch (type) {
+        case TokenType::EQEQ: return "oeq";
+        case TokenType::NOTEQ: return "une";
+        case TokenType::LT: return "olt";
+        case TokenType::GT: return "ogt";
+        case TokenType::LTEQ: return "ole";
+        case TokenType::GTEQ: return "oge";
+        default: return nullptr;
+    }
+}
+
+const char* integer_operator(TokenType type, bool is_signed) {
+    switch (type) {
+        case TokenType::PLUS: return "add";
+        case TokenType::MINUS: return "sub";
+        case TokenType::MULTIPLY: return "mul";
+        case TokenType::DIVIDE: return is_signed ? "sdiv" : "udiv";
+        case TokenType::MODULO: return is_signed ? "srem" : "urem";
+        case TokenType::AMPERSAND: return "and";
+        case TokenType::PIPE: return "or";
+        case TokenType::CARET: return "xor";
+        case TokenType::LSHIFT: return "shl";
+        case TokenType::RSHIFT: return is_signed ? "ashr" : "lshr";
+        default: return nullptr;
+    }
+}
+
+const char* float_operator(TokenType type) {
+    switch (type) {
+        case TokenType::PLUS: return "fadd";
+        case TokenType::MINUS: return "fsub";
+        case TokenType::MULTIPLY: return "fmul";
+        case TokenType::DIVIDE: return "fdiv";
+        default: return nullptr;
+    }
+}
+
+const char* kPrelude = R"(; Generated by the Vyn LLVM IR emitter.
+declare i32 @printf(ptr, ...)
+declare i64 @write(i32, ptr, i64)
+declare i32 @fflush(ptr)
+declare void @abort() noreturn nounwind
+declare void @llvm.memcpy.p0.p0.i64(ptr, ptr, i64, i1)
+declare void @llvm.memmove.p0.p0.i64(ptr, ptr, i64, i1)
+
+@.bounds = private unnamed_addr constant [26 x i8] c"vyn: index out of bounds\0A\00"
+@.division = private unnamed_addr constant [23 x i8] c"vyn: division by zero\0A\00"
+
+; What was printed before a panic is flushed, as vyn_panic does in C
+define internal void @vyn.bounds_fail() cold noreturn nounwind {
+  %flushed = call i32 @fflush(ptr null)
+  %written = call i64 @write(i32 2, ptr @.bounds, i64 25)
+  call void @abort()
+  unreachable
+}
+
+define internal void @vyn.division_fail() cold noreturn nounwind {
+  %flushed = call i32 @fflush(ptr null)
+  %written = call i64 @write(i32 2, ptr @.division, i64 22)
+  call void @abort()
+  unreachable
+}
+)";
+
+void run_tool(const std::vector<std::string>& args, const std::string& log_path) {
+    ProgramRun run = run_program(args, log_path);
+    if (run.error != 0) {
+        throw std::runtime_error("LLVM IR: cannot run `" + command_line(args) + "`: " + std::strerror(run.error));
+    }
+    if (!run.succeeded()) throw std::runtime_error("LLVM IR: `" + command_line(args) + "` failed:\n" + run.output);
+}
+
+// LLVM 14 reads `ptr` only when asked to; 15 and later read nothing else
+std::vector<std::string> pointer_flag(const std::string& tool, const std::string& log_path) {
+    ProgramRun run = run_program({tool, "--version"}, log_path);
+    if (!run.succeeded()) return {};
+    size_t at = run.output.find("version ");
+    if (at == std::string::npos) return {};
+    if (std::atoi(run.output.c_str() + at + 8) < 15) return {"-opaque-pointers"};
+    return {};
+}
+
+} // namespace
+
+std::string LlvmIrEmitter::run(Module* module) {
+    records_.clear();
+    recordsByName_.clear();
+    functions_.clear();
+    functionsByName_.clear();
+    methods_.clear();
+    strings_.clear();
+    globals_.clear();
+    report_ = LlvmIrReport{};
+
+    collect(module);
+    std::vector<size_t> order = orderRecords();
+
+    std::string types;
+    for (size_t index : order) {
+        const Record& record = records_[index];
+        std::vector<std::string> fields;
+        for (auto& [name, type] : record.fields) fields.push_back(ltype(type));
+        types += "%struct." + record.name + " = type { " + join(fields) + (fields.empty() ? "}" : " }") + "\n";
+    }
+
+    std::string functions;
+    for (const Function& fn : functions_) {
+        emitFunction(fn);
+        functions += "\ndefine internal " + signature(fn) + " {\nentry:\n" + allocas_ + body_ + "}\n";
+    }
+    current_ = nullptr;
+
+    auto main = functionsByName_.find("main");
+    if (main != functionsByName_.end()) {
+        const Function& fn = functions_[main->second];
+        if (!fn.params.empty()) fail(fn.decl, "main takes no parameters");
+        functions += "\ndefine i32 @main() {\nentry:\n";
+        if (fn.result.kind == Kind::VOID) {
+            functions += "  call void @vyn.main()\n  ret i32 0\n";
+        } else if (bits(fn.result) == 32 && is_integer(fn.result)) {
+            functions += "  %status = call i32 @vyn.main()\n  ret i32 %status\n";
+        } else if (is_integer(fn.result)) {
+            functions += "  %result = call i64 @vyn.main()\n  %status = trunc i64 %result to i32\n  ret i32 %status\n";
+        } else {
+            fail(fn.decl, "main must return an integer or nothing");
+        }
+        functions += "}\n";
+    }
+
+    report_.structs = records_.size();
+    report_.functions = functions_.size();
+    std::string out = kPrelude;
+    if (!types.empty()) out += "\n" + types;
+    if (!globals_.empty()) out += "\n" + globals_;
+    return out + functions;
+}
+
+void LlvmIrEmitter::verify(const std::string& ir, const std::string& path, const std::string& opt) {
+    {
+        std::ofstream file(path);
+        file << ir;
+        if (!file) throw std::runtime_error("LLVM IR: cannot write " + path);
+    }
+    std::string log = path + ".log";
+    std::vector<std::string> flags = pointer_flag(opt, log);
+    std::vector<std::string> args{opt};
+    args.insert(args.end(), flags.begin(), flags.end());
+    args.insert(args.end(), {"-verify", "-disable-output", path});
+    run_tool(args, log);
+}
+
+void LlvmIrEmitter::compile(const std::string& ir, const std::string& executable, const std::string& compiler) {
+    std::string ll_path = executable + ".ll";
+    std::string bc_path = executable + ".bc";
+    std::string object_path = executable + ".o";
+    std::string log = executable + ".log";
+    {
+        std::ofstream file(ll_path);
+        file << ir;
+        if (!file) throw std::runtime_error("LLVM IR: cannot write " + ll_path);
+    }
+    std::vector<std::string> flags = pointer_flag("opt", log);
+    std::vector<std::string> opt{"opt"};
+    opt.insert(opt.end(), flags.begin(), flags.end());
+    opt.insert(opt.end(), {"-O2", ll_path, "-o", bc_path});
+    run_tool(opt, log);
+    std::vector<std::string> llc{"llc"};
+    llc.insert(llc.end(), flags.begin(), flags.end());
+    llc.insert(llc.end(), {"-O2", "-relocation-model=pic", "-filetype=obj", bc_path, "-o", object_path});
+    run_tool(llc, log);
+    std::remove(bc_path.c_str());
+    run_tool({compiler, "-o", executable, object_path}, log);
+    std::remove(object_path.c_str());
+}
+
+// --- Declarations ---
+
+void LlvmIrEmitter::collect(Module* module) {
+    std::vector<std::pair<FunctionDeclaration*, std::string>> functions;
+    auto add_record = [&](Declaration* decl, Identifier* name, std::vector<FieldDeclaration*> fields) {
+        if (!recordsByName_.emplace(name->name, records_.size()).second) fail(decl, "duplicate type " + name->name);
+        records_.push_back(Record{name->name, decl, std::move(fields), {}});
+    };
+
+    for (auto& stmt : module->body) {
+        switch (stmt->getType()) {
+            case NodeType::STRUCT_DECLARATION: {
+                auto* node = static_cast<StructDeclaration*>(stmt.get());
+                if (!node->genericParams.empty()) fail(node, "generic struct " + node->name->name + " is not supported");
+                std::vector<FieldDeclaration*> fields;
+                for (auto& field : node->fields) fields.push_back(field.get());
+                add_record(node, node->name.get(), std::move(fields));
+                break;
+            }
+            case NodeType::CLASS_DECLARATION: {
+                auto* node = static_cast<ClassDeclaration*>(stmt.get());
+                if (!node->genericParams.empty()) fail(node, "generic class " + node->name->name + " is not supported");
+                std::vector<FieldDeclaration*> fields;
+                for (auto& member : node->members) {
+                    if (member->getType() == NodeType::FIELD_DECLARATION) {
+                        fields.push_back(static_cast<FieldDeclaration*>(member.get()));
+                    } else if (member->getType() == NodeType::FUNCTION_DECLARATION) {
+                        functions.emplace_back(static_cast<FunctionDeclaration*>(member.get()), node->name->name);
+                    } else {
+                        fail(member.get(), "unsupported class member");
+                    }
+                }
+                add_record(node, node->name.get(), std::move(fields));
+                break;
+            }
+            case NodeType::IMPL_DECLARATION: {
+                auto* node = static_cast<ImplDeclaration*>(stmt.get());
+                if (!node->genericParams.empty()) fail(node, "generic impls are not supported");
+                if (!node->selfType || node->selfType->category != TypeNode::TypeCategory::IDENTIFIER ||
+                    !node->selfType->name) {
+                    fail(node, "impl of a type that is not a struct");
+                }
+                for (auto& method : node->methods) functions.emplace_back(method.get(), node->selfType->name->name);
+                break;
+            }
+            case NodeType::FUNCTION_DECLARATION:
+                functions.emplace_back(static_cast<FunctionDeclaration*>(stmt.get()), "");
+                break;
+            default:
+                fail(stmt.get(), describe(stmt.get()) + " at the top level are not supported");
+        }
+    }
+
+    for (Record& record : records_) {
+        for (FieldDeclaration* field : record.fieldDecls) {
+            if (!field->typeNode) fail(field, "field " + field->name->name + " needs a type");
+            record.fields.emplace_back(field->name->name, resolve(field->typeNode.get(), record.name));
+        }
+    }
+    for (auto& [decl, owner] : functions) {
+        if (!owner.empty() && !recordsByName_.count(owner)) fail(decl, "impl of unknown type " + owner);
+        addFunction(decl, owner);
+    }
+}
+
+void LlvmIrEmitter::addFunction(FunctionDeclaration* decl, const std::string& owner) {
+    if (decl->isAsync) fail(decl, "async functions are not supported");
+    if (decl->throwsTypeNode) fail(decl, "functions that throw are not supported");
+    if (!decl->body) fail(decl, "function " + decl->id->name + " has no body");
+
+    Function fn;
+    fn.decl = decl;
+    fn.owner = owner;
+    const std::string& name = decl->id->name;
+    fn.symbol = owner.empty() ? "@vyn." + name : "@" + owner + "." + name;
+    for (size_t i = 0; i < decl->params.size(); ++i) {
+        const FunctionParameter& param = decl->params[i];
+        if (i == 0 && !owner.empty() && param.name->name == "self") {
+            fn.hasSelf = true;
+            continue;
+        }
+        if (!param.typeNode) fail(decl, "parameter " + param.name->name + " needs a type");
+        Type type = resolve(param.typeNode.get(), owner);
+        if (type.kind == Kind::ARRAY) fail(decl, "arrays are passed inside a struct, not by value");
+        fn.params.push_back(std::move(type));
+    }
+    fn.result = decl->returnTypeNode ? resolve(decl->returnTypeNode.get(), owner) : make(Kind::VOID);
+    if (fn.result.kind == Kind::ARRAY) fail(decl, "arrays are returned inside a struct, not by value");
+
+    auto& table = owner.empty() ? functionsByName_ : methods_;
+    std::string key = owner.empty() ? name : owner + "." + name;
+    if (!table.emplace(key, functions_.size()).second) fail(decl, "duplicate function " + key);
+    functions_.push_back(std::move(fn));
+}
+
+Type LlvmIrEmitter::resolve(TypeNode* node, const std::string& self) {
+    switch (node->category) {
+        case TypeNode::TypeCategory::IDENTIFIER: {
+            if (!node->genericArguments.empty()) fail(node, "generic type " + node->toString() + " is not supported");
+            if (node->isOptional) fail(node, "optional types are not supported");
+            const std::string& name = node->name->name;
+            if (name == "Int" || name == "i64") return make(Kind::INT);
+            if (name == "UInt" || name == "u64") return make(Kind::UINT);
+            if (name == "i32") return make(Kind::I32);
+            if (name == "u32") return make(Kind::U32);
+            if (name == "Float" || name == "f64") return make(Kind::FLOAT);
+            if (name == "f32") return make(Kind::F32);
+            if (name == "Bool") return make(Kind::BOOL);
+            if (name == "String") return make(Kind::STRING);
+            Type type = make(Kind::STRUCT);
+            if (name == "Self" && !self.empty()) {
+                type.name = self;
+            } else if (recordsByName_.count(name)) {
+                type.name = name;
+            } else {
+                fail(node, "unknown type " + name);
+            }
+            return type;
+        }
+        case TypeNode::TypeCategory::OWNERSHIP_WRAPPED: {
+            Type pointee = resolve(node->wrappedType.get(), self);
+            if (pointee.kind != Kind::STRUCT) fail(node, node->toString() + " must point to a struct");
+            switch (node->ownership) {
+                case OwnershipKind::THEIR:
+                    return wrap(Kind::BORROWED, pointee);
+                case OwnershipKind::PTR:
+                    return wrap(Kind::POINTER, pointee);
+                case OwnershipKind::MY:
+                    fail(node, "my<T> needs drop lowering and is not supported yet; use the C backend");
+                case OwnershipKind::OUR:
+                    fail(node, "our<T> needs the reference-counting runtime and is not supported");
+            }
+            break;
+        }
+        case TypeNode::TypeCategory::ARRAY:
+            if (!node->arraySizeExpression) fail(node, "slices are not supported; use a fixed array [T; N]");
+            return wrap(Kind::ARRAY, resolve(node->arrayElementType.get(), self),
+                        constant(node->arraySizeExpression.get()));
+        default:
+            break;
+    }
+    fail(node, "type " + node->toString() + " is not supported");
+}
+
+// Structs in an order where everything a struct embeds by value comes first
+std::vector<size_t> LlvmIrEmitter::orderRecords() {
+    std::vector<size_t> order;
+    std::vector<int> state(records_.size(), 0); // 0 new, 1 in progress, 2 done
+    std::function<void(size_t)> visit = [&](size_t index) {
+        if (state[index] == 2) return;
+        Record& record = records_[index];
+        if (state[index] == 1) {
+            fail(record.decl, "struct " + record.name + " contains itself by value; use their<" + record.name + ">");
+        }
+        state[index] = 1;
+        for (auto& [name, type] : record.fields) {
+            const Type* inner = &type;
+            while (inner->kind == Kind::ARRAY) inner = inner->element.get();
+            if (inner->kind == Kind::STRUCT) visit(recordsByName_.at(inner->name));
+        }
+        state[index] = 2;
+        order.push_back(index);
+    };
+    for (size_t i = 0; i < records_.size(); ++i) visit(i);
+    return order;
+}
+
+const LlvmIrEmitter::Function* LlvmIrEmitter::method(const std::string& type, const std::string& name) const {
+    auto it = methods_.find(type + "." + name);
+    return it == methods_.end() ? nullptr : &functions_[it->second];
+}
+
+std::string LlvmIrEmitter::ltype(const Type& type) const {
+    switch (type.kind) {
+        case Kind::VOID: return "void";
+        case Kind::INT:
+        case Kind::UINT: return "i64";
+        case Kind::I32:
+        case Kind::U32: return "i32";
+        case Kind::FLOAT: return "double";
+        case Kind::F32: return "float";
+        case Kind::BOOL: return "i1";
+        case Kind::STRUCT: return "%struct." + type.name;
+        case Kind::ARRAY: return "[" + std::to_string(type.length) + " x " + ltype(*type.element) + "]";
+        case Kind::NIL:
+        case Kind::STRING:
+        case Kind::BORROWED:
+        case Kind::POINTER: return "ptr";
+    }
+    return "void";
+}
+
+bool LlvmIrEmitter::holdsPointer(const Type& type) const {
+    switch (type.kind) {
+        case Kind::BORROWED:
+        case Kind::POINTER: return true;
+        case Kind::STRUCT:
+            for (auto& [name, field] : record(type.name).fields) {
+                if (holdsPointer(field)) return true;
+            }
+            return false;
+        case Kind::ARRAY: return holdsPointer(*type.element);
+        default: return false;
+    }
+}
+
+// The borrow parameter that may be `noalias`, counting self as parameter
+// 0, or -1. The borrow rules do not keep f(p, p) apart, so a borrow is only
+// exclusive when it is the one parameter holding a pointer and its struct
+// holds none, leaving no other path to the pointee
+int LlvmIrEmitter::noaliasParam(const Function& fn) const {
+    int found = -1;
+    size_t holders = 0;
+    size_t index = 0;
+    for (size_t i = 0; i < fn.decl->params.size(); ++i) {
+        Type type;
+        if (fn.hasSelf && i == 0) {
+            Type self = make(Kind::STRUCT);
+            self.name = fn.owner;
+            type = wrap(Kind::BORROWED, self);
+        } else {
+            type = fn.params[index++];
+        }
+        if (!holdsPointer(type)) continue;
+        ++holders;
+        if (type.kind == Kind::BORROWED && !holdsPointer(*type.element)) found = static_cast<int>(i);
+    }
+    return holders == 1 ? found : -1;
+}
+
+// Structs go in by value as `byval` pointers and come back through `sret`
+std::string LlvmIrEmitter::signature(const Function& fn) const {
+    std::vector<std::string> params;
+    if (fn.result.kind == Kind::STRUCT) params.push_back("ptr noalias sret(" + ltype(fn.result) + ") %result");
+    int noalias = noaliasParam(fn);
+    size_t index = 0;
+    for (const FunctionParameter& param : fn.decl->params) {
+        bool exclusive = &param - fn.decl->params.data() == noalias;
+        if (fn.hasSelf && &param == &fn.decl->params.front()) {
+            params.push_back(exclusive ? "ptr noalias %self" : "ptr %self");
+            continue;
+        }
+        const Type& type = fn.params[index++];
+        std::string name = " %" + param.name->name + ".arg";
+        if (type.kind == Kind::STRUCT) {
+            params.push_back("ptr byval(" + ltype(type) + ")" + name);
+        } else if (exclusive) {
+            params.push_back("ptr noalias" + name);
+        } else {
+            params.push_back(ltype(type) + name);
+        }
+    }
+    std::string result = fn.result.kind == Kind::STRUCT ? "void" : ltype(fn.result);
+    return result + " " + fn.symbol + "(" + join(params) + ")";
+}
+
+std::string LlvmIrEmitter::global(const std::string& text) {
+    auto it = strings_.find(text);
+    if (it != strings_.end()) return it->second;
+    std::string name = "@.str." + std::to_string(strings_.size());
+    globals_ += name + " = private unnamed_addr constant [" + std::to_string(text.size() + 1) + " x i8] c\"" +
+                escape(text) + "\\00\"\n";
+    strings_.emplace(text, name);
+    return name;
+}
+
+// --- Emission ---
+
+std::string LlvmIrEmitter::temp() { return "%t" + std::to_string(temps_++); }
+
+std::string LlvmIrEmitter::label(const std::string& kind) { return kind + std::to_string(labels_++); }
+
+// Allocas all go in the entry block, where mem2reg and SROA look for them
+std::string LlvmIrEmitter::stackSlot(const Type& type, const std::string& name) {
+    std::string address;
+    if (name.empty()) {
+        address = temp();
+    } else {
+        size_t count = names_[name]++;
+        address = "%" + name + ".addr" + (count ? std::to_string(count) : "");
+    }
+    allocas_ += "  " + address + " = alloca " + ltype(type) + "\n";
+    ++report_.allocas;
+    return address;
+}
+
+// Code after a return, break or continue goes in a block nothing reaches
+void LlvmIrEmitter::open() {
+    if (terminated_) begin(label("dead"));
+}
+
+void LlvmIrEmitter::instr(const std::string& text) {
+    open();
+    body_ += "  " + text + "\n";
+}
+
+void LlvmIrEmitter::terminate(const std::string& text) {
+    instr(text);
+    terminated_ = true;
+}
+
+// Starts a block; the current one falls through into it
+void LlvmIrEmitter::begin(const std::string& label) {
+    if (!terminated_) body_ += "  br label %" + label + "\n";
+    body_ += label + ":\n";
+    block_ = label;
+    terminated_ = false;
+}
+
+void LlvmIrEmitter::emitFunction(const Function& fn) {
+    current_ = &fn;
+    scopes_.assign(1, {});
+    loops_.clear();
+    names_.clear();
+    allocas_.clear();
+    body_.clear();
+    block_ = "entry";
+    terminated_ = false;
+    boundsFail_ = false;
+    divisionFail_ = false;
+    temps_ = 0;
+    labels_ = 0;
+
+    size_t index = 0;
+    for (const FunctionParameter& param : fn.decl->params) {
+        if (fn.hasSelf && &param == &fn.decl->params.front()) {
+            Type self = make(Kind::STRUCT);
+            self.name = fn.owner;
+            Type type = wrap(Kind::BORROWED, self);
+            std::string address = stackSlot(type, "self");
+            instr("store ptr %self, ptr " + address);
+            declareVariable("self", type, address);
+            continue;
+        }
+        const Type& type = fn.params[index++];
+        const std::string& name = param.name->name;
+        if (type.kind == Kind::STRUCT) { // the byval copy is the variable
+            declareVariable(name, type, "%" + name + ".arg");
+            continue;
+        }
+        std::string address = stackSlot(type, name);
+        instr("store " + ltype(type) + " %" + name + ".arg, ptr " + address);
+        declareVariable(name, type, address);
+    }
+    if (noaliasParam(fn) >= 0) ++report_.noaliasParams;
+    for (auto& stmt : fn.decl->body->body) emitStatement(stmt.get());
+    if (!terminated_) {
+        emitCleanups(fn.decl->body->exitCleanups);
+        // Falling off the end of a function with a result returns its zero
+        // value, as in the bytecode tier
+        if (fn.result.kind == Kind::STRUCT) instr("store " + ltype(fn.result) + " zeroinitializer, ptr %result");
+        bool returns_void = fn.result.kind == Kind::VOID || fn.result.kind == Kind::STRUCT;
+        terminate(returns_void ? "ret void" : "ret " + ltype(fn.result) + " zeroinitializer");
+    }
+    if (boundsFail_) body_ += "bounds.fail:\n  call void @vyn.bounds_fail()\n  unreachable\n";
+    if (divisionFail_) body_ += "division.fail:\n  call void @vyn.division_fail()\n  unreachable\n";
+    scopes_.clear();
+}
+
+void LlvmIrEmitter::emitBlock(BlockStatement* node) {
+    scopes_.emplace_back();
+    for (auto& stmt : node->body) emitStatement(stmt.get());
+    if (!ends_in_jump(node->body)) emitCleanups(node->exitCleanups);
+    scopes_.pop_back();
+}
+
+// The body of an if or else, which need not be a block
+void LlvmIrEmitter::emitBody(Statement* node) {
+    if (node->getType() == NodeType::BLOCK_STATEMENT) {
+        emitBlock(static_cast<BlockStatement*>(node));
+        return;
+    }
+    scopes_.emplace_back();
+    emitStatement(node);
+    scopes_.pop_back();
+}
+
+void LlvmIrEmitter::emitCleanups(const CleanupList& cleanups) {
+    for (Statement* cleanup : cleanups) emitBody(cleanup);
+}
+
+void LlvmIrEmitter::declareVariable(const std::string& name, const Type& type, const std::string& address) {
+    scopes_.back()[name] = Variable{type, address};
+}
+
+const LlvmIrEmitter::Variable* LlvmIrEmitter::lookup(const std::string& name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) return &it->second;
+    }
+    return nullptr;
+}
+
+void LlvmIrEmitter::emitStatement(Statement* node) {
+    switch (node->getType()) {
+        case NodeType::VARIABLE_DECLARATION: {
+            auto* decl = static_cast<VariableDeclaration*>(node);
+            const std::string& name = decl->id->name;
+            if (decl->typeNode) {
+                Type type = resolve(decl->typeNode.get(), current_->owner);
+                std::string address = stackSlot(type, name);
+                if (decl->init) {
+                    emitInto(decl->init.get(), address, type);
+                } else {
+                    instr("store " + ltype(type) + " zeroinitializer, ptr " + address);
+                }
+                declareVariable(name, type, address);
+                break;
+            }
+            if (!decl->init) fail(node, name + " needs a type or an initializer");
+            Value init = emitExpression(decl->init.get());
+            if (init.type.kind == Kind::VOID || init.type.kind == Kind::NIL) fail(node, name + " needs a type");
+            if (is_aggregate(init.type) && !init.lvalue) { // the temporary becomes the variable
+                declareVariable(name, init.type, init.code);
+                break;
+            }
+            std::string address = stackSlot(init.type, name);
+            store(init, address, init.type, node);
+            declareVariable(name, init.type, address);
+            break;
+        }
+        case NodeType::EXPRESSION_STATEMENT: {
+            Expression* expr = static_cast<ExpressionStatement*>(node)->expression.get();
+            if (expr->getType() == NodeType::ASSIGNMENT_EXPRESSION) {
+                auto* assign = static_cast<AssignmentExpression*>(expr);
+                Value left = emitExpression(assign->left.get());
+                if (!left.lvalue) fail(node, "cannot assign to " + assign->left->toString());
+                if (left.type.kind == Kind::ARRAY) fail(node, "arrays cannot be assigned; assign their elements");
+                Value right = emitExpression(assign->right.get());
+                if (left.type.kind == Kind::STRUCT) {
+                    if (right.type.kind != Kind::STRUCT || right.type.name != left.type.name) {
+                        fail(node, "cannot assign " + type_name(right.type) + " to " + type_name(left.type));
+                    }
+                    // Source and destination may be the same struct
+                    instr("call void @llvm.memmove.p0.p0.i64(ptr " + left.code + ", ptr " + right.code + ", i64 " +
+                          size_of(ltype(left.type)) + ", i1 false)");
+                } else {
+                    store(right, left.code, left.type, node);
+                }
+                break;
+            }
+            emitExpression(expr);
+            break;
+        }
+        case NodeType::BLOCK_STATEMENT:
+            emitBlock(static_cast<BlockStatement*>(node));
+            break;
+        case NodeType::SCOPED_STATEMENT: // regions only matter to the VRE allocator
+            emitBlock(static_cast<ScopedStatement*>(node)->body.get());
+            break;
+        case NodeType::DEFER_STATEMENT: // inlined at each exit through the cleanup lists
+            break;
+        case NodeType::IF_STATEMENT:
+            emitIf(static_cast<IfStatement*>(node));
+            break;
+        case NodeType::WHILE_STATEMENT: {
+            auto* loop = static_cast<WhileStatement*>(node);
+            if (loop->body->getType() != NodeType::BLOCK_STATEMENT) fail(node, "loop bodies must be blocks");
+            std::string cond = label("while.cond");
+            std::string body = label("while.body");
+            std::string exit = label("while.end");
+            begin(cond);
+            std::string test = convert(emitExpression(loop->test.get()), make(Kind::BOOL), loop->test.get());
+            terminate("br i1 " + test + ", label %" + body + ", label %" + exit);
+            begin(body);
+            loops_.push_back(Loop{cond, exit});
+            emitBlock(static_cast<BlockStatement*>(loop->body.get()));
+            loops_.pop_back();
+            if (!terminated_) terminate("br label %" + cond);
+            begin(exit);
+            break;
+        }
+        case NodeType::FOR_STATEMENT:
+            emitFor(static_cast<ForStatement*>(node));
+            break;
+        case NodeType::RETURN_STATEMENT:
+            emitReturn(static_cast<ReturnStatement*>(node));
+            break;
+        case NodeType::BREAK_STATEMENT:
+        case NodeType::CONTINUE_STATEMENT: {
+            bool is_break = node->getType() == NodeType::BREAK_STATEMENT;
+            if (loops_.empty()) fail(node, std::string(is_break ? "break" : "continue") + " outside a loop");
+            emitCleanups(is_break ? static_cast<BreakStatement*>(node)->cleanups
+                                  : static_cast<ContinueStatement*>(node)->cleanups);
+            terminate("br label %" + (is_break ? loops_.back().exit : loops_.back().next));
+            break;
+        }
+        default:
+            fail(node, describe(node) + " is not supported");
+    }
+}
+
+void LlvmIrEmitter::emitIf(IfStatement* node) {
+    if (emitSwitch(node)) return;
+    std::string test = convert(emitExpression(node->test.get()), make(Kind::BOOL), node->test.get());
+    std::string then = label("if.then");
+    std::string end = label("if.end");
+    std::string otherwise = node->alternate ? label("if.else") : end;
+    terminate("br i1 " + test + ", label %" + then + ", label %" + otherwise);
+    begin(then);
+    emitBody(node->consequent.get());
+    if (node->alternate) {
+        if (!terminated_) terminate("br label %" + end);
+        begin(otherwise);
+        emitBody(node->alternate.get());
+    }
+    begin(end);
+}
+
+// `if (x == 1) {...} else if (x == 2) {...} else {...}` over one integer
+// variable and distinct constants is a switch. The tests only read x, so
+// reading it once up front changes nothing. The chain ends at the first
+// test of another shape, which becomes the default.
+bool LlvmIrEmitter::emitSwitch(IfStatement* node) {
+    std::string name;
+    std::vector<std::pair<int64_t, Statement*>> cases;
+    Statement* otherwise = nullptr;
+    std::unordered_set<int64_t> seen;
+    const Variable* var = nullptr;
+    for (IfStatement* branch = node; branch;) {
+        auto* test = dynamic_cast<BinaryExpression*>(branch->test.get());
+        Identifier* id = nullptr;
+        int64_t value = 0;
+        if (test && test->op.type == TokenType::EQEQ) {
+            id = dynamic_cast<Identifier*>(test->left.get());
+            if (!id || !case_value(test->right.get(), value)) {
+                id = dynamic_cast<Identifier*>(test->right.get());
+                if (!id || !case_value(test->left.get(), value)) id = nullptr;
+            }
+        }
+        if (id && cases.empty()) {
+            name = id->name;
+            var = lookup(name);
+            if (!var || !is_integer(var->type)) return false;
+        }
+        if (!id || id->name != name || !fits(value, var->type) || !seen.insert(value).second) {
+            if (cases.size() < 2) return false;
+            otherwise = branch;
+            break;
+        }
+        cases.emplace_back(value, branch->consequent.get());
+        Statement* alternate = branch->alternate.get();
+        branch = dynamic_cast<IfStatement*>(alternate);
+        if (!branch) otherwise = alternate;
+    }
+    if (cases.size() < 2) return false;
+
+    std::string type = ltype(var->type);
+    std::string scrutinee = rvalue(Value{var->address, var->type, true});
+    std::string end = label("sw.end");
+    std::string fallback = otherwise ? label("sw.default") : end;
+    std::vector<std::string> targets;
+    std::string text = "switch " + type + " " + scrutinee + ", label %" + fallback + " [";
+    for (auto& [value, body] : cases) {
+        targets.push_back(label("sw.case"));
+        text += "\n    " + type + " " + std::to_string(value) + ", label %" + targets.back();
+    }
+    terminate(text + "\n  ]");
+    for (size_t i = 0; i < cases.size(); ++i) {
+        begin(targets[i]);
+        emitBody(cases[i].second);
+        if (!terminated_) terminate("br label %" + end);
+    }
+    if (otherwise) {
+        begin(fallback);
+        emitBody(otherwise);
+    }
+    begin(end);
+    ++report_.switches;
+    return true;
+}
+
+void LlvmIrEmitter::emitFor(ForStatement* node) {
+    auto* induction = dynamic_cast<Identifier*>(node->init.get());
+    auto* range = dynamic_cast<BinaryExpression*>(node->test.get());
+    if (!induction || !range || range->op.type != TokenType::DOTDOT || !node->body ||
+        node->body->getType() != NodeType::BLOCK_STATEMENT) {
+        fail(node, "only `for (i in a..b) { ... }` loops are supported");
+    }
+    Value low = emitExpression(range->left.get());
+    Value high = emitExpression(range->right.get());
+    if (!is_integer(low.type) || !is_integer(high.type)) fail(node, "ranges must be over integers");
+    Type type = low.literal ? high.type : low.type;
+    if (!node->hoistedBoundsChecks.empty()) {
+        // The bound is the range's, evaluated once above. A loop that runs no
+        // iterations indexes nothing, so it checks 0 instead.
+        std::string bound = convert(high, make(Kind::INT), range);
+        std::string empty = temp();
+        instr(empty + " = icmp sle i64 " + bound + ", " + convert(low, make(Kind::INT), range));
+        std::string checked = temp();
+        instr(checked + " = select i1 " + empty + ", i64 0, i64 " + bound);
+        for (const HoistedBoundsCheck& check : node->hoistedBoundsChecks) {
+            const Variable* array = lookup(check.slice);
+            if (!array || array->type.kind != Kind::ARRAY) fail(node, "hoisted bounds check on " + check.slice);
+            if (check.bound != range->right.get()) fail(node, "hoisted bounds check is not on the loop's bound");
+            emitBoundsCheck(checked, array->type.length, true);
+        }
+    }
+    std::string address = stackSlot(type, induction->name);
+    instr("store " + ltype(type) + " " + convert(low, type, range) + ", ptr " + address);
+    std::string end = convert(high, type, range);
+
+    std::string cond = label("for.cond");
+    std::string body = label("for.body");
+    std::string step = label("for.step");
+    std::string exit = label("for.end");
+    std::string t = ltype(type);
+    begin(cond);
+    std::string current = temp();
+    instr(current + " = load " + t + ", ptr " + address);
+    std::string more = temp();
+    instr(more + " = icmp " + (is_signed(type) ? "slt " : "ult ") + t + " " + current + ", " + end);
+    terminate("br i1 " + more + ", label %" + body + ", label %" + exit);
+
+    begin(body);
+    scopes_.emplace_back();
+    declareVariable(induction->name, type, address);
+    loops_.push_back(Loop{step, exit});
+    emitBlock(static_cast<BlockStatement*>(node->body.get()));
+    loops_.pop_back();
+    scopes_.pop_back();
+
+    // i < end before the step, so i + 1 cannot overflow
+    begin(step);
+    std::string before = temp();
+    instr(before + " = load " + t + ", ptr " + address);
+    std::string after = temp();
+    instr(after + " = add " + (is_signed(type) ? "nsw " : "nuw ") + t + " " + before + ", 1");
+    instr("store " + t + " " + after + ", ptr " + address);
+    terminate("br label %" + cond);
+    begin(exit);
+}
+
+void LlvmIrEmitter::emitReturn(ReturnStatement* node) {
+    const Type& result = current_->result;
+    if (!node->argument) {
+        if (result.kind != Kind::VOID) fail(node, "missing return value");
+        emitCleanups(node->cleanups);
+        terminate("ret void");
+        return;
+    }
+    if (result.kind == Kind::VOID) fail(node, current_->decl->id->name + " returns nothing");
+    if (result.kind == Kind::STRUCT) {
+        emitInto(node->argument.get(), "%result", result);
+        emitCleanups(node->cleanups);
+        terminate("ret void");
+        return;
+    }
+    std::string value = convert(emitExpression(node->argument.get()), result, node);
+    emitCleanups(node->cleanups);
+    terminate("ret " + ltype(result) + " " + value);
+}
+
+// Branches to the function's cold bounds.fail block unless index < length
+// (index <= length when `inclusive`). Negative indices compare as huge.
+void LlvmIrEmitter::emitBoundsCheck(const std::string& index, int64_t length, bool inclusive) {
+    std::string ok = temp();
+    instr(ok + " = icmp " + (inclusive ? "ule" : "ult") + " i64 " + index + ", " + std::to_string(length));
+    std::string next = label("bounds.ok");
+    terminate("br i1 " + ok + ", label %" + next + ", label %bounds.fail");
+    begin(next);
+    boundsFail_ = true;
+}
+
+// Branches to the function's cold division.fail block if the divisor is
+// zero, and returns the divisor to use: a signed MIN / -1, poison for sdiv
+// and srem, divides by 1 instead, giving MIN and 0 as in the other tiers
+std::string LlvmIrEmitter::emitDivisor(const std::string& dividend, const std::string& divisor, const Type& type) {
+    std::string t = ltype(type);
+    std::string zero = temp();
+    instr(zero + " = icmp eq " + t + " " + divisor + ", 0");
+    std::string next = label("division.ok");
+    terminate("br i1 " + zero + ", label %division.fail, label %" + next);
+    begin(next);
+    divisionFail_ = true;
+    if (!is_signed(type)) return divisor;
+    std::string minimum = temp();
+    instr(minimum + " = icmp eq " + t + " " + dividend + ", " +
+          (bits(type) == 64 ? "-9223372036854775808" : "-2147483648"));
+    std::string negative = temp();
+    instr(negative + " = icmp eq " + t + " " + divisor + ", -1");
+    std::string overflow = temp();
+    instr(overflow + " = and i1 " + minimum + ", " + negative);
+    std::string safe = temp();
+    instr(safe + " = select i1 " + overflow + ", " + t + " 1, " + t + " " + divisor);
+    return safe;
+}
+
+// --- Expressions ---
+
+std::string LlvmIrEmitter::rvalue(const Value& value) {
+    if (is_aggregate(value.type)) throw std::runtime_error("LLVM IR: a " + type_name(value.type) + " is not a scalar");
+    if (value.type.kind == Kind::VOID) throw std::runtime_error("LLVM IR: a call returning nothing has no value");
+    if (!value.lvalue) return value.code;
+    std::string result = temp();
+    instr(result + " = load " + ltype(value.type) + ", ptr " + value.code);
+    return result;
+}
+
+std::string LlvmIrEmitter::convert(const Value& value, const Type& to, Node* node) {
+    const Type& from = value.type;
+    if (is_aggregate(from) || is_aggregate(to)) fail(node, "cannot use " + type_name(from) + " as " + type_name(to));
+    std::string code = rvalue(value);
+    std::string result;
+    auto cast = [&](const char* op) {
+        result = temp();
+        instr(result + " = " + op + " " + ltype(from) + " " + code + " to " + ltype(to));
+        return result;
+    };
+    if (from.kind == Kind::NIL) {
+        if (is_pointer(to) || to.kind == Kind::STRING || to.kind == Kind::NIL) return "null";
+    } else if (is_pointer(from) && is_pointer(to)) {
+        if (from.element->name == to.element->name) return code;
+    } else if (from.kind == to.kind) {
+        return code;
+    } else if (is_integer(from) && is_integer(to)) {
+        if (value.literal) {
+            if (!fits(std::stoll(code), to)) fail(node, code + " does not fit in " + type_name(to));
+            return code;
+        }
+        if (bits(from) == bits(to)) return code;
+        return cast(bits(from) > bits(to) ? "trunc" : is_signed(from) ? "sext" : "zext");
+    } else if (is_integer(from) && is_float(to)) {
+        if (value.literal) return float_literal(static_cast<double>(std::stoll(code)), to.kind == Kind::F32);
+        return cast(is_signed(from) ? "sitofp" : "uitofp");
+    } else if (is_float(from) && is_float(to)) {
+        return cast(from.kind == Kind::F32 ? "fpext" : "fptrunc");
+    } else if (is_float(from) && is_integer(to)) {
+        return cast(is_signed(to) ? "fptosi" : "fptoui");
+    }
+    fail(node, "cannot use " + type_name(from) + " as " + type_name(to));
+}
+
+void LlvmIrEmitter::store(const Value& value, const std::string& address, const Type& type, Node* node) {
+    if (!is_aggregate(type)) {
+        instr("store " + ltype(type) + " " + convert(value, type, node) + ", ptr " + address);
+        return;
+    }
+    if (ltype(value.type) != ltype(type)) fail(node, "cannot use " + type_name(value.type) + " as " + type_name(type));
+    copy(address, value.code, type);
+}
+
+void LlvmIrEmitter::copy(const std::string& to, const std::string& from, const Type& type) {
+    if (to == from) return;
+    instr("call void @llvm.memcpy.p0.p0.i64(ptr " + to + ", ptr " + from + ", i64 " + size_of(ltype(type)) +
+          ", i1 false)");
+}
+
+// Evaluates an initializer straight into fresh storage: array and struct
+// literals element by element, struct results through sret
+void LlvmIrEmitter::emitInto(Expression* node, const std::string& address, const Type& type) {
+    if (node->getType() == NodeType::ARRAY_LITERAL_NODE) {
+        auto* literal = static_cast<ArrayLiteralNode*>(node);
+        if (type.kind != Kind::ARRAY) fail(node, "an array literal cannot initialize a " + type_name(type));
+        if (static_cast<int64_t>(literal->elements.size()) > type.length) {
+            fail(node, "too many elements for " + type_name(type));
+        }
+        if (static_cast<int64_t>(literal->elements.size()) < type.length) {
+            instr("store " + ltype(type) + " zeroinitializer, ptr " + address);
+        }
+        for (size_t i = 0; i < literal->elements.size(); ++i) {
+            std::string element = temp();
+            instr(element + " = getelementptr inbounds " + ltype(type) + ", ptr " + address + ", i64 0, i64 " +
+                  std::to_string(i));
+            emitInto(literal->elements[i].get(), element, *type.element);
+        }
+        return;
+    }
+    if (node->getType() == NodeType::CALL_EXPRESSION) {
+        auto* call = static_cast<CallExpression*>(node);
+        auto* callee = dynamic_cast<Identifier*>(call->callee.get());
+        auto found = callee ? recordsByName_.find(callee->name) : recordsByName_.end();
+        if (found != recordsByName_.end() && call->arguments.size() == 1 &&
+            call->arguments[0]->getType() == NodeType::OBJECT_LITERAL_NODE) {
+            const Record& record = records_[found->second];
+            if (type.kind != Kind::STRUCT || type.name != record.name) {
+                fail(node, "cannot use " + record.name + " as " + type_name(type));
+            }
+            auto& properties = static_cast<ObjectLiteral*>(call->arguments[0].get())->properties;
+            std::unordered_set<std::string> given;
+            for (ObjectProperty& property : properties) given.insert(property.key->name);
+            if (given.size() < record.fields.size()) instr("store " + ltype(type) + " zeroinitializer, ptr " + address);
+            for (ObjectProperty& property : properties) {
+                size_t index = 0;
+                while (index < record.fields.size() && record.fields[index].first != property.key->name) ++index;
+                if (index == record.fields.size()) fail(node, record.name + " has no field " + property.key->name);
+                std::string field = temp();
+                instr(field + " = getelementptr inbounds " + ltype(type) + ", ptr " + address + ", i32 0, i32 " +
+                      std::to_string(index));
+                emitInto(property.value.get(), field, record.fields[index].second);
+            }
+            return;
+        }
+        if (type.kind == Kind::STRUCT) {
+            Value value = emitCall(call, &address);
+            if (value.code == address) {
+                if (value.type.name != type.name) fail(node, "cannot use " + type_name(value.type) + " as " + type.name);
+                return;
+            }
+            store(value, address, type, node);
+            return;
+        }
+    }
+    store(emitExpression(node), address, type, node);
+}
+
+LlvmIrEmitter::Value LlvmIrEmitter::emitExpression(Expression* node) {
+    switch (node->getType()) {
+        case NodeType::IDENTIFIER: {
+            const std::string& name = static_cast<Identifier*>(node)->name;
+            if (const Variable* var = lookup(name)) return Value{var->address, var->type, true};
+            if (functionsByName_.count(name)) fail(node, "functions are not values");
+            fail(node, "unknown name " + name);
+        }
+        case NodeType::INTEGER_LITERAL:
+            return Value{std::to_string(static_cast<IntegerLiteral*>(node)->value), make(Kind::INT), false, true};
+        case NodeType::FLOAT_LITERAL:
+            return Value{float_literal(static_cast<FloatLiteral*>(node)->value, false), make(Kind::FLOAT)};
+        case NodeType::BOOLEAN_LITERAL:
+            return Value{static_cast<BooleanLiteral*>(node)->value ? "true" : "false", make(Kind::BOOL)};
+        case NodeType::STRING_LITERAL:
+            return Value{global(static_cast<StringLiteral*>(node)->value), make(Kind::STRING)};
+        case NodeType::NIL_LITERAL:
+            return Value{"null", make(Kind::NIL)};
+        case NodeType::UNARY_EXPRESSION: {
+            auto* unary = static_cast<UnaryExpression*>(node);
+            Value operand = emitExpression(unary->operand.get());
+            switch (unary->op.type) {
+                case TokenType::BANG: {
+                    std::string value = convert(operand, make(Kind::BOOL), node);
+                    std::string result = temp();
+                    instr(result + " = xor i1 " + value + ", true");
+                    return Value{result, make(Kind::BOOL)};
+                }
+                case TokenType::MINUS: {
+                    if (operand.literal) {
+                        operand.code = operand.code[0] == '-' ? operand.code.substr(1) : "-" + operand.code;
+                        return operand;
+                    }
+                    std::string value = rvalue(operand);
+                    std::string result = temp();
+                    if (is_integer(operand.type)) {
+                        instr(result + " = sub " + ltype(operand.type) + " 0, " + value);
+                    } else if (is_float(operand.type)) {
+                        instr(result + " = fneg " + ltype(operand.type) + " " + value);
+                    } else {
+                        fail(node, "unary - needs a number");
+                    }
+                    return Value{result, operand.type};
+                }
+                case TokenType::PLUS:
+                    if (!is_integer(operand.type) && !is_float(operand.type)) fail(node, "unary + needs a number");
+                    if (operand.literal) return operand;
+                    return Value{rvalue(operand), operand.type};
+                default:
+                    fail(node, "unsupported operator " + unary->op.lexeme);
+            }
+        }
+        case NodeType::BINARY_EXPRESSION:
+            return emitBinary(static_cast<BinaryExpression*>(node));
+        case NodeType::CALL_EXPRESSION:
+            return emitCall(static_cast<CallExpression*>(node));
+        case NodeType::MEMBER_EXPRESSION:
+            return emitMember(static_cast<MemberExpression*>(node));
+        case NodeType::ASSIGNMENT_EXPRESSION: {
+            auto* assign = static_cast<AssignmentExpression*>(node);
+            Value left = emitExpression(assign->left.get());
+            if (!left.lvalue || is_aggregate(left.type)) fail(node, "cannot assign to " + assign->left->toString());
+            std::string value = convert(emitExpression(assign->right.get()), left.type, node);
+            instr("store " + ltype(left.type) + " " + value + ", ptr " + left.code);
+            return Value{value, left.type};
+        }
+        case NodeType::BORROW_EXPRESSION_NODE: {
+            Value value = emitExpression(static_cast<BorrowExprNode*>(node)->expression.get());
+            if (value.type.kind == Kind::STRUCT) {
+                if (!value.lvalue) fail(node, "cannot borrow a temporary");
+                return Value{value.code, wrap(Kind::BORROWED, value.type)};
+            }
+            if (is_pointer(value.type)) return Value{rvalue(value), wrap(Kind::BORROWED, *value.type.element)};
+            fail(node, "only structs can be borrowed");
+        }
+        case NodeType::ARRAY_LITERAL_NODE:
+            return emitArrayLiteral(static_cast<ArrayLiteralNode*>(node));
+        default:
+            fail(node, describe(node) + " are not supported");
+    }
+}
+
+LlvmIrEmitter::Value LlvmIrEmitter::emitArrayLiteral(ArrayLiteralNode* node) {
+    if (node->elements.empty()) fail(node, "an empty array literal needs a type");
+    std::vector<Value> values;
+    for (auto& element : node->elements) {
+        Value value = emitExpression(element.get());
+        if (!is_aggregate(value.type) && value.lvalue) value = Value{rvalue(value), value.type};
+        values.push_back(std::move(value));
+    }
+    Type type = wrap(Kind::ARRAY, values.front().type, static_cast<int64_t>(values.size()));
+    std::string address = stackSlot(type);
+    for (size_t i = 0; i < values.size(); ++i) {
+        std::string element = temp();
+        instr(element + " = getelementptr inbounds " + ltype(type) + ", ptr " + address + ", i64 0, i64 " +
+              std::to_string(i));
+        store(values[i], element, *type.element, node->elements[i].get());
+    }
+    return Value{address, type, false};
+}
+
+// Both sides are brought to one type first: an integer literal takes the
+// other side's type, Float wins over f32 over integers, and 64-bit integers
+// over 32-bit ones
+LlvmIrEmitter::Value LlvmIrEmitter::emitBinary(BinaryExpression* node) {
+    TokenType op = node->op.type;
+    if (op == TokenType::AND || op == TokenType::OR) return emitLogical(node);
+    Value left = emitExpression(node->left.get());
+    if (left.lvalue && !is_aggregate(left.type)) { // read before the right side runs, which may store to it
+        left.code = rvalue(left);
+        left.lvalue = false;
+    }
+    Value right = emitExpression(node->right.get());
+    for (const Value* side : {&left, &right}) {
+        Kind kind = side->type.kind;
+        if (kind == Kind::STRUCT || kind == Kind::ARRAY || kind == Kind::STRING || kind == Kind::VOID) {
+            fail(node, "operator " + node->op.lexeme + " needs numbers, booleans or pointers");
+        }
+    }
+
+    Type type;
+    bool pointers = is_pointer(left.type) || is_pointer(right.type) || left.type.kind == Kind::NIL ||
+                    right.type.kind == Kind::NIL;
+    if (pointers) {
+        type = is_pointer(left.type) ? left.type : right.type;
+    } else if (left.type.kind == Kind::BOOL || right.type.kind == Kind::BOOL) {
+        type = make(Kind::BOOL);
+    } else if (left.type.kind == Kind::FLOAT || right.type.kind == Kind::FLOAT) {
+        type = make(Kind::FLOAT);
+    } else if (left.type.kind == Kind::F32 || right.type.kind == Kind::F32) {
+        type = make(Kind::F32);
+    } else if (left.literal) {
+        type = right.type;
+    } else if (right.literal || bits(left.type) >= bits(right.type)) {
+        type = left.type;
+    } else {
+        type = right.type;
+    }
+    if (pointers && op != TokenType::EQEQ && op != TokenType::NOTEQ) fail(node, "pointers can only be compared");
+    if (pointers && type.kind == Kind::NIL) fail(node, "cannot compare nil with nil");
+    std::string a = convert(left, type, node);
+    std::string b = convert(right, type, node);
+    std::string t = ltype(type);
+    std::string result = temp();
+
+    if (is_comparison(op)) {
+        if (is_float(type)) {
+            instr(result + " = fcmp " + float_compare(op) + " " + t + " " + a + ", " + b);
+        } else {
+            if ((pointers || type.kind == Kind::BOOL) && op != TokenType::EQEQ && op != TokenType::NOTEQ) {
+                fail(node, "operator " + node->op.lexeme + " needs numbers");
+            }
+            instr(result + " = icmp " + integer_compare(op, is_signed(type)) + " " + t + " " + a + ", " + b);
+        }
+        return Value{result, make(Kind::BOOL)};
+    }
+    const char* instruction = nullptr;
+    if (is_float(type)) {
+        instruction = float_operator(op);
+    } else if (type.kind == Kind::BOOL) {
+        if (op == TokenType::AMPERSAND || op == TokenType::PIPE || op == TokenType::CARET) {
+            instruction = integer_operator(op, false);
+        }
+    } else {
+        instruction = integer_operator(op, is_signed(type));
+    }
+    if (!instruction) fail(node, "operator " + node->op.lexeme + " is not supported on " + type_name(type));
+    if (is_integer(type) && (op == TokenType::DIVIDE || op == TokenType::MODULO)) {
+        b = emitDivisor(a, b, type);
+    } else if (is_integer(type) && (op == TokenType::LSHIFT || op == TokenType::RSHIFT)) {
+        // Shift counts are taken modulo the width; shl and ashr by more are poison
+        std::string count = temp();
+        instr(count + " = and " + t + " " + b + ", " + std::to_string(bits(type) - 1));
+        b = count;
+    }
+    instr(result + " = " + instruction + " " + t + " " + a + ", " + b);
+    return Value{result, type};
+}
+
+// && and || only evaluate the right side when they must
+LlvmIrEmitter::Value LlvmIrEmitter::emitLogical(BinaryExpression* node) {
+    bool is_and = node->op.type == TokenType::AND;
+    std::string left = convert(emitExpression(node->left.get()), make(Kind::BOOL), node->left.get());
+    open();
+    std::string from = block_;
+    std::string rhs = label(is_and ? "and.rhs" : "or.rhs");
+    std::string end = label(is_and ? "and.end" : "or.end");
+    terminate("br i1 " + left + ", label %" + (is_and ? rhs : end) + ", label %" + (is_and ? end : rhs));
+    begin(rhs);
+    std::string right = convert(emitExpression(node->right.get()), make(Kind::BOOL), node->right.get());
+    open();
+    std::string through = block_;
+    begin(end);
+    std::string result = temp();
+    instr(result + " = phi i1 [ " + (is_and ? "false" : "true") + ", %" + from + " ], [ " + right + ", %" + through +
+          " ]");
+    return Value{result, make(Kind::BOOL)};
+}
+
+LlvmIrEmitter::Value LlvmIrEmitter::emitMember(MemberExpression* node) {
+    if (node->computed) {
+        Value object = emitExpression(node->object.get());
+        if (object.type.kind != Kind::ARRAY) fail(node, "only fixed arrays can be indexed");
+        Value index = emitExpression(node->property.get());
+        if (!is_integer(index.type)) fail(node, "array indices must be integers");
+        bool constant_in_bounds = index.literal && std::stoll(index.code) >= 0 &&
+                                  std::stoll(index.code) < object.type.length;
+        std::string position = convert(index, make(Kind::INT), node);
+        if (node->boundsCheck == BoundsCheck::CHECKED && !constant_in_bounds) {
+            ++report_.boundsChecks;
+            emitBoundsCheck(position, object.type.length, false);
+        }
+        std::string element = temp();
+        instr(element + " = getelementptr inbounds " + ltype(object.type) + ", ptr " + object.code + ", i64 0, i64 " +
+              position);
+        const Type& type = *object.type.element;
+        return Value{element, type, !is_aggregate(type) || object.lvalue};
+    }
+    auto* field = dynamic_cast<Identifier*>(node->property.get());
+    if (!field) fail(node, "member names must be identifiers");
+    Value object = emitExpression(node->object.get());
+    if (object.type.kind == Kind::ARRAY && field->name == "length") {
+        return Value{std::to_string(object.type.length), make(Kind::INT), false, true};
+    }
+    const std::string* type = struct_of(object.type);
+    if (!type) fail(node, "." + field->name + " on a value that is not a struct");
+    const Record& owner = record(*type);
+    std::string base = is_pointer(object.type) ? rvalue(object) : object.code;
+    for (size_t i = 0; i < owner.fields.size(); ++i) {
+        if (owner.fields[i].first != field->name) continue;
+        std::string address = temp();
+        instr(address + " = getelementptr inbounds %struct." + *type + ", ptr " + base + ", i32 0, i32 " +
+              std::to_string(i));
+        const Type& fieldType = owner.fields[i].second;
+        return Value{address, fieldType, !is_aggregate(fieldType) || object.lvalue || is_pointer(object.type)};
+    }
+    fail(node, *type + " has no field " + field->name);
+}
+
+LlvmIrEmitter::Value LlvmIrEmitter::emitCall(CallExpression* node, const std::string* into) {
+    Expression* callee = node->callee.get();
+    if (callee->getType() == NodeType::IDENTIFIER) {
+        const std::string& name = static_cast<Identifier*>(callee)->name;
+        if (name == "make_my") fail(node, "my<T> needs drop lowering and is not supported yet; use the C backend");
+        if (name == "println" || name == "print") return emitPrint(node, name == "println");
+        if (name == "len" && node->arguments.size() == 1) {
+            Value value = emitExpression(node->arguments[0].get());
+            if (value.type.kind == Kind::ARRAY) {
+                return Value{std::to_string(value.type.length), make(Kind::INT), false, true};
+            }
+        }
+        auto record = recordsByName_.find(name);
+        if (record != recordsByName_.end() && node->arguments.size() == 1 &&
+            node->arguments[0]->getType() == NodeType::OBJECT_LITERAL_NODE) {
+            Type type = make(Kind::STRUCT);
+            type.name = name;
+            std::string address = stackSlot(type);
+            emitInto(node, address, type);
+            return Value{address, type, false};
+        }
+        auto fn = functionsByName_.find(name);
+        if (fn == functionsByName_.end()) fail(node, "unknown function " + name);
+        return emitInvoke(node, functions_[fn->second], {}, 0, into);
+    }
+
+    if (callee->getType() != NodeType::MEMBER_EXPRESSION || static_cast<MemberExpression*>(callee)->computed) {
+        fail(node, "only functions and methods can be called");
+    }
+    auto* member = static_cast<MemberExpression*>(callee);
+    auto* name = dynamic_cast<Identifier*>(member->property.get());
+    if (!name) fail(node, "method names must be identifiers");
+
+    auto self_pointer = [&](const Value& self) {
+        if (self.type.kind == Kind::STRUCT) return "ptr " + self.code;
+        if (!is_pointer(self.type)) fail(node, "self must be a struct");
+        return "ptr " + rvalue(self);
+    };
+
+    // Type::method(...) or Type.method(...)
+    if (auto* type = dynamic_cast<Identifier*>(member->object.get());
+        type && !lookup(type->name) && recordsByName_.count(type->name)) {
+        const Function* fn = method(type->name, name->name);
+        if (!fn) fail(node, type->name + " has no method " + name->name);
+        std::vector<std::string> args;
+        size_t first = 0;
+        if (fn->hasSelf) {
+            if (node->arguments.empty()) fail(node, type->name + "::" + name->name + " needs self");
+            args.push_back(self_pointer(emitExpression(node->arguments[0].get())));
+            first = 1;
+        }
+        return emitInvoke(node, *fn, std::move(args), first, into);
+    }
+
+    Value object = emitExpression(member->object.get());
+    if (object.type.kind == Kind::ARRAY && name->name == "len" && node->arguments.empty()) {
+        return Value{std::to_string(object.type.length), make(Kind::INT), false, true};
+    }
+    const std::string* type = struct_of(object.type);
+    const Function* fn = type ? method(*type, name->name) : nullptr;
+    if (!fn) fail(node, "no method " + name->name + " on " + member->object->toString());
+    if (!fn->hasSelf) fail(node, *type + "::" + name->name + " has no self; call it on the type");
+    return emitInvoke(node, *fn, {self_pointer(object)}, 0, into);
+}
+
+// Arguments from `first` on go to the declared parameters; a struct is
+// borrowed implicitly for a their<T> parameter. A struct result lands in
+// `into` when given, else in a temporary.
+LlvmIrEmitter::Value LlvmIrEmitter::emitInvoke(CallExpression* node, const Function& fn,
+                                               std::vector<std::string> args, size_t first, const std::string* into) {
+    if (node->arguments.size() - first != fn.params.size()) {
+        fail(node, fn.decl->id->name + " takes " + std::to_string(fn.params.size()) + " arguments");
+    }
+    for (size_t i = 0; i < fn.params.size(); ++i) {
+        Expression* arg = node->arguments[first + i].get();
+        const Type& param = fn.params[i];
+        Value value = emitExpression(arg);
+        if (is_pointer(param) && value.type.kind == Kind::STRUCT) {
+            if (!value.lvalue) fail(arg, "cannot borrow a temporary");
+            if (value.type.name != param.element->name) fail(arg, "cannot borrow " + type_name(value.type));
+            args.push_back("ptr " + value.code);
+        } else if (param.kind == Kind::STRUCT) {
+            if (value.type.kind != Kind::STRUCT || value.type.name != param.name) {
+                fail(arg, "cannot use " + type_name(value.type) + " as " + param.name);
+            }
+            args.push_back("ptr byval(" + ltype(param) + ") " + value.code);
+        } else {
+            args.push_back(ltype(param) + " " + convert(value, param, arg));
+        }
+    }
+    if (fn.result.kind == Kind::STRUCT) {
+        std::string result = into ? *into : stackSlot(fn.result);
+        args.insert(args.begin(), "ptr sret(" + ltype(fn.result) + ") " + result);
+        instr("call void " + fn.symbol + "(" + join(args) + ")");
+        return Value{result, fn.result, false};
+    }
+    if (fn.result.kind == Kind::VOID) {
+        instr("call void " + fn.symbol + "(" + join(args) + ")");
+        return Value{"", fn.result};
+    }
+    std::string result = temp();
+    instr(result + " = call " + ltype(fn.result) + " " + fn.symbol + "(" + join(args) + ")");
+    return Value{result, fn.result};
+}
+
+LlvmIrEmitter::Value LlvmIrEmitter::emitPrint(CallExpression* node, bool newline) {
+    std::string format;
+    std::vector<std::string> args;
+    for (auto& arg : node->arguments) {
+        Value value = emitExpression(arg.get());
+        if (!format.empty()) format += " ";
+        switch (value.type.kind) {
+            case Kind::INT: format += "%lld"; args.push_back("i64 " + rvalue(value)); break;
+            case Kind::UINT: format += "%llu"; args.push_back("i64 " + rvalue(value)); break;
+            case Kind::I32: format += "%d"; args.push_back("i32 " + rvalue(value)); break;
+            case Kind::U32: format += "%u"; args.push_back("i32 " + rvalue(value)); break;
+            case Kind::FLOAT:
+            case Kind::F32: format += "%g"; args.push_back("double " + convert(value, make(Kind::FLOAT), arg.get())); break;
+            case Kind::BOOL: {
+                std::string flag = rvalue(value);
+                std::string text = temp();
+                instr(text + " = select i1 " + flag + ", ptr " + global("true") + ", ptr " + global("false"));
+                format += "%s";
+                args.push_back("ptr " + text);
+                break;
+            }
+            case Kind::STRING: format += "%s"; args.push_back("ptr " + rvalue(value)); break;
+            default: fail(arg.get(), "cannot print " + arg->toString());
+        }
+    }
+    if (newline) format += "\n";
+    args.insert(args.begin(), "ptr " + global(format));
+    std::string written = temp();
+    instr(written + " = call i32 (ptr, ...) @printf(" + join(args) + ")");
+    return Value{"", make(Kind::VOID)};
+}
+
+} // namespace vyn
@@ -1,5 +1,13 @@
 #include "vyn/vyn.hpp"
+#include "vyn/bounds_check.hpp"
+#include "vyn/c_backend.hpp"
+#include "vyn/defer_lowering.hpp"
+#include "vyn/error_lowering.hpp"
+#include "vyn/llvm_ir.hpp"
+#include "vyn/repl.hpp"
+#include "vyn/tiered.hpp"
 #include <catch2/catch_session.hpp>
+#include <unistd.h>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -10,8 +18,14 @@ int main(int argc, char** argv) {
     std::cout << "./vyn_parser: Version: 0.3.0\n" << std::endl;
 
     bool run_tests = false;
+    bool run_benchmarks = false;
     bool show_success = false;
     std::string filename;
+    std::string native_output; // --native <executable>: compile through the C backend
+    std::string llvm_output;   // --emit-llvm <file.ll>: write LLVM IR
+    bool tiered = false;       // --tiered: run main in the bytecode tier, hot functions natively
+    bool repl = false;         // --repl: an interactive session on stdin
+    std::vector<std::string> positional;
 
     // Parse command-line arguments
     std::vector<std::string> catch_args = {"vyn_parser"}; // Program name as argv[0]
@@ -20,16 +34,39 @@ int main(int argc, char** argv) {
         if (arg == "--test") {
             run_tests = true;
             // Skip adding --test to catch_args
+        } else if (arg == "--bench") {
+            run_benchmarks = true;
+        } else if (arg == "--native" && i + 1 < argc) {
+            native_output = argv[++i];
+        } else if (arg == "--emit-llvm" && i + 1 < argc) {
+            llvm_output = argv[++i];
+        } else if (arg == "--tiered") {
+            tiered = true;
+        } else if (arg == "--repl") {
+            repl = true;
         } else if (arg == "--success") {
             show_success = true;
             catch_args.push_back("-s"); // Map --success to Catch2's -s (show successes)
         } else if (arg[0] != '-') {
-            filename = arg;
+            positional.push_back(arg);
         } else {
             catch_args.push_back(arg); // Pass other args to Catch2 (e.g., test filters)
         }
     }
 
+    if (!run_tests && !run_benchmarks) {
+        if (!positional.empty()) filename = positional.front();
+    } else {
+        // With --test/--bench, positional arguments are Catch2 test specs
+        catch_args.insert(catch_args.end(), positional.begin(), positional.end());
+    }
+
+    if (run_benchmarks) {
+        // Benchmarks are tagged [.benchmark] so a plain --test run skips them
+        catch_args.push_back("[benchmark]");
+        run_tests = true;
+    }
+
     if (run_tests) {
         // Convert string vector to char* array for Catch2
         std::vector<char*> catch_argv;
@@ -44,6 +81,12 @@ int main(int argc, char** argv) {
         return result;
     }
 
+    if (repl) {
+        vyn::Repl session;
+        session.run(std::cin, std::cout, isatty(STDIN_FILENO));
+        return 0;
+    }
+
     if (filename.empty()) {
         std::cerr << "Error: No input file specified.\n";
         return 1;
@@ -85,5 +128,39 @@ int main(int argc, char** argv) {
         std::cout << "Parsing successful.\n";
     }
 
+    if (!native_output.empty() || !llvm_output.empty() || tiered) {
+        try {
+            vyn::BoundsCheckElimination().run(ast.get());
+            vyn::ErrorLowering().run(ast.get());
+            vyn::DeferLowering().run(ast.get());
+            if (!native_output.empty()) {
+                vyn::CBackend backend;
+                vyn::CBackend::compile(backend.run(ast.get()), native_output);
+                std::cout << "Wrote " << native_output << " (C source in " << native_output << ".c)\n";
+            }
+            if (!llvm_output.empty()) {
+                std::ofstream out(llvm_output);
+                out << vyn::LlvmIrEmitter().run(ast.get());
+                if (!out) throw std::runtime_error("cannot write " + llvm_output);
+                std::cout << "Wrote " << llvm_output << "\n";
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Compile error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    if (tiered) {
+        try {
+            vyn::TieredEngine engine;
+            engine.load(ast.get());
+            vyn::vre::VreValue status = engine.call("main");
+            return status.is_integer() ? static_cast<int>(std::get<int64_t>(status.data)) : 0;
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Runtime error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,281 @@
+#include "vyn/parallel_check.hpp"
+
+#include <functional>
+
+namespace vyn {
+
+namespace {
+
+const std::string* identifier_name(Expression* expr) {
+    if (expr && expr->getType() == NodeType::IDENTIFIER) {
+        return &static_cast<Identifier*>(expr)->name;
+    }
+    return nullptr;
+}
+
+bool is_range(Expression* expr) {
+    return expr && expr->getType() == NodeType::BINARY_EXPRESSION &&
+           static_cast<BinaryExpression*>(expr)->op.type == TokenType::DOTDOT;
+}
+
+bool is_read_only_method(const std::string& name) {
+    return name == "len" || name == "length" || name == "get";
+}
+
+class LocalCollector : public AstWalker {
+public:
+    std::unordered_set<std::string> names;
+
+    using AstWalker::visit;
+    void visit(VariableDeclaration* node) override {
+        if (node->id) names.insert(node->id->name);
+        AstWalker::visit(node);
+    }
+    void visit(ForStatement* node) override {
+        if (const std::string* induction = identifier_name(dynamic_cast<Expression*>(node->init.get()))) {
+            names.insert(*induction);
+        }
+        AstWalker::visit(node);
+    }
+    void visit(FunctionDeclaration*) override {}
+};
+
+// Builtins without effects; any other function must be declared in the
+// module and pass ParallelLoopCheck::pure
+bool is_pure_builtin(const std::string& name) {
+    return name == "len" || name == "make_my" || name == "_list_comprehension" ||
+           name == "_parallel_list_comprehension";
+}
+
+// Finds what stops the iterations of one parallel body from being
+// independent, or what gives a function called from one an effect; records
+// the first problem only. A function may rebind its parameters, but they
+// still refer to the caller's values.
+class IndependenceCheck : public AstWalker {
+public:
+    IndependenceCheck(std::unordered_set<std::string> locals, const std::string* induction,
+                      std::function<bool(const std::string&)> pure,
+                      std::unordered_set<std::string> params = {}, bool function = false)
+        : locals_(std::move(locals)), params_(std::move(params)), induction_(induction), pure_(std::move(pure)),
+          function_(function) {}
+
+    bool failed() const { return !reason.empty(); }
+    SourceLocation loc;
+    std::string reason;
+    std::unordered_set<std::string> stored; // shared arrays stored into at the loop variable
+
+    using AstWalker::visit;
+
+    void visit(AssignmentExpression* node) override {
+        AstWalker::visit(node);
+        Expression* target = node->left.get();
+        if (const std::string* name = identifier_name(target)) {
+            if (!locals_.count(*name) && !params_.count(*name)) {
+                fail(node, "assigns '" + *name + "', which is shared between iterations");
+            }
+            return;
+        }
+        if (!target || target->getType() != NodeType::MEMBER_EXPRESSION) return;
+        auto* member = static_cast<MemberExpression*>(target);
+        const std::string* object = identifier_name(member->object.get());
+        if (object && locals_.count(*object)) return;
+        std::string shared = object ? "'" + *object + "'" : "a shared value";
+        if (!member->computed) {
+            fail(node, "assigns a field of " + shared);
+            return;
+        }
+        const std::string* index = identifier_name(member->property.get());
+        if (!object || !induction_ || !index || *index != *induction_) {
+            fail(node, "stores into " + shared + " at an index other than the loop variable");
+            return;
+        }
+        stored.insert(*object);
+    }
+
+    void visit(CallExpression* node) override {
+        if (const std::string* callee = identifier_name(node->callee.get())) {
+            if (*callee == "_await") {
+                fail(node, "awaits");
+            } else if (!locals_.count(*callee) && !is_pure_builtin(*callee) && !pure_(*callee)) {
+                fail(node, "calls '" + *callee + "', which may have effects");
+            }
+            AstWalker::visit(node);
+            return;
+        }
+        AstWalker::visit(node);
+        if (!node->callee || node->callee->getType() != NodeType::MEMBER_EXPRESSION) return;
+        auto* member = static_cast<MemberExpression*>(node->callee.get());
+        const std::string* object = identifier_name(member->object.get());
+        const std::string* method = identifier_name(member->property.get());
+        if (object && method && !member->computed && !locals_.count(*object) && !is_read_only_method(*method)) {
+            fail(node, "calls '" + *method + "' on shared '" + *object + "'");
+        }
+    }
+
+    void visit(ForStatement* node) override {
+        ++loopDepth_;
+        AstWalker::visit(node);
+        --loopDepth_;
+    }
+    void visit(WhileStatement* node) override {
+        ++loopDepth_;
+        AstWalker::visit(node);
+        --loopDepth_;
+    }
+    void visit(BreakStatement* node) override {
+        if (loopDepth_ == 0 && !function_) fail(node, "leaves the loop with break");
+    }
+    void visit(ReturnStatement* node) override {
+        if (!function_) fail(node, "leaves the loop with return");
+        AstWalker::visit(node);
+    }
+    void visit(FunctionDeclaration*) override {}
+
+private:
+    std::unordered_set<std::string> locals_;
+    std::unordered_set<std::string> params_;
+    const std::string* induction_;
+    std::function<bool(const std::string&)> pure_;
+    bool function_;
+    int loopDepth_ = 0; // Loops nested inside the parallel body
+
+    void fail(Node* node, std::string why) {
+        if (failed()) return;
+        loc = node->loc;
+        reason = std::move(why);
+    }
+};
+
+// Iterations may read a shared array they store into only at their own
+// element: `a[i] = a[i + 1]` reads what another iteration writes. Any other
+// use of the array, other than its length, is a read that may race.
+class SharedReadCheck : public AstWalker {
+public:
+    SharedReadCheck(const std::unordered_set<std::string>& stored, const std::string& induction)
+        : stored_(stored), induction_(induction) {}
+
+    const Identifier* found = nullptr;
+
+    using AstWalker::visit;
+
+    void visit(MemberExpression* node) override {
+        const std::string* object = identifier_name(node->object.get());
+        if (object && stored_.count(*object)) {
+            const std::string* index = identifier_name(node->property.get());
+            bool own = node->computed && index && *index == induction_;
+            bool length = !node->computed && index && is_read_only_method(*index) && *index != "get";
+            if (own || length) {
+                if (node->computed) walk(node->property.get());
+                return;
+            }
+        }
+        AstWalker::visit(node);
+    }
+
+    void visit(Identifier* node) override {
+        if (!found && stored_.count(node->name)) found = node;
+    }
+
+    void visit(FunctionDeclaration*) override {}
+
+private:
+    const std::unordered_set<std::string>& stored_;
+    const std::string& induction_;
+};
+
+} // namespace
+
+std::vector<ParallelDiagnostic> ParallelLoopCheck::check(Module* module) {
+    diagnostics_.clear();
+    functions_.clear();
+    pure_.clear();
+    for (auto& stmt : module->body) {
+        if (stmt->getType() == NodeType::FUNCTION_DECLARATION) {
+            auto* fn = static_cast<FunctionDeclaration*>(stmt.get());
+            if (fn->id) functions_[fn->id->name] = fn;
+        }
+    }
+    walk(module);
+    return std::move(diagnostics_);
+}
+
+// A function is pure when it only assigns its own locals and parameters,
+// stores nothing through them, and calls only pure functions. Recursion
+// assumes the function being checked is pure.
+bool ParallelLoopCheck::pure(const std::string& name) {
+    auto known = pure_.find(name);
+    if (known != pure_.end()) return known->second;
+    auto found = functions_.find(name);
+    if (found == functions_.end() || !found->second->body || found->second->isAsync) return false;
+    pure_[name] = true;
+    LocalCollector locals;
+    locals.walk(found->second->body.get());
+    std::unordered_set<std::string> params;
+    for (const FunctionParameter& param : found->second->params) {
+        if (param.name) params.insert(param.name->name);
+    }
+    IndependenceCheck check(std::move(locals.names), nullptr,
+                            [this](const std::string& callee) { return pure(callee); }, std::move(params), true);
+    check.walk(found->second->body.get());
+    return pure_[name] = !check.failed();
+}
+
+void ParallelLoopCheck::visit(ForStatement* node) {
+    AstWalker::visit(node);
+    if (!node->isParallel) return;
+    const std::string* induction = identifier_name(dynamic_cast<Expression*>(node->init.get()));
+    if (!induction || !is_range(node->test.get())) {
+        diagnostics_.push_back({node->loc, "@parallel loops must iterate over a range `a..b`"});
+        node->isParallel = false;
+        return;
+    }
+    LocalCollector locals;
+    locals.walk(node->body.get());
+    locals.names.insert(*induction);
+    IndependenceCheck check(std::move(locals.names), induction,
+                            [this](const std::string& callee) { return pure(callee); });
+    check.walk(node->body.get());
+    if (!check.failed() && !check.stored.empty()) {
+        SharedReadCheck reads(check.stored, *induction);
+        reads.walk(node->body.get());
+        if (reads.found) {
+            diagnostics_.push_back({reads.found->loc, "@parallel loop reads '" + reads.found->name +
+                                                          "' at an index other than the loop variable, "
+                                                          "which another iteration stores into"});
+            node->isParallel = false;
+            return;
+        }
+    }
+    if (check.failed()) {
+        diagnostics_.push_back({check.loc, "@parallel loop " + check.reason});
+        node->isParallel = false;
+    }
+}
+
+void ParallelLoopCheck::visit(CallExpression* node) {
+    AstWalker::visit(node);
+    auto* callee = node->callee && node->callee->getType() == NodeType::IDENTIFIER
+                       ? static_cast<Identifier*>(node->callee.get())
+                       : nullptr;
+    if (!callee || callee->name != "_parallel_list_comprehension" || node->arguments.size() != 3) return;
+
+    // Arguments: element expression, variable, iterable
+    std::string reason;
+    SourceLocation loc = node->loc;
+    if (!is_range(node->arguments[2].get())) {
+        reason = "must iterate over a range `a..b`";
+    } else {
+        IndependenceCheck check({}, nullptr, [this](const std::string& callee) { return pure(callee); });
+        check.walk(node->arguments[0].get());
+        if (check.failed()) {
+            loc = check.loc;
+            reason = check.reason;
+        }
+    }
+    if (!reason.empty()) {
+        diagnostics_.push_back({loc, "@parallel comprehension " + reason});
+        callee->name = "_list_comprehension";
+    }
+}
+
+} // namespace vyn
@@ -0,0 +1,53 @@
+#include "vyn/process.hpp"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+extern char** environ;
+
+namespace vyn {
+
+ProgramRun run_program(const std::vector<std::string>& args, const std::string& log_path) {
+    std::vector<std::string> copies = args; // posix_spawnp takes char* const*
+    std::vector<char*> argv;
+    for (std::string& arg : copies) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&actions, 1, 2);
+    ProgramRun run;
+    pid_t pid;
+    run.error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    int status = 0;
+    while (run.error == 0 && waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) run.error = errno;
+    }
+    if (run.error == 0) {
+        run.exited = WIFEXITED(status);
+        run.status = run.exited ? WEXITSTATUS(status) : 0;
+    }
+
+    std::ifstream log(log_path);
+    std::stringstream output;
+    output << log.rdbuf();
+    run.output = output.str();
+    std::remove(log_path.c_str());
+    return run;
+}
+
+std::string command_line(const std::vector<std::string>& args) {
+    std::string command;
+    for (size_t i = 0; i < args.size(); ++i) command += (i ? " " : "") + args[i];
+    return command;
+}
+
+} // namespace vyn
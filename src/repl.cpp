@@ -0,0 +1,104 @@
+#include "vyn/repl.hpp"
+
+#include "vyn/defer_lowering.hpp"
+#include "vyn/vyn.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace vyn {
+
+namespace {
+
+// The parser traces every token to std::cerr when built with VERBOSE; in a
+// session that would bury the prompt
+class MuteTrace {
+public:
+    MuteTrace() : saved_(std::cerr.rdbuf(nullptr)) {}
+    ~MuteTrace() {
+        std::cerr.rdbuf(saved_);
+        std::cerr.clear();
+    }
+
+private:
+    std::streambuf* saved_;
+};
+
+// The formats of print, so a value shows as it would print
+std::string show(const vre::VreValue& value) {
+    switch (value.type) {
+        case vre::VreValueType::INTEGER: return std::to_string(std::get<int64_t>(value.data));
+        case vre::VreValueType::BOOLEAN: return std::get<bool>(value.data) ? "true" : "false";
+        case vre::VreValueType::FLOAT: {
+            char text[32];
+            std::snprintf(text, sizeof text, "%g", std::get<double>(value.data));
+            return text;
+        }
+        default: return "";
+    }
+}
+
+} // namespace
+
+std::string Repl::eval(const std::string& input) {
+    std::string name = "<input " + std::to_string(++count_) + ">";
+    std::unique_ptr<Module> module;
+    {
+        MuteTrace mute;
+        Lexer lexer(input, name);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, name);
+        module = parser.parse_module();
+    }
+    DeferLowering().run(module.get());
+    // Kept even if the input fails: its functions stay defined when only its statements failed
+    inputs_.push_back(std::move(module));
+    return show(engine_.evaluate(inputs_.back().get()));
+}
+
+bool Repl::complete(const std::string& input) {
+    int depth = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        char c = input[i];
+        if (c == '"') {
+            for (++i; i < input.size() && input[i] != '"'; ++i) {
+                if (input[i] == '\\') ++i;
+            }
+            if (i >= input.size()) return false; // an open string literal
+        } else if (c == '#' || (c == '/' && i + 1 < input.size() && input[i + 1] == '/')) {
+            while (i < input.size() && input[i] != '\n') ++i;
+        } else if (c == '(' || c == '{' || c == '[') {
+            ++depth;
+        } else if (c == ')' || c == '}' || c == ']') {
+            --depth;
+        }
+    }
+    return depth <= 0;
+}
+
+void Repl::run(std::istream& in, std::ostream& out, bool prompt) {
+    std::string input;
+    std::string line;
+    for (;;) {
+        if (prompt) out << (input.empty() ? "vyn> " : "...> ") << std::flush;
+        if (!std::getline(in, line)) break;
+        if (input.empty() && (line == ":quit" || line == ":q")) break;
+        input += line + "\n";
+        if (!complete(input)) continue;
+        if (input.find_first_not_of(" \t\r\n") != std::string::npos) {
+            try {
+                std::string shown = eval(input);
+                std::fflush(stdout); // what the input printed comes first
+                if (!shown.empty()) out << shown << "\n";
+            } catch (const std::runtime_error& e) {
+                std::fflush(stdout);
+                out << "error: " << e.what() << "\n";
+            }
+        }
+        input.clear();
+    }
+    if (prompt) out << "\n";
+}
+
+} // namespace vyn
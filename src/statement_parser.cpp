@@ -34,8 +34,23 @@ vyn::StmtPtr StatementParser::parse() {
         return this->parse_while();
     } else if (current_token.type == vyn::TokenType::KEYWORD_FOR) {
         return this->parse_for();
+    } else if (current_token.type == vyn::TokenType::AT) {
+        // @parallel for (i in a..b) { ... }
+        this->consume();
+        vyn::token::Token attribute = this->expect(vyn::TokenType::IDENTIFIER);
+        if (attribute.lexeme != "parallel") {
+            throw std::runtime_error("Unknown attribute '@" + attribute.lexeme + "' at " + location_to_string(loc));
+        }
+        if (this->peek().type != vyn::TokenType::KEYWORD_FOR) {
+            throw std::runtime_error("Expected a for loop after '@parallel' at " + location_to_string(this->current_location()));
+        }
+        auto loop = this->parse_for();
+        loop->isParallel = true;
+        return loop;
     } else if (current_token.type == vyn::TokenType::KEYWORD_RETURN) {
         return this->parse_return();
+    } else if (current_token.type == vyn::TokenType::KEYWORD_SCOPED) {
+        return this->parse_scoped();
     } else if (current_token.type == vyn::TokenType::KEYWORD_LET || current_token.type == vyn::TokenType::KEYWORD_VAR || current_token.type == vyn::TokenType::KEYWORD_CONST) {
         return this->parse_var_decl();
     } else if (current_token.type == vyn::TokenType::LBRACE) {
@@ -56,19 +71,14 @@ vyn::StmtPtr StatementParser::parse() {
             throw std::runtime_error("Expected block after 'try' at " + location_to_string(this->current_location()));
         }
 
-        std::optional<std::string> catch_ident;
-        std::unique_ptr<vyn::BlockStatement> catch_block = nullptr;
+        std::vector<vyn::CatchClause> catches;
         std::unique_ptr<vyn::BlockStatement> finally_block = nullptr;
 
-        // Parse all catch blocks - currently we only support one in the AST, so we'll combine them
-        std::vector<std::pair<std::string, std::unique_ptr<vyn::BlockStatement>>> catch_blocks;
-        
         while (this->peek().type == vyn::TokenType::KEYWORD_CATCH) {
             this->consume(); // consume 'catch'
             this->skip_comments_and_newlines(); // Skip any whitespace after 'catch'
             
-            std::string current_catch_ident;
-            std::string error_type;
+            vyn::CatchClause clause;
             
             // Optional identifier in parentheses: catch (e) or catch (e: ErrorType)
             if (this->peek().type == vyn::TokenType::LPAREN) {
@@ -78,7 +88,7 @@ vyn::StmtPtr StatementParser::parse() {
                 if (this->peek().type != vyn::TokenType::IDENTIFIER) {
                     throw std::runtime_error("Expected identifier in catch clause at " + location_to_string(this->current_location()));
                 }
-                current_catch_ident = this->consume().lexeme; // consume the identifier
+                clause.ident = this->consume().lexeme; // consume the identifier
                 
                 // Handle error type specification (e.g., "e: NetworkError")
                 if (this->peek().type == vyn::TokenType::COLON) {
@@ -87,7 +97,7 @@ vyn::StmtPtr StatementParser::parse() {
                     
                     // Parse the error type
                     if (this->peek().type == vyn::TokenType::IDENTIFIER) {
-                        error_type = this->consume().lexeme; // Store the error type
+                        clause.errorType = this->consume().lexeme;
                     } else {
                         throw std::runtime_error("Expected error type after ':' in catch clause at " + location_to_string(this->current_location()));
                     }
@@ -98,14 +108,13 @@ vyn::StmtPtr StatementParser::parse() {
             } 
             // If there's an identifier directly after 'catch' without parentheses
             else if (this->peek().type == vyn::TokenType::IDENTIFIER) {
-                current_catch_ident = this->consume().lexeme; // consume the identifier
+                clause.ident = this->consume().lexeme; // consume the identifier
             }
             
             this->skip_comments_and_newlines(); // Skip any whitespace after catch parameter
             
-            std::unique_ptr<vyn::BlockStatement> current_catch_block;
             if (this->peek().type == vyn::TokenType::LBRACE || this->peek().type == vyn::TokenType::INDENT) {
-                current_catch_block = this->parse_block();
+                clause.block = this->parse_block();
             } else {
                 // Allow a single statement after 'catch' (wrap in BlockStatement)
                 vyn::SourceLocation stmt_loc = this->current_location();
@@ -113,23 +122,10 @@ vyn::StmtPtr StatementParser::parse() {
                 this->skip_comments_and_newlines();
                 std::vector<vyn::StmtPtr> stmts;
                 if (stmt) stmts.push_back(std::move(stmt));
-                current_catch_block = std::make_unique<vyn::BlockStatement>(stmt_loc, std::move(stmts));
+                clause.block = std::make_unique<vyn::BlockStatement>(stmt_loc, std::move(stmts));
             }
             
-            // Store this catch block for later processing
-            catch_blocks.push_back({current_catch_ident, std::move(current_catch_block)});
-        }
-        
-        // Process the catch blocks
-        if (!catch_blocks.empty()) {
-            // Use the identifier from the first catch block
-            catch_ident = catch_blocks[0].first;
-            
-            // For now, we'll just use the first catch block's body
-            catch_block = std::move(catch_blocks[0].second);
-            
-            // In a more complete implementation, we would combine multiple catch blocks
-            // into a single block with conditional logic based on the error type
+            catches.push_back(std::move(clause));
         }
 
         // Optionally parse 'finally' block
@@ -151,16 +147,38 @@ vyn::StmtPtr StatementParser::parse() {
         }
 
         // At least one of catch or finally must be present
-        if (!catch_block && !finally_block) {
+        if (catches.empty() && !finally_block) {
             throw std::runtime_error("'try' must be followed by at least a 'catch' or 'finally' block at " + location_to_string(loc));
         }
 
-        return std::make_unique<vyn::TryStatement>(loc, std::move(try_block), std::move(catch_ident), std::move(catch_block), std::move(finally_block));
+        return std::make_unique<vyn::TryStatement>(loc, std::move(try_block), std::move(catches), std::move(finally_block));
+    } else if (current_token.type == vyn::TokenType::KEYWORD_THROW) {
+        this->consume();
+        // throw expr: lowered like `await`, as a call to the `_throw` intrinsic
+        auto value = this->expr_parser_.parse();
+        if (!value) {
+            throw std::runtime_error("Expected a value after 'throw' at " + location_to_string(this->current_location()));
+        }
+        std::vector<vyn::ExprPtr> args;
+        args.push_back(std::move(value));
+        auto callee = std::make_unique<vyn::Identifier>(loc, "_throw");
+        auto call = std::make_unique<vyn::CallExpression>(loc, std::move(callee), std::move(args));
+        return std::make_unique<vyn::ExpressionStatement>(loc, std::move(call));
     } else if (current_token.type == vyn::TokenType::KEYWORD_DEFER) {
         this->consume();
-        // Defer: treat as an expression statement
-        auto expr = this->expr_parser_.parse();
-        return std::make_unique<vyn::ExpressionStatement>(loc, std::move(expr));
+        // defer expr, or defer { ... }
+        vyn::StmtPtr body;
+        if (this->peek().type == vyn::TokenType::LBRACE) {
+            body = this->parse_block();
+        } else {
+            vyn::SourceLocation expr_loc = this->current_location();
+            auto expr = this->expr_parser_.parse();
+            if (!expr) {
+                throw std::runtime_error("Expected an expression or block after 'defer' at " + location_to_string(expr_loc));
+            }
+            body = std::make_unique<vyn::ExpressionStatement>(expr_loc, std::move(expr));
+        }
+        return std::make_unique<vyn::DeferStatement>(loc, std::move(body));
     } else if (current_token.type == vyn::TokenType::KEYWORD_ASYNC) {
         // Peek ahead: if next token is 'fn', this is an async function declaration, not an expression
         if (this->peekNext().type == vyn::TokenType::KEYWORD_FN) {
@@ -444,6 +462,16 @@ std::unique_ptr<vyn::ReturnStatement> StatementParser::parse_return() {
     return std::make_unique<vyn::ReturnStatement>(loc, std::move(value));
 }
 
+std::unique_ptr<vyn::ScopedStatement> StatementParser::parse_scoped() {
+    vyn::SourceLocation loc = this->current_location();
+    this->expect(vyn::TokenType::KEYWORD_SCOPED);
+    if (this->peek().type != vyn::TokenType::LBRACE && this->peek().type != vyn::TokenType::INDENT) {
+        throw std::runtime_error("Expected block after 'scoped' at " + location_to_string(this->current_location()));
+    }
+    auto body = this->parse_block();
+    return std::make_unique<vyn::ScopedStatement>(loc, std::move(body));
+}
+
 std::unique_ptr<vyn::VariableDeclaration> StatementParser::parse_var_decl() {
     vyn::SourceLocation loc = this->current_location();
     bool is_const_decl = true;
@@ -1,8 +1,49 @@
 #define CATCH_CONFIG_MAIN
 #include "vyn/vyn.hpp"
+#include "vyn/vre/packed_value.hpp"
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/runtime_types.hpp"
+#include "vyn/vre/region.hpp"
+#include "vyn/vre/our.hpp"
+#include "vyn/vre/cycle_collector.hpp"
+#include "vyn/vre/inline_cache.hpp"
+#include "vyn/vre/hash_map.hpp"
+#include "vyn/vre/mutex.hpp"
+#include "vyn/vre/executor.hpp"
+#include "vyn/vre/channel.hpp"
+#include "vyn/vre/parallel.hpp"
+#include "vyn/vre/result.hpp"
+#include "vyn/vre/type_info.hpp"
+#include "vyn/vre/trait_object.hpp"
+#include "vyn/vre/closure.hpp"
+#include "vyn/escape_analysis.hpp"
+#include "vyn/bounds_check.hpp"
+#include "vyn/coroutine_lowering.hpp"
+#include "vyn/parallel_check.hpp"
+#include "vyn/error_lowering.hpp"
+#include "vyn/defer_lowering.hpp"
+#include "vyn/type_table.hpp"
+#include "vyn/closure_conversion.hpp"
+#include "vyn/c_backend.hpp"
+#include "vyn/llvm_ir.hpp"
+#include "vyn/tiered.hpp"
+#include "vyn/repl.hpp"
 #include <catch2/catch_all.hpp>
+#include <atomic>
+#include <chrono>
 #include <iostream> // Added iostream for std::cerr
 #include <string>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 TEST_CASE("Print parser version", "[parser]") {
     REQUIRE(true); // Placeholder to ensure test runs
@@ -413,4 +454,2952 @@ TEST_CASE("Lexer handles ref and underscore", "[lexer]") {
     }
     REQUIRE(found_ref); // Assert that 'my' was found
     REQUIRE(found_underscore);
-}
\ No newline at end of file
+}
+
+TEST_CASE("VrePackedValue encodes scalars in 8 bytes", "[vre]") {
+    using vyn::vre::VrePackedValue;
+    using vyn::vre::VreValueType;
+    REQUIRE(sizeof(VrePackedValue) == 8);
+    REQUIRE(sizeof(VrePackedValue) * 2 <= sizeof(vyn::vre::VreValue));
+
+    REQUIRE(VrePackedValue().is_nil());
+    REQUIRE(VrePackedValue(true).as_boolean());
+    REQUIRE_FALSE(VrePackedValue(false).as_boolean());
+    REQUIRE(VrePackedValue(int64_t(-42)).as_integer() == -42);
+    REQUIRE(VrePackedValue(VrePackedValue::INT48_MAX).as_integer() == VrePackedValue::INT48_MAX);
+    REQUIRE(VrePackedValue(VrePackedValue::INT48_MIN).as_integer() == VrePackedValue::INT48_MIN);
+    REQUIRE(VrePackedValue(1.5).as_float() == 1.5);
+    REQUIRE(VrePackedValue(-std::numeric_limits<double>::infinity()).is_float());
+    REQUIRE(VrePackedValue(std::nan("")).type() == VreValueType::FLOAT);
+    REQUIRE(VrePackedValue(-std::nan("")).raw_bits() == VrePackedValue::CANONICAL_NAN);
+    REQUIRE_FALSE(VrePackedValue(int64_t(7)).is_heap());
+    REQUIRE_THROWS_AS(VrePackedValue(1.5).as_integer(), std::runtime_error);
+}
+
+TEST_CASE("VrePackedValue boxes wide integers and strings", "[vre]") {
+    using vyn::vre::VrePackedValue;
+    using vyn::vre::VreValueType;
+    int64_t wide = std::numeric_limits<int64_t>::min();
+    VrePackedValue boxed(wide);
+    REQUIRE(boxed.is_heap());
+    REQUIRE(boxed.is_integer());
+    REQUIRE(boxed.as_integer() == wide);
+
+    VrePackedValue s("hello");
+    VrePackedValue copy = s;
+    REQUIRE(copy.is_string());
+    REQUIRE(copy.raw_bits() == s.raw_bits()); // copies share the heap cell
+    VrePackedValue moved = std::move(copy);
+    REQUIRE(copy.is_nil());
+    REQUIRE(moved.as_string() == "hello");
+
+    vyn::vre::VreValue round = VrePackedValue::from_value(vyn::vre::VreValue("abc")).to_value();
+    REQUIRE(round.is_string());
+    REQUIRE(std::get<vyn::vre::VreString>(round.data) == "abc");
+
+    // Objects and arrays sit in a cell that holds one our<T> reference
+    using vyn::vre::our;
+    our<vyn::vre::VreObject> object = vyn::vre::make_our<vyn::vre::VreObject>();
+    our<vyn::vre::VreArray> array = vyn::vre::make_our<vyn::vre::VreArray>();
+    {
+        VrePackedValue packed = VrePackedValue::from_value(vyn::vre::VreValue(object));
+        VrePackedValue shared = packed;
+        REQUIRE(shared.is_object());
+        REQUIRE(shared.is_heap());
+        REQUIRE(shared.type() == VreValueType::OBJECT);
+        REQUIRE(shared.as_object().header() == object.header());
+        REQUIRE(object.use_count() == 2); // one for the cell, not one per copy
+        REQUIRE_THROWS_AS(shared.as_array(), std::runtime_error);
+        vyn::vre::VreValue back = shared.to_value();
+        REQUIRE(back.type == VreValueType::OBJECT);
+        REQUIRE(std::get<our<vyn::vre::VreObject>>(back.data).header() == object.header());
+
+        VrePackedValue list = VrePackedValue::from_value(vyn::vre::VreValue(array));
+        REQUIRE(list.is_array());
+        REQUIRE_FALSE(list.is_object());
+        REQUIRE(list.to_value().type == VreValueType::ARRAY);
+        REQUIRE(std::get<our<vyn::vre::VreArray>>(list.to_value().data).header() == array.header());
+    }
+    REQUIRE(object.use_count() == 1);
+    REQUIRE(array.use_count() == 1);
+}
+
+TEST_CASE("VreString stores short strings inline and shares long buffers", "[vre]") {
+    using vyn::vre::VreString;
+    REQUIRE(sizeof(VreString) == 24);
+
+    uint64_t before = VreString::heap_allocations();
+    VreString small("fifteen chars!!");
+    REQUIRE(small.is_inline());
+    REQUIRE(small.size() == 15);
+    REQUIRE(VreString::heap_allocations() == before);
+
+    VreString big("this string is longer than the inline capacity");
+    REQUIRE_FALSE(big.is_inline());
+    REQUIRE(VreString::heap_allocations() == before + 1);
+    VreString copy = big;
+    REQUIRE(copy.data() == big.data()); // O(1) copy shares the buffer
+    REQUIRE(VreString::heap_allocations() == before + 1);
+    REQUIRE(copy == big);
+    REQUIRE(copy.hash() == big.hash());
+    REQUIRE(std::string(big.c_str()) == big.str());
+
+    VreString joined = small + VreString("+") + big;
+    REQUIRE(joined.size() == 15 + 1 + big.size());
+    REQUIRE(joined.view().substr(0, 16) == "fifteen chars!!+");
+    REQUIRE(VreString("a") + VreString("b") == "ab");
+}
+
+TEST_CASE("VreString intern returns a shared immortal buffer", "[vre]") {
+    using vyn::vre::VreString;
+    VreString a = VreString::intern("some_long_identifier_name");
+    uint64_t before = VreString::heap_allocations();
+    VreString b = VreString::intern(std::string("some_long_identifier_") + "name");
+    REQUIRE(VreString::heap_allocations() == before);
+    REQUIRE(a.is_interned());
+    REQUIRE(a.data() == b.data());
+    REQUIRE(a == b);
+    REQUIRE(VreString::intern("short").is_inline());
+}
+
+TEST_CASE("Slab allocator reuses freed objects and tracks statistics", "[vre]") {
+    using namespace vyn::vre;
+    AllocatorStats before = allocator_stats();
+    void* a = allocate_raw(40);
+    REQUIRE(reinterpret_cast<uintptr_t>(a) % SLAB_ALIGNMENT == 0);
+    deallocate_raw(a, 40);
+    void* b = allocate_raw(48); // same size class as 40
+    REQUIRE(b == a);
+    deallocate_raw(b, 48);
+
+    void* big = allocate_raw(SLAB_MAX_SIZE + 1);
+    deallocate_raw(big, SLAB_MAX_SIZE + 1);
+
+    AllocatorStats after = allocator_stats();
+    REQUIRE(after.allocations - before.allocations == 3);
+    REQUIRE(after.deallocations - before.deallocations == 3);
+    REQUIRE(after.large_allocations - before.large_allocations == 1);
+
+    my<VreObject> obj = make_my<VreObject>();
+    obj->fields_by_index.emplace_back(int64_t(1));
+    REQUIRE(allocator_stats().allocations > after.allocations);
+}
+
+TEST_CASE("Slab allocator accepts frees from other threads", "[vre]") {
+    using namespace vyn::vre;
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 5000; ++i) {
+        ptrs.push_back(allocate_raw(64));
+    }
+    std::thread freer([&ptrs] {
+        for (void* p : ptrs) deallocate_raw(p, 64);
+    });
+    freer.join(); // exiting flushes the freeing thread's cache to the depot
+
+    AllocatorStats before = allocator_stats();
+    REQUIRE(before.depot_flushes > 0);
+    std::vector<void*> again;
+    for (int i = 0; i < 5000; ++i) {
+        again.push_back(allocate_raw(64));
+    }
+    for (void* p : again) deallocate_raw(p, 64);
+    REQUIRE(allocator_stats().depot_refills > before.depot_refills);
+}
+
+TEST_CASE("Parser handles scoped blocks", "[parser]") {
+    std::string source = R"(fn handle() {
+    scoped {
+        var tmp = [1, 2, 3]
+        process(tmp)
+    }
+})";
+    Lexer lexer(source, "test34.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test34.vyn");
+    auto module = parser.parse_module();
+    auto* fn = dynamic_cast<vyn::FunctionDeclaration*>(module->body[0].get());
+    REQUIRE(fn != nullptr);
+    REQUIRE(fn->body->body[0]->getType() == vyn::NodeType::SCOPED_STATEMENT);
+}
+
+TEST_CASE("Escape analysis reports values leaving scoped blocks", "[parser][vre]") {
+    std::string source = R"(fn handle(out: Buffer) -> Node {
+    var keep = Node { v: 0 }
+    scoped {
+        var local = [1, 2]
+        var leaked = Node { v: 1 }
+        var fine = Node { v: 2 }
+        var alias = fine
+        keep = leaked
+        out.last = local
+        return fine
+    }
+})";
+    Lexer lexer(source, "test35.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test35.vyn");
+    auto module = parser.parse_module();
+    vyn::EscapeAnalysis analysis;
+    auto diagnostics = analysis.analyze(module.get());
+    REQUIRE(diagnostics.size() == 3);
+    REQUIRE(diagnostics[0].name == "leaked");
+    REQUIRE(diagnostics[0].reason == "stored into 'keep'");
+    REQUIRE(diagnostics[1].name == "local");
+    REQUIRE(diagnostics[2].name == "fine");
+    REQUIRE(diagnostics[2].reason == "returned");
+
+    auto* fn = dynamic_cast<vyn::FunctionDeclaration*>(module->body[0].get());
+    auto* scoped = dynamic_cast<vyn::ScopedStatement*>(fn->body->body[1].get());
+    REQUIRE(scoped != nullptr);
+    REQUIRE(scoped->escapingNames == std::vector<std::string>{"leaked", "local", "fine"});
+}
+
+TEST_CASE("VreRegion bump-allocates and frees in one step", "[vre]") {
+    using namespace vyn::vre;
+    REQUIRE(current_region() == nullptr);
+    int finalized = 0;
+    struct Tracked {
+        int* counter;
+        explicit Tracked(int* c) : counter(c) {}
+        ~Tracked() { ++*counter; }
+    };
+    {
+        RegionScope outer;
+        REQUIRE(current_region() == &outer.region());
+        void* a = scoped_allocate(24);
+        void* b = scoped_allocate(24);
+        REQUIRE(static_cast<char*>(b) - static_cast<char*>(a) == 32); // 16-byte aligned bump
+        outer.region().make<Tracked>(&finalized);
+        void* big = outer.region().allocate(VreRegion::DEFAULT_CHUNK_SIZE);
+        REQUIRE(outer.region().contains(big));
+        REQUIRE(region_depth_of(a) == 1);
+
+        void* heap = allocate_raw(24);
+        {
+            RegionScope inner;
+            void* inner_obj = scoped_allocate(16);
+            REQUIRE(region_depth_of(inner_obj) == 2);
+            REQUIRE_NOTHROW(check_region_store(inner_obj, a));
+            REQUIRE_THROWS_AS(check_region_store(a, inner_obj), std::runtime_error);
+            REQUIRE_THROWS_AS(check_region_store(heap, inner_obj), std::runtime_error);
+        }
+        REQUIRE(current_region() == &outer.region());
+        deallocate_raw(heap, 24);
+        REQUIRE(finalized == 0);
+    }
+    REQUIRE(finalized == 1);
+    REQUIRE(current_region() == nullptr);
+
+    auto promoted = promote(std::string("escapes"));
+    REQUIRE(*promoted == "escapes");
+}
+
+namespace {
+
+struct Counted {
+    int value;
+    std::atomic<int>* destroyed;
+    Counted(int v, std::atomic<int>* d) : value(v), destroyed(d) {}
+    ~Counted() { ++*destroyed; }
+};
+
+} // namespace
+
+TEST_CASE("our<T> counts owner references without atomics", "[vre]") {
+    using namespace vyn::vre;
+    std::atomic<int> destroyed{0};
+    {
+        our<Counted> a = make_our<Counted>(7, &destroyed);
+        REQUIRE(a->value == 7);
+        REQUIRE(a.use_count() == 1);
+        {
+            our<Counted> b = a;
+            our<Counted> c;
+            c = b;
+            REQUIRE(a.use_count() == 3);
+            REQUIRE(a.header()->shared.load() == 0); // owner never touched the shared word
+            REQUIRE(c == a);
+        }
+        REQUIRE(a.use_count() == 1);
+        our<Counted> moved = std::move(a);
+        REQUIRE_FALSE(a);
+        REQUIRE(moved.use_count() == 1);
+        REQUIRE(destroyed == 0);
+    }
+    REQUIRE(destroyed == 1);
+}
+
+TEST_CASE("our<T> merges references released by other threads", "[vre]") {
+    using namespace vyn::vre;
+    std::atomic<int> destroyed{0};
+
+    SECTION("non-owner drops the last reference after the owner") {
+        our<Counted> a = make_our<Counted>(1, &destroyed);
+        our<Counted> copy = a;
+        std::thread t([moved = std::move(copy)]() mutable {
+            REQUIRE(moved.use_count() == 2);
+            moved.reset();
+        });
+        t.join();
+        // The other thread drove `shared` negative and queued the object to us
+        REQUIRE(t_rc_record->pending.load());
+        REQUIRE(destroyed == 0);
+        a.reset(); // the biased count still holds the reference the other thread released
+        REQUIRE(destroyed == 0);
+        our_process_pending_merges();
+        REQUIRE(destroyed == 1);
+    }
+
+    SECTION("owner drops the last reference after other threads") {
+        our<Counted> a = make_our<Counted>(2, &destroyed);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([copy = a]() mutable {
+                for (int j = 0; j < 1000; ++j) {
+                    our<Counted> local = copy;
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        our_process_pending_merges();
+        REQUIRE(destroyed == 0);
+        REQUIRE(a.use_count() == 1);
+        a.reset();
+        REQUIRE(destroyed == 1);
+    }
+
+    SECTION("objects outlive the thread that created them") {
+        our<Counted> survivor;
+        std::thread t([&] { survivor = make_our<Counted>(3, &destroyed); });
+        t.join();
+        REQUIRE(survivor->value == 3);
+        our<Counted> copy = survivor;
+        survivor.reset();
+        REQUIRE(destroyed == 0);
+        copy.reset();
+        REQUIRE(destroyed == 1);
+    }
+}
+
+TEST_CASE("Cycle collector frees unreachable our<T> cycles", "[vre]") {
+    using namespace vyn::vre;
+    REQUIRE_FALSE(cycle_collector_config().enabled);
+
+    auto link = [](const our<VreObject>& from, const our<VreObject>& to) {
+        from->fields_by_index.push_back(VreValue(to));
+    };
+
+    // Off by default: releases buffer nothing
+    {
+        our<VreObject> a = make_our<VreObject>();
+        link(a, a);
+    }
+    REQUIRE(collect_cycles() == 0);
+
+    VreCycleCollectorConfig config;
+    config.enabled = true;
+    config.max_roots_per_pause = 2;
+    configure_cycle_collector(config);
+    VreCycleCollectorStats before = cycle_collector_stats();
+
+    our<VreObject> survivor = make_our<VreObject>();
+    {
+        our<VreObject> a = make_our<VreObject>();
+        our<VreObject> b = make_our<VreObject>();
+        our<VreArray> list = make_our<VreArray>();
+        link(a, b);
+        link(b, a);
+        list->push(VreValue(a));
+        list->push(VreValue(survivor));
+        a->fields_by_index.push_back(VreValue(list));
+
+        size_t children = 0;
+        for_each_child(list, [&](VreRcHeader* child) {
+            ++children;
+            REQUIRE((child == a.header() || child == survivor.header()));
+        });
+        REQUIRE(children == 2);
+
+        // A live cycle that the survivor still points into
+        our<VreObject> c = make_our<VreObject>();
+        our<VreObject> d = make_our<VreObject>();
+        link(c, d);
+        link(d, c);
+        link(survivor, c);
+    }
+    REQUIRE(survivor.use_count() == 2); // local and list
+    REQUIRE(collect_cycles_step() <= 3);  // one bounded pause
+    collect_cycles();
+
+    VreCycleCollectorStats after = cycle_collector_stats();
+    REQUIRE(after.objects_freed - before.objects_freed == 3); // a, b, list
+    REQUIRE(after.pauses - before.pauses >= 2);
+    REQUIRE(after.max_pause_ns > 0);
+    REQUIRE(survivor.use_count() == 1);
+
+    // The live cycle is intact
+    our<VreObject> c = std::get<our<VreObject>>(survivor->fields_by_index[0].data);
+    REQUIRE(c->fields_by_index.size() == 1);
+    REQUIRE(c.use_count() == 3);
+
+    survivor->fields_by_index.clear();
+    c.reset();
+    collect_cycles();
+    REQUIRE(cycle_collector_stats().objects_freed - after.objects_freed == 2);
+
+    // A candidate merged after a release on another thread gives the buffer's
+    // reference back through `shared`
+    {
+        our<VreObject> child = make_our<VreObject>();
+        our<VreObject> root = make_our<VreObject>();
+        root->fields_by_index.push_back(VreValue(child));
+        our<VreObject> moved = root;
+        root.reset(); // buffered
+        std::thread t([moved = std::move(moved)]() mutable { moved.reset(); });
+        t.join();
+        our_process_pending_merges();
+        REQUIRE(child.use_count() == 2);
+        collect_cycles();
+        REQUIRE(child.use_count() == 1); // root was freed
+    }
+
+    configure_cycle_collector(VreCycleCollectorConfig());
+}
+
+TEST_CASE("Shapes share transitions and inline caches key on them", "[vre]") {
+    using namespace vyn::vre;
+    VreObject a, b, c;
+    a.set_field("x", VreValue(int64_t(1)));
+    a.set_field("y", VreValue(int64_t(2)));
+    b.set_field("x", VreValue(int64_t(3)));
+    b.set_field("y", VreValue(int64_t(4)));
+    c.set_field("y", VreValue(int64_t(5)));
+    c.set_field("x", VreValue(int64_t(6)));
+    REQUIRE(a.shape == b.shape);
+    REQUIRE(a.shape != c.shape);
+    REQUIRE(a.shape->property_count() == 2);
+    REQUIRE(a.shape->slot_of("y") == 1);
+    REQUIRE(c.shape->slot_of("y") == 0);
+    REQUIRE(a.find_field("z") == nullptr);
+
+    VreInlineCache load_x;
+    REQUIRE(load_x.state() == VreInlineCache::State::UNINITIALIZED);
+    REQUIRE(std::get<int64_t>(load_x.load(a, "x")->data) == 1);
+    REQUIRE(std::get<int64_t>(load_x.load(b, "x")->data) == 3);
+    REQUIRE(load_x.state() == VreInlineCache::State::MONOMORPHIC);
+    REQUIRE(load_x.misses() == 1);
+    REQUIRE(std::get<int64_t>(load_x.load(c, "x")->data) == 6);
+    REQUIRE(load_x.state() == VreInlineCache::State::POLYMORPHIC);
+
+    // Stores that add a property cache the transition
+    VreInlineCache store_z;
+    VreObject d, e;
+    d.set_field("x", VreValue(int64_t(0)));
+    e.set_field("x", VreValue(int64_t(0)));
+    store_z.store(d, "z", VreValue(int64_t(7)));
+    store_z.store(e, "z", VreValue(int64_t(8)));
+    REQUIRE(store_z.misses() == 1);
+    REQUIRE(d.shape == e.shape);
+    REQUIRE(std::get<int64_t>(e.find_field("z")->data) == 8);
+
+    // More than MAX_ENTRIES shapes make the site megamorphic, which stays correct
+    const char* names[] = {"p", "q", "r", "s", "t", "u"};
+    for (const char* name : names) {
+        VreObject o;
+        o.set_field(name, VreValue(int64_t(0)));
+        o.set_field("x", VreValue(int64_t(42)));
+        REQUIRE(std::get<int64_t>(load_x.load(o, "x")->data) == 42);
+    }
+    REQUIRE(load_x.state() == VreInlineCache::State::MEGAMORPHIC);
+    REQUIRE(load_x.entry_count() == VreInlineCache::MAX_ENTRIES);
+
+    VreObject indexed;
+    indexed.fields_by_index.push_back(VreValue(int64_t(1)));
+    REQUIRE(load_x.load(indexed, "x") == nullptr);
+    REQUIRE_THROWS_AS(store_z.store(indexed, "w", VreValue()), std::runtime_error);
+}
+
+TEST_CASE("Parser gives each member access its own cache site", "[parser][vre]") {
+    std::string source = R"(fn f(p: Point) -> Int {
+    return p.x + p.y
+})";
+    Lexer lexer(source, "test36.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test36.vyn");
+    auto module = parser.parse_module();
+
+    struct Sites : vyn::AstWalker {
+        std::vector<uint32_t> ids;
+        void visit(vyn::MemberExpression* node) override {
+            ids.push_back(node->cacheSite);
+            vyn::AstWalker::visit(node);
+        }
+    } sites;
+    sites.walk(module.get());
+    REQUIRE(sites.ids.size() == 2);
+    REQUIRE(sites.ids[0] != sites.ids[1]);
+
+    vyn::vre::VreInlineCacheTable table;
+    table.at(sites.ids[1]);
+    REQUIRE(table.size() > sites.ids[1]);
+}
+
+TEST_CASE("VreArray stores homogeneous elements unboxed", "[vre]") {
+    using namespace vyn::vre;
+    VreArray ints;
+    REQUIRE(ints.kind() == VreArrayKind::EMPTY);
+    for (int64_t i = 0; i < 100; ++i) {
+        ints.push(VreValue(i));
+    }
+    REQUIRE(ints.kind() == VreArrayKind::INT);
+    REQUIRE(reinterpret_cast<uintptr_t>(ints.int_data()) % VreArray::STORAGE_ALIGNMENT == 0);
+    REQUIRE(ints.int_data()[42] == 42);
+    REQUIRE(ints.storage_bytes() * 5 <= 100 * sizeof(VreValue));
+    REQUIRE(ints.float_data() == nullptr);
+
+    VreArray copy = ints;
+    ints.set(1, VreValue(int64_t(-1)));
+    REQUIRE(std::get<int64_t>(copy.get(1).data) == 1);
+
+    // A store of another type boxes every element
+    ints.set(2, VreValue("two"));
+    REQUIRE(ints.kind() == VreArrayKind::GENERIC);
+    REQUIRE(ints.int_data() == nullptr);
+    REQUIRE(ints.size() == 100);
+    REQUIRE(std::get<int64_t>(ints.get(1).data) == -1);
+    REQUIRE(ints.get(2).is_string());
+    REQUIRE(std::get<int64_t>(ints.get(99).data) == 99);
+    REQUIRE_THROWS_AS(ints.get(100), std::runtime_error);
+
+    VreArray flags;
+    for (int i = 0; i < 70; ++i) {
+        flags.push(VreValue(i % 3 == 0));
+    }
+    REQUIRE(flags.kind() == VreArrayKind::BOOL);
+    REQUIRE(flags.storage_bytes() == 16);
+    REQUIRE(std::get<bool>(flags.get(69).data));
+    REQUIRE_FALSE(std::get<bool>(flags.get(68).data));
+    flags.set(68, VreValue(true));
+    REQUIRE(std::get<bool>(flags.get(68).data));
+
+    VreArray floats;
+    floats.push(VreValue(1.5));
+    floats.push(VreValue(int64_t(2))); // Int into a Float array is a different kind
+    REQUIRE(floats.kind() == VreArrayKind::GENERIC);
+}
+
+TEST_CASE("VreSlice is bounds-checked and subslices without copying", "[vre]") {
+    using namespace vyn::vre;
+    VreArray numbers;
+    for (int64_t i = 0; i < 10; ++i) {
+        numbers.push(VreValue(i * 10));
+    }
+    {
+        VreSlice all(numbers);
+        VreSlice middle = all.subslice(2, 8);   // all[2..8]
+        VreSlice inner = middle.subslice(1, 3); // elements 3 and 4
+        REQUIRE(inner.size() == 2);
+        REQUIRE(std::get<int64_t>(inner.get(0).data) == 30);
+        REQUIRE(inner.int_data() == numbers.int_data() + 3);
+        REQUIRE_THROWS_AS(inner.get(2), std::runtime_error);
+        REQUIRE_THROWS_AS(middle.subslice(4, 7), std::runtime_error);
+        REQUIRE_THROWS_AS(VreSlice(numbers, 5, 11), std::runtime_error);
+
+        inner.set(1, VreValue(int64_t(-4)));
+        REQUIRE(std::get<int64_t>(numbers.get(4).data) == -4);
+
+        // Borrowed arrays keep their storage where the slices see it
+        REQUIRE(numbers.borrow_count() == 3);
+        REQUIRE_THROWS_AS(inner.set(0, VreValue("boxed")), std::runtime_error);
+        REQUIRE_THROWS_AS(numbers.reserve(1000), std::runtime_error);
+    }
+    REQUIRE(numbers.borrow_count() == 0);
+    numbers.set(0, VreValue("boxed"));
+    REQUIRE(numbers.kind() == VreArrayKind::GENERIC);
+    REQUIRE(std::get<int64_t>(VreSlice(numbers).get(9).data) == 90);
+}
+
+TEST_CASE("Bounds checks are eliminated or hoisted out of counted loops", "[parser]") {
+    std::string source = R"(fn sum(s: [Int], n: Int) -> Int {
+    var total = 0
+    for (i in 0..s.len()) {
+        total = total + s[i]
+    }
+    for (i in 0..n) {
+        total = total + s[i] + s[i]
+    }
+    for (i in 0..len(s)) {
+        s = other()
+        total = total + s[i]
+    }
+    for (j in 0..s.len()) {
+        total = total + s[j + 1]
+    }
+    return total + s[0] + s[1..3].len()
+})";
+    Lexer lexer(source, "test37.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test37.vyn");
+    auto module = parser.parse_module();
+
+    vyn::BoundsCheckElimination pass;
+    vyn::BoundsCheckReport report = pass.run(module.get());
+    REQUIRE(report.indexSites == 6);
+    REQUIRE(report.eliminated == 1);
+    REQUIRE(report.hoisted == 2);
+    REQUIRE(report.hoistedChecks == 1);
+    REQUIRE(report.remaining() == 3);
+
+    auto* fn = dynamic_cast<vyn::FunctionDeclaration*>(module->body[0].get());
+    REQUIRE(fn != nullptr);
+    auto* counted = dynamic_cast<vyn::ForStatement*>(fn->body->body[2].get());
+    REQUIRE(counted != nullptr);
+    REQUIRE(counted->hoistedBoundsChecks.size() == 1);
+    REQUIRE(counted->hoistedBoundsChecks[0].slice == "s");
+    REQUIRE(static_cast<vyn::Identifier*>(counted->hoistedBoundsChecks[0].bound)->name == "n");
+}
+
+TEST_CASE("HashMap matches std::unordered_map under inserts and erases", "[vre]") {
+    using namespace vyn::vre;
+    HashMap<int64_t, int64_t> map;
+    std::unordered_map<int64_t, int64_t> reference;
+    uint64_t state = 12345;
+    for (int step = 0; step < 20000; ++step) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        int64_t key = static_cast<int64_t>((state >> 33) % 512);
+        if (state & 1) {
+            map[key] = step;
+            reference[key] = step;
+        } else {
+            REQUIRE(map.erase(key) == reference.erase(key));
+        }
+    }
+    REQUIRE(map.size() == reference.size());
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        REQUIRE(reference.at(key) == value);
+        ++visited;
+    }
+    REQUIRE(visited == reference.size());
+    for (int64_t key = 0; key < 512; ++key) {
+        REQUIRE(map.contains(key) == (reference.count(key) == 1));
+    }
+
+    // Capacity stays bounded despite the tombstones left by erase-heavy use
+    REQUIRE(map.capacity() <= 1023);
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.begin() == map.end());
+    REQUIRE_THROWS_AS(map.at(0), std::runtime_error);
+}
+
+TEST_CASE("HashMap looks up VreValue and VreString keys without building them", "[vre]") {
+    using namespace vyn::vre;
+    HashMap<VreValue, int> values;
+    values.reserve(100);
+    size_t capacity = values.capacity();
+    values.try_emplace(VreValue("a fairly long string key"), 1);
+    values.try_emplace(VreValue(int64_t(7)), 2);
+    values.try_emplace(VreValue(7.0), 3);
+    values.try_emplace(VreValue(-0.0), 4);
+    REQUIRE(values.capacity() == capacity);
+
+    uint64_t allocations = VreString::heap_allocations();
+    REQUIRE(values.at("a fairly long string key") == 1);
+    REQUIRE(values.at(std::string_view("a fairly long string key")) == 1);
+    REQUIRE(VreString::heap_allocations() == allocations);
+    REQUIRE(values.at(int64_t(7)) == 2);
+    REQUIRE(values.at(VreValue(7.0)) == 3); // Int 7 and Float 7.0 are distinct keys
+    REQUIRE(values.at(VreValue(0.0)) == 4);
+    REQUIRE_FALSE(values.contains("missing"));
+
+    auto first = values.insert_or_assign(VreValue(int64_t(7)), 20);
+    REQUIRE_FALSE(first.second);
+    REQUIRE(values.at(int64_t(7)) == 20);
+
+    HashMap<VreString, int> names;
+    names["x"] = 1;
+    names[VreString::intern("y")] = 2;
+    HashMap<VreString, int> copy = names;
+    names.erase("x");
+    REQUIRE(copy.size() == 2);
+    REQUIRE(copy.at("x") == 1);
+    REQUIRE(names.find("x") == names.end());
+}
+
+TEST_CASE("Mutex hands the lock to waiters in arrival order", "[vre]") {
+    using namespace vyn::vre;
+    using namespace std::chrono_literals;
+    Mutex<std::vector<int>> order;
+    std::vector<std::thread> threads;
+    {
+        auto guard = order.lock();
+        REQUIRE_FALSE(order.try_lock().has_value());
+        REQUIRE_FALSE(order.lock_timeout(5ms).has_value());
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&order, i] { order.lock()->push_back(i); });
+            std::this_thread::sleep_for(20ms); // let thread i queue before the next one starts
+        }
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(*order.lock() == std::vector<int>{0, 1, 2, 3});
+
+    Mutex<int64_t> counter(0);
+    threads.clear();
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) ++*counter.lock();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(*counter.lock() == 40000);
+}
+
+TEST_CASE("Mutex is poisoned by a holder that throws", "[vre]") {
+    using namespace vyn::vre;
+    Mutex<int> value(1);
+    REQUIRE_THROWS_AS(([&] {
+        auto guard = value.lock();
+        *guard = 2;
+        throw std::runtime_error("fails halfway");
+    }()), std::runtime_error);
+    REQUIRE(value.is_poisoned());
+    REQUIRE_THROWS_AS(value.lock(), VrePoisonError);
+    REQUIRE_THROWS_AS(value.try_lock(), VrePoisonError);
+
+    value.clear_poison();
+    auto guard = value.try_lock();
+    REQUIRE(guard.has_value());
+    REQUIRE(**guard == 2);
+}
+
+namespace {
+
+// `async fn fib(n) { if n < 2 { return n } return await fib(n - 1) + await fib(n - 2) }`
+// lowered by hand, with both awaits started together
+struct FibFrame : vyn::vre::VreFrame {
+    int n;
+    int64_t* out;
+    int64_t left = 0;
+    int64_t right = 0;
+
+    FibFrame(int n, int64_t* out) : n(n), out(out) {}
+
+    vyn::vre::VrePoll resume(vyn::vre::VreTaskContext& ctx) override {
+        switch (state_) {
+            case 0:
+                if (n < 2) {
+                    *out = n;
+                    return vyn::vre::VrePoll::READY;
+                }
+                state_ = 1;
+                ctx.await_all(this, {new FibFrame(n - 1, &left), new FibFrame(n - 2, &right)});
+                return vyn::vre::VrePoll::PENDING;
+            default:
+                *out = left + right;
+                return vyn::vre::VrePoll::READY;
+        }
+    }
+};
+
+} // namespace
+
+TEST_CASE("Chase-Lev deque pops LIFO, steals FIFO and grows", "[vre]") {
+    using namespace vyn::vre;
+    VreChaseLevDeque<int> deque(2);
+    int items[100];
+    for (int i = 0; i < 100; ++i) {
+        items[i] = i;
+        deque.push(&items[i]);
+    }
+    REQUIRE(deque.size_estimate() == 100);
+    REQUIRE(*deque.steal() == 0);
+    REQUIRE(*deque.pop() == 99);
+
+    // Owner pops race four thieves; every item is taken exactly once
+    std::atomic<int> taken{0};
+    std::atomic<int64_t> sum{0};
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 4; ++t) {
+        thieves.emplace_back([&] {
+            while (taken.load() < 98) {
+                if (int* item = deque.steal()) {
+                    sum += *item;
+                    ++taken;
+                }
+            }
+        });
+    }
+    while (taken.load() < 98) {
+        if (int* item = deque.pop()) {
+            sum += *item;
+            ++taken;
+        }
+    }
+    for (auto& thief : thieves) thief.join();
+    REQUIRE(sum.load() == 99 * 100 / 2 - 99);
+    REQUIRE(deque.pop() == nullptr);
+    REQUIRE(deque.steal() == nullptr);
+}
+
+TEST_CASE("Executor runs awaiting frames to completion across workers", "[vre]") {
+    using namespace vyn::vre;
+    VreExecutor executor(4);
+    REQUIRE(executor.worker_count() == 4);
+    int64_t result = 0;
+    executor.block_on(new FibFrame(20, &result));
+    REQUIRE(result == 6765);
+
+    VreExecutorStats stats = executor.stats();
+    REQUIRE(stats.frames_completed == 21891); // frames in the call tree of fib(20)
+    REQUIRE(stats.resumes == stats.frames_completed + (21891 - 1) / 2);
+
+    int64_t again = 0;
+    executor.block_on(new FibFrame(1, &again));
+    REQUIRE(again == 1);
+}
+
+TEST_CASE("Async functions lower to precisely sized coroutine frames", "[parser]") {
+    std::string source = R"(async fn tick() -> Int {
+    return 1
+}
+async fn add_later(a: Int, b: Int) -> Int {
+    var x = a * 2
+    var y = await tick()
+    return x + y + b
+}
+async fn count(n: Int) -> Int {
+    var total = 0
+    for (i in 0..n) {
+        total = total + await tick()
+    }
+    return total
+}
+async fn countdown(n: Int) -> Int {
+    if (n < 1) {
+        return 0
+    }
+    return await countdown(n - 1) + n
+})";
+    Lexer lexer(source, "test38.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test38.vyn");
+    auto module = parser.parse_module();
+
+    vyn::CoroutineLowering pass;
+    vyn::CoroutineReport report = pass.run(module.get());
+    REQUIRE(report.asyncFunctions == 4);
+    REQUIRE(report.awaitPoints == 3);
+    REQUIRE(report.parameters == 4);
+    REQUIRE(report.spilledLocals == 3); // x, and total and i across the loop
+    REQUIRE(report.unspilledLocals == 1); // y is defined by the await, not live across it
+    REQUIRE(report.boxedAwaits == 1);     // countdown awaits itself
+
+    auto layout_of = [&](size_t index) -> const vyn::CoroutineLayout& {
+        auto* fn = dynamic_cast<vyn::FunctionDeclaration*>(module->body[index].get());
+        REQUIRE(fn != nullptr);
+        REQUIRE(fn->coroutine.lowered);
+        return fn->coroutine;
+    };
+    const size_t header = sizeof(vyn::vre::VreCoroutine);
+    const auto& tick = layout_of(0);
+    REQUIRE(tick.awaitCount == 0);
+    REQUIRE(tick.resultOffset == header);
+    REQUIRE(tick.frameSize == header + 8);
+
+    const auto& add_later = layout_of(1);
+    REQUIRE(add_later.awaitCount == 1);
+    REQUIRE(add_later.slots.size() == 3);
+    REQUIRE(add_later.slots[0].name == "a");
+    REQUIRE(add_later.slots[1].name == "b");
+    REQUIRE(add_later.slots[2].name == "x");
+    REQUIRE(add_later.slots[2].offset == header + 24);
+    REQUIRE(add_later.awaitOffset == header + 32);
+    REQUIRE(add_later.awaitSize == tick.frameSize); // tick's frame is built in place
+    REQUIRE(add_later.frameSize == add_later.awaitOffset + tick.frameSize);
+    auto* fn = static_cast<vyn::FunctionDeclaration*>(module->body[1].get());
+    auto* y = dynamic_cast<vyn::VariableDeclaration*>(fn->body->body[1].get());
+    REQUIRE(y != nullptr);
+    auto* call = static_cast<vyn::CallExpression*>(y->init.get()); // `(await tick)()`
+    REQUIRE(static_cast<vyn::CallExpression*>(call->callee.get())->awaitState == 1);
+
+    REQUIRE(layout_of(2).slots.size() == 3);
+    REQUIRE(layout_of(3).awaitSize == sizeof(void*));
+}
+
+namespace {
+
+// What the lowering of tick and add_later above compiles to. tick is a leaf
+// future that completes once its waker has been fired from outside.
+std::atomic<vyn::vre::VreWaker*> g_tick_waker{nullptr};
+
+struct AddLaterFrame {
+    static constexpr size_t header = sizeof(vyn::vre::VreCoroutine);
+    static constexpr size_t tick_result = header;
+    static constexpr uint32_t tick_size = header + 8;
+    static constexpr size_t result = header, a = header + 8, b = header + 16, x = header + 24;
+    static constexpr size_t await_area = header + 32;
+    static constexpr uint32_t size = await_area + tick_size;
+};
+
+vyn::vre::VrePoll tick_resume(vyn::vre::VreCoroutine* self, vyn::vre::VreWaker& waker) {
+    using vyn::vre::VrePoll;
+    if (self->state == 0) {
+        self->state = 1;
+        g_tick_waker.store(&waker);
+        return VrePoll::PENDING;
+    }
+    *self->slot<int64_t>(AddLaterFrame::tick_result) = 1;
+    return VrePoll::READY;
+}
+
+vyn::vre::VrePoll add_later_resume(vyn::vre::VreCoroutine* self, vyn::vre::VreWaker& waker) {
+    using vyn::vre::VrePoll;
+    using F = AddLaterFrame;
+    if (self->state == 0) {
+        *self->slot<int64_t>(F::x) = *self->slot<int64_t>(F::a) * 2;
+        self->start_callee(F::await_area, tick_resume, F::tick_size);
+        self->state = 1;
+    }
+    auto* callee = self->slot<vyn::vre::VreCoroutine>(F::await_area);
+    if (callee->poll(waker) == VrePoll::PENDING) return VrePoll::PENDING;
+    int64_t y = *callee->slot<int64_t>(F::tick_result);
+    *self->slot<int64_t>(F::result) = *self->slot<int64_t>(F::x) + y + *self->slot<int64_t>(F::b);
+    return VrePoll::READY;
+}
+
+} // namespace
+
+TEST_CASE("Lowered coroutines run on the executor without per-await allocation", "[vre]") {
+    using namespace vyn::vre;
+    VreExecutor executor(2);
+    VreCoroutine* frame = VreCoroutine::create(add_later_resume, AddLaterFrame::size);
+    *frame->slot<int64_t>(AddLaterFrame::a) = 5;
+    *frame->slot<int64_t>(AddLaterFrame::b) = 7;
+
+    std::thread timer([] {
+        VreWaker* waker;
+        while (!(waker = g_tick_waker.load())) std::this_thread::yield();
+        waker->wake();
+    });
+    uint64_t allocations = allocator_stats().allocations;
+    executor.block_on(frame);
+    timer.join();
+    REQUIRE(allocator_stats().allocations - allocations == 1); // the executor's task, not the await
+    REQUIRE(frame->state == VreCoroutine::DONE);
+    REQUIRE(*frame->slot<int64_t>(AddLaterFrame::result) == 18);
+
+    struct NeverWoken final : VreWaker {
+        void wake() override { FAIL("finished coroutine registered a waker"); }
+    } never;
+    REQUIRE(frame->poll(never) == VrePoll::READY); // finished coroutines stay finished
+    VreCoroutine::destroy(frame);
+}
+
+TEST_CASE("Channel queues keep FIFO order and respect capacity", "[vre]") {
+    using namespace vyn::vre;
+    VreBoundedQueue<std::string> bounded(3);
+    REQUIRE(bounded.capacity() == 4);
+    for (int i = 0; i < 4; ++i) REQUIRE(bounded.try_push(std::to_string(i)));
+    REQUIRE(bounded.full());
+    std::string rejected = "rejected";
+    REQUIRE_FALSE(bounded.try_push(std::move(rejected)));
+    REQUIRE(rejected == "rejected"); // not moved from
+    for (int lap = 0; lap < 3; ++lap) { // wrap around the ring
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(*bounded.try_pop() == std::to_string(lap * 4 + i));
+            REQUIRE(bounded.try_push(std::to_string(lap * 4 + i + 4)));
+        }
+    }
+    REQUIRE_FALSE(bounded.empty());
+
+    // Crosses many blocks; what is left is destroyed with the queue
+    auto tracked = std::make_shared<int>(0);
+    {
+        VreSegmentedQueue<std::shared_ptr<int>> unbounded;
+        REQUIRE_FALSE(unbounded.try_pop());
+        for (int i = 0; i < 1000; ++i) unbounded.try_push(std::shared_ptr<int>(tracked));
+        for (int i = 0; i < 700; ++i) REQUIRE(unbounded.try_pop().has_value());
+        REQUIRE(tracked.use_count() == 301);
+    }
+    REQUIRE(tracked.use_count() == 1);
+}
+
+namespace {
+
+// Four producers send 0..n-1 each, four consumers receive until the channel
+// closes; returns the sum received
+template<typename Channel>
+int64_t run_channel_mpmc(Channel& channel, int64_t n) {
+    std::atomic<int64_t> sum{0};
+    std::vector<std::thread> producers, consumers;
+    for (int t = 0; t < 4; ++t) {
+        consumers.emplace_back([&] {
+            int64_t local = 0;
+            while (auto value = channel.recv()) local += *value;
+            sum += local;
+        });
+    }
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&] {
+            for (int64_t i = 0; i < n; ++i) channel.send(i);
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    channel.close();
+    for (auto& consumer : consumers) consumer.join();
+    return sum.load();
+}
+
+} // namespace
+
+TEST_CASE("Channels deliver every message under MPMC contention", "[vre]") {
+    using namespace vyn::vre;
+    const int64_t n = 20000;
+    BoundedChannel<int64_t> bounded(8);
+    REQUIRE(run_channel_mpmc(bounded, n) == 4 * n * (n - 1) / 2);
+    UnboundedChannel<int64_t> unbounded;
+    REQUIRE(run_channel_mpmc(unbounded, n) == 4 * n * (n - 1) / 2);
+
+    REQUIRE_THROWS_AS(bounded.send(1), VreChannelClosedError);
+    REQUIRE_FALSE(bounded.recv().has_value());
+    REQUIRE_FALSE(unbounded.try_recv().has_value());
+}
+
+namespace {
+
+// Hand-lowered `async fn produce(ch, n) { for (i in 0..n) { await ch.send(i) } }`
+// and `async fn consume(ch) -> Int { ... while let v = await ch.recv() ... }`
+struct ProducerFrame {
+    vyn::vre::VreCoroutine header;
+    vyn::vre::BoundedChannel<int64_t>* channel;
+    int64_t next;
+    int64_t count;
+    int64_t pending; // the value being sent
+};
+
+struct ConsumerFrame {
+    vyn::vre::VreCoroutine header;
+    vyn::vre::BoundedChannel<int64_t>* channel;
+    std::optional<int64_t> received;
+    int64_t sum;
+};
+
+vyn::vre::VrePoll produce_resume(vyn::vre::VreCoroutine* self, vyn::vre::VreWaker& waker) {
+    using vyn::vre::VrePoll;
+    auto* frame = reinterpret_cast<ProducerFrame*>(self);
+    for (;;) {
+        if (self->state == 0) {
+            if (frame->next == frame->count) {
+                frame->channel->close();
+                return VrePoll::READY;
+            }
+            frame->pending = frame->next++;
+            self->state = 1;
+        }
+        if (frame->channel->poll_send(frame->pending, waker) == VrePoll::PENDING) return VrePoll::PENDING;
+        self->state = 0;
+    }
+}
+
+vyn::vre::VrePoll consume_resume(vyn::vre::VreCoroutine* self, vyn::vre::VreWaker& waker) {
+    using vyn::vre::VrePoll;
+    auto* frame = reinterpret_cast<ConsumerFrame*>(self);
+    self->state = 1;
+    for (;;) {
+        if (frame->channel->poll_recv(frame->received, waker) == VrePoll::PENDING) return VrePoll::PENDING;
+        if (!frame->received) return VrePoll::READY;
+        frame->sum += *frame->received;
+    }
+}
+
+} // namespace
+
+TEST_CASE("Async send and recv suspend tasks instead of blocking workers", "[vre]") {
+    using namespace vyn::vre;
+    BoundedChannel<int64_t> channel(2); // outlives the executor, which may still be finishing the producer
+    // One worker: if a full or empty channel blocked it, the other task could never run
+    VreExecutor executor(1);
+    auto* producer = reinterpret_cast<ProducerFrame*>(VreCoroutine::create(produce_resume, sizeof(ProducerFrame)));
+    producer->channel = &channel;
+    producer->count = 1000;
+    auto* consumer = reinterpret_cast<ConsumerFrame*>(VreCoroutine::create(consume_resume, sizeof(ConsumerFrame)));
+    consumer->channel = &channel;
+    new (&consumer->received) std::optional<int64_t>();
+
+    executor.spawn(&producer->header);
+    executor.block_on(&consumer->header);
+    REQUIRE(consumer->sum == 1000 * 999 / 2);
+    REQUIRE(executor.stats().resumes > 1000 / 2); // the tasks took turns
+    VreCoroutine::destroy(&consumer->header);
+}
+
+TEST_CASE("@parallel loops and comprehensions are checked for independent iterations", "[parser]") {
+    std::string source = R"(fn scale(s: [Float], out: [Float], n: Int) -> [Int] {
+    @parallel for (i in 0..n) {
+        var x = s[i] * 2.0
+        for (j in 0..4) {
+            if (x > 8.0) {
+                break
+            }
+            x = x * x
+        }
+        out[i] = x + s.len()
+    }
+    var total = 0
+    @parallel for (i in 0..n) {
+        total = total + i
+    }
+    @parallel for (i in 0..n) {
+        out[i + 1] = s[i]
+    }
+    @parallel for (i in 0..n) {
+        out.push(s[i])
+    }
+    @parallel for (x in s) {
+        out[0] = x
+    }
+    var squares = @parallel [i * i for i in 0..n]
+    return @parallel [await f(i) for i in 0..n]
+})";
+    Lexer lexer(source, "test39.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test39.vyn");
+    auto module = parser.parse_module();
+
+    auto* fn = dynamic_cast<vyn::FunctionDeclaration*>(module->body[0].get());
+    REQUIRE(fn != nullptr);
+    auto loop = [&](size_t index) {
+        auto* node = dynamic_cast<vyn::ForStatement*>(fn->body->body[index].get());
+        REQUIRE(node != nullptr);
+        return node;
+    };
+    for (size_t index : {0, 2, 3, 4, 5}) REQUIRE(loop(index)->isParallel);
+
+    vyn::ParallelLoopCheck check;
+    std::vector<vyn::ParallelDiagnostic> diagnostics = check.check(module.get());
+    REQUIRE(diagnostics.size() == 5);
+    REQUIRE(diagnostics[0].reason == "@parallel loop assigns 'total', which is shared between iterations");
+    REQUIRE(diagnostics[1].reason == "@parallel loop stores into 'out' at an index other than the loop variable");
+    REQUIRE(diagnostics[2].reason == "@parallel loop calls 'push' on shared 'out'");
+    REQUIRE(diagnostics[3].reason == "@parallel loops must iterate over a range `a..b`");
+    REQUIRE(diagnostics[4].reason == "@parallel comprehension awaits");
+    REQUIRE(diagnostics[0].loc.line == 14);
+
+    REQUIRE(loop(0)->isParallel); // locals, a nested break and out[i] are fine
+    for (size_t index : {2, 3, 4, 5}) REQUIRE_FALSE(loop(index)->isParallel);
+    auto comprehension_of = [](vyn::Expression* expr) {
+        auto* call = dynamic_cast<vyn::CallExpression*>(expr);
+        REQUIRE(call != nullptr);
+        return static_cast<vyn::Identifier*>(call->callee.get())->name;
+    };
+    auto* squares = dynamic_cast<vyn::VariableDeclaration*>(fn->body->body[6].get());
+    REQUIRE(squares != nullptr);
+    REQUIRE(comprehension_of(squares->init.get()) == "_parallel_list_comprehension");
+    auto* ret = dynamic_cast<vyn::ReturnStatement*>(fn->body->body[7].get());
+    REQUIRE(ret != nullptr);
+    REQUIRE(comprehension_of(ret->argument.get()) == "_list_comprehension");
+
+    std::string bad = R"(fn f() {
+    @inline for (i in 0..3) {
+    }
+})";
+    Lexer bad_lexer(bad, "test40.vyn");
+    auto bad_tokens = bad_lexer.tokenize();
+    vyn::Parser bad_parser(bad_tokens, "test40.vyn");
+    REQUIRE_THROWS_AS(bad_parser.parse_module(), std::runtime_error);
+}
+
+TEST_CASE("@parallel loops reject loop-carried reads and calls with effects", "[parser]") {
+    std::string source = R"(fn twice(x: Int) -> Int {
+    x = x * 2
+    return x
+}
+fn log(x: Int) -> Int {
+    println(x)
+    return x
+}
+fn fill(a: [Int], x: Int) -> Int {
+    a[0] = x
+    return x
+}
+fn shift(a: [Int], b: [Int], n: Int) {
+    @parallel for (i in 0..n) {
+        a[i] = a[i + 1] + 1
+    }
+    @parallel for (i in 0..n) {
+        a[i] = twice(a[i]) + b[i + 1] + a.len()
+    }
+    @parallel for (i in 0..n) {
+        a[i] = log(i)
+    }
+    @parallel for (i in 0..n) {
+        b[i] = fill(a, i)
+    }
+    @parallel for (i in 0..n) {
+        b[i] = missing(i)
+    }
+    var doubled = @parallel [twice(i) for i in 0..n]
+    var logged = @parallel [log(i) for i in 0..n]
+})";
+    Lexer lexer(source, "test56.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test56.vyn");
+    auto module = parser.parse_module();
+
+    std::vector<vyn::ParallelDiagnostic> diagnostics = vyn::ParallelLoopCheck().check(module.get());
+    REQUIRE(diagnostics.size() == 5);
+    CHECK(diagnostics[0].reason ==
+          "@parallel loop reads 'a' at an index other than the loop variable, which another iteration stores into");
+    CHECK(diagnostics[0].loc.line == 15);
+    CHECK(diagnostics[1].reason == "@parallel loop calls 'log', which may have effects");
+    CHECK(diagnostics[2].reason == "@parallel loop calls 'fill', which may have effects");
+    CHECK(diagnostics[3].reason == "@parallel loop calls 'missing', which may have effects");
+    CHECK(diagnostics[4].reason == "@parallel comprehension calls 'log', which may have effects");
+
+    auto* fn = dynamic_cast<vyn::FunctionDeclaration*>(module->body[3].get());
+    REQUIRE(fn != nullptr);
+    auto* own = dynamic_cast<vyn::ForStatement*>(fn->body->body[1].get());
+    REQUIRE(own != nullptr);
+    CHECK(own->isParallel); // reads a[i], a pure function and another array
+}
+
+TEST_CASE("parallel_for splits ranges across workers and collects in place", "[vre]") {
+    using namespace vyn::vre;
+    VreExecutor executor(4);
+
+    const int64_t n = 100000;
+    std::vector<int64_t> squares(n, -1);
+    parallel_for(executor, 0, n, [&](int64_t i) { squares[i] = i * i; });
+    bool all_set = true;
+    for (int64_t i = 0; i < n; ++i) all_set = all_set && squares[i] == i * i;
+    REQUIRE(all_set);
+    REQUIRE(executor.stats().frames_completed > 1);
+
+    std::atomic<int64_t> chunks{0};
+    std::atomic<int64_t> covered{0};
+    parallel_for_chunks(
+        executor, 10, 1010,
+        [&](int64_t lo, int64_t hi) {
+            REQUIRE(hi - lo <= 64);
+            chunks.fetch_add(1);
+            covered.fetch_add(hi - lo);
+        },
+        64);
+    REQUIRE(covered.load() == 1000);
+    REQUIRE(chunks.load() == 16);
+    parallel_for(executor, 5, 5, [&](int64_t) { chunks.fetch_add(1); });
+    REQUIRE(chunks.load() == 16); // an empty range runs nothing
+
+    VreArray ints = parallel_collect<int64_t>(executor, -3, 997, [](int64_t i) { return i * 3; });
+    REQUIRE(ints.kind() == VreArrayKind::INT);
+    REQUIRE(ints.size() == 1000);
+    REQUIRE(ints.int_data()[0] == -9);
+    REQUIRE(ints.int_data()[999] == 2988);
+
+    VreArray floats = parallel_collect<double>(executor, 0, 1000, [](int64_t i) { return i * 0.5; });
+    REQUIRE(floats.kind() == VreArrayKind::FLOAT);
+    REQUIRE(floats.float_data()[999] == 499.5);
+
+    VreArray boxed = parallel_collect<VreValue>(executor, 0, 300, [](int64_t i) { return VreValue(std::to_string(i)); });
+    REQUIRE(boxed.kind() == VreArrayKind::GENERIC);
+    REQUIRE(boxed.size() == 300);
+    REQUIRE(std::get<VreString>(boxed.generic_data()[123].data) == "123");
+
+    // A nested loop runs inline on the worker that reached it
+    std::atomic<int64_t> nested{0};
+    parallel_for(executor, 0, 64, [&](int64_t) {
+        parallel_for(executor, 0, 100, [&](int64_t j) { nested.fetch_add(j, std::memory_order_relaxed); });
+    });
+    REQUIRE(nested.load() == 64 * 4950);
+
+    std::atomic<int64_t> ran{0};
+    std::string error;
+    try {
+        parallel_for(
+            executor, 0, n,
+            [&](int64_t i) {
+                ran.fetch_add(1, std::memory_order_relaxed);
+                if (i == 500) throw std::runtime_error("bad element");
+            },
+            100);
+    } catch (const std::runtime_error& e) {
+        error = e.what();
+    }
+    REQUIRE(error == "bad element");
+    REQUIRE(ran.load() < n); // chunks not yet started when it threw were skipped
+}
+
+TEST_CASE("throw and try/catch/finally lower to error edges", "[parser]") {
+    std::string source = R"(fn parse_digit(c: Int) -> Int {
+    if (c < 48) {
+        throw ParseError(c)
+    }
+    return c - 48
+}
+fn parse_pair(a: Int, b: Int) -> Int {
+    return parse_digit(a) * 10 + parse_digit(b)
+}
+fn safe(a: Int) -> Int {
+    try {
+        return parse_pair(a, a)
+    } catch (e) {
+        return 0 - 1
+    }
+}
+fn typed(a: Int) -> Int {
+    var r = 0
+    try {
+        r = parse_digit(a)
+    } catch (e: IOError) {
+        r = 1
+    } catch (e: ParseError) {
+        r = 2
+    } finally {
+        log(r)
+    }
+    return r
+}
+fn cleanup(a: Int) -> Int {
+    try {
+        try {
+            return parse_digit(a)
+        } finally {
+            log(1)
+        }
+    } catch (e) {
+        throw e
+    } finally {
+        log(2)
+    }
+}
+fn declared() -> Int throws IOError
+fn pure(a: Int) -> Int {
+    return safe(a) + 1
+})";
+    Lexer lexer(source, "test41.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test41.vyn");
+    auto module = parser.parse_module();
+
+    vyn::ErrorLowering pass;
+    vyn::ErrorLoweringReport report = pass.run(module.get());
+    REQUIRE(report.failingFunctions == 5);
+    REQUIRE(report.throwSites == 2);
+    REQUIRE(report.checkedCalls == 5);
+    REQUIRE(report.uncheckedCalls == 5); // ParseError, safe and three logs
+    REQUIRE(report.handledSites == 3);
+    REQUIRE(report.cleanupEdges == 2);
+
+    auto fn = [&](size_t index) {
+        auto* node = dynamic_cast<vyn::FunctionDeclaration*>(module->body[index].get());
+        REQUIRE(node != nullptr);
+        return node;
+    };
+    std::vector<bool> can_fail;
+    for (size_t i = 0; i < module->body.size(); ++i) can_fail.push_back(fn(i)->canFail);
+    REQUIRE(can_fail == std::vector<bool>{true, true, false, true, true, true, false});
+    REQUIRE(fn(5)->throwsTypeNode != nullptr);
+
+    auto* typed_try = dynamic_cast<vyn::TryStatement*>(fn(3)->body->body[1].get());
+    REQUIRE(typed_try != nullptr);
+    REQUIRE(typed_try->catches.size() == 2);
+    REQUIRE(*typed_try->catches[1].errorType == "ParseError");
+    REQUIRE(typed_try->unmatched.target == vyn::ErrorTarget::RETURN);
+    REQUIRE(typed_try->unmatched.cleanups == 1);
+
+    auto* outer = dynamic_cast<vyn::TryStatement*>(fn(4)->body->body[0].get());
+    REQUIRE(outer != nullptr);
+    REQUIRE(outer->unmatched.target == vyn::ErrorTarget::NONE); // catch (e) takes everything
+    auto* inner = dynamic_cast<vyn::TryStatement*>(outer->tryBlock->body[0].get());
+    REQUIRE(inner != nullptr);
+    auto* ret = dynamic_cast<vyn::ReturnStatement*>(inner->tryBlock->body[0].get());
+    auto* call = dynamic_cast<vyn::CallExpression*>(ret->argument.get());
+    REQUIRE(call != nullptr);
+    REQUIRE(call->errorEdge.target == vyn::ErrorTarget::HANDLER);
+    REQUIRE(call->errorEdge.cleanups == 1); // the inner finally runs before the outer catch
+    auto* rethrow = dynamic_cast<vyn::ExpressionStatement*>(outer->catches[0].block->body[0].get());
+    REQUIRE(rethrow != nullptr);
+    auto* throw_call = dynamic_cast<vyn::CallExpression*>(rethrow->expression.get());
+    REQUIRE(throw_call != nullptr);
+    REQUIRE(static_cast<vyn::Identifier*>(throw_call->callee.get())->name == "_throw");
+    REQUIRE(throw_call->errorEdge.target == vyn::ErrorTarget::RETURN);
+    REQUIRE(throw_call->errorEdge.cleanups == 1);
+}
+
+namespace {
+
+// parse_digit and typed() from the lowering test, lowered by hand
+vyn::vre::VreResult<int64_t> lowered_parse_digit(int64_t c) {
+    using namespace vyn::vre;
+    if (c < 48) return VreError{vre_error_type("ParseError"), VreValue(c)};
+    return c - 48;
+}
+
+vyn::vre::VreResult<int64_t> lowered_typed(int64_t a, std::vector<int64_t>& log) {
+    using namespace vyn::vre;
+    int64_t r = 0;
+    VreResult<int64_t> digit = lowered_parse_digit(a);
+    if (digit.is_err()) {
+        if (digit.error().is(vre_error_type("IOError"))) {
+            r = 1;
+        } else if (digit.error().is(vre_error_type("ParseError"))) {
+            r = 2;
+        } else {
+            log.push_back(r); // the unmatched edge runs the finally block
+            return vre_failed;
+        }
+    } else {
+        r = digit.value();
+    }
+    log.push_back(r);
+    return r;
+}
+
+} // namespace
+
+TEST_CASE("VreResult carries typed errors through lowered calls", "[vre]") {
+    using namespace vyn::vre;
+    REQUIRE(vre_error_type("") == 0);
+    uint32_t parse_error = vre_error_type("ParseError");
+    REQUIRE(parse_error != 0);
+    REQUIRE(vre_error_type("ParseError") == parse_error);
+    REQUIRE(vre_error_type("IOError") != parse_error);
+    REQUIRE(vre_error_type_name(parse_error) == "ParseError");
+
+    VreResult<int64_t> ok = lowered_parse_digit(55);
+    REQUIRE(ok.is_ok());
+    REQUIRE(ok.value() == 7);
+    VreResult<int64_t> failed = lowered_parse_digit(20);
+    REQUIRE(failed.is_err());
+    REQUIRE(failed.error().is(parse_error));
+    REQUIRE(std::get<int64_t>(failed.error().payload.data) == 20);
+    REQUIRE_THROWS_AS(failed.value(), VreUncaughtError);
+
+    std::vector<int64_t> log;
+    REQUIRE(lowered_typed(57, log).value() == 9);
+    REQUIRE(lowered_typed(1, log).value() == 2);
+    REQUIRE(log == std::vector<int64_t>{9, 2});
+
+    VreResult<void> done;
+    REQUIRE(done.is_ok());
+    REQUIRE_NOTHROW(done.value());
+    VreResult<void> untyped(VreError{0, VreValue("oops")});
+    REQUIRE(untyped.is_err());
+    REQUIRE(untyped.take_error().type == 0);
+}
+
+TEST_CASE("defer lowers to cleanup code inlined at every scope exit", "[parser]") {
+    std::string source = R"(fn process(items: [Int], n: Int) -> Int {
+    var total = 0
+    open_log()
+    defer close_log()
+    for (i in 0..n) {
+        var h = acquire(i)
+        defer release(h)
+        if (items[i] < 0) {
+            break
+        }
+        if (items[i] == 0) {
+            continue
+        }
+        defer {
+            flush(h)
+            total = total + 1
+        }
+        if (items[i] > 100) {
+            return total
+        }
+    }
+    try {
+        defer note(1)
+        check(total)
+    } catch (e) {
+        return 0
+    } finally {
+        note(2)
+    }
+    return total
+}
+fn check(x: Int) -> Int {
+    defer note(3)
+    if (x < 0) {
+        throw BadTotal(x)
+    }
+    return x
+})";
+    Lexer lexer(source, "test42.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test42.vyn");
+    auto module = parser.parse_module();
+
+    vyn::ErrorLowering errors;
+    errors.run(module.get());
+    vyn::DeferLowering pass;
+    vyn::DeferReport report = pass.run(module.get());
+    REQUIRE(report.defers == 5);
+    REQUIRE(report.exits == 12);
+    REQUIRE(report.inlinedCleanups == 16);
+
+    auto* process = dynamic_cast<vyn::FunctionDeclaration*>(module->body[0].get());
+    REQUIRE(process != nullptr);
+    auto& body = process->body->body;
+    auto* close_log = dynamic_cast<vyn::DeferStatement*>(body[2].get());
+    REQUIRE(close_log != nullptr);
+    REQUIRE(process->body->exitCleanups == vyn::CleanupList{close_log->body.get()});
+
+    auto* loop = dynamic_cast<vyn::ForStatement*>(body[3].get());
+    REQUIRE(loop != nullptr);
+    auto* loop_body = dynamic_cast<vyn::BlockStatement*>(loop->body.get());
+    REQUIRE(loop_body != nullptr);
+    vyn::Statement* release = static_cast<vyn::DeferStatement*>(loop_body->body[1].get())->body.get();
+    vyn::Statement* flush = static_cast<vyn::DeferStatement*>(loop_body->body[4].get())->body.get();
+    REQUIRE(loop_body->exitCleanups == vyn::CleanupList{flush, release});
+    auto first_in = [](vyn::Statement* stmt) {
+        auto* branch = dynamic_cast<vyn::IfStatement*>(stmt);
+        REQUIRE(branch != nullptr);
+        auto* block = dynamic_cast<vyn::BlockStatement*>(branch->consequent.get());
+        REQUIRE(block != nullptr);
+        return block->body[0].get();
+    };
+    auto* brk = dynamic_cast<vyn::BreakStatement*>(first_in(loop_body->body[2].get()));
+    REQUIRE(brk != nullptr);
+    REQUIRE(brk->cleanups == vyn::CleanupList{release}); // `flush` is not registered yet
+    auto* cont = dynamic_cast<vyn::ContinueStatement*>(first_in(loop_body->body[3].get()));
+    REQUIRE(cont != nullptr);
+    REQUIRE(cont->cleanups == vyn::CleanupList{release});
+    auto* early = dynamic_cast<vyn::ReturnStatement*>(first_in(loop_body->body[5].get()));
+    REQUIRE(early != nullptr);
+    REQUIRE(early->cleanups == vyn::CleanupList{flush, release, close_log->body.get()});
+
+    auto* guarded = dynamic_cast<vyn::TryStatement*>(body[4].get());
+    REQUIRE(guarded != nullptr);
+    vyn::Statement* note1 = static_cast<vyn::DeferStatement*>(guarded->tryBlock->body[0].get())->body.get();
+    auto* check_call = dynamic_cast<vyn::CallExpression*>(
+        static_cast<vyn::ExpressionStatement*>(guarded->tryBlock->body[1].get())->expression.get());
+    REQUIRE(check_call != nullptr);
+    REQUIRE(check_call->errorEdge.target == vyn::ErrorTarget::HANDLER);
+    REQUIRE(check_call->errorCleanups == vyn::CleanupList{note1});
+    auto* in_catch = dynamic_cast<vyn::ReturnStatement*>(guarded->catches[0].block->body[0].get());
+    REQUIRE(in_catch != nullptr);
+    REQUIRE(in_catch->cleanups == vyn::CleanupList{guarded->finallyBlock.get(), close_log->body.get()});
+
+    std::string bad = R"(fn f() -> Int {
+    defer {
+        for (i in 0..3) {
+            break
+        }
+        return 1
+    }
+    return 0
+})";
+    Lexer bad_lexer(bad, "test43.vyn");
+    auto bad_tokens = bad_lexer.tokenize();
+    vyn::Parser bad_parser(bad_tokens, "test43.vyn");
+    auto bad_module = bad_parser.parse_module();
+    vyn::DeferLowering bad_pass;
+    REQUIRE_THROWS_AS(bad_pass.run(bad_module.get()), std::runtime_error);
+}
+
+TEST_CASE("Struct layouts and trait impls build the runtime type table", "[parser]") {
+    std::string source = R"(struct Vec2 { x: f32, y: f32 }
+struct Node {
+    live: Bool,
+    label: String,
+    pos: Vec2,
+    next: our<Node>,
+    weight: Float,
+    owner: my<Vec2>,
+    extra: Any
+}
+struct Pair<T> { a: T, b: T }
+impl Shape for Node {
+    fn area(n: Node) -> Float {
+        return n.weight
+    }
+}
+impl Shape for Vec2 {
+    fn area(v: Vec2) -> Float {
+        return 0.0
+    }
+}
+impl Named for Node {
+    fn name(n: Node) -> String {
+        return n.label
+    }
+}
+impl Shape for Int {
+    fn area(i: Int) -> Float {
+        return 0.0
+    }
+})";
+    Lexer lexer(source, "test44.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test44.vyn");
+    auto module = parser.parse_module();
+    vyn::TypeTableGenerator generator;
+    vyn::vre::VreTypeTable table = generator.run(module.get());
+
+    auto* vec2 = static_cast<vyn::StructDeclaration*>(module->body[0].get());
+    auto* node = static_cast<vyn::StructDeclaration*>(module->body[1].get());
+    auto* pair = static_cast<vyn::StructDeclaration*>(module->body[2].get());
+    REQUIRE(vec2->typeId == 1);
+    REQUIRE(node->typeId == 2);
+    REQUIRE(pair->typeId == 0); // generic: laid out per instantiation, not here
+    REQUIRE(table.type_count() == 3);
+
+    CHECK(table.type(vec2->typeId).size == 8);
+    CHECK(table.type(vec2->typeId).align == 4);
+    CHECK(std::string(table.type(node->typeId).name) == "Node");
+
+    // Packed by decreasing alignment: the Bool goes last, not first
+    const auto* live = table.find_field(node->typeId, "live");
+    const auto* pos = table.find_field(node->typeId, "pos");
+    const auto* next = table.find_field(node->typeId, "next");
+    const auto* extra = table.find_field(node->typeId, "extra");
+    REQUIRE(live);
+    REQUIRE(pos);
+    REQUIRE(next);
+    REQUIRE(extra);
+    for (const auto& field : table.fields(node->typeId)) {
+        if (&field != live) CHECK(field.offset < live->offset);
+        CHECK(field.offset % std::min<uint32_t>(field.size, 8) == 0);
+    }
+    CHECK(pos->kind == vyn::vre::VreFieldKind::STRUCT);
+    CHECK(pos->type == vec2->typeId);
+    CHECK(table.find_field(node->typeId, "owner")->kind == vyn::vre::VreFieldKind::RAW);
+    CHECK(extra->kind == vyn::vre::VreFieldKind::VALUE);
+    // Traced slots: next (our<Node>) and extra (a VreValue), not owner
+    REQUIRE(table.pointers(node->typeId).size() == 2);
+    CHECK(table.pointers(vec2->typeId).size() == 0);
+
+    int64_t shape = table.find_trait("Shape");
+    int64_t named = table.find_trait("Named");
+    REQUIRE(shape == 0);
+    REQUIRE(named == 1);
+    CHECK(table.implements(node->typeId, 0));
+    CHECK(table.implements(node->typeId, 1));
+    CHECK(table.implements(vec2->typeId, 0));
+    CHECK_FALSE(table.implements(vec2->typeId, 1));
+    CHECK_FALSE(table.implements(vyn::vre::VRE_DYNAMIC_TYPE, 0));
+    CHECK(table.vtable(node->typeId, 0) == nullptr); // filled in by the code generator
+    CHECK(table.sole_implementor(1) == node->typeId);
+    CHECK(table.sole_implementor(0) == vyn::vre::VRE_DYNAMIC_TYPE);
+
+    std::string recursive = R"(struct Link { value: Int, rest: Link })";
+    Lexer bad_lexer(recursive, "test45.vyn");
+    auto bad_tokens = bad_lexer.tokenize();
+    vyn::Parser bad_parser(bad_tokens, "test45.vyn");
+    auto bad_module = bad_parser.parse_module();
+    vyn::TypeTableGenerator bad_generator;
+    REQUIRE_THROWS_AS(bad_generator.run(bad_module.get()), std::runtime_error);
+}
+
+namespace {
+
+struct NativeInner {
+    vyn::vre::our<Counted> ref;
+    int64_t count = 0;
+};
+
+struct NativeOuter {
+    vyn::vre::VreString name;
+    NativeInner inner;
+    vyn::vre::VreValue value;
+};
+
+void collect_child(vyn::vre::VreRcHeader* child, void* context) {
+    static_cast<std::vector<vyn::vre::VreRcHeader*>*>(context)->push_back(child);
+}
+
+} // namespace
+
+TEST_CASE("VreTypeTable traces and drops through flattened pointer maps", "[vre]") {
+    using namespace vyn::vre;
+    VreTypeTableBuilder builder;
+    VreTypeId inner = builder.add_native<NativeInner>(
+        "Inner", {{"ref", offsetof(NativeInner, ref), 8, VreFieldKind::REF},
+                  {"count", offsetof(NativeInner, count), 8, VreFieldKind::INT}});
+    VreTypeId outer = builder.add_type(
+        "Outer", sizeof(NativeOuter), alignof(NativeOuter),
+        {{"name", offsetof(NativeOuter, name), sizeof(VreString), VreFieldKind::STRING},
+         {"inner", offsetof(NativeOuter, inner), sizeof(NativeInner), VreFieldKind::STRUCT, inner},
+         {"value", offsetof(NativeOuter, value), sizeof(VreValue), VreFieldKind::VALUE}});
+    VreTraitId drawable = builder.add_trait("Drawable");
+    static const VreVtableHeader vtable_marker{};
+    builder.implement(outer, drawable, &vtable_marker);
+    REQUIRE_THROWS_AS(builder.add_type("Broken", 4, 4, {{"x", 0, 8, VreFieldKind::INT}}), std::invalid_argument);
+    REQUIRE_THROWS_AS(builder.add_type("Ahead", 8, 8, {{"x", 0, 8, VreFieldKind::STRUCT, 99}}),
+                      std::invalid_argument);
+    VreTypeTable table = builder.build();
+
+    CHECK(table.type(inner).drop != nullptr); // our<T> has a destructor
+    CHECK(table.type(outer).drop == nullptr); // dropped by field kind
+    REQUIRE(table.pointers(outer).size() == 2);
+    CHECK(table.pointers(outer)[0].offset == offsetof(NativeOuter, inner) + offsetof(NativeInner, ref));
+    CHECK(table.implements(outer, drawable));
+    CHECK_FALSE(table.implements(inner, drawable));
+    CHECK(table.vtable(outer, drawable) == &vtable_marker);
+    CHECK(table.find_type("Outer") == outer);
+    CHECK(table.find_type("Missing") == -1);
+
+    std::atomic<int> destroyed{0};
+    alignas(NativeOuter) unsigned char storage[sizeof(NativeOuter)];
+    auto* object = new (storage) NativeOuter{VreString("outer"), {make_our<Counted>(1, &destroyed), 3}, VreValue()};
+    our<Counted> shared = object->inner.ref;
+
+    std::vector<VreRcHeader*> children;
+    table.trace(object, outer, collect_child, &children);
+    REQUIRE(children.size() == 1);
+    CHECK(children[0] == shared.header());
+
+    REQUIRE(shared.use_count() == 2);
+    table.drop(object, outer);
+    CHECK(shared.use_count() == 1);
+    CHECK(destroyed == 0);
+    shared = our<Counted>();
+    CHECK(destroyed == 1);
+}
+
+namespace {
+
+struct SmallShape {
+    int64_t side;
+    std::atomic<int>* destroyed;
+    SmallShape(int64_t s, std::atomic<int>* d) : side(s), destroyed(d) {}
+    SmallShape(SmallShape&& other) noexcept : side(other.side), destroyed(other.destroyed) { other.destroyed = nullptr; }
+    ~SmallShape() {
+        if (destroyed) ++*destroyed;
+    }
+};
+
+struct LargeShape {
+    int64_t sides[8];
+    std::atomic<int>* destroyed;
+    LargeShape(int64_t s, std::atomic<int>* d) : sides{s, s, s, s, s, s, s, s}, destroyed(d) {}
+    LargeShape(LargeShape&& other) noexcept : LargeShape(other.sides[0], other.destroyed) { other.destroyed = nullptr; }
+    ~LargeShape() {
+        if (destroyed) ++*destroyed;
+    }
+};
+
+int64_t small_area(void* self) { return static_cast<SmallShape*>(self)->side * static_cast<SmallShape*>(self)->side; }
+int64_t small_scaled(void* self, int64_t k) { return static_cast<SmallShape*>(self)->side * k; }
+int64_t large_area(void* self) { return static_cast<LargeShape*>(self)->sides[7] * 100; }
+int64_t large_scaled(void* self, int64_t k) { return static_cast<LargeShape*>(self)->sides[0] * k * 100; }
+
+} // namespace
+
+TEST_CASE("Trait objects store small values inline and dispatch through compact vtables", "[vre]") {
+    using namespace vyn::vre;
+    static const auto small_vtable = vre_vtable_for<SmallShape>(1, small_area, small_scaled);
+    static const auto large_vtable = vre_vtable_for<LargeShape>(2, large_area, large_scaled);
+    CHECK(small_vtable.header.size == sizeof(SmallShape));
+    CHECK(small_vtable.header.method_count == 2);
+    CHECK(sizeof(small_vtable) == sizeof(VreVtableHeader) + 2 * sizeof(VreMethod));
+
+    std::atomic<int> destroyed{0};
+    {
+        VreTraitObject small = VreTraitObject::make<SmallShape>(&small_vtable.header, 3, &destroyed);
+        VreTraitObject large = VreTraitObject::make<LargeShape>(&large_vtable.header, 2, &destroyed);
+        CHECK(small.is_inline());
+        CHECK_FALSE(large.is_inline());
+        CHECK(small.type() == 1);
+        CHECK(small.call<int64_t>(0) == 9);
+        CHECK(small.call<int64_t>(1, int64_t{5}) == 15);
+        CHECK(large.call<int64_t>(0) == 200);
+
+        // Moving relocates an inline value and steals a heap one
+        void* large_data = large.data();
+        VreTraitObject moved_small = std::move(small);
+        VreTraitObject moved_large = std::move(large);
+        CHECK_FALSE(small);
+        CHECK(moved_large.data() == large_data);
+        CHECK(moved_small.call<int64_t>(0) == 9);
+        CHECK(destroyed == 0);
+
+        SmallShape loose(4, &destroyed);
+        VreTraitObject adopted = VreTraitObject::relocate_from(&small_vtable.header, &loose);
+        CHECK(adopted.call<int64_t>(0) == 16);
+        moved_small = std::move(adopted); // drops the 3
+        CHECK(destroyed == 1);
+        CHECK(moved_small.call<int64_t>(0) == 16);
+        new (&loose) SmallShape(0, nullptr); // relocate_from destroyed it; give its destructor an object
+    }
+    CHECK(destroyed == 3);
+
+    std::vector<VreTraitObject> shapes;
+    for (int64_t i = 1; i <= 4; ++i) shapes.push_back(VreTraitObject::make<SmallShape>(&small_vtable.header, i, nullptr));
+    VreDispatchSite site;
+    CHECK(site.state() == VreDispatchSite::State::UNINITIALIZED);
+    int64_t total = 0;
+    for (auto& shape : shapes) total += site.call<int64_t>(shape, 0);
+    CHECK(total == 1 + 4 + 9 + 16);
+    CHECK(site.state() == VreDispatchSite::State::MONOMORPHIC);
+    CHECK(site.monomorphic_vtable() == &small_vtable.header);
+    CHECK(site.misses() == 1);
+
+    // The guarded fast path agrees with the vtable on both sides of the guard
+    VreTraitObject other = VreTraitObject::make<LargeShape>(&large_vtable.header, 1, nullptr);
+    CHECK(vre_guarded_call<small_area>(shapes[2], &small_vtable.header, 0) == 9);
+    CHECK(vre_guarded_call<small_area>(other, &small_vtable.header, 0) == 100);
+    CHECK(vre_guarded_call<small_scaled>(other, &small_vtable.header, 1, int64_t{2}) == 200);
+
+    site.call<int64_t>(other, 0);
+    CHECK(site.state() == VreDispatchSite::State::POLYMORPHIC);
+    CHECK(site.monomorphic_vtable() == nullptr);
+    site.call<int64_t>(shapes[0], 0);
+    CHECK(site.state() == VreDispatchSite::State::POLYMORPHIC);
+    CHECK(site.calls() == 6);
+}
+
+TEST_CASE("Closures capture enclosing variables into flat environments", "[parser]") {
+    std::string source = R"(fn make(start: Int, label: String, items: their<Buffer>) -> Int {
+    var step = 2
+    var flag = true
+    var add = fn (x: Int) => x + start + step
+    var report = fn (n: Int) -> Int {
+        var local = n * 2
+        log(label, local, flag)
+        items.push(n)
+        var inner = fn () => local + step
+        return inner()
+    }
+    var pure = fn (a: Int, b: Int) => a * b
+    var r = borrow items
+    var peek = fn () => r.len()
+    for (i in 0..10) {
+        var each = fn () => i + start
+    }
+    return add(1)
+})";
+    Lexer lexer(source, "test46.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test46.vyn");
+    auto module = parser.parse_module();
+
+    std::vector<vyn::ClosureExpression*> closures;
+    struct Closures : vyn::AstWalker {
+        std::vector<vyn::ClosureExpression*>* out;
+        using AstWalker::visit;
+        void visit(vyn::ClosureExpression* node) override {
+            out->push_back(node);
+            AstWalker::visit(node);
+        }
+    } finder;
+    finder.out = &closures;
+    finder.walk(module.get());
+    REQUIRE(closures.size() == 6); // add, report, inner, pure, peek, each
+
+    vyn::ClosureReport report = vyn::ClosureConversion().run(module.get());
+    CHECK(report.closures == 6);
+    CHECK(report.emptyClosures == 1);
+    CHECK(report.byReference == 2); // items in report, r in peek
+
+    auto names = [](vyn::ClosureExpression* closure) {
+        std::vector<std::string> result;
+        for (const auto& capture : closure->layout.captures) result.push_back(capture.name);
+        return result;
+    };
+    auto* add = closures[0];
+    auto* reporter = closures[1];
+    auto* inner = closures[2];
+    auto* pure = closures[3];
+    auto* peek = closures[4];
+    auto* each = closures[5];
+
+    // Parameters and functions (log) are not captured
+    CHECK(names(add) == std::vector<std::string>{"start", "step"});
+    CHECK(add->layout.envSize == 16);
+    // First-use order, including what the nested closure uses (step)
+    CHECK(names(reporter) == std::vector<std::string>{"label", "flag", "items", "step"});
+    CHECK(names(inner) == std::vector<std::string>{"local", "step"});
+    CHECK(pure->layout.converted);
+    CHECK(pure->layout.captures.empty());
+    CHECK(pure->layout.envSize == 0);
+    CHECK(names(each) == std::vector<std::string>{"i", "start"});
+    CHECK(each->layout.envSize == 16);
+
+    const auto& captures = reporter->layout.captures;
+    CHECK(captures[0].mode == vyn::CaptureMode::BY_VALUE);
+    CHECK(captures[0].size == sizeof(vyn::vre::VreString));
+    CHECK(captures[1].size == 1);
+    CHECK(captures[2].mode == vyn::CaptureMode::BY_REFERENCE);
+    CHECK(captures[2].size == sizeof(void*));
+    CHECK(captures[1].offset == reporter->layout.envSize - 8); // the Bool is packed last
+    CHECK(peek->layout.captures[0].mode == vyn::CaptureMode::BY_REFERENCE);
+    for (auto* closure : closures) {
+        for (const auto& capture : closure->layout.captures) {
+            CHECK(capture.offset % capture.align == 0);
+            CHECK(capture.offset + capture.size <= closure->layout.envSize);
+        }
+    }
+}
+
+namespace {
+
+struct AdderEnv {
+    int64_t base;
+    vyn::vre::VreString label;
+};
+
+int64_t add_base(void* env, int64_t x) { return static_cast<AdderEnv*>(env)->base + x; }
+int64_t label_length(void* env) { return static_cast<int64_t>(static_cast<AdderEnv*>(env)->label.size()); }
+int64_t twice(void*, int64_t x) { return 2 * x; }
+
+} // namespace
+
+TEST_CASE("VreClosure keeps the environment inline with the code pointer", "[vre]") {
+    using namespace vyn::vre;
+    VreClosure adder = VreClosure::make(add_base, AdderEnv{40, VreString("forty")});
+    CHECK(adder.call<int64_t>(int64_t{2}) == 42);
+    CHECK(adder.function()->env_size == sizeof(AdderEnv));
+    CHECK(adder.function()->drop_env != nullptr); // VreString needs destroying
+    CHECK(static_cast<unsigned char*>(adder.env()) ==
+          reinterpret_cast<unsigned char*>(adder.function()) + sizeof(VreFunction));
+
+    VreClosure moved = std::move(adder);
+    CHECK_FALSE(adder);
+    CHECK(moved.call<int64_t>(int64_t{-40}) == 0);
+
+    // Generated code fills the environment capture by capture
+    VreClosure built = VreClosure::allocate(reinterpret_cast<VreMethod>(label_length), sizeof(AdderEnv),
+                                            [](void* env) { static_cast<AdderEnv*>(env)->~AdderEnv(); });
+    new (built.env()) AdderEnv{0, VreString("seven!!")};
+    CHECK(built.call<int64_t>() == 7);
+
+    // Closures over nothing share one static function and allocate nothing
+    VreClosure a = VreClosure::of<twice>();
+    VreClosure b = VreClosure::of<twice>();
+    CHECK(a.function() == b.function());
+    CHECK(a.function()->flags & VreFunction::STATIC);
+    CHECK(a.call<int64_t>(int64_t{21}) == 42);
+    a.reset();
+    CHECK(b.call<int64_t>(int64_t{5}) == 10);
+}
+
+TEST_CASE("C backend lowers structs, owners and fixed arrays to C11", "[parser]") {
+    std::string source = R"(struct Vec2 { x: Int, y: Int }
+class Cell {
+    var value: Int
+    var next: my<Cell>
+}
+class Stack {
+    var top: my<Cell>
+    var items: [Int; 4]
+    var size: Int
+
+    fn push(self: their<Stack>, value: Int) {
+        self.top = make_my(Cell { value: value, next: self.top })
+        self.size = self.size + 1
+    }
+    fn sum(self: their<Stack>) -> Int {
+        var total = 0
+        var cell = borrow self.top
+        while (cell != nil) {
+            total = total + cell.value
+            cell = borrow cell.next
+        }
+        return total
+    }
+}
+fn dot(a: Vec2, b: their<Vec2>) -> Int {
+    return a.x * b.x + a.y * b.y
+}
+fn main() -> Int {
+    defer println("done")
+    var stack = Stack { size: 0 }
+    for (i in 1..5) {
+        stack.push(i)
+        stack.items[i - 1] = i * i
+    }
+    var squares = 0
+    for (i in 0..4) {
+        squares = squares + stack.items[i]
+    }
+    var weights: [Int; 4] = [1, 2, 3, 4]
+    var weighted = 0
+    for (i in 0..4) {
+        weighted = weighted + weights[i]
+    }
+    var v = Vec2 { x: 3, y: 4 }
+    var w = Vec2 { x: 1, y: 2 }
+    println(stack.sum(), squares, dot(v, w), weighted)
+    return stack.sum() + squares + dot(v, w) + weighted
+})";
+    Lexer lexer(source, "test47.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test47.vyn");
+    auto module = parser.parse_module();
+    vyn::BoundsCheckElimination().run(module.get());
+    vyn::DeferLowering().run(module.get());
+
+    vyn::CBackend backend;
+    std::string c = backend.run(module.get());
+    INFO(c);
+    CHECK(backend.report().structs == 3);
+    CHECK(backend.report().functions == 4);
+    CHECK(backend.report().droppedTypes == 2); // Cell and Stack own memory, Vec2 does not
+    CHECK(backend.report().boundsChecks == 2); // stack.items[...]; weights[i] is hoisted
+    CHECK(c.find("struct Cell {\n    int64_t value;\n    Cell* next;\n};") != std::string::npos);
+    CHECK(c.find("    int64_t items[4];") != std::string::npos);
+    CHECK(c.find("static void vyn_drop_Stack(Stack* self) {\n    vyn_free_Cell(self->top);") != std::string::npos);
+    CHECK(c.find("vyn_drop_Vec2") == std::string::npos);
+    // Building the new cell moves the old top out of the field
+    CHECK(c.find(".next = vyn_move_Cell(&self->top)") != std::string::npos);
+    CHECK(c.find("Stack_push(&stack, i);") != std::string::npos);
+    CHECK(c.find("vyn_dot(v, &w)") != std::string::npos);
+    CHECK(c.find("int64_t vyn_bound") != std::string::npos); // the bound is evaluated once
+    CHECK(c.find(" > INT64_C(0) && (uint64_t)vyn_bound") != std::string::npos);
+    CHECK(c.find(" > 4) vyn_panic") != std::string::npos);
+    CHECK(c.find("weights[i]") != std::string::npos);
+    // The deferred println runs before the locals are dropped
+    CHECK(c.find("printf(\"%s\\n\", \"done\");\n    vyn_drop_Stack(&stack);\n    return vyn_ret") != std::string::npos);
+
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string executable = (dir / "vyn_c_backend_test").string();
+        std::string output = (dir / "vyn_c_backend_test.out").string();
+        vyn::CBackend::compile(c, executable);
+        int status = std::system(("'" + executable + "' > '" + output + "'").c_str());
+        REQUIRE(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 10 + 30 + 11 + 10);
+        std::ifstream printed(output);
+        std::stringstream text;
+        text << printed.rdbuf();
+        CHECK(text.str() == "10 30 11 10\ndone\n");
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+        std::filesystem::remove(output);
+    }
+
+    auto lower = [](const std::string& text) {
+        Lexer bad_lexer(text, "test48.vyn");
+        auto bad_tokens = bad_lexer.tokenize();
+        vyn::Parser bad_parser(bad_tokens, "test48.vyn");
+        auto bad = bad_parser.parse_module();
+        return vyn::CBackend().run(bad.get());
+    };
+    REQUIRE_THROWS_AS(lower("struct Pair<T> { a: T, b: T }"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("struct Link { value: Int, rest: Link }"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("struct Node { x: Int }\nfn f(n: our<Node>) -> Int {\n    return 0\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("fn f(items: [Int]) -> Int {\n    return 0\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("fn f() -> Int {\n    return g()\n}"), std::runtime_error);
+}
+
+TEST_CASE("Bounds checks stay per access when not every iteration indexes", "[parser]") {
+    std::string source = R"(fn guarded() -> Int {
+    var a: [Int; 4] = [1, 2, 3, 4]
+    var s = 0
+    for (i in 0..10) {
+        if (i < 4) {
+            s = s + a[i]
+        }
+    }
+    return s
+}
+fn stops() -> Int {
+    var a: [Int; 4] = [1, 2, 3, 4]
+    var s = 0
+    for (i in 0..10) {
+        if (i == 4) {
+            break
+        }
+        s = s + a[i]
+    }
+    return s
+}
+fn empty(n: Int) -> Int {
+    var a: [Int; 4] = [1, 2, 3, 4]
+    var s = 0
+    for (i in 5..n) {
+        s = s + a[i]
+    }
+    return s
+}
+fn main() -> Int {
+    return guarded() + stops() + empty(3)
+})";
+    Lexer lexer(source, "test55.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test55.vyn");
+    auto module = parser.parse_module();
+    vyn::BoundsCheckReport report = vyn::BoundsCheckElimination().run(module.get());
+    CHECK(report.indexSites == 3);
+    CHECK(report.hoisted == 1); // only empty(), whose loop indexes on every iteration
+    CHECK(report.remaining() == 2);
+
+    vyn::CBackend backend;
+    std::string c = backend.run(module.get());
+    INFO(c);
+    CHECK(backend.report().boundsChecks == 2);
+    // The hoisted check skips a loop that runs no iterations
+    CHECK(c.find(" > INT64_C(5) && (uint64_t)vyn_bound") != std::string::npos);
+    std::string ir = vyn::LlvmIrEmitter().run(module.get());
+    CHECK(ir.find("select i1") != std::string::npos);
+
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        std::string executable = (std::filesystem::temp_directory_path() / "vyn_bounds_test").string();
+        vyn::CBackend::compile(c, executable);
+        int status = std::system(("'" + executable + "'").c_str());
+        REQUIRE(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 10 + 10);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+    }
+}
+
+TEST_CASE("Bounds checks stay per access when the loop prints", "[parser]") {
+    std::string source = R"(fn show(n: Int) -> Int {
+    var a: [Int; 4] = [1, 2, 3, 4]
+    var s = 0
+    for (i in 0..n) {
+        println(i)
+        s = s + a[i]
+    }
+    return s
+}
+fn main() -> Int {
+    return show(6)
+})";
+    Lexer lexer(source, "test65.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test65.vyn");
+    auto module = parser.parse_module();
+    vyn::BoundsCheckReport report = vyn::BoundsCheckElimination().run(module.get());
+    CHECK(report.indexSites == 1);
+    CHECK(report.hoisted == 0); // a check before the loop would panic before anything is printed
+
+    // Every tier prints the iterations before the bad access, then panics
+    const std::string expected = "0\n1\n2\n3\n4\nvyn: index out of bounds\n";
+    auto dir = std::filesystem::temp_directory_path();
+    std::string output = (dir / "vyn_bounds_print_test.out").string();
+    auto printed = [&](const std::string& executable) {
+        int status = std::system(("'" + executable + "' > '" + output + "' 2>&1").c_str());
+        CHECK(status != 0);
+        std::ifstream file(output);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    };
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        std::string executable = (dir / "vyn_bounds_print_test_c").string();
+        vyn::CBackend::compile(vyn::CBackend().run(module.get()), executable);
+        CHECK(printed(executable).rfind(expected, 0) == 0);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+    }
+    if (std::system("opt --version > /dev/null 2>&1 && llc --version > /dev/null 2>&1 && cc --version > /dev/null 2>&1") ==
+        0) {
+        std::string executable = (dir / "vyn_bounds_print_test_llvm").string();
+        vyn::LlvmIrEmitter::compile(vyn::LlvmIrEmitter().run(module.get()), executable);
+        CHECK(printed(executable).rfind(expected, 0) == 0);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".ll");
+    }
+    std::filesystem::remove(output);
+}
+
+TEST_CASE("C backend lowers throw and try/catch/finally to flag returns", "[parser]") {
+    std::string source = R"(class Cell {
+    var value: Int
+}
+fn digit(c: Int) -> Int {
+    if (c < 0) {
+        throw Negative(c)
+    }
+    if (c > 9) {
+        throw TooBig
+    }
+    return c
+}
+fn pair(a: Int, b: Int) -> Int {
+    defer println("pair", a, b)
+    var keep = make_my(Cell { value: a })
+    return digit(keep.value) * 10 + digit(b)
+}
+fn typed(a: Int) -> Int {
+    var r = 0
+    try {
+        r = pair(a, 1)
+    } catch (e: Negative) {
+        r = 100 + e
+    } finally {
+        println("finally", r)
+    }
+    return r
+}
+fn outer(a: Int) -> Int {
+    try {
+        return typed(a)
+    } catch (e) {
+        println("outer caught", e)
+        throw e
+    }
+}
+fn main() -> Int {
+    var total = typed(3) + typed(0 - 4)
+    try {
+        outer(12)
+    } catch (e: TooBig) {
+        total = total + 100
+    }
+    return total
+})";
+    Lexer lexer(source, "test57.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test57.vyn");
+    auto module = parser.parse_module();
+    vyn::ErrorLowering().run(module.get());
+    vyn::DeferLowering().run(module.get());
+
+    std::string c = vyn::CBackend().run(module.get());
+    INFO(c);
+    CHECK(c.find("static bool vyn_digit(int64_t c, int64_t* vyn_result);") != std::string::npos);
+    CHECK(c.find("vyn_error_type = 1;\n        vyn_error_payload = (int64_t)c;\n        return true;") != std::string::npos);
+    // The error edge runs the defer and drops the owner before returning
+    CHECK(c.find("if (vyn_digit(keep->value, &vyn_res0)) {\n        printf(\"%s %lld %lld\\n\", \"pair\", (long long)a, "
+                 "(long long)b);\n        vyn_free_Cell(keep);\n        return true;") != std::string::npos);
+    // An error no clause matches runs the finally block on its way out
+    CHECK(c.find("} else {\n            {\n                printf(\"%s %lld\\n\", \"finally\", (long long)r);\n            }\n"
+                 "            return true;") != std::string::npos);
+    CHECK(c.find("if (vyn_main(&status)) vyn_panic(\"uncaught error\");") != std::string::npos);
+
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string executable = (dir / "vyn_c_backend_errors").string();
+        std::string output = (dir / "vyn_c_backend_errors.out").string();
+        vyn::CBackend::compile(c, executable);
+        int status = std::system(("'" + executable + "' > '" + output + "'").c_str());
+        REQUIRE(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 31 + 96 + 100);
+        std::ifstream printed(output);
+        std::stringstream text;
+        text << printed.rdbuf();
+        CHECK(text.str() == "pair 3 1\nfinally 31\npair -4 1\nfinally 96\npair 12 1\nfinally 0\nouter caught 0\n");
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+        std::filesystem::remove(output);
+    }
+
+    auto lower = [](const std::string& text) {
+        Lexer bad_lexer(text, "test58.vyn");
+        auto bad_tokens = bad_lexer.tokenize();
+        vyn::Parser bad_parser(bad_tokens, "test58.vyn");
+        auto bad = bad_parser.parse_module();
+        vyn::ErrorLowering().run(bad.get());
+        return vyn::CBackend().run(bad.get());
+    };
+    // The check of a call in a loop condition runs before every test
+    CHECK(lower("fn f(x: Int) -> Bool {\n    throw Bad\n}\nfn g() {\n    while (f(1)) {\n    }\n}")
+              .find("    while (true) {\n        bool vyn_res0;\n        if (vyn_f(INT64_C(1), &vyn_res0)) {\n"
+                    "            return true;\n        }\n        if (!(vyn_res0)) break;\n    }") != std::string::npos);
+    REQUIRE_THROWS_AS(lower("fn f() {\n    throw 3\n}"), std::runtime_error);
+}
+
+TEST_CASE("C backend defines integer overflow, division and shifts", "[parser]") {
+    std::string source = R"(fn grows(x: Int) -> Bool {
+    return x + 1 > x
+}
+fn quotient(a: Int, b: Int) -> Int {
+    return a / b
+}
+fn shifted(a: Int, b: Int) -> Int {
+    return a * b
+}
+fn main() -> Int {
+    var big = 9223372036854775807
+    var small = 0 - big - 1
+    println(grows(big), grows(1), quotient(small, 0 - 1), shifted(1, 65), -small, big * 2)
+    return quotient(7, 0)
+})";
+    Lexer lexer(source, "test59.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test59.vyn");
+    auto module = parser.parse_module();
+
+    std::string c = vyn::CBackend().run(module.get());
+    INFO(c);
+    // No signed arithmetic is left to C, where overflow is undefined
+    CHECK(c.find("return ((int64_t)((uint64_t)x + (uint64_t)INT64_C(1)) > x);") != std::string::npos);
+    CHECK(c.find("return vyn_div(a, b);") != std::string::npos);
+    CHECK(c.find("static inline int64_t vyn_shl(int64_t a, int64_t b)") != std::string::npos);
+
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string executable = (dir / "vyn c backend overflow").string(); // compile() takes any path
+        std::string output = (dir / "vyn_c_backend_overflow.out").string();
+        vyn::CBackend::compile(c, executable);
+        int status = std::system(("'" + executable + "' > '" + output + "' 2>&1").c_str());
+        CHECK(status != 0); // 7 / 0 panics
+        std::ifstream printed(output);
+        std::stringstream text;
+        text << printed.rdbuf();
+        // The shell may add its own note about the abort
+        CHECK(text.str().rfind("false true -9223372036854775808 65 -9223372036854775808 -2\nvyn: division by zero\n",
+                               0) == 0);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+        std::filesystem::remove(output);
+    }
+}
+
+TEST_CASE("C backend evaluates operands and arguments left to right", "[parser]") {
+    std::string source = R"(struct Log { v: Int }
+fn f(x: Int) -> Int {
+    print(x)
+    return x
+}
+fn step(log: their<Log>, d: Int) -> Int {
+    log.v = log.v * 10 + d
+    return d
+}
+fn main() -> Int {
+    println(f(1), f(2))
+    let y = f(3) - f(4)
+    println(y)
+    var i = 0
+    while (f(i) < 2 && f(7) > 0) {
+        i = i + 1
+    }
+    println(i)
+    if (f(5) > 9) {
+        println(0)
+    } else if (f(6) + f(7) == 13) {
+        println(13)
+    }
+    var log = Log { v: 0 }
+    let z = log.v + step(log, 8)
+    println(z, log.v)
+    return 0
+})";
+    Lexer lexer(source, "test62.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test62.vyn");
+    auto module = parser.parse_module();
+
+    std::string c = vyn::CBackend().run(module.get());
+    INFO(c);
+    // The call in the else-if test runs in an else block, after the first test
+    CHECK(c.find("} else {\n        int64_t vyn_res") != std::string::npos);
+
+    // What the bytecode tier prints; the read of log.v comes before step sets it
+    const std::string expected = "121 2\n34-1\n071722\n56713\n8 8\n";
+    auto dir = std::filesystem::temp_directory_path();
+    std::string output = (dir / "vyn_order_test.out").string();
+    auto printed = [&](const std::string& executable) {
+        int status = std::system(("'" + executable + "' > '" + output + "'").c_str());
+        CHECK(WIFEXITED(status));
+        std::ifstream file(output);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    };
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        std::string executable = (dir / "vyn_order_test_c").string();
+        vyn::CBackend::compile(c, executable);
+        CHECK(printed(executable) == expected);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".c");
+    }
+    if (std::system("opt --version > /dev/null 2>&1 && llc --version > /dev/null 2>&1 && cc --version > /dev/null 2>&1") ==
+        0) {
+        std::string executable = (dir / "vyn_order_test_llvm").string();
+        vyn::LlvmIrEmitter::compile(vyn::LlvmIrEmitter().run(module.get()), executable);
+        CHECK(printed(executable) == expected);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".ll");
+    }
+    std::filesystem::remove(output);
+}
+
+TEST_CASE("LLVM IR emitter writes verifiable IR with allocas, switch and noalias borrows", "[parser]") {
+    std::string source = R"(struct Vec2 { x: Float, y: Float }
+class Grid {
+    var cells: [Int; 8]
+    var origin: Vec2
+
+    fn fill(self: their<Grid>, start: i32) {
+        for (i in 0..8) {
+            self.cells[i] = start + i
+        }
+    }
+    fn sum(self: their<Grid>) -> Int {
+        var total = 0
+        for (i in 0..8) {
+            total = total + self.cells[i]
+        }
+        return total
+    }
+}
+fn scale(v: Vec2, k: Float) -> Vec2 {
+    return Vec2 { x: v.x * k, y: v.y * k }
+}
+fn shift(g: their<Grid>, raw: ptr<Grid>) -> Float {
+    return g.origin.x + raw.origin.y
+}
+fn classify(n: Int) -> Int {
+    if (n == 0) {
+        return 10
+    } else if (n == 1) {
+        return 20
+    } else if (n == -3) {
+        return 30
+    } else {
+        return 40
+    }
+}
+fn main() -> Int {
+    defer println("done")
+    var g = Grid { cells: [1, 2, 3], origin: Vec2 { x: 1.5, y: 2 } }
+    g.fill(3)
+    var v: Vec2 = scale(g.origin, 2.0)
+    var index = 5
+    var ok = v.x > 2.5 && g.cells[index] == 8
+    println(g.sum(), v.y, ok, classify(1) + classify(-3) + classify(7), shift(g, g))
+    return g.sum() - 52 + classify(0)
+})";
+    Lexer lexer(source, "test49.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test49.vyn");
+    auto module = parser.parse_module();
+    vyn::BoundsCheckElimination().run(module.get());
+    vyn::DeferLowering().run(module.get());
+
+    vyn::LlvmIrEmitter emitter;
+    std::string ir = emitter.run(module.get());
+    INFO(ir);
+    CHECK(emitter.report().structs == 2);
+    CHECK(emitter.report().functions == 6);
+    CHECK(emitter.report().switches == 1);
+    CHECK(emitter.report().noaliasParams == 2); // both selfs; g and raw may point to one Grid, as in shift(g, g)
+    CHECK(ir.find("%struct.Grid = type { [8 x i64], %struct.Vec2 }") != std::string::npos);
+    CHECK(ir.find("define internal i64 @Grid.sum(ptr noalias %self)") != std::string::npos);
+    CHECK(ir.find("define internal double @vyn.shift(ptr %g.arg, ptr %raw.arg)") != std::string::npos);
+    CHECK(ir.find("define internal void @vyn.scale(ptr noalias sret(%struct.Vec2) %result, ptr byval(%struct.Vec2) "
+                  "%v.arg, double %k.arg)") != std::string::npos);
+    // Locals are allocas at the top of the entry block
+    CHECK(ir.find("define internal i64 @vyn.classify(i64 %n.arg) {\nentry:\n  %n.addr = alloca i64\n") !=
+          std::string::npos);
+    CHECK(ir.find("switch i64 %t0, label %sw.default1 [\n    i64 0, label %sw.case2\n    i64 1, label %sw.case3\n"
+                  "    i64 -3, label %sw.case4\n  ]") != std::string::npos);
+    // An i32 operand is widened to the Int it is added to
+    CHECK(ir.find("sext i32") != std::string::npos);
+    // The struct result is written straight into v
+    CHECK(ir.find("call void @vyn.scale(ptr sret(%struct.Vec2) %v.addr") != std::string::npos);
+    CHECK(ir.find("br i1 %t") != std::string::npos);
+    CHECK(ir.find("label %bounds.fail") != std::string::npos);
+    CHECK(ir.find("phi i1 [ false") != std::string::npos);
+    CHECK(ir.find("%status = trunc i64 %result to i32") != std::string::npos);
+
+    auto dir = std::filesystem::temp_directory_path();
+    if (std::system("opt --version > /dev/null 2>&1") == 0) {
+        std::string path = (dir / "vyn_llvm_ir_test.ll").string();
+        vyn::LlvmIrEmitter::verify(ir, path);
+        std::filesystem::remove(path);
+    }
+    if (std::system("opt --version > /dev/null 2>&1 && llc --version > /dev/null 2>&1 && cc --version > /dev/null 2>&1") ==
+        0) {
+        std::string executable = (dir / "vyn_llvm_ir_test").string();
+        std::string output = (dir / "vyn_llvm_ir_test.out").string();
+        vyn::LlvmIrEmitter::compile(ir, executable);
+        int status = std::system(("'" + executable + "' > '" + output + "'").c_str());
+        REQUIRE(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 10);
+        std::ifstream printed(output);
+        std::stringstream text;
+        text << printed.rdbuf();
+        CHECK(text.str() == "52 4 true 90 3.5\ndone\n");
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".ll");
+        std::filesystem::remove(output);
+    }
+
+    auto lower = [](const std::string& text) {
+        Lexer bad_lexer(text, "test50.vyn");
+        auto bad_tokens = bad_lexer.tokenize();
+        vyn::Parser bad_parser(bad_tokens, "test50.vyn");
+        auto bad = bad_parser.parse_module();
+        return vyn::LlvmIrEmitter().run(bad.get());
+    };
+    REQUIRE_THROWS_AS(lower("struct Node { x: Int }\nfn f(n: my<Node>) -> Int {\n    return 0\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("struct Link { value: Int, rest: Link }"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("fn f(x: i32) -> i32 {\n    return x + 5000000000\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(lower("fn f() -> Int {\n    return g()\n}"), std::runtime_error);
+}
+
+TEST_CASE("LLVM IR emitter keeps noalias off borrows that may alias", "[parser]") {
+    std::string source = R"(struct P { x: Int }
+struct Link { value: Int, next: ptr<Link> }
+fn absorb(a: their<P>, b: their<P>) {
+    a.x = a.x + b.x
+    a.x = a.x + b.x
+}
+fn bump(p: their<P>) {
+    p.x = p.x + 1
+}
+fn follow(l: their<Link>) -> Int {
+    return l.value + l.next.value
+}
+fn main() -> Int {
+    var p = P { x: 1 }
+    absorb(p, p)
+    bump(p)
+    println(p.x)
+    return p.x
+})";
+    Lexer lexer(source, "test60.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test60.vyn");
+    auto module = parser.parse_module();
+
+    vyn::LlvmIrEmitter emitter;
+    std::string ir = emitter.run(module.get());
+    INFO(ir);
+    CHECK(emitter.report().noaliasParams == 1);
+    // absorb(p, p) passes one P to both borrows
+    CHECK(ir.find("define internal void @vyn.absorb(ptr %a.arg, ptr %b.arg)") != std::string::npos);
+    CHECK(ir.find("define internal void @vyn.bump(ptr noalias %p.arg)") != std::string::npos);
+    // l.next may point back to l
+    CHECK(ir.find("define internal i64 @vyn.follow(ptr %l.arg)") != std::string::npos);
+
+    if (std::system("opt --version > /dev/null 2>&1 && llc --version > /dev/null 2>&1 && cc --version > /dev/null 2>&1") ==
+        0) {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string executable = (dir / "vyn_llvm_alias_test").string();
+        std::string output = (dir / "vyn_llvm_alias_test.out").string();
+        vyn::LlvmIrEmitter::compile(ir, executable);
+        int status = std::system(("'" + executable + "' > '" + output + "'").c_str());
+        REQUIRE(WIFEXITED(status));
+        CHECK(WEXITSTATUS(status) == 5); // as CBackend computes it: 1, 2, 4, then bump
+        std::ifstream printed(output);
+        std::stringstream text;
+        text << printed.rdbuf();
+        CHECK(text.str() == "5\n");
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".ll");
+        std::filesystem::remove(output);
+    }
+}
+
+TEST_CASE("LLVM IR emitter defines division and overflow like the other tiers", "[parser]") {
+    std::string source = R"(fn grows(x: Int) -> Bool {
+    return x + 1 > x
+}
+fn quotient(a: Int, b: Int) -> Int {
+    return a / b
+}
+fn narrow(a: i32, b: i32) -> i32 {
+    return a / b
+}
+fn main() -> Int {
+    var big = 9223372036854775807
+    var small = 0 - big - 1
+    var low: i32 = 0 - 2147483647 - 1
+    var minus: i32 = 0 - 1
+    println(grows(big), quotient(small, 0 - 1), narrow(low, minus), -small, big * 2)
+    return quotient(7, 0)
+})";
+    Lexer lexer(source, "test64.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test64.vyn");
+    auto module = parser.parse_module();
+
+    std::string ir = vyn::LlvmIrEmitter().run(module.get());
+    INFO(ir);
+    // sdiv by zero or of MIN by -1 is poison; neither reaches it
+    CHECK(ir.find("br i1 %t3, label %division.fail, label %division.ok0") != std::string::npos);
+    CHECK(ir.find("%t7 = select i1 %t6, i64 1, i64 %t1\n  %t2 = sdiv i64 %t0, %t7") != std::string::npos);
+    CHECK(ir.find("%t7 = select i1 %t6, i32 1, i32 %t1\n  %t2 = sdiv i32 %t0, %t7") != std::string::npos);
+
+    if (std::system("opt --version > /dev/null 2>&1 && llc --version > /dev/null 2>&1 && cc --version > /dev/null 2>&1") ==
+        0) {
+        auto dir = std::filesystem::temp_directory_path();
+        std::string executable = (dir / "vyn llvm division test").string(); // compile() takes any path
+        std::string output = (dir / "vyn_llvm_division_test.out").string();
+        vyn::LlvmIrEmitter::compile(ir, executable);
+        int status = std::system(("'" + executable + "' > '" + output + "' 2>&1").c_str());
+        CHECK(status != 0); // 7 / 0 panics
+        std::ifstream printed(output);
+        std::stringstream text;
+        text << printed.rdbuf();
+        // What the C backend prints for the same program, flushed before the panic
+        CHECK(text.str().rfind("false -9223372036854775808 -2147483648 -9223372036854775808 -2\nvyn: division by zero\n",
+                               0) == 0);
+        std::filesystem::remove(executable);
+        std::filesystem::remove(executable + ".ll");
+        std::filesystem::remove(output);
+    }
+}
+
+TEST_CASE("Tiered engine runs bytecode and switches hot functions to native code", "[parser]") {
+    std::string source = R"(fn fib(n: Int) -> Int {
+    if (n < 2) {
+        return n
+    }
+    return fib(n - 1) + fib(n - 2)
+}
+fn mix(count: Int, x: Float, flag: Bool) -> Float {
+    var total = 0.0
+    for (i in 0..count) {
+        if (flag && i > 2) {
+            total = total + x * i
+        } else {
+            total = total - 1
+        }
+    }
+    return total
+}
+fn steps(limit: Int) -> Int {
+    defer println("steps done")
+    var n = 0
+    var i = 0
+    while (i < 100) {
+        i = i + 1
+        if (i == 50) {
+            continue
+        }
+        if (i > limit) {
+            break
+        }
+        n = n + i
+    }
+    return n
+}
+fn odd(n: Int) -> Bool {
+    return (n & 1) == 1
+})";
+    Lexer lexer(source, "test51.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test51.vyn");
+    auto module = parser.parse_module();
+    vyn::DeferLowering().run(module.get());
+
+    auto integer = [](const vyn::vre::VreValue& value) { return std::get<int64_t>(value.data); };
+
+    // Below the thresholds everything stays in the interpreter
+    vyn::TierOptions cold;
+    cold.callThreshold = 1000000;
+    cold.backEdgeThreshold = 1000000;
+    vyn::TieredEngine interpreter(cold);
+    interpreter.load(module.get());
+    CHECK(integer(interpreter.call("fib", {vyn::vre::VreValue(int64_t{20})})) == 6765);
+    CHECK(std::get<double>(interpreter.call("mix", {vyn::vre::VreValue(int64_t{10}), vyn::vre::VreValue(int64_t{1}),
+                                                    vyn::vre::VreValue(true)}).data) == 39.0);
+    CHECK(integer(interpreter.call("steps", {vyn::vre::VreValue(int64_t{90})})) == 4045);
+    CHECK(std::get<bool>(interpreter.call("odd", {vyn::vre::VreValue(int64_t{7})}).data));
+    CHECK(interpreter.tier("fib") == vyn::Tier::BYTECODE);
+    CHECK(interpreter.report().interpretedCalls == 21891 + 3);
+    CHECK(interpreter.report().backEdges == 10 + 90); // continue runs the back edge too
+    CHECK(interpreter.report().compiles == 0);
+    REQUIRE_THROWS_AS(interpreter.call("fib", {vyn::vre::VreValue(1.5)}), std::runtime_error);
+    REQUIRE_THROWS_AS(interpreter.call("missing"), std::runtime_error);
+
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        vyn::TierOptions hot;
+        hot.callThreshold = 10;
+        hot.backEdgeThreshold = 50;
+        hot.background = false;
+        vyn::TieredEngine engine(hot);
+        engine.load(module.get());
+        // fib turns hot inside its own recursion; the frames still running
+        // in the interpreter make their remaining calls natively
+        CHECK(integer(engine.call("fib", {vyn::vre::VreValue(int64_t{20})})) == 6765);
+        INFO(engine.report().compileError);
+        CHECK(engine.tier("fib") == vyn::Tier::NATIVE);
+        CHECK(engine.report().interpretedCalls == 9); // the tenth call compiles and runs natively
+        CHECK(engine.report().nativeCalls > 0);
+        CHECK(engine.report().compiles == 1);
+        // mix stays interpreted until its loop runs 50 times, then joins the same object
+        CHECK(engine.tier("mix") == vyn::Tier::BYTECODE);
+        CHECK(std::get<double>(engine.call("mix", {vyn::vre::VreValue(int64_t{60}), vyn::vre::VreValue(0.5),
+                                                   vyn::vre::VreValue(false)}).data) == -60.0);
+        CHECK(engine.call("mix", {vyn::vre::VreValue(int64_t{60}), vyn::vre::VreValue(0.5),
+                                  vyn::vre::VreValue(false)}).type == vyn::vre::VreValueType::FLOAT);
+        CHECK(engine.tier("mix") == vyn::Tier::NATIVE);
+        CHECK(engine.report().compiles == 1);
+        CHECK(engine.report().tieredUp == 2);
+        for (int64_t i = 0; i < 12; ++i) {
+            CHECK(std::get<bool>(engine.call("odd", {vyn::vre::VreValue(i)}).data) == (i % 2 == 1));
+        }
+        CHECK(engine.tier("odd") == vyn::Tier::NATIVE);
+    }
+
+    auto load = [](const std::string& text) {
+        Lexer bad_lexer(text, "test52.vyn");
+        auto bad_tokens = bad_lexer.tokenize();
+        vyn::Parser bad_parser(bad_tokens, "test52.vyn");
+        auto bad = bad_parser.parse_module();
+        vyn::TieredEngine engine;
+        engine.load(bad.get());
+    };
+    REQUIRE_THROWS_AS(load("struct P { x: Int }"), std::runtime_error);
+    REQUIRE_THROWS_AS(load("fn f(s: String) -> Int {\n    return 0\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(load("fn f() -> Int {\n    return true\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(load("fn f() -> Int {\n    return g()\n}"), std::runtime_error);
+}
+
+TEST_CASE("Tiered engine computes the same integers in both tiers", "[parser]") {
+    std::string source = R"(fn grows(x: Int) -> Bool {
+    return x + 1 > x
+}
+fn quotient(a: Int, b: Int) -> Int {
+    return a / b
+}
+fn scaled(a: Int, b: Int) -> Int {
+    return a * b - b
+}
+fn positive(x: Int) -> Int {
+    if (x > 0) {
+        return x
+    }
+})";
+    Lexer lexer(source, "test61.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test61.vyn");
+    auto module = parser.parse_module();
+
+    const int64_t max = std::numeric_limits<int64_t>::max();
+    const int64_t min = std::numeric_limits<int64_t>::min();
+    const int64_t wrapped = static_cast<int64_t>(static_cast<uint64_t>(max) * 3 - 3);
+    auto check = [&](vyn::TieredEngine& engine) {
+        for (int i = 0; i < 20; ++i) {
+            CHECK_FALSE(std::get<bool>(engine.call("grows", {vyn::vre::VreValue(max)}).data));
+            CHECK(std::get<int64_t>(engine.call("quotient", {vyn::vre::VreValue(min), vyn::vre::VreValue(int64_t{-1})})
+                                        .data) == min);
+            CHECK(std::get<int64_t>(engine.call("scaled", {vyn::vre::VreValue(max), vyn::vre::VreValue(int64_t{3})})
+                                        .data) == wrapped);
+            // Falling off the end returns the zero value
+            CHECK(std::get<int64_t>(engine.call("positive", {vyn::vre::VreValue(int64_t{-i})}).data) == 0);
+        }
+        std::string error;
+        try {
+            engine.call("quotient", {vyn::vre::VreValue(int64_t{1}), vyn::vre::VreValue(int64_t{0})});
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+        CHECK(error == "tiered engine: division by zero in quotient");
+    };
+
+    vyn::TierOptions cold;
+    cold.callThreshold = 1000000;
+    vyn::TieredEngine interpreter(cold);
+    interpreter.load(module.get());
+    check(interpreter);
+    CHECK(interpreter.tier("quotient") == vyn::Tier::BYTECODE);
+
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        vyn::TierOptions hot;
+        hot.callThreshold = 5;
+        hot.background = false;
+        vyn::TieredEngine engine(hot);
+        engine.load(module.get());
+        check(engine);
+        INFO(engine.report().compileError);
+        CHECK(engine.tier("grows") == vyn::Tier::NATIVE);
+        CHECK(engine.tier("quotient") == vyn::Tier::NATIVE);
+        CHECK(engine.tier("scaled") == vyn::Tier::NATIVE);
+        CHECK(engine.tier("positive") == vyn::Tier::NATIVE);
+        // The engine is still usable after a panic in native code
+        CHECK(std::get<int64_t>(engine.call("quotient", {vyn::vre::VreValue(int64_t{9}), vyn::vre::VreValue(int64_t{2})})
+                                    .data) == 4);
+    }
+}
+
+TEST_CASE("Tiered engine moves frames inside hot loops into native code", "[parser]") {
+    std::string source = R"(fn spin(limit: Int) -> Int {
+    var total = 0
+    var i = 0
+    var odd = false
+    var scale = 0.5
+    while (i < limit) {
+        i = i + 1
+        odd = !odd
+        if (odd) {
+            total = total + i
+        }
+    }
+    return total + scale * 4.0
+}
+fn grid(rows: Int, cols: Int) -> Int {
+    var sum = 0
+    for (r in 0..rows) {
+        for (c in 0..cols) {
+            sum = sum + r * c
+        }
+        sum = sum + 1
+    }
+    return sum
+}
+fn hidden(n: Int) -> Int {
+    var x = 1
+    if (n > 0) {
+        var x = 2
+        var k = 0
+        while (k < n) {
+            k = k + 1
+            x = x + 1
+        }
+    }
+    return x
+})";
+    Lexer lexer(source, "test53.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test53.vyn");
+    auto module = parser.parse_module();
+    vyn::DeferLowering().run(module.get());
+
+    // Each loop records where the variables in scope at its head live
+    vyn::BytecodeModule bytecode = vyn::BytecodeCompiler().run(module.get());
+    const vyn::BytecodeFunction& grid = bytecode.functions[bytecode.byName.at("grid")];
+    REQUIRE(grid.loops.size() == 2);
+    CHECK(grid.loops[1].variables.size() == 5); // rows, cols, sum, r, c
+    CHECK(grid.loops[1].bounds.size() == 2);
+    CHECK_FALSE(grid.loops[1].shadowed);
+    CHECK(bytecode.functions[bytecode.byName.at("hidden")].loops[0].shadowed);
+
+    if (std::system("cc --version > /dev/null 2>&1") != 0) return;
+    vyn::TierOptions options;
+    options.callThreshold = 1000000; // every function is called once: only back edges tier up
+    options.backEdgeThreshold = 100;
+    options.background = false;
+    vyn::TieredEngine engine(options);
+    engine.load(module.get());
+    auto integer = [](const vyn::vre::VreValue& value) { return std::get<int64_t>(value.data); };
+
+    CHECK(integer(engine.call("spin", {vyn::vre::VreValue(int64_t{1000})})) == 250002);
+    INFO(engine.report().compileError);
+    CHECK(engine.report().osrEntries == 1);
+    CHECK(engine.tier("spin") == vyn::Tier::NATIVE);
+    // The inner loop turns hot; the entry sets both induction variables and bounds
+    CHECK(integer(engine.call("grid", {vyn::vre::VreValue(int64_t{30}), vyn::vre::VreValue(int64_t{40})})) == 339330);
+    CHECK(engine.report().osrEntries == 2);
+    // The inner x hides the outer one, so the frame finishes in the interpreter
+    CHECK(integer(engine.call("hidden", {vyn::vre::VreValue(int64_t{1000})})) == 1);
+    CHECK(engine.report().osrEntries == 2);
+    CHECK(engine.tier("hidden") == vyn::Tier::NATIVE);
+    CHECK(engine.report().backEdges == 100 + 100 + 1000);
+    CHECK(engine.report().interpretedCalls == 3);
+    CHECK(engine.report().compiles == 1);
+    // Called again, they start natively
+    CHECK(integer(engine.call("spin", {vyn::vre::VreValue(int64_t{10})})) == 27);
+    CHECK(engine.report().nativeCalls == 1);
+}
+
+TEST_CASE("Tiered engine prints the same before and after tier-up", "[parser]") {
+    std::string source = R"(fn f(x: Int) -> Int {
+    print(x)
+    return x
+}
+fn pair(a: Int) -> Int {
+    println(f(a), f(a + 1))
+    return f(a) - f(a + 1)
+}
+fn count(n: Int) -> Int {
+    var i = 0
+    while (f(i) < n && f(0 - i) < 1) {
+        i = i + 1
+    }
+    println(i)
+    return i
+})";
+    Lexer lexer(source, "test63.vyn");
+    auto tokens = lexer.tokenize();
+    vyn::Parser parser(tokens, "test63.vyn");
+    auto module = parser.parse_module();
+
+    if (std::system("cc --version > /dev/null 2>&1") != 0) return;
+    vyn::TierOptions options;
+    options.callThreshold = 3;
+    options.backEdgeThreshold = 5;
+    options.background = false;
+    vyn::TieredEngine engine(options);
+    engine.load(module.get());
+
+    // Both tiers print through this process's stdout
+    std::string path = (std::filesystem::temp_directory_path() / "vyn_tiered_order.out").string();
+    std::fflush(stdout);
+    int saved = dup(1);
+    int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(file >= 0);
+    dup2(file, 1);
+    close(file);
+    std::vector<int64_t> results;
+    for (int64_t a = 0; a < 6; ++a) results.push_back(std::get<int64_t>(engine.call("pair", {vyn::vre::VreValue(a)}).data));
+    results.push_back(std::get<int64_t>(engine.call("count", {vyn::vre::VreValue(int64_t{12})}).data));
+    std::fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+
+    std::ifstream printed(path);
+    std::stringstream text;
+    text << printed.rdbuf();
+    std::filesystem::remove(path);
+    std::string expected;
+    for (int64_t a = 0; a < 6; ++a) {
+        std::string x = std::to_string(a), y = std::to_string(a + 1);
+        expected += x + y + x + " " + y + "\n" + x + y;
+        CHECK(results[a] == -1);
+    }
+    for (int64_t i = 0; i < 12; ++i) expected += std::to_string(i) + std::to_string(-i);
+    expected += "12" "12\n";
+    CHECK(results.back() == 12);
+    CHECK(text.str() == expected);
+    INFO(engine.report().compileError);
+    CHECK(engine.tier("pair") == vyn::Tier::NATIVE);
+    CHECK(engine.report().osrEntries == 1); // count finishes its loop natively
+}
+
+TEST_CASE("REPL keeps functions and globals across inputs", "[parser]") {
+    vyn::Repl repl;
+    CHECK(repl.eval("fn square(x: Int) -> Int {\n    return x * x\n}\n") == "");
+    CHECK(repl.eval("var total = 0\n") == "");
+    CHECK(repl.eval("for (i in 0..4) {\n    total = total + square(i)\n}\ntotal\n") == "14");
+    // A function reads and writes globals from earlier input
+    CHECK(repl.eval("fn bump(by: Int) -> Int {\n    total = total + by\n    return total\n}\n") == "");
+    CHECK(repl.eval("bump(6)") == "20");
+    CHECK(repl.eval("total = 1") == ""); // assignments are not shown
+    CHECK(repl.eval("total * 2.5") == "2.5");
+    CHECK(repl.eval("total > 0") == "true");
+    CHECK(repl.eval("var base = 10\nfn plus(x: Int) -> Int {\n    return x + base\n}\nplus(1)") == "11");
+    // Redefining a function changes it for earlier callers too
+    CHECK(repl.eval("fn twice(x: Int) -> Int {\n    return square(x) + square(x)\n}\ntwice(3)") == "18");
+    CHECK(repl.eval("fn square(x: Int) -> Int {\n    return x\n}\ntwice(3)") == "6");
+
+    // Errors leave the session as it was
+    REQUIRE_THROWS_AS(repl.eval("fn square(x: Float) -> Float {\n    return x\n}"), std::runtime_error);
+    REQUIRE_THROWS_AS(repl.eval("var total = true"), std::runtime_error);
+    REQUIRE_THROWS_AS(repl.eval("fn fresh() -> Int {\n    return 1\n}\nvar other = 2\nmissing()"), std::runtime_error);
+    REQUIRE_THROWS_AS(repl.eval("fresh()"), std::runtime_error);
+    REQUIRE_THROWS_AS(repl.eval("other"), std::runtime_error);
+    REQUIRE_THROWS_AS(repl.eval("fn broken( -> Int {"), std::runtime_error);
+    REQUIRE_THROWS_AS(repl.eval("total / 0"), std::runtime_error);
+    CHECK(repl.eval("twice(4) + total") == "9");
+
+    CHECK(vyn::Repl::complete("fn f() -> Int {\n    return 1\n}\n"));
+    CHECK_FALSE(vyn::Repl::complete("fn f() -> Int {\n"));
+    CHECK(vyn::Repl::complete("println(\"{ not a brace\") // nor (\n"));
+    CHECK_FALSE(vyn::Repl::complete("println(\"open"));
+
+    std::istringstream in("var n = 2\nfn add(a: Int,\n        b: Int) -> Int {\n    return a + b\n}\nadd(n, 3)\nnope\n:quit\nn\n");
+    std::ostringstream out;
+    repl.run(in, out, false);
+    CHECK(out.str().rfind("5\nerror: bytecode: unknown name nope at <input ", 0) == 0);
+
+    // Each input's statements reuse one function, so a long session does not grow
+    vyn::BytecodeModule session;
+    std::vector<std::unique_ptr<vyn::Module>> inputs;
+    auto add = [&](const std::string& text) {
+        Lexer input_lexer(text, "<input>");
+        auto input_tokens = input_lexer.tokenize();
+        vyn::Parser input_parser(input_tokens, "<input>");
+        inputs.push_back(input_parser.parse_module());
+        return vyn::BytecodeCompiler().add(session, inputs.back().get());
+    };
+    vyn::BytecodeInput first = add("fn one() -> Int {\n    return 1\n}\none()");
+    CHECK(session.functions.size() == 2);
+    for (int i = 0; i < 10; ++i) CHECK(add("one() + " + std::to_string(i)).script == first.script);
+    CHECK(session.functions.size() == 2);
+    CHECK(add("fn two() -> Int {\n    return 2\n}\ntwo()").script == first.script);
+    CHECK(session.functions.size() == 3);
+}
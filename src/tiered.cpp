@@ -0,0 +1,401 @@
+#include "vyn/tiered.hpp"
+
+#include "vyn/c_backend.hpp"
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace vyn {
+
+namespace {
+
+std::string c_type(SlotKind kind) {
+    switch (kind) {
+        case SlotKind::INT: return "int64_t";
+        case SlotKind::FLOAT: return "double";
+        case SlotKind::BOOL: return "bool";
+        case SlotKind::VOID: break;
+    }
+    return "void";
+}
+
+int64_t wrap(uint64_t value) { return static_cast<int64_t>(value); }
+
+vre::VreValue value(SlotKind kind, Slot slot) {
+    switch (kind) {
+        case SlotKind::INT: return vre::VreValue(slot.i);
+        case SlotKind::FLOAT: return vre::VreValue(slot.f);
+        case SlotKind::BOOL: return vre::VreValue(slot.i != 0);
+        case SlotKind::VOID: break;
+    }
+    return vre::VreValue();
+}
+
+// The body of an entry point that takes its arguments and result as 8-byte
+// slots, once the arguments are in place
+std::string store_result(SlotKind kind, const std::string& call) {
+    switch (kind) {
+        case SlotKind::VOID: return "    " + call + ";\n    (void)result;\n";
+        case SlotKind::BOOL: return "    int64_t r = " + call + " ? 1 : 0;\n    memcpy(result, &r, 8);\n";
+        default: return "    " + c_type(kind) + " r = " + call + ";\n    memcpy(result, &r, 8);\n";
+    }
+}
+
+// An entry point: returns NULL, or the message of a panic in the native code
+// (vyn_panic), which the engine throws as the interpreter would
+std::string entry_point(const std::string& symbol, const std::string& params, const std::string& body) {
+    return "const char* " + symbol + "(" + params + ", void* result) {\n"
+           "    jmp_buf trap;\n"
+           "    if (setjmp(trap)) {\n"
+           "        vyn_trap = NULL;\n"
+           "        return vyn_trap_message;\n"
+           "    }\n"
+           "    vyn_trap = &trap;\n" +
+           body +
+           "    vyn_trap = NULL;\n"
+           "    return NULL;\n"
+           "}\n";
+}
+
+// The OSR copy of a function at one loop is `vyn_` + this, its entry point `vyn_tier_` + this
+std::string osr_name(const BytecodeFunction& fn, size_t loop) {
+    return "osr_" + fn.name + "_" + std::to_string(loop);
+}
+
+std::atomic<unsigned> libraries{0}; // distinct shared object names within the process
+
+} // namespace
+
+TieredEngine::TieredEngine(TierOptions options) : options_(std::move(options)) {}
+
+TieredEngine::~TieredEngine() {
+    if (compiler_.joinable()) compiler_.join();
+    if (compiling_) {
+        std::remove(libraryPath_.c_str());
+        std::remove((libraryPath_ + ".c").c_str());
+    }
+    if (library_) dlclose(library_);
+}
+
+void TieredEngine::load(Module* module) {
+    if (module_) throw std::runtime_error("tiered engine: a module is already loaded");
+    bytecode_ = BytecodeCompiler().run(module);
+    module_ = module;
+    functions_.assign(bytecode_.functions.size(), Function{});
+    stack_.resize(options_.stackSlots);
+}
+
+vre::VreValue TieredEngine::evaluate(Module* input) {
+    BytecodeInput added = BytecodeCompiler().add(bytecode_, input);
+    session_ = true;
+    functions_.resize(bytecode_.functions.size());
+    for (const std::string& name : added.functions) functions_[bytecode_.byName.at(name)] = Function{}; // new bodies
+    functions_[added.script] = Function{};
+    globals_.resize(bytecode_.globals.size());
+    stack_.resize(options_.stackSlots);
+    return value(bytecode_.functions[added.script].result, invoke(added.script, nullptr));
+}
+
+vre::VreValue TieredEngine::call(const std::string& function, const std::vector<vre::VreValue>& args) {
+    auto found = bytecode_.byName.find(function);
+    if (found == bytecode_.byName.end()) throw std::runtime_error("tiered engine: no function " + function);
+    const BytecodeFunction& fn = bytecode_.functions[found->second];
+    if (args.size() != fn.params.size()) {
+        throw std::runtime_error("tiered engine: " + function + " takes " + std::to_string(fn.params.size()) +
+                                 " arguments");
+    }
+    std::vector<Slot> slots(args.size());
+    for (size_t i = 0; i < args.size(); ++i) {
+        const vre::VreValue& arg = args[i];
+        switch (fn.params[i]) {
+            case SlotKind::INT:
+                if (arg.type != vre::VreValueType::INTEGER) break;
+                slots[i].i = std::get<int64_t>(arg.data);
+                continue;
+            case SlotKind::FLOAT:
+                if (arg.type == vre::VreValueType::INTEGER) {
+                    slots[i].f = static_cast<double>(std::get<int64_t>(arg.data));
+                    continue;
+                }
+                if (arg.type != vre::VreValueType::FLOAT) break;
+                slots[i].f = std::get<double>(arg.data);
+                continue;
+            case SlotKind::BOOL:
+                if (arg.type != vre::VreValueType::BOOLEAN) break;
+                slots[i].i = std::get<bool>(arg.data) ? 1 : 0;
+                continue;
+            case SlotKind::VOID:
+                break;
+        }
+        throw std::runtime_error("tiered engine: argument " + std::to_string(i + 1) + " of " + function +
+                                 " has the wrong type");
+    }
+    return value(fn.result, invoke(found->second, slots.data()));
+}
+
+Tier TieredEngine::tier(const std::string& function) const {
+    auto found = bytecode_.byName.find(function);
+    if (found == bytecode_.byName.end()) throw std::runtime_error("tiered engine: no function " + function);
+    return functions_[found->second].state == State::NATIVE ? Tier::NATIVE : Tier::BYTECODE;
+}
+
+// --- Interpreter ---
+
+// Every call goes through here, so a function that turned native is used by
+// the next call from anywhere, including interpreter frames below it
+Slot TieredEngine::invoke(uint32_t index, const Slot* args) {
+    if (compiling_) poll();
+    Function& fn = functions_[index];
+    if (fn.state != State::NATIVE && ++fn.calls == options_.callThreshold) hot(index);
+    if (fn.state == State::NATIVE) {
+        ++report_.nativeCalls;
+        Slot result;
+        result.i = 0;
+        if (const char* panic = fn.native(args, &result)) {
+            throw std::runtime_error("tiered engine: " + std::string(panic) + " in " + bytecode_.functions[index].name);
+        }
+        return result;
+    }
+    ++report_.interpretedCalls;
+    return execute(index, args);
+}
+
+Slot TieredEngine::execute(uint32_t index, const Slot* args) {
+    const BytecodeFunction& fn = bytecode_.functions[index];
+    Function& state = functions_[index];
+    if (stack_.size() - top_ < fn.registers) throw std::runtime_error("tiered engine: stack overflow in " + fn.name);
+    Slot* r = stack_.data() + top_;
+    std::copy(args, args + fn.params.size(), r);
+    struct Frame {
+        size_t& top;
+        size_t size;
+        ~Frame() { top -= size; }
+    } frame{top_, fn.registers};
+    top_ += fn.registers;
+
+    const Instruction* code = fn.code.data();
+    const Slot* constants = fn.constants.data();
+    size_t pc = 0;
+    for (;;) {
+        const Instruction& in = code[pc++];
+        switch (in.op) {
+            case Op::LOAD_CONST: r[in.a] = constants[in.b]; break;
+            case Op::MOVE: r[in.a] = r[in.b]; break;
+            case Op::ADD: r[in.a].i = wrap(static_cast<uint64_t>(r[in.b].i) + static_cast<uint64_t>(r[in.c].i)); break;
+            case Op::SUB: r[in.a].i = wrap(static_cast<uint64_t>(r[in.b].i) - static_cast<uint64_t>(r[in.c].i)); break;
+            case Op::MUL: r[in.a].i = wrap(static_cast<uint64_t>(r[in.b].i) * static_cast<uint64_t>(r[in.c].i)); break;
+            case Op::DIV:
+            case Op::MOD: {
+                int64_t left = r[in.b].i;
+                int64_t right = r[in.c].i;
+                if (right == 0) throw std::runtime_error("tiered engine: division by zero in " + fn.name);
+                if (right == -1) { // INT64_MIN / -1 overflows
+                    r[in.a].i = in.op == Op::DIV ? wrap(0 - static_cast<uint64_t>(left)) : 0;
+                } else {
+                    r[in.a].i = in.op == Op::DIV ? left / right : left % right;
+                }
+                break;
+            }
+            case Op::FADD: r[in.a].f = r[in.b].f + r[in.c].f; break;
+            case Op::FSUB: r[in.a].f = r[in.b].f - r[in.c].f; break;
+            case Op::FMUL: r[in.a].f = r[in.b].f * r[in.c].f; break;
+            case Op::FDIV: r[in.a].f = r[in.b].f / r[in.c].f; break;
+            case Op::BIT_AND: r[in.a].i = r[in.b].i & r[in.c].i; break;
+            case Op::BIT_OR: r[in.a].i = r[in.b].i | r[in.c].i; break;
+            case Op::BIT_XOR: r[in.a].i = r[in.b].i ^ r[in.c].i; break;
+            case Op::SHL: r[in.a].i = wrap(static_cast<uint64_t>(r[in.b].i) << (r[in.c].i & 63)); break;
+            case Op::SHR: r[in.a].i = r[in.b].i >> (r[in.c].i & 63); break;
+            case Op::EQ: r[in.a].i = r[in.b].i == r[in.c].i; break;
+            case Op::NE: r[in.a].i = r[in.b].i != r[in.c].i; break;
+            case Op::LT: r[in.a].i = r[in.b].i < r[in.c].i; break;
+            case Op::LE: r[in.a].i = r[in.b].i <= r[in.c].i; break;
+            case Op::FEQ: r[in.a].i = r[in.b].f == r[in.c].f; break;
+            case Op::FNE: r[in.a].i = r[in.b].f != r[in.c].f; break;
+            case Op::FLT: r[in.a].i = r[in.b].f < r[in.c].f; break;
+            case Op::FLE: r[in.a].i = r[in.b].f <= r[in.c].f; break;
+            case Op::NEG: r[in.a].i = wrap(0 - static_cast<uint64_t>(r[in.b].i)); break;
+            case Op::FNEG: r[in.a].f = -r[in.b].f; break;
+            case Op::NOT: r[in.a].i = !r[in.b].i; break;
+            case Op::INC: r[in.a].i = wrap(static_cast<uint64_t>(r[in.a].i) + 1); break;
+            case Op::INT_TO_FLOAT: r[in.a].f = static_cast<double>(r[in.b].i); break;
+            case Op::FLOAT_TO_INT: r[in.a].i = static_cast<int64_t>(r[in.b].f); break;
+            case Op::JUMP: pc = in.a; break;
+            case Op::JUMP_IF_FALSE:
+                if (!r[in.b].i) pc = in.a;
+                break;
+            case Op::JUMP_IF_TRUE:
+                if (r[in.b].i) pc = in.a;
+                break;
+            case Op::LOOP:
+                pc = in.a;
+                ++report_.backEdges;
+                if (++state.backEdges == options_.backEdgeThreshold) hot(index);
+                if (compiling_) poll();
+                if (state.state == State::NATIVE && state.osr[in.b]) { // the rest of the call runs natively
+                    ++report_.osrEntries;
+                    Slot result;
+                    result.i = 0;
+                    if (const char* panic = state.osr[in.b](r, &result)) {
+                        throw std::runtime_error("tiered engine: " + std::string(panic) + " in " + fn.name);
+                    }
+                    return result;
+                }
+                break;
+            case Op::CALL: r[in.a] = invoke(in.b, r + in.c); break;
+            case Op::RETURN: return r[in.a];
+            case Op::RETURN_VOID: {
+                Slot none;
+                none.i = 0;
+                return none;
+            }
+            case Op::PRINT: print(fn.prints[in.b], r); break;
+            case Op::GET_GLOBAL: r[in.a] = globals_[in.b]; break;
+            case Op::SET_GLOBAL: globals_[in.a] = r[in.b]; break;
+        }
+    }
+}
+
+// The formats of CBackend::emitPrint, so both tiers print alike
+void TieredEngine::print(const PrintSpec& spec, const Slot* registers) const {
+    for (size_t i = 0; i < spec.items.size(); ++i) {
+        const PrintItem& item = spec.items[i];
+        if (i) std::fputc(' ', stdout);
+        switch (item.kind) {
+            case SlotKind::VOID: std::fputs(item.text.c_str(), stdout); break;
+            case SlotKind::INT: std::printf("%lld", static_cast<long long>(registers[item.reg].i)); break;
+            case SlotKind::FLOAT: std::printf("%g", registers[item.reg].f); break;
+            case SlotKind::BOOL: std::fputs(registers[item.reg].i ? "true" : "false", stdout); break;
+        }
+    }
+    if (spec.newline) std::fputc('\n', stdout);
+}
+
+// --- Native tier ---
+
+void TieredEngine::hot(uint32_t index) {
+    Function& fn = functions_[index];
+    if (fn.state != State::INTERPRETED || session_) return;
+    fn.state = State::QUEUED;
+    if (library_) {
+        link();
+        return;
+    }
+    if (!report_.compileError.empty()) {
+        fn.state = State::FAILED;
+        return;
+    }
+    if (compiling_) return;
+    std::string source;
+    try {
+        source = nativeSource();
+    } catch (const std::runtime_error& e) {
+        report_.compileError = e.what();
+        fn.state = State::FAILED;
+        return;
+    }
+    compiling_ = true;
+    ready_.store(false);
+    libraryPath_ = (std::filesystem::temp_directory_path() /
+                    ("vyn_tier_" + std::to_string(getpid()) + "_" + std::to_string(libraries++) + ".so"))
+                       .string();
+    if (options_.background) {
+        compiler_ = std::thread(&TieredEngine::build, this, std::move(source));
+    } else {
+        build(std::move(source));
+        poll();
+    }
+}
+
+// The whole module through CBackend, plus one entry point per function and
+// per loop (for OSR) that takes the interpreter's 8-byte slots
+std::string TieredEngine::nativeSource() {
+    std::vector<CBackend::OsrEntry> entries;
+    for (const BytecodeFunction& fn : bytecode_.functions) {
+        for (size_t i = 0; i < fn.loops.size(); ++i) {
+            const BytecodeLoop& loop = fn.loops[i];
+            if (loop.shadowed) continue;
+            entries.push_back(
+                CBackend::OsrEntry{fn.decl, loop.node, "vyn_" + osr_name(fn, i), loop.variables, loop.bounds});
+        }
+    }
+    std::string source = CBackend().run(module_, /*entryPoint*/ false, entries);
+    source += "\n";
+    for (const BytecodeFunction& fn : bytecode_.functions) {
+        for (size_t i = 0; i < fn.loops.size(); ++i) {
+            if (fn.loops[i].shadowed) continue;
+            source += entry_point("vyn_tier_" + osr_name(fn, i), "const void* slots",
+                                  store_result(fn.result, "vyn_" + osr_name(fn, i) + "((const int64_t*)slots)"));
+        }
+        std::string body;
+        std::string call = "vyn_" + fn.name + "(";
+        for (size_t i = 0; i < fn.params.size(); ++i) {
+            std::string arg = "a" + std::to_string(i);
+            std::string slot = fn.params[i] == SlotKind::BOOL ? "int64_t" : c_type(fn.params[i]);
+            body += "    " + slot + " " + arg + ";\n";
+            body += "    memcpy(&" + arg + ", (const char*)args + " + std::to_string(8 * i) + ", 8);\n";
+            call += (i ? ", " : "") + arg + (fn.params[i] == SlotKind::BOOL ? " != 0" : "");
+        }
+        call += ")";
+        source += entry_point("vyn_tier_" + fn.name, "const void* args", body + store_result(fn.result, call));
+    }
+    return source;
+}
+
+// On the compile thread in background mode: touches only the build fields
+void TieredEngine::build(std::string source) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        CBackend::compile(source, libraryPath_, options_.compiler, /*shared*/ true);
+    } catch (const std::runtime_error& e) {
+        buildError_ = e.what();
+    }
+    buildMilliseconds_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ready_.store(true, std::memory_order_release);
+}
+
+void TieredEngine::poll() {
+    if (!compiling_ || !ready_.load(std::memory_order_acquire)) return;
+    if (compiler_.joinable()) compiler_.join();
+    compiling_ = false;
+    ++report_.compiles;
+    report_.compileMilliseconds += buildMilliseconds_;
+    if (buildError_.empty()) {
+        library_ = dlopen(libraryPath_.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!library_) buildError_ = std::string("tiered engine: dlopen failed: ") + dlerror();
+    }
+    std::remove(libraryPath_.c_str()); // the mapping stays valid
+    std::remove((libraryPath_ + ".c").c_str());
+    if (!buildError_.empty()) {
+        report_.compileError = buildError_;
+        for (Function& fn : functions_) {
+            if (fn.state == State::QUEUED) fn.state = State::FAILED;
+        }
+        return;
+    }
+    link();
+}
+
+void TieredEngine::link() {
+    for (size_t i = 0; i < functions_.size(); ++i) {
+        Function& fn = functions_[i];
+        if (fn.state != State::QUEUED) continue;
+        const BytecodeFunction& code = bytecode_.functions[i];
+        std::string symbol = "vyn_tier_" + code.name;
+        fn.native = reinterpret_cast<NativeEntry>(dlsym(library_, symbol.c_str()));
+        fn.osr.assign(code.loops.size(), nullptr);
+        for (size_t loop = 0; loop < code.loops.size(); ++loop) {
+            std::string entry = "vyn_tier_" + osr_name(code, loop); // absent for shadowed loops
+            fn.osr[loop] = reinterpret_cast<NativeEntry>(dlsym(library_, entry.c_str()));
+        }
+        fn.state = fn.native ? State::NATIVE : State::FAILED;
+        report_.tieredUp += fn.native != nullptr;
+    }
+}
+
+} // namespace vyn
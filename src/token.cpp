@@ -49,6 +49,7 @@ std::string token_type_to_string(vyn::TokenType type) { // Corrected namespace f
         {vyn::TokenType::KEYWORD_TRY, "KEYWORD_TRY"},
         {vyn::TokenType::KEYWORD_CATCH, "KEYWORD_CATCH"},
         {vyn::TokenType::KEYWORD_FINALLY, "KEYWORD_FINALLY"},
+        {vyn::TokenType::KEYWORD_THROW, "KEYWORD_THROW"},
         {vyn::TokenType::KEYWORD_DEFER, "KEYWORD_DEFER"},
         {vyn::TokenType::KEYWORD_MATCH, "KEYWORD_MATCH"},
         {vyn::TokenType::KEYWORD_SCOPED, "KEYWORD_SCOPED"},
@@ -0,0 +1,127 @@
+#include "vyn/type_table.hpp"
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/value.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vyn {
+
+namespace {
+
+constexpr TypeTableGenerator::FieldType kValueField{vre::VreFieldKind::VALUE, sizeof(vre::VreValue), alignof(vre::VreValue)};
+
+uint32_t align_up(uint32_t offset, uint32_t align) { return (offset + align - 1) / align * align; }
+
+} // namespace
+
+vre::VreTypeTable TypeTableGenerator::run(Module* module) {
+    records_.clear();
+    byName_.clear();
+    impls_.clear();
+    inProgress_.clear();
+    builder_ = vre::VreTypeTableBuilder();
+    walk(module);
+
+    for (size_t i = 0; i < records_.size(); ++i) layOut(i);
+
+    std::unordered_map<std::string, vre::VreTraitId> traits;
+    for (ImplDeclaration* impl : impls_) {
+        TypeNode* self = impl->selfType.get();
+        TypeNode* trait = impl->traitType.get();
+        if (!trait || trait->category != TypeNode::TypeCategory::IDENTIFIER || !trait->name) continue;
+        if (!self || self->category != TypeNode::TypeCategory::IDENTIFIER || !self->name) continue;
+        auto record = byName_.find(self->name->name);
+        if (record == byName_.end()) continue; // impls for builtin types dispatch statically
+        auto [it, inserted] = traits.try_emplace(trait->name->name, 0);
+        if (inserted) it->second = builder_.add_trait(trait->name->name);
+        builder_.implement(*records_[record->second].typeId, it->second);
+    }
+    return builder_.build();
+}
+
+void TypeTableGenerator::visit(StructDeclaration* node) {
+    if (node->name && node->genericParams.empty()) {
+        node->typeId = vre::VRE_DYNAMIC_TYPE;
+        Record record{node->name->name, {}, &node->typeId};
+        for (auto& field : node->fields) record.fields.push_back(field.get());
+        byName_.emplace(record.name, records_.size());
+        records_.push_back(std::move(record));
+    }
+    AstWalker::visit(node);
+}
+
+void TypeTableGenerator::visit(ClassDeclaration* node) {
+    if (node->name && node->genericParams.empty()) {
+        node->typeId = vre::VRE_DYNAMIC_TYPE;
+        Record record{node->name->name, {}, &node->typeId};
+        for (auto& member : node->members) {
+            if (member && member->getType() == NodeType::FIELD_DECLARATION) {
+                record.fields.push_back(static_cast<FieldDeclaration*>(member.get()));
+            }
+        }
+        byName_.emplace(record.name, records_.size());
+        records_.push_back(std::move(record));
+    }
+    AstWalker::visit(node);
+}
+
+void TypeTableGenerator::visit(ImplDeclaration* node) {
+    impls_.push_back(node);
+    AstWalker::visit(node);
+}
+
+vre::VreTypeId TypeTableGenerator::layOut(size_t index) {
+    if (*records_[index].typeId != vre::VRE_DYNAMIC_TYPE) return *records_[index].typeId;
+    if (!inProgress_.insert(index).second) {
+        const std::string& name = records_[index].name;
+        throw std::runtime_error("Struct '" + name + "' contains itself by value; use our<" + name + "> or my<" +
+                                 name + "> to break the cycle");
+    }
+
+    std::vector<std::pair<FieldDeclaration*, FieldType>> fields;
+    for (FieldDeclaration* field : records_[index].fields) {
+        fields.emplace_back(field, fieldType(field->typeNode.get()));
+    }
+    std::stable_sort(fields.begin(), fields.end(),
+                     [](const auto& a, const auto& b) { return a.second.align > b.second.align; });
+
+    Record& record = records_[index];
+    std::vector<vre::VreTypeTableBuilder::Field> layout;
+    uint32_t offset = 0;
+    record.align = 1;
+    for (const auto& [field, type] : fields) {
+        offset = align_up(offset, type.align);
+        layout.push_back({field->name ? field->name->name : std::string(), offset, type.size, type.kind, type.type});
+        offset += type.size;
+        record.align = std::max(record.align, type.align);
+    }
+    record.size = align_up(offset, record.align);
+    *record.typeId = builder_.add_type(record.name, record.size, record.align, std::move(layout));
+    inProgress_.erase(index);
+    return *record.typeId;
+}
+
+TypeTableGenerator::FieldType TypeTableGenerator::fieldType(TypeNode* type) {
+    if (!type || type->isOptional || type->isPointer) return kValueField;
+    if (type->category == TypeNode::TypeCategory::OWNERSHIP_WRAPPED) {
+        if (type->ownership == OwnershipKind::OUR) return {vre::VreFieldKind::REF, 8, 8};
+        return {vre::VreFieldKind::RAW, 8, 8};
+    }
+    if (type->category != TypeNode::TypeCategory::IDENTIFIER || !type->name || !type->genericArguments.empty()) {
+        return kValueField;
+    }
+    const std::string& name = type->name->name;
+    if (name == "Int" || name == "i64" || name == "u64") return {vre::VreFieldKind::INT, 8, 8};
+    if (name == "i32" || name == "u32") return {vre::VreFieldKind::INT, 4, 4};
+    if (name == "Float" || name == "f64") return {vre::VreFieldKind::FLOAT, 8, 8};
+    if (name == "f32") return {vre::VreFieldKind::FLOAT, 4, 4};
+    if (name == "Bool") return {vre::VreFieldKind::BOOL, 1, 1};
+    if (name == "String") return {vre::VreFieldKind::STRING, sizeof(vre::VreString), alignof(vre::VreString)};
+    auto inner = byName_.find(name);
+    if (inner == byName_.end()) return kValueField;
+    vre::VreTypeId id = layOut(inner->second);
+    return {vre::VreFieldKind::STRUCT, records_[inner->second].size, records_[inner->second].align, id};
+}
+
+} // namespace vyn
@@ -0,0 +1,262 @@
+#include "vyn/vre/runtime_types.hpp"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace vyn::vre {
+
+namespace {
+
+constexpr size_t kMinCapacity = 8;
+
+inline size_t bool_words(size_t bits) { return (bits + 63) / 64; }
+
+void* allocate_storage(size_t bytes) {
+    return ::operator new(bytes, std::align_val_t(VreArray::STORAGE_ALIGNMENT));
+}
+
+void free_storage(void* storage) {
+    ::operator delete(storage, std::align_val_t(VreArray::STORAGE_ALIGNMENT));
+}
+
+void check_index(size_t index, size_t size) {
+    if (index >= size) {
+        throw std::runtime_error("Array index " + std::to_string(index) + " out of bounds for length " +
+                                 std::to_string(size));
+    }
+}
+
+} // namespace
+
+VreArray::VreArray(const VreArray& other)
+    : kind_(other.kind_), size_(other.size_), capacity_(other.size_), elements_(other.elements_) {
+    if (other.storage_ && other.size_ > 0) {
+        size_t bytes = storage_capacity_bytes();
+        storage_ = allocate_storage(bytes);
+        std::memcpy(storage_, other.storage_, bytes);
+    } else {
+        capacity_ = 0;
+    }
+}
+
+VreArray::VreArray(VreArray&& other) noexcept
+    : kind_(other.kind_), size_(other.size_), capacity_(other.capacity_), storage_(other.storage_),
+      elements_(std::move(other.elements_)) {
+    other.kind_ = VreArrayKind::EMPTY;
+    other.size_ = other.capacity_ = 0;
+    other.storage_ = nullptr;
+}
+
+VreArray& VreArray::operator=(VreArray other) noexcept {
+    std::swap(kind_, other.kind_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(storage_, other.storage_);
+    std::swap(elements_, other.elements_);
+    return *this;
+}
+
+VreArray::~VreArray() {
+    release_storage();
+}
+
+void VreArray::release_storage() {
+    if (storage_) {
+        free_storage(storage_);
+        storage_ = nullptr;
+    }
+    capacity_ = 0;
+}
+
+VreArrayKind VreArray::kind_for(const VreValue& value) {
+    switch (value.type) {
+        case VreValueType::INTEGER:
+            return VreArrayKind::INT;
+        case VreValueType::FLOAT:
+            return VreArrayKind::FLOAT;
+        case VreValueType::BOOLEAN:
+            return VreArrayKind::BOOL;
+        default:
+            return VreArrayKind::GENERIC;
+    }
+}
+
+size_t VreArray::storage_capacity_bytes() const {
+    if (kind_ == VreArrayKind::BOOL) return bool_words(capacity_) * sizeof(uint64_t);
+    return capacity_ * sizeof(int64_t); // INT and FLOAT are both 8 bytes wide
+}
+
+size_t VreArray::storage_bytes() const {
+    switch (kind_) {
+        case VreArrayKind::EMPTY:
+            return 0;
+        case VreArrayKind::INT:
+        case VreArrayKind::FLOAT:
+            return size_ * sizeof(int64_t);
+        case VreArrayKind::BOOL:
+            return bool_words(size_) * sizeof(uint64_t);
+        case VreArrayKind::GENERIC:
+            break;
+    }
+    return size_ * sizeof(VreValue);
+}
+
+void VreArray::grow(size_t min_capacity) {
+    check_not_borrowed("grow");
+    size_t capacity = capacity_ < kMinCapacity ? kMinCapacity : capacity_;
+    while (capacity < min_capacity) capacity *= 2;
+    size_t old_bytes = storage_capacity_bytes();
+    capacity_ = capacity;
+    void* storage = allocate_storage(storage_capacity_bytes());
+    std::memset(storage, 0, storage_capacity_bytes()); // keeps the unused bits of BOOL words clear
+    if (storage_) {
+        std::memcpy(storage, storage_, old_bytes);
+        free_storage(storage_);
+    }
+    storage_ = storage;
+}
+
+VreArray VreArray::filled(size_t size, VreArrayKind kind) {
+    VreArray array;
+    if (kind == VreArrayKind::GENERIC || kind == VreArrayKind::EMPTY) {
+        array.kind_ = VreArrayKind::GENERIC;
+        array.elements_.resize(size);
+    } else {
+        array.kind_ = kind;
+        if (size > 0) array.grow(size); // zero-filled
+    }
+    array.size_ = size;
+    return array;
+}
+
+void VreArray::reserve(size_t capacity) {
+    if (kind_ == VreArrayKind::GENERIC || kind_ == VreArrayKind::EMPTY) {
+        if (capacity > elements_.capacity()) check_not_borrowed("grow");
+        elements_.reserve(capacity);
+    } else if (capacity > capacity_) {
+        grow(capacity);
+    }
+}
+
+void VreArray::store_unboxed(size_t index, const VreValue& value) {
+    switch (kind_) {
+        case VreArrayKind::INT:
+            static_cast<int64_t*>(storage_)[index] = std::get<int64_t>(value.data);
+            break;
+        case VreArrayKind::FLOAT:
+            static_cast<double*>(storage_)[index] = std::get<double>(value.data);
+            break;
+        case VreArrayKind::BOOL: {
+            uint64_t& word = static_cast<uint64_t*>(storage_)[index / 64];
+            uint64_t bit = uint64_t(1) << (index % 64);
+            word = std::get<bool>(value.data) ? (word | bit) : (word & ~bit);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+VreValue VreArray::get(size_t index) const {
+    check_index(index, size_);
+    return get_unchecked(index);
+}
+
+VreValue VreArray::get_unchecked(size_t index) const {
+    switch (kind_) {
+        case VreArrayKind::INT:
+            return VreValue(static_cast<const int64_t*>(storage_)[index]);
+        case VreArrayKind::FLOAT:
+            return VreValue(static_cast<const double*>(storage_)[index]);
+        case VreArrayKind::BOOL:
+            return VreValue(((static_cast<const uint64_t*>(storage_)[index / 64] >> (index % 64)) & 1) != 0);
+        default:
+            return elements_[index];
+    }
+}
+
+void VreArray::check_not_borrowed(const char* operation) const {
+    if (borrows_ != 0) {
+        throw std::runtime_error(std::string("Cannot ") + operation + " an array while it is borrowed by a slice");
+    }
+}
+
+void VreArray::make_generic() {
+    check_not_borrowed("change the element kind of");
+    std::vector<VreValue> boxed;
+    boxed.reserve(size_);
+    for (size_t i = 0; i < size_; ++i) {
+        boxed.push_back(get(i));
+    }
+    release_storage();
+    elements_ = std::move(boxed);
+    kind_ = VreArrayKind::GENERIC;
+}
+
+void VreArray::set(size_t index, VreValue value) {
+    check_index(index, size_);
+    if (kind_ != VreArrayKind::GENERIC && kind_for(value) != kind_) {
+        make_generic();
+    }
+    if (kind_ == VreArrayKind::GENERIC) {
+        elements_[index] = std::move(value);
+    } else {
+        store_unboxed(index, value);
+    }
+}
+
+void VreArray::push(VreValue value) {
+    if (kind_ == VreArrayKind::EMPTY) {
+        kind_ = kind_for(value);
+        if (kind_ != VreArrayKind::GENERIC && elements_.capacity() > 0) {
+            size_t reserved = elements_.capacity(); // honour a reserve() made while EMPTY
+            std::vector<VreValue>().swap(elements_);
+            grow(reserved);
+        }
+    } else if (kind_ != VreArrayKind::GENERIC && kind_for(value) != kind_) {
+        make_generic();
+    }
+    if (kind_ == VreArrayKind::GENERIC) {
+        if (elements_.size() == elements_.capacity()) check_not_borrowed("grow");
+        elements_.push_back(std::move(value));
+        ++size_;
+        return;
+    }
+    if (size_ == capacity_) {
+        grow(size_ + 1);
+    }
+    store_unboxed(size_++, value);
+}
+
+void VreArray::clear_children() {
+    elements_.clear();
+    release_storage();
+    kind_ = VreArrayKind::EMPTY;
+    size_ = 0;
+}
+
+VreSlice::VreSlice(VreArray& array, size_t begin, size_t end) : array_(&array), offset_(begin), length_(end - begin) {
+    if (begin > end || end > array.size()) {
+        throw std::runtime_error("Slice range " + std::to_string(begin) + ".." + std::to_string(end) +
+                                 " out of bounds for length " + std::to_string(array.size()));
+    }
+    array.borrow();
+}
+
+VreSlice VreSlice::subslice(size_t begin, size_t end) const {
+    if (!array_ && begin == 0 && end == 0) return VreSlice();
+    if (begin > end || end > length_) {
+        throw std::runtime_error("Slice range " + std::to_string(begin) + ".." + std::to_string(end) +
+                                 " out of bounds for length " + std::to_string(length_));
+    }
+    return VreSlice(*array_, offset_ + begin, offset_ + end);
+}
+
+void VreSlice::throw_out_of_bounds(size_t index) const {
+    throw std::runtime_error("Slice index " + std::to_string(index) + " out of bounds for length " +
+                             std::to_string(length_));
+}
+
+} // namespace vyn::vre
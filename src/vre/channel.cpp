@@ -0,0 +1,85 @@
+#include "vyn/vre/channel.hpp"
+
+#include <algorithm>
+#include <climits>
+
+namespace vyn::vre {
+
+uint32_t VreChannelSignal::prepare_wait() {
+    threads_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_seq_cst);
+}
+
+void VreChannelSignal::wait(uint32_t epoch) {
+    futex_wait(&epoch_, epoch);
+    leave();
+}
+
+// A returning thread consumes a credit if there is one, and otherwise stops
+// counting as a sleeper. Credits are interchangeable: whichever thread
+// returns first re-checks the queue on behalf of the one that was claimed.
+void VreChannelSignal::leave() {
+    uint64_t threads = threads_.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t next = threads >= CREDIT ? threads - CREDIT : threads - 1;
+        if (threads_.compare_exchange_weak(threads, next, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+void VreChannelSignal::register_waker(VreWaker* waker) {
+    waiting_.lock()->push_back(waker);
+    wakers_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+bool VreChannelSignal::unregister_waker(VreWaker* waker) {
+    auto queue = waiting_.lock();
+    auto it = std::find(queue->begin(), queue->end(), waker);
+    if (it == queue->end()) return false;
+    queue->erase(it);
+    wakers_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void VreChannelSignal::notify_slow(bool all) {
+    uint64_t threads = threads_.load(std::memory_order_relaxed);
+    uint32_t claimed = 0;
+    for (;;) {
+        claimed = all ? sleepers(threads) : std::min<uint32_t>(1, sleepers(threads));
+        if (claimed == 0) break;
+        uint64_t next = threads - claimed + claimed * CREDIT;
+        if (threads_.compare_exchange_weak(threads, next, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (claimed > 0) {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(&epoch_, all ? INT_MAX : 1);
+    }
+    if (wakers_.load(std::memory_order_relaxed) == 0) return;
+    // Wake outside the lock: wake() may run the task, which may wait here again
+    if (!all) {
+        VreWaker* waker = nullptr;
+        {
+            auto queue = waiting_.lock();
+            if (queue->empty()) return;
+            waker = queue->front();
+            queue->pop_front();
+            wakers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        waker->wake();
+        return;
+    }
+    std::deque<VreWaker*> woken;
+    {
+        auto queue = waiting_.lock();
+        woken.swap(*queue);
+        wakers_.fetch_sub(static_cast<uint32_t>(woken.size()), std::memory_order_relaxed);
+    }
+    for (VreWaker* waker : woken) waker->wake();
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,23 @@
+#include "vyn/vre/closure.hpp"
+
+namespace vyn::vre {
+
+// Plain operator new already returns memory aligned for a VreFunction; the
+// align_val_t overloads cost an extra indirection per closure
+static_assert(alignof(VreFunction) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+VreClosure VreClosure::allocate(VreMethod code, uint32_t env_size, void (*drop_env)(void*)) {
+    void* memory = ::operator new(sizeof(VreFunction) + env_size);
+    return VreClosure(new (memory) VreFunction{code, drop_env, env_size, 0});
+}
+
+void VreClosure::reset() noexcept {
+    if (!fn_) return;
+    if (!(fn_->flags & VreFunction::STATIC)) {
+        if (fn_->drop_env) fn_->drop_env(fn_->env());
+        ::operator delete(fn_);
+    }
+    fn_ = nullptr;
+}
+
+} // namespace vyn::vre
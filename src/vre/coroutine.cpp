@@ -0,0 +1,22 @@
+#include "vyn/vre/coroutine.hpp"
+#include "vyn/vre/memory.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace vyn::vre {
+
+VreCoroutine* VreCoroutine::create(ResumeFn resume, uint32_t frame_size) {
+    if (frame_size < sizeof(VreCoroutine)) {
+        throw std::runtime_error("Coroutine frame smaller than its header");
+    }
+    void* memory = allocate_raw(frame_size);
+    std::memset(memory, 0, frame_size);
+    return new (memory) VreCoroutine{resume, 0, frame_size};
+}
+
+void VreCoroutine::destroy(VreCoroutine* frame) {
+    if (frame) deallocate_raw(frame, frame->frame_size);
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,253 @@
+#include "vyn/vre/cycle_collector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace vyn::vre {
+
+namespace {
+
+enum Color : uint8_t { BLACK = 0, GRAY = 1, WHITE = 2 };
+
+std::atomic<size_t> g_max_roots_per_pause{VreCycleCollectorConfig().max_roots_per_pause};
+
+struct StatsTable {
+    std::mutex mutex;
+    VreCycleCollectorStats totals;
+};
+
+StatsTable& stats_table() {
+    static StatsTable* table = new StatsTable(); // never destroyed; threads may collect during exit
+    return *table;
+}
+
+thread_local bool t_in_pause = false;
+
+// Drops the buffer's reference without buffering the object again. A merge
+// (after a release on another thread) has folded it into `shared`.
+void drop_owner_reference(VreRcHeader* header) {
+    if (header->merged) {
+        rc_release_shared(header);
+    } else if (--header->biased == 0) {
+        rc_owner_unbias(header);
+    }
+}
+
+template<typename F>
+void for_each_child_of(VreRcHeader* header, F&& visit) {
+    using Fn = std::remove_reference_t<F>;
+    header->ops->trace(
+        header, [](VreRcHeader* child, void* context) { (*static_cast<Fn*>(context))(child); }, &visit);
+}
+
+// One collection pause over a slice of candidate roots. The trial counts are
+// the owner's biased counts, which nothing but this thread touches.
+class Pause {
+public:
+    explicit Pause(VreThreadRecord* me) : me_(me) {}
+
+    size_t run(const std::vector<VreRcHeader*>& roots) {
+        // The buffer's own reference is not part of the graph
+        for (VreRcHeader* root : roots) {
+            if (participates(root)) --root->biased;
+        }
+        for (VreRcHeader* root : roots) {
+            if (participates(root)) mark_gray(root);
+        }
+        for (VreRcHeader* root : roots) {
+            if (participates(root)) scan(root);
+        }
+        for (VreRcHeader* root : roots) {
+            if (participates(root)) ++root->biased;
+        }
+        size_t freed = collect_white();
+        for (VreRcHeader* root : roots) {
+            root->buffered = false;
+            drop_owner_reference(root);
+        }
+        return freed;
+    }
+
+    uint64_t objects_traced() const { return traced_; }
+
+private:
+    VreThreadRecord* me_;
+    std::vector<VreRcHeader*> marked_; // every object colored gray by this pause
+    std::vector<VreRcHeader*> stack_;
+    uint64_t traced_ = 0;
+
+    bool participates(const VreRcHeader* header) const {
+        return header->owner == me_ && !header->merged && header->ops->trace &&
+               header->shared.load(std::memory_order_relaxed) == 0;
+    }
+
+    // Phase 1: color the subgraph gray and subtract every internal edge.
+    void mark_gray(VreRcHeader* root) {
+        if (root->color == GRAY) return;
+        root->color = GRAY;
+        marked_.push_back(root);
+        stack_.push_back(root);
+        while (!stack_.empty()) {
+            VreRcHeader* header = stack_.back();
+            stack_.pop_back();
+            ++traced_;
+            for_each_child_of(header, [&](VreRcHeader* child) {
+                if (!participates(child)) return;
+                --child->biased;
+                if (child->color != GRAY) {
+                    child->color = GRAY;
+                    marked_.push_back(child);
+                    stack_.push_back(child);
+                }
+            });
+        }
+    }
+
+    // Phase 2: anything with a count left is externally reachable; restore it
+    // and everything below it. The rest is garbage.
+    void scan(VreRcHeader* root) {
+        stack_.push_back(root);
+        while (!stack_.empty()) {
+            VreRcHeader* header = stack_.back();
+            stack_.pop_back();
+            if (header->color != GRAY) continue;
+            if (header->biased > 0) {
+                scan_black(header);
+                continue;
+            }
+            header->color = WHITE;
+            for_each_child_of(header, [&](VreRcHeader* child) {
+                if (participates(child)) stack_.push_back(child);
+            });
+        }
+    }
+
+    void scan_black(VreRcHeader* start) {
+        std::vector<VreRcHeader*> pending{start};
+        start->color = BLACK;
+        while (!pending.empty()) {
+            VreRcHeader* header = pending.back();
+            pending.pop_back();
+            for_each_child_of(header, [&](VreRcHeader* child) {
+                if (!participates(child)) return;
+                ++child->biased;
+                if (child->color != BLACK) {
+                    child->color = BLACK;
+                    pending.push_back(child);
+                }
+            });
+        }
+    }
+
+    // Phase 3: restore the real counts of white objects, pin them, break their
+    // references to each other, then unpin so they free themselves.
+    size_t collect_white() {
+        std::vector<VreRcHeader*> white;
+        for (VreRcHeader* header : marked_) {
+            if (header->color == WHITE) {
+                white.push_back(header);
+            } else {
+                header->color = BLACK;
+            }
+        }
+        for (VreRcHeader* header : white) {
+            for_each_child_of(header, [&](VreRcHeader* child) {
+                if (participates(child)) ++child->biased;
+            });
+        }
+        std::vector<bool> was_buffered;
+        was_buffered.reserve(white.size());
+        for (VreRcHeader* header : white) {
+            ++header->biased;
+            was_buffered.push_back(header->buffered);
+            header->buffered = true; // keep clear() from buffering it again
+        }
+        for (VreRcHeader* header : white) {
+            header->ops->clear(header);
+        }
+        for (size_t i = 0; i < white.size(); ++i) {
+            VreRcHeader* header = white[i];
+            header->color = BLACK;
+            if (was_buffered[i]) {
+                --header->biased; // the root loop drops the last (buffer) reference
+            } else {
+                drop_owner_reference(header);
+            }
+        }
+        return white.size();
+    }
+};
+
+} // namespace
+
+void configure_cycle_collector(const VreCycleCollectorConfig& config) {
+    rc_cycle_root_threshold.store(config.root_threshold, std::memory_order_relaxed);
+    g_max_roots_per_pause.store(std::max<size_t>(config.max_roots_per_pause, 1), std::memory_order_relaxed);
+    rc_cycle_collection_enabled.store(config.enabled, std::memory_order_relaxed);
+}
+
+VreCycleCollectorConfig cycle_collector_config() {
+    VreCycleCollectorConfig config;
+    config.enabled = rc_cycle_collection_enabled.load(std::memory_order_relaxed);
+    config.root_threshold = rc_cycle_root_threshold.load(std::memory_order_relaxed);
+    config.max_roots_per_pause = g_max_roots_per_pause.load(std::memory_order_relaxed);
+    return config;
+}
+
+VreCycleCollectorStats cycle_collector_stats() {
+    StatsTable& table = stats_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.totals;
+}
+
+void rc_buffer_candidate(VreRcHeader* header) {
+    header->buffered = true;
+    ++header->biased; // the buffer keeps the object alive until a pause looks at it
+    t_rc_record->cycle_candidates.push_back(header);
+}
+
+void rc_collect_cycles_at_threshold() {
+    collect_cycles_step();
+}
+
+size_t collect_cycles_step() {
+    VreThreadRecord* me = t_rc_record;
+    if (!me || me->cycle_candidates.empty() || t_in_pause) return 0;
+    t_in_pause = true;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<VreRcHeader*>& buffer = me->cycle_candidates;
+    size_t take = std::min(buffer.size(), g_max_roots_per_pause.load(std::memory_order_relaxed));
+    std::vector<VreRcHeader*> roots(buffer.end() - take, buffer.end());
+    buffer.resize(buffer.size() - take);
+
+    Pause pause(me);
+    size_t freed = pause.run(roots);
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    t_in_pause = false;
+
+    StatsTable& table = stats_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    VreCycleCollectorStats& totals = table.totals;
+    ++totals.pauses;
+    totals.roots_scanned += take;
+    totals.objects_traced += pause.objects_traced();
+    totals.objects_freed += freed;
+    totals.total_pause_ns += static_cast<uint64_t>(ns);
+    totals.max_pause_ns = std::max(totals.max_pause_ns, static_cast<uint64_t>(ns));
+    return freed;
+}
+
+size_t collect_cycles() {
+    size_t freed = 0;
+    VreThreadRecord* me = t_rc_record;
+    while (me && !me->cycle_candidates.empty() && !t_in_pause) {
+        freed += collect_cycles_step();
+    }
+    return freed;
+}
+
+} // namespace vyn::vre
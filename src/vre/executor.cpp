@@ -0,0 +1,287 @@
+#include "vyn/vre/executor.hpp"
+#include "vyn/vre/futex.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+namespace vyn::vre {
+
+namespace {
+
+// Rounds of failed searches before a worker parks
+constexpr int kIdleRounds = 64;
+
+// The executor and worker the current thread runs as, if any
+struct CurrentWorker {
+    VreExecutor* executor = nullptr;
+    void* worker = nullptr;
+};
+thread_local CurrentWorker t_current;
+
+// Polls a VreCoroutine as an executor task; its waker resumes the task.
+class CoroutineTask final : public VreFrame, public VreWaker {
+public:
+    CoroutineTask(VreExecutor& executor, VreCoroutine* coroutine, bool owned)
+        : executor_(executor), coroutine_(coroutine), owned_(owned) {}
+    ~CoroutineTask() override {
+        if (owned_) VreCoroutine::destroy(coroutine_);
+    }
+
+    VrePoll resume(VreTaskContext& ctx) override {
+        ctx.suspend(this);
+        return coroutine_->poll(*this);
+    }
+
+    void wake() override { executor_.wake(this); }
+
+private:
+    VreExecutor& executor_;
+    VreCoroutine* coroutine_;
+    bool owned_;
+};
+
+} // namespace
+
+struct VreExecutor::Worker {
+    VreChaseLevDeque<VreFrame> deque;
+    std::thread thread;
+    uint64_t rng; // xorshift state for choosing steal victims
+
+    std::atomic<uint64_t> resumes{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> injected{0};
+    std::atomic<uint64_t> parks{0};
+
+    explicit Worker(uint64_t seed) : rng(seed) {}
+
+    uint64_t next_random() {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return rng;
+    }
+
+    // Counters are only written by the owning worker
+    static void bump(std::atomic<uint64_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+};
+
+void VreTaskContext::spawn(VreFrame* frame) {
+    executor_.push_local(*executor_.workers_[index_], frame);
+}
+
+void VreTaskContext::await_all(VreFrame* self, VreFrame* const* children, size_t count) {
+    // The extra count is dropped by the executor once resume() has returned,
+    // so a child finishing on another worker cannot resume `self` while it
+    // is still running here.
+    self->pending_.store(static_cast<uint32_t>(count + 1), std::memory_order_relaxed);
+    awaited_ = true;
+    for (size_t i = count; i-- > 0;) { // children[0] is popped first
+        children[i]->continuation_ = self;
+        executor_.push_local(*executor_.workers_[index_], children[i]);
+    }
+}
+
+void VreTaskContext::suspend(VreFrame* self) {
+    self->pending_.store(2, std::memory_order_relaxed); // the wake, plus one while running
+    awaited_ = true;
+}
+
+VreExecutor::VreExecutor(size_t workers) {
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(0x9E3779B97F4A7C15ull * (i + 1)));
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        workers_[i]->thread = std::thread([this, i] { run_worker(i); });
+    }
+}
+
+VreExecutor::~VreExecutor() {
+    stop_.store(true, std::memory_order_seq_cst);
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(&epoch_, INT_MAX);
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+    for (auto& worker : workers_) {
+        while (VreFrame* frame = worker->deque.pop()) delete frame;
+    }
+    while (VreFrame* frame = pop_injector()) delete frame;
+}
+
+void VreExecutor::spawn(VreFrame* frame) {
+    if (t_current.executor == this) {
+        push_local(*static_cast<Worker*>(t_current.worker), frame);
+    } else {
+        inject(frame);
+    }
+}
+
+void VreExecutor::block_on(VreFrame* frame) {
+    if (t_current.executor == this) {
+        throw std::runtime_error("block_on called from a worker of the same executor");
+    }
+    std::atomic<uint32_t> done{0};
+    frame->done_ = &done;
+    inject(frame);
+    while (done.load(std::memory_order_acquire) == 0) {
+        futex_wait(&done, 0);
+    }
+}
+
+void VreExecutor::spawn(VreCoroutine* coroutine) {
+    spawn(new CoroutineTask(*this, coroutine, true));
+}
+
+void VreExecutor::block_on(VreCoroutine* coroutine) {
+    block_on(new CoroutineTask(*this, coroutine, false));
+}
+
+void VreExecutor::wake(VreFrame* frame) {
+    if (frame->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        spawn(frame);
+    }
+}
+
+bool VreExecutor::on_worker() const { return t_current.executor == this; }
+
+VreExecutorStats VreExecutor::stats() const {
+    VreExecutorStats stats;
+    for (const auto& worker : workers_) {
+        stats.resumes += worker->resumes.load(std::memory_order_relaxed);
+        stats.frames_completed += worker->completed.load(std::memory_order_relaxed);
+        stats.steals += worker->steals.load(std::memory_order_relaxed);
+        stats.injected += worker->injected.load(std::memory_order_relaxed);
+        stats.parks += worker->parks.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void VreExecutor::run_worker(size_t index) {
+    Worker& worker = *workers_[index];
+    t_current = CurrentWorker{this, &worker};
+    VreTaskContext ctx(*this, index);
+    int idle = 0;
+    while (!stop_.load(std::memory_order_acquire)) {
+        if (VreFrame* frame = find_work(worker)) {
+            idle = 0;
+            run_frame(ctx, worker, frame);
+        } else if (++idle < kIdleRounds) {
+            std::this_thread::yield();
+        } else {
+            idle = 0;
+            park(worker);
+        }
+    }
+    t_current = CurrentWorker{};
+}
+
+void VreExecutor::run_frame(VreTaskContext& ctx, Worker& worker, VreFrame* frame) {
+    ctx.awaited_ = false;
+    VrePoll poll = frame->resume(ctx);
+    Worker::bump(worker.resumes);
+    if (poll == VrePoll::READY) {
+        complete(worker, frame);
+    } else if (!ctx.awaited_) {
+        inject(frame); // a plain yield goes to the back of the line
+    } else if (frame->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        push_local(worker, frame); // everything it awaited already finished
+    }
+}
+
+void VreExecutor::complete(Worker& worker, VreFrame* frame) {
+    VreFrame* parent = frame->continuation_;
+    std::atomic<uint32_t>* done = frame->done_;
+    delete frame;
+    Worker::bump(worker.completed);
+    if (parent && parent->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        push_local(worker, parent);
+    }
+    if (done) {
+        done->store(1, std::memory_order_release);
+        futex_wake(done, INT_MAX);
+    }
+}
+
+VreFrame* VreExecutor::find_work(Worker& worker) {
+    if (VreFrame* frame = worker.deque.pop()) return frame;
+    if (VreFrame* frame = pop_injector()) {
+        Worker::bump(worker.injected);
+        return frame;
+    }
+    size_t count = workers_.size();
+    if (count < 2) return nullptr;
+    size_t start = static_cast<size_t>(worker.next_random() % count);
+    for (size_t i = 0; i < count; ++i) {
+        Worker& victim = *workers_[(start + i) % count];
+        if (&victim == &worker) continue;
+        if (VreFrame* frame = victim.deque.steal()) {
+            Worker::bump(worker.steals);
+            return frame;
+        }
+    }
+    return nullptr;
+}
+
+VreFrame* VreExecutor::pop_injector() {
+    if (injector_size_.load(std::memory_order_acquire) == 0) return nullptr;
+    auto queue = injector_.lock();
+    if (queue->empty()) return nullptr;
+    VreFrame* frame = queue->front();
+    queue->pop_front();
+    injector_size_.fetch_sub(1, std::memory_order_relaxed);
+    return frame;
+}
+
+void VreExecutor::push_local(Worker& worker, VreFrame* frame) {
+    worker.deque.push(frame);
+    notify();
+}
+
+void VreExecutor::inject(VreFrame* frame) {
+    {
+        auto queue = injector_.lock();
+        queue->push_back(frame);
+        injector_size_.fetch_add(1, std::memory_order_release);
+    }
+    notify();
+}
+
+bool VreExecutor::has_visible_work() const {
+    if (injector_size_.load(std::memory_order_seq_cst) > 0) return true;
+    for (const auto& worker : workers_) {
+        if (worker->deque.size_estimate() > 0) return true;
+    }
+    return false;
+}
+
+// Eventcount protocol: a parking worker announces itself in sleepers_, reads
+// the epoch, and re-checks for work before sleeping on the epoch. A pusher
+// publishes its work before reading sleepers_ and bumps the epoch if anyone
+// might be asleep, so either the parker sees the work or its futex_wait sees
+// a changed epoch.
+void VreExecutor::park(Worker& worker) {
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t epoch = epoch_.load(std::memory_order_seq_cst);
+    if (!stop_.load(std::memory_order_seq_cst) && !has_visible_work()) {
+        Worker::bump(worker.parks);
+        futex_wait(&epoch_, epoch);
+    }
+    sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void VreExecutor::notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) > 0) {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(&epoch_, 1);
+    }
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,42 @@
+#include "vyn/vre/futex.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace vyn::vre {
+
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, const std::chrono::nanoseconds* timeout) {
+#ifdef __linux__
+    struct timespec ts;
+    struct timespec* tsp = nullptr;
+    if (timeout) {
+        ts.tv_sec = static_cast<time_t>(timeout->count() / 1000000000);
+        ts.tv_nsec = static_cast<long>(timeout->count() % 1000000000);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, tsp, nullptr, 0);
+#else
+    if (word->load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(timeout ? std::min(*timeout, std::chrono::nanoseconds(50000))
+                                            : std::chrono::nanoseconds(50000));
+    }
+#endif
+}
+
+void futex_wake(std::atomic<uint32_t>* word, int count) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+} // namespace vyn::vre
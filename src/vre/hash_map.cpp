@@ -0,0 +1,49 @@
+#include "vyn/vre/hash_map.hpp"
+
+namespace vyn::vre {
+
+size_t VreHash<VreValue>::operator()(const VreValue& v) const noexcept {
+    switch (v.type) {
+        case VreValueType::NIL:
+            return 0;
+        case VreValueType::BOOLEAN:
+            return std::get<bool>(v.data) ? 1 : 2;
+        case VreValueType::INTEGER:
+            return (*this)(std::get<int64_t>(v.data));
+        case VreValueType::FLOAT: {
+            double d = std::get<double>(v.data);
+            if (d == 0.0) d = 0.0; // -0.0 == 0.0, so they must hash alike
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            return static_cast<size_t>(bits);
+        }
+        case VreValueType::STRING:
+            return std::get<VreString>(v.data).hash();
+        case VreValueType::OBJECT:
+        case VreValueType::ARRAY:
+            return reinterpret_cast<size_t>(v.heap_ref());
+    }
+    return 0;
+}
+
+bool VreKeyEq<VreValue>::operator()(const VreValue& a, const VreValue& b) const noexcept {
+    if (a.type != b.type) return false;
+    switch (a.type) {
+        case VreValueType::NIL:
+            return true;
+        case VreValueType::BOOLEAN:
+            return std::get<bool>(a.data) == std::get<bool>(b.data);
+        case VreValueType::INTEGER:
+            return std::get<int64_t>(a.data) == std::get<int64_t>(b.data);
+        case VreValueType::FLOAT:
+            return std::get<double>(a.data) == std::get<double>(b.data);
+        case VreValueType::STRING:
+            return std::get<VreString>(a.data) == std::get<VreString>(b.data);
+        case VreValueType::OBJECT:
+        case VreValueType::ARRAY:
+            return a.heap_ref() == b.heap_ref();
+    }
+    return false;
+}
+
+} // namespace vyn::vre
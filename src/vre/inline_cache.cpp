@@ -0,0 +1,44 @@
+#include "vyn/vre/inline_cache.hpp"
+
+namespace vyn::vre {
+
+VreInlineCache::State VreInlineCache::state() const {
+    if (megamorphic_) return State::MEGAMORPHIC;
+    if (count_ == 0) return State::UNINITIALIZED;
+    return count_ == 1 ? State::MONOMORPHIC : State::POLYMORPHIC;
+}
+
+void VreInlineCache::remember(const VreShape* shape, const VreShape* transition, uint32_t slot) {
+    if (megamorphic_) return;
+    if (count_ == MAX_ENTRIES) {
+        megamorphic_ = true; // keep the entries we have; stop learning new shapes
+        return;
+    }
+    entries_[count_++] = Entry{shape, transition, slot};
+}
+
+VreValue* VreInlineCache::load_miss(VreObject& object, const VreString& name) {
+    ++misses_;
+    if (!object.shape) return nullptr; // index-keyed objects have no named fields
+    int slot = object.shape->slot_of(name.view());
+    if (slot < 0) return nullptr;
+    remember(object.shape, nullptr, static_cast<uint32_t>(slot));
+    return &object.fields_by_index[slot];
+}
+
+void VreInlineCache::store_miss(VreObject& object, const VreString& name, VreValue value) {
+    ++misses_;
+    if (!object.shape && object.fields_by_index.empty()) {
+        object.shape = VreShape::empty(); // first named store makes the object dynamically shaped
+    }
+    const VreShape* before = object.shape;
+    int slot = before ? before->slot_of(name.view()) : -1;
+    object.set_field(name, std::move(value)); // throws for index-keyed objects
+    if (slot >= 0) {
+        remember(before, nullptr, static_cast<uint32_t>(slot));
+    } else {
+        remember(before, object.shape, static_cast<uint32_t>(object.fields_by_index.size() - 1));
+    }
+}
+
+} // namespace vyn::vre
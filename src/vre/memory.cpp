@@ -0,0 +1,323 @@
+#include "vyn/vre/memory.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Size-class slab allocator.
+//
+// Each thread owns a cache holding one free list per size class. Allocation
+// and deallocation on the owning thread touch only that cache. When a cache
+// runs dry it takes a batch of objects from the central depot for the class,
+// or carves a new slab if the depot is empty. When a cache grows past its limit
+// it returns a batch to the depot. Objects freed by a thread other than the
+// one that allocated them simply join the freeing thread's cache and flow back
+// through the depot. A thread's cache is flushed to the depot when the thread
+// exits; thread-local destructors that run after that go straight to the
+// depot. Slabs are never returned to the system.
+
+namespace vyn::vre {
+
+namespace {
+
+constexpr size_t kSizeClasses[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+constexpr size_t kNumClasses = sizeof(kSizeClasses) / sizeof(kSizeClasses[0]);
+constexpr size_t kSlabBytes = 64 * 1024;
+constexpr size_t kBatchBytes = 8 * 1024; // objects moved between cache and depot at once
+constexpr size_t kCacheBatches = 2;       // cache holds at most this many batches per class
+
+static_assert(kSizeClasses[kNumClasses - 1] == SLAB_MAX_SIZE, "size classes must end at SLAB_MAX_SIZE");
+
+// Maps (size + 15) / 16 to a size class index.
+struct ClassLookup {
+    std::array<uint8_t, SLAB_MAX_SIZE / 16 + 1> table{};
+    constexpr ClassLookup() {
+        size_t cls = 0;
+        for (size_t i = 0; i < table.size(); ++i) {
+            while (kSizeClasses[cls] < i * 16) ++cls;
+            table[i] = static_cast<uint8_t>(cls);
+        }
+    }
+};
+constexpr ClassLookup kClassLookup;
+
+inline size_t size_class_of(size_t size) { return kClassLookup.table[(size + 15) / 16]; }
+inline size_t batch_count(size_t cls) {
+    size_t n = kBatchBytes / kSizeClasses[cls];
+    return n < 4 ? 4 : n;
+}
+
+struct FreeObject {
+    FreeObject* next;
+};
+
+// A linked list of free objects moved as one unit.
+struct Batch {
+    FreeObject* head = nullptr;
+    size_t count = 0;
+};
+
+struct ThreadCache;
+
+struct Depot {
+    std::mutex mutex;
+    std::vector<Batch> batches;
+    std::vector<void*> slabs; // kept for accounting; never freed
+};
+
+struct CentralHeap {
+    std::array<Depot, kNumClasses> depots;
+
+    // Per-thread counters of exited threads are folded in here.
+    std::mutex stats_mutex;
+    AllocatorStats retired;
+    std::vector<ThreadCache*> live_caches;
+};
+
+CentralHeap& central() {
+    static CentralHeap* heap = new CentralHeap(); // never destroyed; threads may exit after static teardown
+    return *heap;
+}
+
+// Carves a fresh slab for `cls` into batches. The first batch is returned
+// to the caller and the rest go to the depot, so a fresh slab does not push
+// a thread cache over its limit.
+Batch carve_slab_into_depot(size_t cls) {
+    size_t obj_size = kSizeClasses[cls];
+    char* slab = static_cast<char*>(::operator new(kSlabBytes, std::align_val_t(SLAB_ALIGNMENT)));
+    size_t n = kSlabBytes / obj_size;
+    size_t per_batch = batch_count(cls);
+
+    std::vector<Batch> batches;
+    for (size_t start = 0; start < n; start += per_batch) {
+        size_t end = start + per_batch < n ? start + per_batch : n;
+        Batch batch;
+        for (size_t i = end; i-- > start;) {
+            auto* obj = reinterpret_cast<FreeObject*>(slab + i * obj_size);
+            obj->next = batch.head;
+            batch.head = obj;
+        }
+        batch.count = end - start;
+        batches.push_back(batch);
+    }
+    Depot& depot = central().depots[cls];
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    depot.slabs.push_back(slab);
+    depot.batches.insert(depot.batches.end(), batches.begin() + 1, batches.end());
+    return batches.front();
+}
+
+// Counter written only by its owning thread and read by allocator_stats().
+struct Counter {
+    std::atomic<uint64_t> value{0};
+    void add(uint64_t n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+// Set once the thread's cache has been destroyed. Other thread-local
+// destructors that run later still allocate and free through the depot.
+thread_local bool t_cache_destroyed = false;
+
+struct ThreadCache {
+    std::array<Batch, kNumClasses> lists;
+
+    Counter allocations, deallocations, bytes_requested, large_allocations;
+    Counter slabs_created, depot_refills, depot_flushes;
+
+    ThreadCache() {
+        CentralHeap& heap = central();
+        std::lock_guard<std::mutex> lock(heap.stats_mutex);
+        heap.live_caches.push_back(this);
+    }
+
+    ~ThreadCache() {
+        t_cache_destroyed = true;
+        for (size_t cls = 0; cls < kNumClasses; ++cls) {
+            if (lists[cls].count > 0) {
+                flush(cls, lists[cls].count);
+            }
+        }
+        CentralHeap& heap = central();
+        std::lock_guard<std::mutex> lock(heap.stats_mutex);
+        accumulate(heap.retired);
+        for (auto it = heap.live_caches.begin(); it != heap.live_caches.end(); ++it) {
+            if (*it == this) {
+                heap.live_caches.erase(it);
+                break;
+            }
+        }
+    }
+
+    void accumulate(AllocatorStats& out) const {
+        out.allocations += allocations.get();
+        out.deallocations += deallocations.get();
+        out.bytes_requested += bytes_requested.get();
+        out.large_allocations += large_allocations.get();
+        out.slabs_created += slabs_created.get();
+        out.depot_refills += depot_refills.get();
+        out.depot_flushes += depot_flushes.get();
+    }
+
+    void* allocate(size_t cls) {
+        Batch& list = lists[cls];
+        if (list.head == nullptr) {
+            refill(cls);
+        }
+        FreeObject* obj = list.head;
+        list.head = obj->next;
+        --list.count;
+        return obj;
+    }
+
+    void deallocate(void* ptr, size_t cls) {
+        Batch& list = lists[cls];
+        auto* obj = static_cast<FreeObject*>(ptr);
+        obj->next = list.head;
+        list.head = obj;
+        ++list.count;
+        if (list.count > batch_count(cls) * kCacheBatches) {
+            flush(cls, batch_count(cls));
+        }
+    }
+
+    void refill(size_t cls) {
+        Depot& depot = central().depots[cls];
+        {
+            std::lock_guard<std::mutex> lock(depot.mutex);
+            if (!depot.batches.empty()) {
+                lists[cls] = depot.batches.back();
+                depot.batches.pop_back();
+                depot_refills.add(1);
+                return;
+            }
+        }
+        carve_slab(cls);
+    }
+
+    void carve_slab(size_t cls) {
+        lists[cls] = carve_slab_into_depot(cls);
+        slabs_created.add(1);
+    }
+
+    // Detaches `count` objects from the cache and hands them to the depot.
+    void flush(size_t cls, size_t count) {
+        Batch& list = lists[cls];
+        Batch out;
+        out.head = list.head;
+        FreeObject* tail = list.head;
+        for (size_t i = 1; i < count; ++i) {
+            tail = tail->next;
+        }
+        list.head = tail->next;
+        list.count -= count;
+        tail->next = nullptr;
+        out.count = count;
+
+        Depot& depot = central().depots[cls];
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        depot.batches.push_back(out);
+        depot_flushes.add(1);
+    }
+};
+
+ThreadCache* thread_cache() {
+    if (t_cache_destroyed) return nullptr;
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+void* depot_allocate(size_t cls) {
+    Depot& depot = central().depots[cls];
+    {
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (!depot.batches.empty()) {
+            Batch& batch = depot.batches.back();
+            FreeObject* obj = batch.head;
+            batch.head = obj->next;
+            if (--batch.count == 0) depot.batches.pop_back();
+            return obj;
+        }
+    }
+    Batch batch = carve_slab_into_depot(cls);
+    FreeObject* obj = batch.head;
+    batch.head = obj->next;
+    if (--batch.count > 0) {
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        depot.batches.push_back(batch);
+    }
+    return obj;
+}
+
+void depot_deallocate(void* ptr, size_t cls) {
+    auto* obj = static_cast<FreeObject*>(ptr);
+    obj->next = nullptr;
+    Depot& depot = central().depots[cls];
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    depot.batches.push_back(Batch{obj, 1});
+}
+
+} // namespace
+
+void* allocate_raw(size_t size) {
+    ThreadCache* cache = thread_cache();
+    if (cache) {
+        cache->allocations.add(1);
+        cache->bytes_requested.add(size);
+    }
+    if (size > SLAB_MAX_SIZE) {
+        if (cache) cache->large_allocations.add(1);
+        return ::operator new(size);
+    }
+    size_t cls = size_class_of(size == 0 ? 1 : size);
+    return cache ? cache->allocate(cls) : depot_allocate(cls);
+}
+
+void deallocate_raw(void* ptr, size_t size) {
+    if (ptr == nullptr) return;
+    ThreadCache* cache = thread_cache();
+    if (cache) cache->deallocations.add(1);
+    if (size > SLAB_MAX_SIZE) {
+        ::operator delete(ptr, size);
+        return;
+    }
+    size_t cls = size_class_of(size == 0 ? 1 : size);
+    if (cache) {
+        cache->deallocate(ptr, cls);
+    } else {
+        depot_deallocate(ptr, cls);
+    }
+}
+
+AllocatorStats allocator_stats() {
+    CentralHeap& heap = central();
+    std::lock_guard<std::mutex> lock(heap.stats_mutex);
+    AllocatorStats stats = heap.retired;
+    for (const ThreadCache* cache : heap.live_caches) {
+        cache->accumulate(stats);
+    }
+    return stats;
+}
+
+void* DefaultAllocator::allocate(size_t size, size_t alignment) {
+    if (alignment <= SLAB_ALIGNMENT) {
+        return allocate_raw(size);
+    }
+    return ::operator new(size, std::align_val_t(alignment));
+}
+
+void DefaultAllocator::deallocate(void* ptr, size_t size, size_t alignment) {
+    if (alignment <= SLAB_ALIGNMENT) {
+        deallocate_raw(ptr, size);
+        return;
+    }
+    ::operator delete(ptr, size, std::align_val_t(alignment));
+}
+
+DefaultAllocator& DefaultAllocator::instance() {
+    static DefaultAllocator allocator;
+    return allocator;
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,130 @@
+#include "vyn/vre/mutex.hpp"
+#include "vyn/vre/futex.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace vyn::vre {
+
+namespace {
+
+constexpr uint32_t kMaxSpins = 1000;
+
+// Spinning only helps when the holder can run at the same time as us
+bool spinning_useful() {
+    static const bool useful = std::thread::hardware_concurrency() > 1;
+    return useful;
+}
+
+} // namespace
+
+void VreQueueLock::lock_queue() {
+    while (queue_lock_.exchange(true, std::memory_order_acquire)) {
+        while (queue_lock_.load(std::memory_order_relaxed)) cpu_relax();
+    }
+}
+
+// Spins while the lock is held but nobody is queued. The budget follows the
+// spin lengths that recently succeeded, as glibc's adaptive mutex does.
+bool VreQueueLock::spin() {
+    if (!spinning_useful()) return false;
+    uint32_t current = spin_limit_.load(std::memory_order_relaxed);
+    uint32_t limit = std::min(kMaxSpins, current * 2 + 10);
+    uint32_t spins = 0;
+    bool acquired = false;
+    for (; spins < limit; ++spins) {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        if (state & QUEUED) break; // queued threads go first
+        if (state == 0 && try_lock()) {
+            acquired = true;
+            break;
+        }
+        cpu_relax();
+    }
+    spin_limit_.store(current + (static_cast<int32_t>(spins) - static_cast<int32_t>(current)) / 8,
+                      std::memory_order_relaxed);
+    return acquired;
+}
+
+bool VreQueueLock::lock_slow(const std::chrono::steady_clock::time_point* deadline) {
+    if (spin()) return true;
+
+    Waiter me;
+    lock_queue();
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    for (;;) {
+        if (state == 0) { // released since we looked; the queue is empty
+            if (state_.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                unlock_queue();
+                return true;
+            }
+        } else if ((state & QUEUED) ||
+                   state_.compare_exchange_weak(state, state | QUEUED, std::memory_order_relaxed,
+                                                std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    me.prev = tail_;
+    if (tail_) {
+        tail_->next = &me;
+    } else {
+        head_ = &me;
+    }
+    tail_ = &me;
+    unlock_queue();
+
+    while (me.granted.load(std::memory_order_acquire) == 0) {
+        if (!deadline) {
+            futex_wait(&me.granted, 0, nullptr);
+            continue;
+        }
+        auto remaining = *deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            lock_queue();
+            if (me.granted.load(std::memory_order_acquire)) { // the baton arrived as we gave up
+                unlock_queue();
+                return true;
+            }
+            unlink(&me);
+            unlock_queue();
+            return false;
+        }
+        auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining);
+        futex_wait(&me.granted, 0, &timeout);
+    }
+    return true;
+}
+
+void VreQueueLock::unlock_slow() {
+    lock_queue();
+    Waiter* next = head_;
+    if (!next) { // the last waiter timed out after we saw QUEUED
+        state_.store(0, std::memory_order_release);
+        unlock_queue();
+        return;
+    }
+    unlink(next);
+    next->granted.store(1, std::memory_order_release); // the lock stays held; `next` owns it now
+    unlock_queue();
+    futex_wake(&next->granted, 1);
+}
+
+// Called with the queue locked. Clears QUEUED when the queue empties; the
+// LOCKED bit is left alone.
+void VreQueueLock::unlink(Waiter* waiter) {
+    if (waiter->prev) {
+        waiter->prev->next = waiter->next;
+    } else {
+        head_ = waiter->next;
+    }
+    if (waiter->next) {
+        waiter->next->prev = waiter->prev;
+    } else {
+        tail_ = waiter->prev;
+    }
+    if (!head_) {
+        state_.fetch_and(~QUEUED, std::memory_order_relaxed);
+    }
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,116 @@
+#include "vyn/vre/our.hpp"
+
+#include "vyn/vre/cycle_collector.hpp"
+
+namespace vyn::vre {
+
+namespace {
+
+void destroy(VreRcHeader* header) {
+    header->ops->destroy(header);
+}
+
+// Explicit merge of a QUEUED object: fold the biased count into `shared` (if
+// not merged yet), clear QUEUED, and free the object if no references remain.
+// Runs on the owner, or on any thread once the owner has exited.
+void merge_queued(VreRcHeader* header) {
+    uint64_t delta = 0;
+    if (!header->merged) {
+        delta = (static_cast<uint64_t>(header->biased) << 2) + VreRcHeader::MERGED;
+        header->biased = 0;
+        header->merged = true;
+    }
+    delta -= VreRcHeader::QUEUED;
+    uint64_t word = header->shared.fetch_add(delta, std::memory_order_acq_rel) + delta;
+    if (VreRcHeader::count_of(word) == 0) {
+        destroy(header);
+    }
+}
+
+void enqueue_to_owner(VreRcHeader* header) {
+    VreThreadRecord* owner = header->owner;
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        if (owner->alive) {
+            owner->queue.push_back(header);
+            owner->pending.store(true, std::memory_order_release);
+            return;
+        }
+    }
+    merge_queued(header); // owner has exited; its biased count can no longer change
+}
+
+struct ThreadRecordHolder {
+    VreThreadRecord* record = new VreThreadRecord();
+
+    ~ThreadRecordHolder() {
+        collect_cycles(); // releases the candidate buffer's references
+        std::vector<VreRcHeader*> queue;
+        {
+            std::lock_guard<std::mutex> lock(record->mutex);
+            record->alive = false;
+            queue.swap(record->queue);
+        }
+        t_rc_record = nullptr;
+        for (VreRcHeader* header : queue) {
+            merge_queued(header);
+        }
+    }
+};
+
+} // namespace
+
+VreThreadRecord* rc_register_thread() {
+    thread_local ThreadRecordHolder holder;
+    t_rc_record = holder.record;
+    return holder.record;
+}
+
+void rc_release_shared(VreRcHeader* header) {
+    uint64_t old = header->shared.load(std::memory_order_relaxed);
+    for (;;) {
+        uint64_t word = old - VreRcHeader::ONE;
+        bool queue = false;
+        // The first time `shared` goes negative before a merge, queue the object
+        // to its owner in the same atomic step, so nobody frees it in between.
+        if (!(old & VreRcHeader::MERGED) && !(old & VreRcHeader::QUEUED) && VreRcHeader::count_of(word) < 0) {
+            word |= VreRcHeader::QUEUED;
+            queue = true;
+        }
+        if (header->shared.compare_exchange_weak(old, word, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            if (queue) {
+                enqueue_to_owner(header);
+            } else if ((word & VreRcHeader::MERGED) && !(word & VreRcHeader::QUEUED) &&
+                       VreRcHeader::count_of(word) == 0) {
+                destroy(header);
+            }
+            return;
+        }
+    }
+}
+
+void rc_owner_unbias(VreRcHeader* header) {
+    // Implicit merge: the owner holds no more biased references.
+    header->merged = true;
+    uint64_t old = header->shared.fetch_add(VreRcHeader::MERGED, std::memory_order_acq_rel);
+    if (VreRcHeader::count_of(old) == 0 && !(old & VreRcHeader::QUEUED)) {
+        destroy(header);
+    }
+    // Otherwise the remaining shared references (or the merge queue) free it.
+}
+
+void our_process_pending_merges() {
+    VreThreadRecord* me = t_rc_record;
+    if (!me || !me->pending.load(std::memory_order_acquire)) return;
+    std::vector<VreRcHeader*> queue;
+    {
+        std::lock_guard<std::mutex> lock(me->mutex);
+        queue.swap(me->queue);
+        me->pending.store(false, std::memory_order_relaxed);
+    }
+    for (VreRcHeader* header : queue) {
+        merge_queued(header);
+    }
+}
+
+} // namespace vyn::vre
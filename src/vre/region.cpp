@@ -0,0 +1,109 @@
+#include "vyn/vre/region.hpp"
+
+#include <stdexcept>
+
+namespace vyn::vre {
+
+namespace {
+
+// Active regions on this thread, innermost last
+thread_local std::vector<VreRegion*> t_region_stack;
+
+} // namespace
+
+VreRegion::VreRegion(size_t chunk_size) : chunk_size_(chunk_size) {}
+
+VreRegion::~VreRegion() {
+    run_finalizers();
+    for (const Chunk& chunk : chunks_) {
+        ::operator delete(chunk.data, chunk.size);
+    }
+}
+
+void* VreRegion::allocate_slow(size_t size, size_t alignment) {
+    // Oversized requests get a dedicated chunk so the current one stays usable
+    size_t needed = size + alignment;
+    if (needed > chunk_size_ / 4) {
+        char* data = static_cast<char*>(::operator new(needed));
+        chunks_.insert(chunks_.begin(), Chunk{data, needed}); // keep the bump chunk last
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(data) + (alignment - 1)) & ~(uintptr_t(alignment) - 1);
+        bytes_allocated_ += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+    char* data = static_cast<char*>(::operator new(chunk_size_));
+    chunks_.push_back(Chunk{data, chunk_size_});
+    cursor_ = reinterpret_cast<uintptr_t>(data);
+    limit_ = cursor_ + chunk_size_;
+    return allocate(size, alignment);
+}
+
+bool VreRegion::contains(const void* ptr) const {
+    auto p = reinterpret_cast<uintptr_t>(ptr);
+    for (const Chunk& chunk : chunks_) {
+        auto start = reinterpret_cast<uintptr_t>(chunk.data);
+        if (p >= start && p < start + chunk.size) return true;
+    }
+    return false;
+}
+
+void VreRegion::run_finalizers() {
+    for (auto it = finalizers_.rbegin(); it != finalizers_.rend(); ++it) {
+        it->destroy(it->object);
+    }
+    finalizers_.clear();
+}
+
+void VreRegion::reset() {
+    run_finalizers();
+    if (chunks_.empty()) return;
+    Chunk keep = chunks_.back();
+    for (size_t i = 0; i + 1 < chunks_.size(); ++i) {
+        ::operator delete(chunks_[i].data, chunks_[i].size);
+    }
+    chunks_.clear();
+    if (reinterpret_cast<uintptr_t>(keep.data) + keep.size == limit_) { // the bump chunk
+        chunks_.push_back(keep);
+        cursor_ = reinterpret_cast<uintptr_t>(keep.data);
+        limit_ = cursor_ + keep.size;
+    } else {
+        ::operator delete(keep.data, keep.size);
+        cursor_ = limit_ = 0;
+    }
+    bytes_allocated_ = 0;
+}
+
+RegionScope::RegionScope() {
+    t_region_stack.push_back(&region_);
+}
+
+RegionScope::~RegionScope() {
+    t_region_stack.pop_back();
+}
+
+VreRegion* current_region() {
+    return t_region_stack.empty() ? nullptr : t_region_stack.back();
+}
+
+size_t region_depth_of(const void* ptr) {
+    for (size_t i = t_region_stack.size(); i-- > 0;) {
+        if (t_region_stack[i]->contains(ptr)) return i + 1;
+    }
+    return 0;
+}
+
+void* scoped_allocate(size_t size) {
+    if (VreRegion* region = current_region()) {
+        return region->allocate(size);
+    }
+    return allocate_raw(size);
+}
+
+void check_region_store(const void* holder, const void* value) {
+    size_t value_depth = region_depth_of(value);
+    if (value_depth == 0) return; // heap values can be stored anywhere
+    if (value_depth > region_depth_of(holder)) {
+        throw std::runtime_error("Region-allocated value escapes its scoped block");
+    }
+}
+
+} // namespace vyn::vre
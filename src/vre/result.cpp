@@ -0,0 +1,43 @@
+#include "vyn/vre/result.hpp"
+#include "vyn/vre/mutex.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace vyn::vre {
+
+namespace {
+
+struct ErrorTypes {
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names{""};
+};
+
+Mutex<ErrorTypes>& error_types() {
+    static Mutex<ErrorTypes> types;
+    return types;
+}
+
+} // namespace
+
+uint32_t vre_error_type(std::string_view name) {
+    if (name.empty()) return 0;
+    auto types = error_types().lock();
+    auto [it, inserted] = types->ids.try_emplace(std::string(name), static_cast<uint32_t>(types->names.size()));
+    if (inserted) types->names.emplace_back(name);
+    return it->second;
+}
+
+VreError& vre_current_error() {
+    thread_local VreError current;
+    return current;
+}
+
+void vre_raise(VreError&& error) { vre_current_error() = std::move(error); }
+
+std::string vre_error_type_name(uint32_t type) {
+    auto types = error_types().lock();
+    return type < types->names.size() ? types->names[type] : std::string();
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,46 @@
+#include "vyn/vre/shape.hpp"
+
+#include <mutex>
+
+namespace vyn::vre {
+
+namespace {
+
+std::mutex& transition_mutex() {
+    static std::mutex* mutex = new std::mutex(); // never destroyed, like the shapes it guards
+    return *mutex;
+}
+
+} // namespace
+
+VreShape::VreShape(const VreShape* parent, VreString name)
+    : parent_(parent), name_(std::move(name)), property_count_(parent->property_count_ + 1) {}
+
+const VreShape* VreShape::empty() {
+    static const VreShape* root = new VreShape();
+    return root;
+}
+
+const VreShape* VreShape::with_property(const VreString& name) const {
+    std::lock_guard<std::mutex> lock(transition_mutex());
+    auto it = transitions_.find(name);
+    if (it != transitions_.end()) {
+        return it->second.get();
+    }
+    VreString key = VreString::intern(name.view());
+    auto* child = new VreShape(this, key);
+    transitions_.emplace(key, std::unique_ptr<VreShape>(child));
+    return child;
+}
+
+int VreShape::slot_of(std::string_view name) const {
+    // The property added by a shape lives in slot property_count - 1
+    for (const VreShape* shape = this; shape->parent_ != nullptr; shape = shape->parent_) {
+        if (shape->name_ == name) {
+            return static_cast<int>(shape->property_count_ - 1);
+        }
+    }
+    return -1;
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,164 @@
+#include "vyn/vre/string.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace vyn::vre {
+
+namespace {
+
+std::atomic<uint64_t> g_heap_allocations{0};
+
+VreStringBuffer* allocate_buffer(size_t size) {
+    if (size > UINT32_MAX) {
+        throw std::runtime_error("VreString exceeds maximum length");
+    }
+    void* mem = ::operator new(offsetof(VreStringBuffer, data) + size + 1);
+    auto* buf = static_cast<VreStringBuffer*>(mem);
+    new (&buf->refcount) std::atomic<uint32_t>(1);
+    buf->size = static_cast<uint32_t>(size);
+    buf->data[size] = '\0';
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return buf;
+}
+
+uint32_t fnv1a(std::string_view s) noexcept {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h == 0 ? 1 : h; // 0 is reserved for "not computed"
+}
+
+// Intern table. Keys view into the immortal buffers they map to.
+struct InternTable {
+    std::mutex mutex;
+    std::unordered_map<std::string_view, VreStringBuffer*> buffers;
+};
+
+InternTable& intern_table() {
+    static InternTable* table = new InternTable(); // never destroyed; interned strings outlive statics
+    return *table;
+}
+
+} // namespace
+
+VreString::VreString(std::string_view s) : VreString(UninitTag{}, s.size()) {
+    std::memcpy(mutable_data(), s.data(), s.size());
+}
+
+VreString::VreString(UninitTag, size_t size) : hash_(0) {
+    if (size <= INLINE_CAPACITY) {
+        size_ = static_cast<uint32_t>(size);
+        inline_[size] = '\0';
+    } else {
+        heap_ = allocate_buffer(size);
+        size_ = static_cast<uint32_t>(size);
+    }
+}
+
+VreString::VreString(const VreString& other) noexcept : size_(other.size_), hash_(other.hash_) {
+    std::memcpy(inline_, other.inline_, sizeof(inline_));
+    retain();
+}
+
+VreString::VreString(VreString&& other) noexcept : size_(other.size_), hash_(other.hash_) {
+    std::memcpy(inline_, other.inline_, sizeof(inline_));
+    other.size_ = 0;
+    other.hash_ = 0;
+    other.inline_[0] = '\0';
+}
+
+VreString& VreString::operator=(const VreString& other) noexcept {
+    if (this != &other) {
+        other.retain();
+        release();
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+        size_ = other.size_;
+        hash_ = other.hash_;
+    }
+    return *this;
+}
+
+VreString& VreString::operator=(VreString&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+        size_ = other.size_;
+        hash_ = other.hash_;
+        other.size_ = 0;
+        other.hash_ = 0;
+        other.inline_[0] = '\0';
+    }
+    return *this;
+}
+
+void VreString::release_heap() noexcept {
+    uint32_t count = heap_->refcount.load(std::memory_order_relaxed);
+    if (count & VreStringBuffer::IMMORTAL) return;
+    if (heap_->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        ::operator delete(heap_);
+    }
+}
+
+VreString VreString::intern(std::string_view s) {
+    if (s.size() <= INLINE_CAPACITY) {
+        return VreString(s); // short strings are already allocation-free
+    }
+    InternTable& table = intern_table();
+    VreString result;
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.buffers.find(s);
+    VreStringBuffer* buf;
+    if (it != table.buffers.end()) {
+        buf = it->second;
+    } else {
+        buf = allocate_buffer(s.size());
+        std::memcpy(buf->data, s.data(), s.size());
+        buf->refcount.store(VreStringBuffer::IMMORTAL, std::memory_order_relaxed);
+        table.buffers.emplace(std::string_view(buf->data, buf->size), buf);
+    }
+    result.heap_ = buf;
+    result.size_ = buf->size;
+    return result;
+}
+
+bool VreString::is_interned() const noexcept {
+    return !is_inline() && (heap_->refcount.load(std::memory_order_relaxed) & VreStringBuffer::IMMORTAL);
+}
+
+uint32_t VreString::hash() const noexcept {
+    if (hash_ == 0) {
+        hash_ = fnv1a(view());
+    }
+    return hash_;
+}
+
+uint32_t VreString::hash_of(std::string_view s) noexcept {
+    return fnv1a(s);
+}
+
+bool operator==(const VreString& a, const VreString& b) noexcept {
+    if (a.size_ != b.size_) return false;
+    if (!a.is_inline() && a.heap_ == b.heap_) return true;
+    if (a.hash_ != 0 && b.hash_ != 0 && a.hash_ != b.hash_) return false;
+    return std::memcmp(a.data(), b.data(), a.size_) == 0;
+}
+
+VreString operator+(const VreString& a, const VreString& b) {
+    VreString result(VreString::UninitTag{}, a.size() + b.size());
+    char* out = result.mutable_data();
+    std::memcpy(out, a.data(), a.size());
+    std::memcpy(out + a.size(), b.data(), b.size());
+    return result;
+}
+
+uint64_t VreString::heap_allocations() noexcept {
+    return g_heap_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace vyn::vre
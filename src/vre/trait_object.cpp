@@ -0,0 +1,55 @@
+#include "vyn/vre/trait_object.hpp"
+
+namespace vyn::vre {
+
+VreTraitObject VreTraitObject::relocate_from(const VreVtableHeader* vtable, void* from) {
+    VreTraitObject object;
+    vtable->relocate(object.allocate(vtable), from);
+    object.set_vtable(vtable);
+    return object;
+}
+
+void VreTraitObject::reset() noexcept {
+    if (!tagged_vtable_) return;
+    const VreVtableHeader* vt = vtable();
+    if (tagged_vtable_ & HEAP_BIT) {
+        vt->drop(storage_.heap);
+        ::operator delete(storage_.heap, std::align_val_t(vt->align));
+    } else {
+        vt->drop(storage_.bytes);
+    }
+    tagged_vtable_ = 0;
+}
+
+void* VreTraitObject::allocate(const VreVtableHeader* vtable) {
+    if (fits_inline(vtable)) return storage_.bytes;
+    storage_.heap = ::operator new(vtable->size, std::align_val_t(vtable->align));
+    return storage_.heap;
+}
+
+void VreTraitObject::take(VreTraitObject& other) noexcept {
+    tagged_vtable_ = other.tagged_vtable_;
+    if (!tagged_vtable_) return;
+    if (tagged_vtable_ & HEAP_BIT) {
+        storage_.heap = other.storage_.heap;
+    } else {
+        vtable()->relocate(storage_.bytes, other.storage_.bytes);
+    }
+    other.tagged_vtable_ = 0;
+}
+
+VreDispatchSite::State VreDispatchSite::state() const {
+    if (polymorphic_) return State::POLYMORPHIC;
+    return seen_ ? State::MONOMORPHIC : State::UNINITIALIZED;
+}
+
+void VreDispatchSite::record_miss(const VreVtableHeader* vtable) {
+    ++misses_;
+    if (!seen_ && !polymorphic_) {
+        seen_ = vtable;
+    } else {
+        polymorphic_ = true;
+    }
+}
+
+} // namespace vyn::vre
@@ -0,0 +1,167 @@
+#include "vyn/vre/type_info.hpp"
+#include "vyn/vre/string.hpp"
+#include "vyn/vre/value.hpp"
+
+#include <algorithm>
+
+namespace vyn::vre {
+
+int64_t VreTypeTable::find_type(std::string_view name) const {
+    for (size_t id = 1; id < types_.size(); ++id) {
+        if (type_names_[id] == name) return static_cast<int64_t>(id);
+    }
+    return -1;
+}
+
+int64_t VreTypeTable::find_trait(std::string_view name) const {
+    for (size_t id = 0; id < trait_names_.size(); ++id) {
+        if (trait_names_[id] == name) return static_cast<int64_t>(id);
+    }
+    return -1;
+}
+
+const VreFieldInfo* VreTypeTable::find_field(VreTypeId type, std::string_view name) const {
+    for (const VreFieldInfo& field : fields(type)) {
+        if (name == field.name) return &field;
+    }
+    return nullptr;
+}
+
+void VreTypeTable::trace(const void* object, VreTypeId type, VreChildVisitor visit, void* context) const {
+    const auto* base = static_cast<const unsigned char*>(object);
+    for (const VrePointerSlot& slot : pointers(type)) {
+        VreRcHeader* child;
+        if (slot.kind == VreFieldKind::REF) {
+            child = *reinterpret_cast<VreRcHeader* const*>(base + slot.offset);
+        } else {
+            child = reinterpret_cast<const VreValue*>(base + slot.offset)->heap_ref();
+        }
+        if (child) visit(child, context);
+    }
+}
+
+void VreTypeTable::drop(void* object, VreTypeId type) const {
+    const VreTypeInfo& info = types_[type];
+    if (info.drop) {
+        info.drop(object);
+        return;
+    }
+    auto* base = static_cast<unsigned char*>(object);
+    for (const VreFieldInfo& field : fields(type)) {
+        void* slot = base + field.offset;
+        switch (field.kind) {
+            case VreFieldKind::STRING:
+                static_cast<VreString*>(slot)->~VreString();
+                break;
+            case VreFieldKind::VALUE:
+                static_cast<VreValue*>(slot)->~VreValue();
+                break;
+            case VreFieldKind::REF: {
+                auto*& header = *static_cast<VreRcHeader**>(slot);
+                if (header) rc_release(header);
+                header = nullptr;
+                break;
+            }
+            case VreFieldKind::STRUCT:
+                drop(slot, field.type);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+VreTypeTableBuilder::VreTypeTableBuilder() {
+    // Slot 0 is the dynamic type: no fields, no traits
+    table_.types_.push_back({nullptr, 0, 1, 0, 0, 0, 0, nullptr});
+    table_.type_names_.emplace_back("<dynamic>");
+}
+
+VreTypeId VreTypeTableBuilder::add_type(std::string name, uint32_t size, uint32_t align, std::vector<Field> fields,
+                                        void (*drop)(void* object)) {
+    auto id = static_cast<VreTypeId>(table_.types_.size());
+    VreTypeInfo info{nullptr, size, align,
+                     static_cast<uint32_t>(table_.fields_.size()), static_cast<uint32_t>(fields.size()),
+                     static_cast<uint32_t>(table_.pointers_.size()), 0, drop};
+    for (Field& field : fields) {
+        if (field.offset + field.size > size) {
+            throw std::invalid_argument("Field '" + field.name + "' of type '" + name + "' lies outside its " +
+                                        std::to_string(size) + " bytes");
+        }
+        switch (field.kind) {
+            case VreFieldKind::REF:
+            case VreFieldKind::VALUE:
+                table_.pointers_.push_back({field.offset, field.kind});
+                break;
+            case VreFieldKind::STRUCT: {
+                if (field.type == VRE_DYNAMIC_TYPE || field.type >= id) {
+                    throw std::invalid_argument("Field '" + field.name + "' of type '" + name +
+                                                "' embeds a type that is not in the table yet");
+                }
+                // Flatten the inner pointer map, so tracing never recurses
+                const VreTypeInfo& inner = table_.types_[field.type];
+                for (uint32_t i = 0; i < inner.pointer_count; ++i) {
+                    VrePointerSlot slot = table_.pointers_[inner.first_pointer + i];
+                    slot.offset += field.offset;
+                    table_.pointers_.push_back(slot);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        table_.fields_.push_back({nullptr, field.offset, field.size, field.kind, field.type});
+        table_.field_names_.push_back(std::move(field.name));
+    }
+    info.pointer_count = static_cast<uint32_t>(table_.pointers_.size()) - info.first_pointer;
+    table_.types_.push_back(info);
+    table_.type_names_.push_back(std::move(name));
+    return id;
+}
+
+VreTraitId VreTypeTableBuilder::add_trait(std::string name) {
+    table_.trait_names_.push_back(std::move(name));
+    return static_cast<VreTraitId>(table_.trait_names_.size() - 1);
+}
+
+void VreTypeTableBuilder::implement(VreTypeId type, VreTraitId trait, const VreVtableHeader* vtable) {
+    if (type == VRE_DYNAMIC_TYPE || type >= table_.types_.size() || trait >= table_.trait_names_.size()) {
+        throw std::invalid_argument("Unknown type or trait in implementation");
+    }
+    for (Impl& impl : impls_) {
+        if (impl.type == type && impl.trait == trait) {
+            if (vtable) impl.vtable = vtable;
+            return;
+        }
+    }
+    impls_.push_back({type, trait, vtable});
+}
+
+VreTypeTable VreTypeTableBuilder::build() {
+    VreTypeTable& table = table_;
+    // Names are only pointed to now that the string arrays stop growing
+    for (size_t id = 0; id < table.types_.size(); ++id) table.types_[id].name = table.type_names_[id].c_str();
+    for (size_t i = 0; i < table.fields_.size(); ++i) table.fields_[i].name = table.field_names_[i].c_str();
+
+    table.trait_stride_ = std::max<size_t>(table.trait_names_.size(), 1);
+    size_t slots = table.types_.size() * table.trait_stride_;
+    table.impls_.assign((slots + 63) / 64, 0);
+    table.vtables_.assign(slots, nullptr);
+    table.sole_implementors_.assign(table.trait_names_.size(), VRE_DYNAMIC_TYPE);
+    std::vector<uint32_t> implementors(table.trait_names_.size(), 0);
+    for (const Impl& impl : impls_) {
+        size_t slot = static_cast<size_t>(impl.type) * table.trait_stride_ + impl.trait;
+        table.impls_[slot / 64] |= uint64_t{1} << (slot % 64);
+        table.vtables_[slot] = impl.vtable;
+        if (++implementors[impl.trait] == 1) {
+            table.sole_implementors_[impl.trait] = impl.type;
+        } else {
+            table.sole_implementors_[impl.trait] = VRE_DYNAMIC_TYPE;
+        }
+    }
+    impls_.clear();
+
+    return std::move(table_);
+}
+
+} // namespace vyn::vre
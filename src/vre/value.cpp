@@ -0,0 +1,73 @@
+#include "vyn/vre/packed_value.hpp"
+#include "vyn/vre/runtime_types.hpp"
+
+namespace vyn::vre {
+
+void VrePackedValue::destroy_cell(VreHeapCell* c) noexcept {
+    switch (c->kind) {
+        case VreHeapKind::BOXED_INT:
+            delete static_cast<VreBoxedInt*>(c);
+            break;
+        case VreHeapKind::STRING:
+            delete static_cast<VreBoxedString*>(c);
+            break;
+        case VreHeapKind::OBJECT:
+            delete static_cast<VreBoxedObject*>(c);
+            break;
+        case VreHeapKind::ARRAY:
+            delete static_cast<VreBoxedArray*>(c);
+            break;
+    }
+}
+
+VreValueType VrePackedValue::type() const noexcept {
+    if (is_float()) return VreValueType::FLOAT;
+    if (is_nil()) return VreValueType::NIL;
+    if (is_boolean()) return VreValueType::BOOLEAN;
+    if (is_integer()) return VreValueType::INTEGER;
+    if (is_object()) return VreValueType::OBJECT;
+    if (is_array()) return VreValueType::ARRAY;
+    return VreValueType::STRING;
+}
+
+VrePackedValue VrePackedValue::from_value(const VreValue& value) {
+    switch (value.type) {
+        case VreValueType::NIL:
+            return VrePackedValue();
+        case VreValueType::BOOLEAN:
+            return VrePackedValue(std::get<bool>(value.data));
+        case VreValueType::INTEGER:
+            return VrePackedValue(std::get<int64_t>(value.data));
+        case VreValueType::FLOAT:
+            return VrePackedValue(std::get<double>(value.data));
+        case VreValueType::STRING:
+            return VrePackedValue(std::get<VreString>(value.data));
+        case VreValueType::OBJECT:
+            return VrePackedValue(std::get<our<VreObject>>(value.data));
+        case VreValueType::ARRAY:
+            return VrePackedValue(std::get<our<VreArray>>(value.data));
+    }
+    throw std::runtime_error("Unknown VreValueType in VrePackedValue::from_value");
+}
+
+VreValue VrePackedValue::to_value() const {
+    switch (type()) {
+        case VreValueType::NIL:
+            return VreValue();
+        case VreValueType::BOOLEAN:
+            return VreValue(as_boolean());
+        case VreValueType::INTEGER:
+            return VreValue(as_integer());
+        case VreValueType::FLOAT:
+            return VreValue(as_float());
+        case VreValueType::STRING:
+            return VreValue(as_string());
+        case VreValueType::OBJECT:
+            return VreValue(as_object());
+        case VreValueType::ARRAY:
+            return VreValue(as_array());
+    }
+    throw std::runtime_error("Unknown VreValueType in VrePackedValue::to_value");
+}
+
+} // namespace vyn::vre